@@ -57,6 +57,7 @@ CALLIN_LIST = {
 	"UnitCmdDone",
 	"UnitPreDamaged",
 	"UnitDamaged",
+	"UnitDamagedBatch",
 	"UnitStunned",
 	"UnitTaken",
 	"UnitGiven",
@@ -64,6 +65,8 @@ CALLIN_LIST = {
 	"UnitEnteredLos",
 	"UnitLeftRadar",
 	"UnitLeftLos",
+	"UnitEnteredLosBatch",
+	"UnitLeftLosBatch",
 	"UnitSeismicPing",
 	"UnitLoaded",
 	"UnitUnloaded",
@@ -1525,6 +1525,26 @@ function gadgetHandler:UnitDamaged(
   end
 end
 
+function gadgetHandler:UnitDamagedBatch(
+  unitIDs,
+  unitDefIDs,
+  unitTeams,
+  damages,
+  paralyzers,
+  weaponDefIDs,
+  projectileIDs,
+  attackerIDs,
+  attackerDefIDs,
+  attackerTeams,
+  count
+)
+  for _,g in r_ipairs(self.UnitDamagedBatchList) do
+    g:UnitDamagedBatch(unitIDs, unitDefIDs, unitTeams,
+                       damages, paralyzers, weaponDefIDs, projectileIDs,
+                       attackerIDs, attackerDefIDs, attackerTeams, count)
+  end
+end
+
 function gadgetHandler:UnitStunned(unitID, unitDefID, unitTeam, stunned)
   for _,g in r_ipairs(self.UnitStunnedList) do
     g:UnitStunned(unitID, unitDefID, unitTeam, stunned)
@@ -1574,6 +1594,20 @@ function gadgetHandler:UnitLeftLos(unitID, unitTeam, allyTeam, unitDefID)
 end
 
 
+function gadgetHandler:UnitEnteredLosBatch(unitIDs, unitTeams, allyTeams, unitDefIDs, count)
+  for _,g in r_ipairs(self.UnitEnteredLosBatchList) do
+    g:UnitEnteredLosBatch(unitIDs, unitTeams, allyTeams, unitDefIDs, count)
+  end
+end
+
+
+function gadgetHandler:UnitLeftLosBatch(unitIDs, unitTeams, allyTeams, unitDefIDs, count)
+  for _,g in r_ipairs(self.UnitLeftLosBatchList) do
+    g:UnitLeftLosBatch(unitIDs, unitTeams, allyTeams, unitDefIDs, count)
+  end
+end
+
+
 function gadgetHandler:UnitEnteredWater(unitID, unitDefID, unitTeam)
   for _,g in r_ipairs(self.UnitEnteredWaterList) do
     g:UnitEnteredWater(unitID, unitDefID, unitTeam)
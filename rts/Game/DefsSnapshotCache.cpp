@@ -0,0 +1,209 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+#include "DefsSnapshotCache.h"
+#include "GameSetup.h"
+#include "GameVersion.h"
+#include "LuaInclude.h"
+#include "Lua/LuaParser.h"
+#include "System/Config/ConfigHandler.h"
+#include "System/FileSystem/ArchiveScanner.h"
+#include "System/FileSystem/DataDirsAccess.h"
+#include "System/FileSystem/FileQueryFlags.h"
+#include "System/FileSystem/FileSystem.h"
+#include "System/FileSystem/FileSystemAbstraction.h"
+#include "System/Log/ILog.h"
+#include "lib/xxhash/xxh3.h"
+
+#include <fmt/format.h>
+
+CONFIG(bool, DefsSnapshotCache)
+	.defaultValue(true)
+	.description("Cache the evaluated gamedata/defs.lua tables so that games on the same archives and options load them without running Lua.")
+;
+
+
+static constexpr char     SNAPSHOT_MAGIC[4] = {'S', 'D', 'F', 'S'};
+static constexpr uint32_t SNAPSHOT_FORMAT = 1;
+
+struct SnapshotHeader {
+	char magic[4];
+	uint32_t format;
+	XXH128_hash_t key;
+	uint64_t dataSize;
+	uint64_t dataHash;
+};
+
+static std::atomic<bool> uncacheable = {false};
+
+
+static XXH128_hash_t GetSnapshotKey()
+{
+	XXH3_state_t state;
+	XXH3_INITSTATE(&state);
+	XXH3_128bits_reset(&state);
+
+	const auto HashBytes = [&](const void* p, size_t n) { XXH3_128bits_update(&state, p, n); };
+	const auto HashString = [&](const std::string& s) { HashBytes(s.c_str(), s.size() + 1); };
+	const auto HashOptions = [&](const spring::unordered_map<std::string, std::string>& options) {
+		std::vector<std::pair<std::string, std::string>> sorted(options.begin(), options.end());
+		std::sort(sorted.begin(), sorted.end());
+
+		for (const auto& [key, value]: sorted) {
+			HashString(key);
+			HashString(value);
+		}
+
+		HashString("");
+	};
+
+	const uint32_t luaNumberSize = sizeof(lua_Number);
+
+	HashBytes(&SNAPSHOT_FORMAT, sizeof(SNAPSHOT_FORMAT));
+	HashBytes(&luaNumberSize, sizeof(luaNumberSize));
+	HashString(SpringVersion::GetSync());
+
+	// defs.lua sees the mod (plus dependencies) and map archives
+	const sha512::raw_digest modChecksum = archiveScanner->GetArchiveCompleteChecksumBytes(archiveScanner->ArchiveFromName(gameSetup->modName));
+	const sha512::raw_digest mapChecksum = archiveScanner->GetArchiveCompleteChecksumBytes(archiveScanner->ArchiveFromName(gameSetup->mapName));
+
+	HashBytes(modChecksum.data(), modChecksum.size());
+	HashBytes(mapChecksum.data(), mapChecksum.size());
+
+	// as well as the Spring.Get{Mod,Map}Option{s} call-outs and Game.*
+	HashOptions(gameSetup->GetModOptionsCont());
+	HashOptions(gameSetup->GetMapOptionsCont());
+
+	const int startPosType = gameSetup->startPosType;
+	const uint8_t ghostedBuildings = gameSetup->ghostedBuildings;
+
+	HashBytes(&startPosType, sizeof(startPosType));
+	HashBytes(&ghostedBuildings, sizeof(ghostedBuildings));
+	HashString(gameSetup->hostDemo? FileSystem::GetBasename(gameSetup->demoName): "");
+
+	return (XXH3_128bits_digest(&state));
+}
+
+static std::string GetSnapshotPath(const XXH128_hash_t& key)
+{
+	static const std::string dir = [] {
+		const std::string sep(1, FileSystemAbstraction::GetNativePathSeparator());
+		return dataDirsAccess.LocateDir(FileSystem::GetCacheDir() + sep + "defs" + sep, FileQueryFlags::WRITE | FileQueryFlags::CREATE_DIRS);
+	}();
+
+	if (dir.empty())
+		return "";
+
+	return (FileSystem::EnsurePathSepAtEnd(dir) + fmt::format("{:016x}{:016x}.bin", key.high64, key.low64));
+}
+
+
+bool DefsSnapshotCache::Load(LuaParser* parser)
+{
+	uncacheable = false;
+
+	if (!configHandler->GetBool("DefsSnapshotCache") || !CGameSetup::ScriptLoaded())
+		return false;
+
+	const XXH128_hash_t key = GetSnapshotKey();
+	const std::string path = GetSnapshotPath(key);
+
+	FILE* file = path.empty()? nullptr: fopen(path.c_str(), "rb");
+
+	if (file == nullptr)
+		return false;
+
+	SnapshotHeader header;
+	std::vector<std::uint8_t> data;
+
+	bool valid = (fread(&header, sizeof(header), 1, file) == 1);
+
+	valid = valid && (memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) == 0);
+	valid = valid && (header.format == SNAPSHOT_FORMAT);
+	valid = valid && (XXH128_isEqual(header.key, key) != 0);
+
+	if (valid) {
+		fseek(file, 0, SEEK_END);
+		valid = (uint64_t(ftell(file)) == (sizeof(header) + header.dataSize));
+		fseek(file, sizeof(header), SEEK_SET);
+	}
+	if (valid) {
+		data.resize(header.dataSize);
+		valid = (fread(data.data(), data.size(), 1, file) == 1);
+		valid = valid && (XXH3_64bits(data.data(), data.size()) == header.dataHash);
+	}
+
+	fclose(file);
+
+	if (!valid || !parser->ExecuteSnapshot(data)) {
+		LOG_L(L_WARNING, "[DefsSnapshotCache::%s] ignoring invalid snapshot \"%s\"", __func__, path.c_str());
+		return false;
+	}
+
+	LOG("[DefsSnapshotCache::%s] loaded gamedata definitions from \"%s\" (%u bytes)", __func__, path.c_str(), uint32_t(data.size()));
+	return true;
+}
+
+bool DefsSnapshotCache::Save(LuaParser* parser)
+{
+	std::vector<std::uint8_t> data;
+
+	// Done regardless of whether the snapshot gets written, so the def tables
+	// iterate in the same order as on a cache hit, on every client. Fails for
+	// roots holding functions, userdata, table keys or tables with metatables;
+	// those are never cached so every client uses the executed root as-is.
+	if (!parser->ReloadRootFromSnapshot(data)) {
+		LOG("[DefsSnapshotCache::%s] gamedata definitions contain non-serializable values, not caching", __func__);
+		return false;
+	}
+
+	if (!configHandler->GetBool("DefsSnapshotCache") || !CGameSetup::ScriptLoaded())
+		return false;
+
+	if (uncacheable || parser->UsedRandom()) {
+		LOG("[DefsSnapshotCache::%s] gamedata definitions depend on per-game state, not caching", __func__);
+		return false;
+	}
+
+	const XXH128_hash_t key = GetSnapshotKey();
+	const std::string path = GetSnapshotPath(key);
+
+	if (path.empty())
+		return false;
+
+	SnapshotHeader header;
+	memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+	header.format = SNAPSHOT_FORMAT;
+	header.key = key;
+	header.dataSize = data.size();
+	header.dataHash = XXH3_64bits(data.data(), data.size());
+
+	// another instance may be loading the same snapshot; never expose partial files
+	const std::string tmpPath = path + ".tmp";
+	FILE* file = fopen(tmpPath.c_str(), "wb");
+
+	if (file == nullptr)
+		return false;
+
+	bool written = true;
+	written = written && (fwrite(&header, sizeof(header), 1, file) == 1);
+	written = written && (fwrite(data.data(), data.size(), 1, file) == 1);
+	written = (fclose(file) == 0) && written;
+
+	if (!written || std::rename(tmpPath.c_str(), path.c_str()) != 0) {
+		LOG_L(L_WARNING, "[DefsSnapshotCache::%s] failed to write \"%s\"", __func__, path.c_str());
+		std::remove(tmpPath.c_str());
+		return false;
+	}
+
+	LOG("[DefsSnapshotCache::%s] saved gamedata definitions to \"%s\" (%u bytes)", __func__, path.c_str(), uint32_t(data.size()));
+	return true;
+}
+
+void DefsSnapshotCache::MarkUncacheable() { uncacheable = true; }
@@ -0,0 +1,33 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#ifndef DEFS_SNAPSHOT_CACHE_H
+#define DEFS_SNAPSHOT_CACHE_H
+
+class LuaParser;
+struct lua_State;
+
+/**
+ * Keeps the table returned by gamedata/defs.lua in the cache directory so
+ * later games on the same mod and map archives (and options) can skip its
+ * evaluation. A snapshot is only written if the result cannot depend on
+ * anything outside the key, i.e. if defs.lua neither drew synced random
+ * numbers nor inspected the team/player/AI setup.
+ */
+namespace DefsSnapshotCache {
+	/// loads the cached root table into <parser> instead of executing it
+	bool Load(LuaParser* parser);
+	/// rebuilds the root table of an executed <parser> from its snapshot
+	/// (as Load would) and stores the snapshot if it is cacheable
+	bool Save(LuaParser* parser);
+
+	void MarkUncacheable();
+
+	/// wraps call-outs whose results are not part of the snapshot key
+	template<int (*func)(lua_State*)>
+	int UncacheableCall(lua_State* L) {
+		MarkUncacheable();
+		return (func(L));
+	}
+};
+
+#endif /* DEFS_SNAPSHOT_CACHE_H */
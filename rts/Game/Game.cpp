@@ -10,6 +10,7 @@
 #include "ChatMessage.h"
 #include "CommandMessage.h"
 #include "ConsoleHistory.h"
+#include "DefsSnapshotCache.h"
 #include "GameHelper.h"
 #include "GameSetup.h"
 #include "GlobalUnsynced.h"
@@ -50,7 +51,9 @@
 #include "Rendering/Units/UnitDrawer.h"
 #include "Rendering/UniformConstants.h"
 #include "Rendering/Map/InfoTexture/IInfoTextureHandler.h"
+#include "Rendering/Models/ModelCache.h"
 #include "Rendering/Textures/NamedTextures.h"
+#include "Lua/LuaChunkCache.h"
 #include "Lua/LuaGaia.h"
 #include "Lua/LuaHandle.h"
 #include "Lua/LuaInputReceiver.h"
@@ -119,6 +122,8 @@
 #include "System/SafeUtil.h"
 #include "System/SpringExitCode.h"
 #include "System/SpringMath.h"
+#include "System/FileSystem/DataDirsAccess.h"
+#include "System/FileSystem/FileQueryFlags.h"
 #include "System/FileSystem/FileSystem.h"
 #include "System/LoadSave/LoadSaveHandler.h"
 #include "System/LoadSave/DemoRecorder.h"
@@ -147,6 +152,8 @@ CONFIG(int, ShowPlayerInfo).defaultValue(1).headlessValue(0);
 CONFIG(float, GuiOpacity).defaultValue(0.8f).minimumValue(0.0f).maximumValue(1.0f).description("Sets the opacity of the built-in Spring UI. Generally has no effect on LuaUI widgets. Can be set in-game using shift+, to decrease and shift+. to increase.");
 CONFIG(std::string, InputTextGeo).defaultValue("");
 
+CONFIG(std::string, ProfilerTraceFile).defaultValue("").description("If set, all profiler timings of the game are written to this file (relative to the write-dir) as Chrome trace events, viewable with chrome://tracing or ui.perfetto.dev. Also works in headless mode.");
+
 CONFIG(int, SmoothTimeOffset).defaultValue(0).headlessValue(0).description("Enables frametimeoffset smoothing, 0 = off (old version), -1 = forced 0.5,  1-20 smooth, recommended = 2-3");
 
 CGame* game = nullptr;
@@ -290,6 +297,8 @@ CGame::~CGame()
 	ENTER_SYNCED_CODE();
 	LOG("[Game::%s][1]", __func__);
 
+	CTimeProfiler::GetInstance().StopTrace();
+
 	RmlGui::Shutdown();
 	helper->Kill();
 	KillLua(true);
@@ -567,31 +576,38 @@ void CGame::LoadDefs(LuaParser* defsParser)
 		defsParser->SetupLua(true, true);
 		// customize the defs environment; LuaParser has no access to LuaSyncedRead
 		#define LSR_ADDFUNC(f) defsParser->AddFunc(#f, LuaSyncedRead::f)
+		// team and player setup is not part of the snapshot key
+		#define LSR_ADDFUNC_UNCACHEABLE(f) defsParser->AddFunc(#f, DefsSnapshotCache::UncacheableCall<LuaSyncedRead::f>)
 		defsParser->GetTable("Spring");
 
 		LSR_ADDFUNC(GetModOptions);
 		LSR_ADDFUNC(GetModOption);
 		LSR_ADDFUNC(GetMapOptions);
 		LSR_ADDFUNC(GetMapOption);
-		LSR_ADDFUNC(GetTeamLuaAI);
-		LSR_ADDFUNC(GetTeamList);
-		LSR_ADDFUNC(GetGaiaTeamID);
-		LSR_ADDFUNC(GetPlayerList);
-		LSR_ADDFUNC(GetAllyTeamList);
-		LSR_ADDFUNC(GetTeamInfo);
-		LSR_ADDFUNC(GetAllyTeamInfo);
-		LSR_ADDFUNC(GetAIInfo);
-		LSR_ADDFUNC(GetTeamAllyTeamID);
-		LSR_ADDFUNC(AreTeamsAllied);
-		LSR_ADDFUNC(ArePlayersAllied);
+		LSR_ADDFUNC_UNCACHEABLE(GetTeamLuaAI);
+		LSR_ADDFUNC_UNCACHEABLE(GetTeamList);
+		LSR_ADDFUNC_UNCACHEABLE(GetGaiaTeamID);
+		LSR_ADDFUNC_UNCACHEABLE(GetPlayerList);
+		LSR_ADDFUNC_UNCACHEABLE(GetAllyTeamList);
+		LSR_ADDFUNC_UNCACHEABLE(GetTeamInfo);
+		LSR_ADDFUNC_UNCACHEABLE(GetAllyTeamInfo);
+		LSR_ADDFUNC_UNCACHEABLE(GetAIInfo);
+		LSR_ADDFUNC_UNCACHEABLE(GetTeamAllyTeamID);
+		LSR_ADDFUNC_UNCACHEABLE(AreTeamsAllied);
+		LSR_ADDFUNC_UNCACHEABLE(ArePlayersAllied);
 		LSR_ADDFUNC(GetSideData);
 
 		defsParser->EndTable();
+		#undef LSR_ADDFUNC_UNCACHEABLE
 		#undef LSR_ADDFUNC
 
-		// run the parser
-		if (!defsParser->Execute())
-			throw content_error("Defs-Parser: " + defsParser->GetErrorLog());
+		// run the parser, unless an earlier game on the same content left its result
+		if (!DefsSnapshotCache::Load(defsParser)) {
+			if (!defsParser->Execute())
+				throw content_error("Defs-Parser: " + defsParser->GetErrorLog());
+
+			DefsSnapshotCache::Save(defsParser);
+		}
 
 		const LuaTable& root = defsParser->GetRoot();
 
@@ -922,6 +938,27 @@ void CGame::LoadFinalize()
 		);
 	}
 
+	{
+		const LuaChunkCache::Stats stats = LuaChunkCache::GetStats();
+
+		LOG("[Game::%s] Lua chunk cache: %u hits, %u misses, %u stores, %u rejects (%.1fms spent loading)", __func__, stats.hits, stats.misses, stats.stores, stats.rejects, stats.loadMicros * 1e-3f);
+		LuaChunkCache::ResetStats();
+	}
+
+	{
+		const ModelCache::Stats stats = ModelCache::GetStats();
+
+		LOG("[Game::%s] model cache: %u hits, %u misses, %u stores, %u rejects (%.1fms spent loading)", __func__, stats.hits, stats.misses, stats.stores, stats.rejects, stats.loadMicros * 1e-3f);
+		ModelCache::ResetStats();
+	}
+
+	{
+		const std::string traceFile = configHandler->GetString("ProfilerTraceFile");
+
+		if (!traceFile.empty())
+			CTimeProfiler::GetInstance().StartTrace(dataDirsAccess.LocateFile(traceFile, FileQueryFlags::WRITE | FileQueryFlags::CREATE_DIRS));
+	}
+
 	lastReadNetTime = spring_gettime();
 	lastSimFrameTime = lastReadNetTime;
 	lastDrawFrameTime = lastReadNetTime;
@@ -1245,6 +1282,9 @@ bool CGame::Update()
 
 	LEAVE_SYNCED_CODE();
 
+	// timers queued by all threads since the last frame
+	CTimeProfiler::GetInstance().Merge();
+
 	{
 		SLuaAllocError error = {};
 
@@ -655,41 +655,168 @@ namespace {
 
 
 
-size_t CGameHelper::GenerateWeaponTargets(const CWeapon* weapon, const CUnit* avoidUnit, std::vector<std::pair<float, CUnit*>>& targets)
-{
-	const CUnit*  weaponOwner = weapon->owner;
-	const CUnit* lastAttacker = ((weaponOwner->lastAttackFrame + 200) <= gs->frameNum) ? weaponOwner->lastAttacker : nullptr;
+namespace {
+	// [0] := default, [1,2,3,4,5,6] := target is {avoidee, in bad category, crashing, last attacker, paralyzed, outside unboosted range}
+	constexpr float tgtPriorityMults[] = {1.0f, 10.0f, 100.0f, 1000.0f, 0.5f, 4.0f, 100000.0f};
+
+	// per-weapon state shared by GenerateWeaponTargets and ScoreWeaponTargets
+	struct WeaponTargetScorer {
+		WeaponTargetScorer(const CWeapon* w)
+			: weapon(w)
+			, weaponOwner(w->owner)
+			, lastAttacker(((weaponOwner->lastAttackFrame + 200) <= gs->frameNum) ? weaponOwner->lastAttacker : nullptr)
+			, weaponDef(w->weaponDef)
+			, weaponDmg(w->damages)
+			, ownerPos(weaponOwner->pos)
+			, aimPosHeight(w->aimFromPos.y)
+			, minMapHeight(std::max(0.0f, readMap->GetCurrMinHeight()))
+			// how much damage the weapon deals over 1 second
+			, secDamage(weaponDmg->GetDefault() * w->salvoSize / w->reloadTime * GAME_SPEED)
+			, heightMod(weaponDef->heightmod)
+			, worldMainDir(w->weaponDir)
+			, weaponAimAdjustPriority(w->weaponAimAdjustPriority)
+			, baseRange(w->range)
+			, rangeBoost(w->autoTargetRangeBoost)
+			// find theoretical maximum range based on height above lowest point on map
+			// scanRadius = weapon->GetRange2D(rangeBoost, (minMapHeight - aimPosHeight) * heightMod);
+			, scanRadius(baseRange + rangeBoost + (aimPosHeight - minMapHeight) * heightMod)
+			, paralyzer(weaponDmg->paralyzeDamageTime != 0)
+		{}
 
-	const      WeaponDef* weaponDef = weapon->weaponDef;
-	const DynDamageArray* weaponDmg = weapon->damages;
+		/**
+		 * Returns false if <targetUnit> can not be auto-targeted, otherwise
+		 * fills in the factors of its priority. No script or Lua code is
+		 * entered, the avoidee and TargetWeight terms are added later by
+		 * WeaponTargetPriority.
+		 */
+		bool Score(CUnit* targetUnit, SWeaponTargetScore& score) const {
+			if (!weapon->TestTarget(testPos, SWeaponTarget(targetUnit)))
+				return false;
+
+			const unsigned short targetLOSState = targetUnit->losStatus[weaponOwner->allyteam];
 
-	const float3& ownerPos = weaponOwner->pos;
-	const float3 testPos;
+			float3 targetPos;
 
-	const float aimPosHeight = weapon->aimFromPos.y;
-	const float minMapHeight = std::max(0.0f, readMap->GetCurrMinHeight());
+			score.unit = targetUnit;
+			score.inLos = (targetLOSState & LOS_INLOS);
+			score.prevLos = (targetLOSState & LOS_PREVLOS);
 
-	// how much damage the weapon deals over 1 second
-	const float secDamage = weaponDmg->GetDefault() * weapon->salvoSize / weapon->reloadTime * GAME_SPEED;
-	const float heightMod = weaponDef->heightmod;
+			if (targetLOSState & LOS_INLOS) {
+				targetPos = targetUnit->aimPos;
+			} else if (targetLOSState & LOS_INRADAR) {
+				targetPos = weapon->GetUnitPositionWithError(targetUnit);
+			} else {
+				return false;
+			}
 
-	const float3 worldMainDir = weapon->weaponDir;
-	const float weaponAimAdjustPriority = weapon->weaponAimAdjustPriority;
+			const float modRange = weapon->GetRange2D(rangeBoost, (targetPos.y - aimPosHeight) * heightMod);
+			const float sqDist2D = ownerPos.SqDistance2D(targetPos);
 
-	const float  baseRange = weapon->range;
-	const float rangeBoost = weapon->autoTargetRangeBoost;
-	// find theoretical maximum range based on height above lowest point on map
-	// const float scanRadius = weapon->GetRange2D(rangeBoost, (minMapHeight - aimPosHeight) * heightMod);
-	const float scanRadius = baseRange + rangeBoost + (aimPosHeight - minMapHeight) * heightMod;
+			if (sqDist2D > Square(modRange))
+				return false;
 
-	// [0] := default, [1,2,3,4,5,6] := target is {avoidee, in bad category, crashing, last attacker, paralyzed, outside unboosted range}
-	constexpr float tgtPriorityMults[] = {1.0f, 10.0f, 100.0f, 1000.0f, 0.5f, 4.0f, 100000.0f};
+			const float3 worldTargetDir = (targetPos - ownerPos).SafeNormalize();
+			const float angleOffset =  (1.f - worldMainDir.dot(worldTargetDir));
+			const float angleMod = angleOffset * weaponAimAdjustPriority + 1.f;
+
+			// Strengthen focus towards the front, desire should weaken quadratically rather
+			// than linearly otherwise target distance can too easily cause units to choose a
+			// target that requires turning around to fire at.
+			const float angleMul = angleMod*angleMod;
+
+			const float dist2D = math::sqrt(sqDist2D);
+			const float rangeMul = (dist2D * weaponDef->proximityPriority + modRange * 0.4f + 100.0f);
+			const float damageMul = std::max(0.0001f, weaponDmg->Get(targetUnit->armorType) * targetUnit->curArmorMultiple);
+
+			// multiplying by 1 is exact, so unused factors do not change the result
+			score.headMults[0] = tgtPriorityMults[(!score.inLos) * 1];
+			score.headMults[1] = angleMul;
+			score.headMults[2] = rangeMul;
+			score.headMults[3] = tgtPriorityMults[(dist2D > baseRange) * 6];
+
+			if (targetLOSState & LOS_INLOS) {
+				const bool paralyzed = (paralyzer && targetUnit->paralyzeDamage > (modInfo.paralyzeOnMaxHealth? targetUnit->maxHealth: targetUnit->health));
+
+				score.headMults[4] = (secDamage + targetUnit->health);
+				score.headMults[5] = tgtPriorityMults[paralyzed * 5];
+			} else {
+				score.headMults[4] = (secDamage + 10000.0f);
+				score.headMults[5] = tgtPriorityMults[0];
+			}
+
+			if (targetLOSState & LOS_PREVLOS) {
+				score.tailDivisor = (damageMul * targetUnit->power);
+				score.tailMults[0] = tgtPriorityMults[((targetUnit->category & weapon->badTargetCategory) != 0) * 2];
+				score.tailMults[1] = tgtPriorityMults[(targetUnit->IsCrashing()) * 3];
+				score.tailMults[2] = tgtPriorityMults[(targetUnit == lastAttacker) * 4];
+			}
+
+			return true;
+		}
+
+		const CWeapon* weapon;
+		const CUnit*  weaponOwner;
+		const CUnit* lastAttacker;
+
+		const      WeaponDef* weaponDef;
+		const DynDamageArray* weaponDmg;
+
+		const float3& ownerPos;
+		const float3 testPos;
+
+		const float aimPosHeight;
+		const float minMapHeight;
+
+		const float secDamage;
+		const float heightMod;
+
+		const float3 worldMainDir;
+		const float weaponAimAdjustPriority;
+
+		const float  baseRange;
+		const float rangeBoost;
+		const float scanRadius;
+
+		const bool paralyzer;
+	};
+
+	// multiplies out a scored candidate in the same order for the serial and
+	// the pre-scored path, so both yield bit-identical priorities
+	float WeaponTargetPriority(const CWeapon* weapon, const SWeaponTargetScore& score, const CUnit* avoidUnit) {
+		float targetPriority = tgtPriorityMults[(score.unit == avoidUnit) * 1];
+
+		for (const float mult: score.headMults) {
+			targetPriority *= mult;
+		}
+
+		if (score.inLos && weapon->hasTargetWeight)
+			targetPriority *= weapon->TargetWeight(score.unit);
+
+		if (score.prevLos) {
+			targetPriority /= score.tailDivisor;
+
+			for (const float mult: score.tailMults) {
+				targetPriority *= mult;
+			}
+		}
+
+		return targetPriority;
+	}
+
+	bool WeaponTargetPairCmp(const std::pair<float, CUnit*>& a, const std::pair<float, CUnit*>& b) { return (a.first < b.first); }
+}
+
+
+size_t CGameHelper::GenerateWeaponTargets(const CWeapon* weapon, const CUnit* avoidUnit, std::vector<std::pair<float, CUnit*>>& targets)
+{
+	const WeaponTargetScorer scorer(weapon);
 
-	const bool paralyzer = (weaponDmg->paralyzeDamageTime != 0);
+	const CUnit* weaponOwner = scorer.weaponOwner;
+	const WeaponDef* weaponDef = scorer.weaponDef;
 
 	// copy on purpose since the below calls lua
 	QuadFieldQuery qfQuery;
-	quadField.GetQuads(qfQuery, ownerPos, scanRadius);
+	quadField.GetQuads(qfQuery, scorer.ownerPos, scorer.scanRadius);
 
 	targets.clear();
 	targets.reserve(32);
@@ -709,80 +836,103 @@ size_t CGameHelper::GenerateWeaponTargets(const CWeapon* weapon, const CUnit* av
 
 				targetUnit->tempNum = tempNum;
 
-				if (!weapon->TestTarget(testPos, SWeaponTarget(targetUnit)))
+				SWeaponTargetScore score;
+
+				if (!scorer.Score(targetUnit, score))
 					continue;
 
-				const unsigned short targetLOSState = targetUnit->losStatus[weaponOwner->allyteam];
+				float targetPriority = WeaponTargetPriority(weapon, score, avoidUnit);
 
-				float targetPriority = tgtPriorityMults[(targetUnit == avoidUnit) * 1];
-				float3 targetPos;
+				const bool allowTarget = eventHandler.AllowWeaponTarget(weaponOwner->id, targetUnit->id, weapon->weaponNum, weaponDef->id, &targetPriority);
 
-				if (targetLOSState & LOS_INLOS) {
-					targetPos = targetUnit->aimPos;
-				} else if (targetLOSState & LOS_INRADAR) {
-					targetPos = weapon->GetUnitPositionWithError(targetUnit);
-					targetPriority *= tgtPriorityMults[1];
-				} else {
+				// Lua call may have changed tempNum, so needs to be set again
+				targetUnit->tempNum = tempNum;
+
+				if (!allowTarget)
 					continue;
-				}
 
-				const float modRange = weapon->GetRange2D(rangeBoost, (targetPos.y - aimPosHeight) * heightMod);
-				const float sqDist2D = ownerPos.SqDistance2D(targetPos);
+				targets.emplace_back(targetPriority, targetUnit);
+			}
+		}
+	}
 
-				if (sqDist2D > Square(modRange))
-					continue;
+	std::stable_sort(targets.begin(), targets.end(), WeaponTargetPairCmp);
+	return (targets.size());
+}
 
-				const float3 worldTargetDir = (targetPos - ownerPos).SafeNormalize();
-				const float angleOffset =  (1.f - worldMainDir.dot(worldTargetDir));
-				const float angleMod = angleOffset * weaponAimAdjustPriority + 1.f;
+size_t CGameHelper::ScoreWeaponTargets(const CWeapon* weapon, std::vector<SWeaponTargetScore>& scores)
+{
+	const WeaponTargetScorer scorer(weapon);
 
-				// Strengthen focus towards the front, desire should weaken quadratically rather
-				// than linearly otherwise target distance can too easily cause units to choose a
-				// target that requires turning around to fire at.
-				const float angleMul = angleMod*angleMod;
+	const CUnit* weaponOwner = scorer.weaponOwner;
 
-				const float dist2D = math::sqrt(sqDist2D);
-				const float rangeMul = (dist2D * weaponDef->proximityPriority + modRange * 0.4f + 100.0f);
-				const float damageMul = std::max(0.0001f, weaponDmg->Get(targetUnit->armorType) * targetUnit->curArmorMultiple);
+	QuadFieldQuery qfQuery;
+	quadField.GetQuads(qfQuery, scorer.ownerPos, scorer.scanRadius);
 
-				targetPriority *= angleMul;
-				targetPriority *= rangeMul;
-				targetPriority *= tgtPriorityMults[(dist2D > baseRange) * 6];
+	scores.clear();
 
-				if (targetLOSState & LOS_INLOS) {
-					targetPriority *= (secDamage + targetUnit->health);
+	// CUnit::tempNum is shared by all threads, use a private stamp instead
+	UnitVisitStamps& visited = unitVisitStamps[ThreadPool::GetThreadNum()];
 
-					if (paralyzer && targetUnit->paralyzeDamage > (modInfo.paralyzeOnMaxHealth? targetUnit->maxHealth: targetUnit->health))
-						targetPriority *= tgtPriorityMults[5];
+	if (visited.stamps.empty() || visited.curStamp == std::numeric_limits<int>::max()) {
+		visited.stamps.clear();
+		visited.stamps.resize(MAX_UNITS, 0);
+		visited.curStamp = 0;
+	}
 
-					if (weapon->hasTargetWeight)
-						targetPriority *= weapon->TargetWeight(targetUnit);
+	const int curStamp = ++visited.curStamp;
 
-				} else {
-					targetPriority *= (secDamage + 10000.0f);
-				}
+	for (int t = 0; t < teamHandler.ActiveAllyTeams(); ++t) {
+		if (teamHandler.Ally(weaponOwner->allyteam, t))
+			continue;
 
-				if (targetLOSState & LOS_PREVLOS) {
-					targetPriority /= (damageMul * targetUnit->power);
-					targetPriority *= tgtPriorityMults[((targetUnit->category & weapon->badTargetCategory) != 0) * 2];
-					targetPriority *= tgtPriorityMults[(targetUnit->IsCrashing()) * 3];
-					targetPriority *= tgtPriorityMults[(targetUnit == lastAttacker) * 4];
-				}
+		for (const int qi: *qfQuery.quads) {
+			const std::vector<CUnit*>& allyTeamUnits = quadField.GetQuad(qi).teamUnits[t];
 
-				const bool allowTarget = eventHandler.AllowWeaponTarget(weaponOwner->id, targetUnit->id, weapon->weaponNum, weaponDef->id, &targetPriority);
+			for (CUnit* targetUnit: allyTeamUnits) {
+				if (visited.stamps[targetUnit->id] == curStamp)
+					continue;
 
-				// Lua call may have changed tempNum, so needs to be set again
-				targetUnit->tempNum = tempNum;
+				visited.stamps[targetUnit->id] = curStamp;
 
-				if (!allowTarget)
+				SWeaponTargetScore score;
+
+				if (!scorer.Score(targetUnit, score))
 					continue;
 
-				targets.emplace_back(targetPriority, targetUnit);
+				scores.push_back(score);
 			}
 		}
 	}
 
-	std::stable_sort(targets.begin(), targets.end(), [](const std::pair<float, CUnit*>& a, const std::pair<float, CUnit*>& b) { return (a.first < b.first); });
+	return (scores.size());
+}
+
+size_t CGameHelper::CommitWeaponTargets(const CWeapon* weapon, const CUnit* avoidUnit, const std::vector<SWeaponTargetScore>& scores, std::vector<std::pair<float, CUnit*>>& targets)
+{
+	const CUnit* weaponOwner = weapon->owner;
+	const WeaponDef* weaponDef = weapon->weaponDef;
+
+	targets.clear();
+	targets.reserve(scores.size());
+
+	// candidates are visited in the same order as GenerateWeaponTargets would
+	for (const SWeaponTargetScore& score: scores) {
+		CUnit* targetUnit = score.unit;
+
+		// the target may have been killed between scoring and now
+		if (targetUnit->isDead && !modInfo.fireAtKilled)
+			continue;
+
+		float targetPriority = WeaponTargetPriority(weapon, score, avoidUnit);
+
+		if (!eventHandler.AllowWeaponTarget(weaponOwner->id, targetUnit->id, weapon->weaponNum, weaponDef->id, &targetPriority))
+			continue;
+
+		targets.emplace_back(targetPriority, targetUnit);
+	}
+
+	std::stable_sort(targets.begin(), targets.end(), WeaponTargetPairCmp);
 	return (targets.size());
 }
 
@@ -6,7 +6,9 @@
 #include "Sim/Projectiles/ExplosionListener.h"
 #include "Sim/Units/CommandAI/Command.h"
 #include "Sim/Misc/GlobalConstants.h"
+#include "Sim/Weapons/WeaponTarget.h"
 #include "System/EventClient.h"
+#include "System/Threading/ThreadPool.h"
 #include "System/float3.h"
 #include "System/float4.h"
 #include "System/type2.h"
@@ -156,6 +158,15 @@ public:
 
 	static size_t GenerateWeaponTargets(const CWeapon* weapon, const CUnit* avoidUnit, std::vector<std::pair<float, CUnit*>>& targets);
 
+	/**
+	 * Two-phase variant of GenerateWeaponTargets (modInfo.parallelWeaponTargeting).
+	 * ScoreWeaponTargets is safe to call from for_mt since it calls no Lua or unit
+	 * scripts; CommitWeaponTargets must run on the sim thread and applies the
+	 * deferred terms (avoidee, TargetWeight, AllowWeaponTarget) in scoring order.
+	 */
+	size_t ScoreWeaponTargets(const CWeapon* weapon, std::vector<SWeaponTargetScore>& scores);
+	static size_t CommitWeaponTargets(const CWeapon* weapon, const CUnit* avoidUnit, const std::vector<SWeaponTargetScore>& scores, std::vector<std::pair<float, CUnit*>>& targets);
+
 	void Init();
 	void Kill();
 	void Update();
@@ -211,6 +222,13 @@ private:
 	std::array<std::vector<WaitingDamage>, 128> waitingDamages;
 	static_assert (std::has_single_bit(std::tuple_size_v <decltype(waitingDamages)>), "Size is used in bit hax and must be 2^N");
 
+	// per-thread visit stamps, replace CUnit::tempNum in ScoreWeaponTargets
+	struct UnitVisitStamps {
+		std::vector<int> stamps;
+		int curStamp = 0;
+	};
+	std::array<UnitVisitStamps, ThreadPool::MAX_THREADS> unitVisitStamps;
+
 public:
 	std::vector<int> targetUnitIDs; // GetEnemyUnits{NoLosTest}
 	std::vector<std::pair<float, CUnit*>> targetPairs; // GenerateWeaponTargets
@@ -0,0 +1,253 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <thread>
+#include <vector>
+
+#include "LuaChunkCache.h"
+#include "LuaInclude.h"
+#include "Game/GameVersion.h"
+#include "System/Config/ConfigHandler.h"
+#include "System/FileSystem/DataDirsAccess.h"
+#include "System/FileSystem/FileQueryFlags.h"
+#include "System/FileSystem/FileSystem.h"
+#include "System/FileSystem/FileSystemAbstraction.h"
+#include "System/Misc/SpringTime.h"
+#include "lib/xxhash/xxh3.h"
+
+#include <fmt/format.h>
+
+#include "System/Misc/TracyDefs.h"
+
+#ifndef UNIT_TEST
+CONFIG(bool, LuaChunkCache)
+	.defaultValue(true)
+	.description("Keep compiled Lua chunks in the cache directory so unchanged sources need not be parsed again on the next launch.")
+	.readOnly(true)
+;
+CONFIG(int, LuaChunkCacheSize)
+	.defaultValue(128)
+	.minimumValue(0)
+	.description("Size in MB the compiled Lua chunk cache is trimmed to on startup, dropping the least recently used chunks first.")
+	.readOnly(true)
+;
+#endif
+
+
+static constexpr char     CHUNK_MAGIC[4] = {'S', 'L', 'C', 'C'};
+static constexpr uint32_t CHUNK_FORMAT = 1;
+
+// also matches the temporary files of interrupted writes
+static constexpr char CHUNK_FILE_REGEX[] = ".*\\.luac(\\.[0-9a-f]+\\.tmp)?";
+
+struct ChunkHeader {
+	char magic[4];
+	uint32_t format;
+	// hash of the Lua and engine versions the chunk was compiled by
+	uint64_t compilerHash;
+	uint64_t sourceSize;
+	// independent of the key hash, guards against file-name collisions
+	uint64_t sourceHash;
+};
+
+static std::atomic<uint32_t> numHits = {0};
+static std::atomic<uint32_t> numMisses = {0};
+static std::atomic<uint32_t> numStores = {0};
+static std::atomic<uint32_t> numRejects = {0};
+static std::atomic<uint64_t> loadMicros = {0};
+
+
+static uint64_t GetCompilerHash()
+{
+	// bytecode layout depends on the (locally modified) Lua core, so any
+	// engine build counts as a different compiler; lundump would reject
+	// chunks of another Lua version or number type on its own as well
+	static const uint64_t hash = [] {
+		const std::string ver = std::string(LUA_RELEASE) + "|" + LUA_VERSION + "|" + std::to_string(sizeof(lua_Number)) + "|" + SpringVersion::GetSync();
+		return XXH3_64bits(ver.data(), ver.size());
+	}();
+
+	return hash;
+}
+
+static const std::string& GetCacheDir()
+{
+	static const std::string dir = [] {
+	#ifndef UNIT_TEST
+		if (configHandler == nullptr || !configHandler->GetBool("LuaChunkCache"))
+			return std::string();
+
+		const std::string sep(1, FileSystemAbstraction::GetNativePathSeparator());
+		const std::string cacheDir = dataDirsAccess.LocateDir(FileSystem::GetCacheDir() + sep + "luachunks" + sep, FileQueryFlags::WRITE | FileQueryFlags::CREATE_DIRS);
+
+		// once per run, before any chunk of this run refreshes its timestamp
+		if (!cacheDir.empty())
+			LuaChunkCache::Prune(cacheDir, uint64_t(configHandler->GetInt("LuaChunkCacheSize")) << 20);
+
+		return cacheDir;
+	#else
+		return std::string();
+	#endif
+	}();
+
+	return dir;
+}
+
+static std::string GetChunkPath(const std::string& cacheDir, const std::string& code, const std::string& name)
+{
+	// the chunk name is baked into the bytecode (error messages, debug.getinfo)
+	const uint64_t nameHash = XXH3_64bits_withSeed(name.data(), name.size(), GetCompilerHash());
+	const uint64_t codeHash = XXH3_64bits_withSeed(code.data(), code.size(), nameHash);
+
+	return (FileSystem::EnsurePathSepAtEnd(cacheDir) + fmt::format("{:016x}.luac", codeHash));
+}
+
+
+static bool ReadChunk(const std::string& path, const std::string& code, std::vector<char>& chunk)
+{
+	FILE* file = fopen(path.c_str(), "rb");
+
+	if (file == nullptr)
+		return false;
+
+	ChunkHeader header;
+	bool valid = (fread(&header, sizeof(header), 1, file) == 1);
+
+	valid = valid && (memcmp(header.magic, CHUNK_MAGIC, sizeof(CHUNK_MAGIC)) == 0);
+	valid = valid && (header.format == CHUNK_FORMAT);
+	valid = valid && (header.compilerHash == GetCompilerHash());
+	valid = valid && (header.sourceSize == code.size());
+	valid = valid && (header.sourceHash == XXH3_64bits(code.data(), code.size()));
+
+	if (valid) {
+		fseek(file, 0, SEEK_END);
+		const long fileSize = ftell(file);
+		fseek(file, sizeof(header), SEEK_SET);
+
+		valid = (fileSize > long(sizeof(header)));
+
+		if (valid) {
+			chunk.resize(fileSize - sizeof(header));
+			valid = (fread(chunk.data(), chunk.size(), 1, file) == 1);
+		}
+	}
+
+	fclose(file);
+
+	if (!valid)
+		numRejects += 1;
+
+	return valid;
+}
+
+static int WriteChunkData(lua_State* L, const void* data, size_t size, void* ud)
+{
+	std::vector<char>* chunk = static_cast<std::vector<char>*>(ud);
+	chunk->insert(chunk->end(), static_cast<const char*>(data), static_cast<const char*>(data) + size);
+	return 0;
+}
+
+static void WriteChunk(lua_State* L, const std::string& path, const std::string& code)
+{
+	std::vector<char> chunk;
+
+	// function compiled from <code> is on top of the stack
+	if (lua_dump(L, WriteChunkData, &chunk) != 0 || chunk.empty())
+		return;
+
+	ChunkHeader header;
+	memcpy(header.magic, CHUNK_MAGIC, sizeof(CHUNK_MAGIC));
+	header.format = CHUNK_FORMAT;
+	header.compilerHash = GetCompilerHash();
+	header.sourceSize = code.size();
+	header.sourceHash = XXH3_64bits(code.data(), code.size());
+
+	// write to a private file first so concurrent loaders (or engine
+	// instances) never observe a partially written chunk under <path>
+	const uint64_t tmpSalt = std::hash<std::thread::id>{}(std::this_thread::get_id()) ^ spring_gettime().toNanoSecsi();
+	const std::string tmpPath = fmt::format("{}.{:x}.tmp", path, tmpSalt);
+	FILE* file = fopen(tmpPath.c_str(), "wb");
+
+	if (file == nullptr)
+		return;
+
+	bool written = true;
+	written = written && (fwrite(&header, sizeof(header), 1, file) == 1);
+	written = written && (fwrite(chunk.data(), chunk.size(), 1, file) == 1);
+	written = (fclose(file) == 0) && written;
+
+	if (!written || std::rename(tmpPath.c_str(), path.c_str()) != 0) {
+		std::remove(tmpPath.c_str());
+		return;
+	}
+
+	numStores += 1;
+}
+
+
+int LuaChunkCache::LoadBuffer(lua_State* L, const std::string& code, const std::string& name)
+{
+	return (LoadBuffer(L, code, name, GetCacheDir()));
+}
+
+int LuaChunkCache::LoadBuffer(lua_State* L, const std::string& code, const std::string& name, const std::string& cacheDir)
+{
+	RECOIL_DETAILED_TRACY_ZONE;
+
+	if (cacheDir.empty())
+		return (luaL_loadbuffer(L, code.c_str(), code.size(), name.c_str()));
+
+	const spring_time t0 = spring_gettime();
+	const std::string path = GetChunkPath(cacheDir, code, name);
+
+	std::vector<char> chunk;
+	int error = 0;
+
+	if (ReadChunk(path, code, chunk)) {
+		// lundump re-validates the bytecode header; on failure just recompile
+		if ((error = luaL_loadbuffer(L, chunk.data(), chunk.size(), name.c_str())) == 0) {
+			// keeps chunks in use from being pruned
+			FileSystemAbstraction::UpdateFileModificationTime(path);
+
+			numHits += 1;
+			loadMicros += (spring_gettime() - t0).toMicroSecsi();
+			return 0;
+		}
+
+		numRejects += 1;
+		lua_pop(L, 1);
+	}
+
+	numMisses += 1;
+
+	if ((error = luaL_loadbuffer(L, code.c_str(), code.size(), name.c_str())) == 0)
+		WriteChunk(L, path, code);
+
+	loadMicros += (spring_gettime() - t0).toMicroSecsi();
+	return error;
+}
+
+
+void LuaChunkCache::Prune(const std::string& cacheDir, uint64_t maxSize)
+{
+	RECOIL_DETAILED_TRACY_ZONE;
+	FileSystemAbstraction::PruneFiles(cacheDir, CHUNK_FILE_REGEX, maxSize);
+}
+
+
+LuaChunkCache::Stats LuaChunkCache::GetStats()
+{
+	return {numHits.load(), numMisses.load(), numStores.load(), numRejects.load(), loadMicros.load()};
+}
+
+void LuaChunkCache::ResetStats()
+{
+	numHits = 0;
+	numMisses = 0;
+	numStores = 0;
+	numRejects = 0;
+	loadMicros = 0;
+}
@@ -0,0 +1,41 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#ifndef LUA_CHUNK_CACHE_H
+#define LUA_CHUNK_CACHE_H
+
+#include <cstdint>
+#include <string>
+
+struct lua_State;
+
+/**
+ * Persistent cache of compiled Lua chunks, stored under the CacheDir.
+ *
+ * Entries are keyed by chunk name, source text and the Lua and engine
+ * versions, so a changed file or a different engine build never sees a
+ * stale chunk. Anything unreadable or mismatching is ignored and the source
+ * gets compiled as usual. Loading a chunk refreshes its modification time,
+ * and the cache is trimmed to LuaChunkCacheSize on first use.
+ */
+namespace LuaChunkCache {
+	struct Stats {
+		uint32_t hits;
+		uint32_t misses;
+		uint32_t stores;
+		uint32_t rejects;
+		uint64_t loadMicros;
+	};
+
+	/// drop-in replacement for luaL_loadbuffer; thread-safe
+	int LoadBuffer(lua_State* L, const std::string& code, const std::string& name);
+	/// as above, but caches in <cacheDir> instead of the configured directory
+	int LoadBuffer(lua_State* L, const std::string& code, const std::string& name, const std::string& cacheDir);
+
+	/// deletes the least recently used chunks until at most <maxSize> bytes are left
+	void Prune(const std::string& cacheDir, uint64_t maxSize);
+
+	Stats GetStats();
+	void ResetStats();
+};
+
+#endif /* LUA_CHUNK_CACHE_H */
@@ -7,6 +7,7 @@
 #include "LuaUI.h"
 
 #include "LuaCallInCheck.h"
+#include "LuaChunkCache.h"
 #include "LuaConfig.h"
 #include "LuaHashString.h"
 #include "LuaOpenGL.h"
@@ -37,6 +38,7 @@
 #include "Sim/Weapons/WeaponDef.h"
 #include "System/creg/SerializeLuaState.h"
 #include "System/Config/ConfigHandler.h"
+#include "System/EventBatch.h"
 #include "System/EventHandler.h"
 #include "System/Exceptions.h"
 #include "System/GlobalConfig.h"
@@ -59,6 +61,7 @@
 
 #include <algorithm>
 #include <string>
+#include <type_traits>
 
 
 CONFIG(float, LuaGarbageCollectionMemLoadMult).defaultValue(1.33f).minimumValue(1.0f).maximumValue(100.0f).description("How much the amount of Lua memory in use increases the rate of garbage collection.");
@@ -521,7 +524,7 @@ bool CLuaHandle::LoadCode(lua_State* L, std::string code, const string& debug)
 	const LuaUtils::ScopedDebugTraceBack traceBack(L);
 
 	LuaUtils::TracyRemoveAlsoExtras(code.data());
-	const int error = luaL_loadbuffer(L, code.c_str(), code.size(), debug.c_str());
+	const int error = LuaChunkCache::LoadBuffer(L, code, debug);
 
 	if (error != 0) {
 		LOG_L(L_ERROR, "[%s::%s] error=%i (%s) debug=%s msg=%s", name.c_str(), __func__, error, LuaErrorString(error), debug.c_str(), lua_tostring(L, -1));
@@ -1363,6 +1366,97 @@ void CLuaHandle::UnitDamaged(
 	RunCallInTraceback(L, cmdStr, argCount, 0, traceBack.GetErrFuncIdx(), false);
 }
 
+enum {
+	BATCH_ARRAYS_UNIT_DAMAGED     =  0,
+	BATCH_ARRAYS_UNIT_ENTERED_LOS = 10,
+	BATCH_ARRAYS_UNIT_LEFT_LOS    = 14,
+	BATCH_ARRAYS_COUNT            = 18,
+};
+
+template<typename T>
+void CLuaHandle::PushBatchArray(lua_State* L, size_t index, const std::vector<T>& values)
+{
+	if (batchArrays.empty())
+		batchArrays.resize(BATCH_ARRAYS_COUNT, {LUA_NOREF, 0});
+
+	auto& [ref, size] = batchArrays[index];
+
+	if (ref == LUA_NOREF) {
+		lua_createtable(L, values.size(), 0);
+		lua_pushvalue(L, -1);
+		ref = luaL_ref(L, LUA_REGISTRYINDEX);
+	} else {
+		lua_rawgeti(L, LUA_REGISTRYINDEX, ref);
+	}
+
+	for (size_t i = 0; i < values.size(); i++) {
+		if constexpr (std::is_same_v<T, uint8_t>) {
+			lua_pushboolean(L, values[i]);
+		} else {
+			lua_pushnumber(L, values[i]);
+		}
+
+		lua_rawseti(L, -2, i + 1);
+	}
+
+	// clear what is left of a longer previous batch so that #array stays valid
+	for (size_t i = values.size(); i < size; i++) {
+		lua_pushnil(L);
+		lua_rawseti(L, -2, i + 1);
+	}
+
+	size = values.size();
+}
+
+/*** Called once per frame, just before GameFramePost, with every UnitDamaged
+ * event of that frame. Only delivered to handles with full read access.
+ *
+ * Each parameter except the count is an array with one entry per event, in
+ * the order the events happened. The units may no longer exist. The arrays
+ * are reused and overwritten by the next call; copy what has to be kept.
+ *
+ * @function Callins:UnitDamagedBatch
+ * @param unitIDs integer[]
+ * @param unitDefIDs integer[]
+ * @param unitTeams integer[]
+ * @param damages number[]
+ * @param paralyzers boolean[]
+ * @param weaponDefIDs integer[]
+ * @param projectileIDs integer[]
+ * @param attackerIDs integer[] -1 where there was no attacker
+ * @param attackerDefIDs integer[] -1 where there was no attacker
+ * @param attackerTeams integer[] -1 where there was no attacker
+ * @param count integer
+ */
+void CLuaHandle::UnitDamagedBatch(const UnitDamagedEventBatch& batch)
+{
+	RECOIL_DETAILED_TRACY_ZONE;
+	LUA_CALL_IN_CHECK(L);
+	luaL_checkstack(L, 13, __func__);
+
+	static const LuaHashString cmdStr(__func__);
+	const LuaUtils::ScopedDebugTraceBack traceBack(L);
+
+	if (!cmdStr.GetGlobalFunc(L))
+		return;
+
+	PushBatchArray(L, BATCH_ARRAYS_UNIT_DAMAGED + 0, batch.unitIDs);
+	PushBatchArray(L, BATCH_ARRAYS_UNIT_DAMAGED + 1, batch.unitDefIDs);
+	PushBatchArray(L, BATCH_ARRAYS_UNIT_DAMAGED + 2, batch.unitTeams);
+	PushBatchArray(L, BATCH_ARRAYS_UNIT_DAMAGED + 3, batch.damages);
+	PushBatchArray(L, BATCH_ARRAYS_UNIT_DAMAGED + 4, batch.paralyzers);
+	PushBatchArray(L, BATCH_ARRAYS_UNIT_DAMAGED + 5, batch.weaponDefIDs);
+	PushBatchArray(L, BATCH_ARRAYS_UNIT_DAMAGED + 6, batch.projectileIDs);
+	PushBatchArray(L, BATCH_ARRAYS_UNIT_DAMAGED + 7, batch.attackerIDs);
+	PushBatchArray(L, BATCH_ARRAYS_UNIT_DAMAGED + 8, batch.attackerDefIDs);
+	PushBatchArray(L, BATCH_ARRAYS_UNIT_DAMAGED + 9, batch.attackerTeams);
+	lua_pushnumber(L, batch.size());
+
+	// call the routine
+	RunCallInTraceback(L, cmdStr, 11, 0, traceBack.GetErrFuncIdx(), false);
+}
+
+
 /*** Called when a unit changes its stun status.
  *
  * @function Callins:UnitStunned
@@ -1589,6 +1683,63 @@ void CLuaHandle::UnitLeftLos(const CUnit* unit, int allyTeam)
 }
 
 
+void CLuaHandle::LosBatchCallIn(const LuaHashString& hs, const UnitLosEventBatch& batch, size_t firstArray)
+{
+	RECOIL_DETAILED_TRACY_ZONE;
+	LUA_CALL_IN_CHECK(L);
+	luaL_checkstack(L, 7, __func__);
+	if (!hs.GetGlobalFunc(L))
+		return;
+
+	PushBatchArray(L, firstArray + 0, batch.unitIDs);
+	PushBatchArray(L, firstArray + 1, batch.unitTeams);
+	PushBatchArray(L, firstArray + 2, batch.allyTeams);
+	PushBatchArray(L, firstArray + 3, batch.unitDefIDs);
+	lua_pushnumber(L, batch.size());
+
+	// call the routine
+	RunCallIn(L, hs, 5, 0);
+}
+
+
+/***
+ * Called once per frame, just before GameFramePost, with every UnitEnteredLos
+ * event of that frame. Only delivered to handles with full read access.
+ * The arrays are reused like those of UnitDamagedBatch.
+ *
+ * @function Callins:UnitEnteredLosBatch
+ * @param unitIDs integer[]
+ * @param unitTeams integer[]
+ * @param allyTeams integer[]
+ * @param unitDefIDs integer[]
+ * @param count integer
+ */
+void CLuaHandle::UnitEnteredLosBatch(const UnitLosEventBatch& batch)
+{
+	static const LuaHashString hs(__func__);
+	LosBatchCallIn(hs, batch, BATCH_ARRAYS_UNIT_ENTERED_LOS);
+}
+
+
+/***
+ * Called once per frame, just before GameFramePost, with every UnitLeftLos
+ * event of that frame. Only delivered to handles with full read access.
+ * The arrays are reused like those of UnitDamagedBatch.
+ *
+ * @function Callins:UnitLeftLosBatch
+ * @param unitIDs integer[]
+ * @param unitTeams integer[]
+ * @param allyTeams integer[]
+ * @param unitDefIDs integer[]
+ * @param count integer
+ */
+void CLuaHandle::UnitLeftLosBatch(const UnitLosEventBatch& batch)
+{
+	static const LuaHashString hs(__func__);
+	LosBatchCallIn(hs, batch, BATCH_ARRAYS_UNIT_LEFT_LOS);
+}
+
+
 /******************************************************************************
  * Transport
  * @section transport
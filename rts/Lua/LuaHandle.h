@@ -142,6 +142,7 @@ class CLuaHandle : public CEventClient
 			int projectileID,
 			bool paralyzer
 		) override;
+		void UnitDamagedBatch(const UnitDamagedEventBatch& batch) override;
 		void UnitStunned(const CUnit* unit, bool stunned) override;
 		void UnitExperience(const CUnit* unit, float oldExperience) override;
 		void UnitHarvestStorageFull(const CUnit* unit) override;
@@ -152,6 +153,8 @@ class CLuaHandle : public CEventClient
 		void UnitEnteredLos(const CUnit* unit, int allyTeam) override;
 		void UnitLeftRadar(const CUnit* unit, int allyTeam) override;
 		void UnitLeftLos(const CUnit* unit, int allyTeam) override;
+		void UnitEnteredLosBatch(const UnitLosEventBatch& batch) override;
+		void UnitLeftLosBatch(const UnitLosEventBatch& batch) override;
 
 		void UnitEnteredUnderwater(const CUnit* unit) override;
 		void UnitEnteredWater(const CUnit* unit) override;
@@ -320,6 +323,9 @@ class CLuaHandle : public CEventClient
 		bool RunCallIn(lua_State* L, const LuaHashString& hs, int inArgs, int outArgs);
 
 		void LosCallIn(const LuaHashString& hs, const CUnit* unit, int allyTeam);
+		void LosBatchCallIn(const LuaHashString& hs, const UnitLosEventBatch& batch, size_t firstArray);
+		template<typename T>
+		void PushBatchArray(lua_State* L, size_t index, const std::vector<T>& values);
 		void UnitCallIn(const LuaHashString& hs, const CUnit* unit);
 
 		void RunDrawCallIn(const LuaHashString& hs);
@@ -348,6 +354,10 @@ class CLuaHandle : public CEventClient
 		std::vector<bool> watchExplosionDefs;   // callin masks for Explosion
 		std::vector<bool> watchAllowTargetDefs; // callin masks for AllowWeapon*Target*
 
+		// registry refs and lengths of the arrays passed to *Batch call-ins,
+		// refilled on every call instead of creating new tables each frame
+		std::vector<std::pair<int, size_t>> batchArrays;
+
 	private: // call-outs
 		static int KillActiveHandle(lua_State* L);
 		static int CallOutGetName(lua_State* L);
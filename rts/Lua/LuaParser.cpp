@@ -11,6 +11,8 @@
 #include "System/float3.h"
 #include "System/float4.h"
 #include "LuaInclude.h"
+#include "LuaChunkCache.h"
+#include "LuaTableSnapshot.h"
 
 #include "LuaConstGame.h"
 #include "LuaConstEngine.h"
@@ -237,7 +239,14 @@ bool LuaParser::Execute()
 	int errorNum = 0;
 
 	LuaUtils::TracyRemoveAlsoExtras(code.data());
-	if ((errorNum = luaL_loadbuffer(L, code.c_str(), code.size(), codeLabel.c_str())) != 0) {
+
+	// only cache files, text chunks are typically generated per game
+	if (textChunk.empty())
+		errorNum = LuaChunkCache::LoadBuffer(L, code, codeLabel);
+	else
+		errorNum = luaL_loadbuffer(L, code.c_str(), code.size(), codeLabel.c_str());
+
+	if (errorNum != 0) {
 		SNPRINTF(errorBuf, sizeof(errorBuf), "[loadbuf] error %d (\"%s\") in %s", errorNum, lua_tostring(L, -1), codeLabel.c_str());
 		LUA_CLOSE(&L);
 
@@ -291,6 +300,59 @@ bool LuaParser::Execute()
 	return (valid = true);
 }
 
+bool LuaParser::ExecuteSnapshot(const std::vector<std::uint8_t>& snapshot)
+{
+	if (!IsValid()) {
+		errorLog = "could not initialize Lua library";
+		return false;
+	}
+
+	assert(rootRef == LUA_NOREF);
+	assert(initDepth == 0);
+
+	if (!LuaTableSnapshot::Read(L, snapshot.data(), snapshot.size())) {
+		// leave the parser usable for a regular Execute
+		errorLog = "invalid root table snapshot";
+		return false;
+	}
+
+	initDepth = -1;
+	rootRef = luaL_ref(L, LUA_REGISTRYINDEX);
+	lua_settop(L, 0);
+
+	return (valid = true);
+}
+
+bool LuaParser::GetRootSnapshot(std::vector<std::uint8_t>& snapshot)
+{
+	if (!valid || rootRef == LUA_NOREF)
+		return false;
+
+	lua_rawgeti(L, LUA_REGISTRYINDEX, rootRef);
+	const bool ret = LuaTableSnapshot::Write(L, -1, snapshot);
+	lua_pop(L, 1);
+
+	return ret;
+}
+
+bool LuaParser::ReloadRootFromSnapshot(std::vector<std::uint8_t>& snapshot)
+{
+	// LuaTable's hold references into the current root
+	assert(tables.empty());
+
+	if (!GetRootSnapshot(snapshot))
+		return false;
+
+	if (!LuaTableSnapshot::Read(L, snapshot.data(), snapshot.size()))
+		return false;
+
+	luaL_unref(L, LUA_REGISTRYINDEX, rootRef);
+	rootRef = luaL_ref(L, LUA_REGISTRYINDEX);
+	lua_settop(L, 0);
+
+	return true;
+}
+
 
 void LuaParser::AddTable(LuaTable* tbl) { spring::VectorInsertUnique(tables, tbl); }
 void LuaParser::RemoveTable(LuaTable* tbl) { spring::VectorErase(tables, tbl); }
@@ -526,6 +588,7 @@ int LuaParser::Random(lua_State* L)
 {
 	// both US and DS depend on LuaParser via MapParser, etc
 	#if (!defined(UNITSYNC) && !defined(DEDICATED))
+	GetLuaParser(L)->usedRandom = true;
 
 	switch (lua_gettop(L)) {
 		case 0: {
@@ -644,7 +707,7 @@ int LuaParser::Include(lua_State* L)
 	}
 
 	LuaUtils::TracyRemoveAlsoExtras(code.data());
-	int error = luaL_loadbuffer(L, code.c_str(), code.size(), filename.c_str());
+	int error = LuaChunkCache::LoadBuffer(L, code, filename);
 	if (error != 0) {
 		char buf[1024];
 		SNPRINTF(buf, sizeof(buf), "error = %i, %s, %s\n", error, filename.c_str(), lua_tostring(L, -1));
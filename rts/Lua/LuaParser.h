@@ -3,6 +3,7 @@
 #ifndef LUA_PARSER_H
 #define LUA_PARSER_H
 
+#include <cstdint>
 #include <string>
 #include <vector>
 
@@ -132,6 +133,11 @@ public:
 	void SetupLua(bool isSyncedCtxt, bool isDefsParser);
 
 	bool Execute();
+	/// alternative to Execute, uses a root table saved by GetRootSnapshot
+	bool ExecuteSnapshot(const std::vector<std::uint8_t>& snapshot);
+	bool GetRootSnapshot(std::vector<std::uint8_t>& snapshot);
+	/// replaces the root by its rebuilt snapshot, s.t. it iterates like one from ExecuteSnapshot
+	bool ReloadRootFromSnapshot(std::vector<std::uint8_t>& snapshot);
 	bool IsValid() const { return (L != nullptr); } // true if nothing failed during Execute
 	bool NoTable() const { return (errorLog.find("no return table") == 0); } // parser is still valid if true
 
@@ -141,6 +147,8 @@ public:
 	}
 
 	const std::string& GetErrorLog() const { return errorLog; }
+	/// true if evaluation consumed synced random numbers
+	bool UsedRandom() const { return usedRandom; }
 
 	// for setting up the initial params table
 	void GetTable(int index,               bool overwrite = false);
@@ -191,6 +199,7 @@ private:
 	bool valid = false;
 	bool lowerKeys = false; // convert all returned keys to lower case
 	bool lowerCppKeys = false; // convert strings in arguments keys to lower case
+	bool usedRandom = false;
 
 private:
 	// Weird call-outs
@@ -233,6 +233,7 @@ bool LuaSyncedRead::PushEntries(lua_State* L)
 	REGISTER_LUA_CFUNC(GetUnitDirection);
 	REGISTER_LUA_CFUNC(GetUnitHeading);
 	REGISTER_LUA_CFUNC(GetUnitVelocity);
+	REGISTER_LUA_CFUNC(GetUnitsStateBulk);
 	REGISTER_LUA_CFUNC(GetUnitBuildFacing);
 	REGISTER_LUA_CFUNC(GetUnitIsBuilding);
 	REGISTER_LUA_CFUNC(GetUnitWorkerTask);
@@ -4570,6 +4571,243 @@ int LuaSyncedRead::GetUnitVelocity(lua_State* L)
 }
 
 
+enum BulkUnitField {
+	BULK_UNIT_FIELD_VISIBILITY,
+	BULK_UNIT_FIELD_POSITION,
+	BULK_UNIT_FIELD_MIDPOSITION,
+	BULK_UNIT_FIELD_AIMPOSITION,
+	BULK_UNIT_FIELD_VELOCITY,
+	BULK_UNIT_FIELD_HEALTH,
+	BULK_UNIT_FIELD_DIRECTION,
+	BULK_UNIT_FIELD_HEADING,
+	BULK_UNIT_FIELD_UNITDEFID,
+	BULK_UNIT_FIELD_TEAM,
+	BULK_UNIT_FIELD_COUNT,
+};
+
+static constexpr struct {
+	const char* name;
+	int numValues;
+} BULK_UNIT_FIELDS[BULK_UNIT_FIELD_COUNT] = {
+	{"visibility" , 1},
+	{"position"   , 3},
+	{"midPosition", 3},
+	{"aimPosition", 3},
+	{"velocity"   , 4},
+	{"health"     , 5},
+	{"direction"  , 9},
+	{"heading"    , 1},
+	{"unitDefID"  , 1},
+	{"team"       , 1},
+};
+
+/*** Reads the state of many units at once into a flat array
+ *
+ * Fills one array with the requested fields of every unit in turn: the values
+ * of the `i`-th unit occupy entries `(i - 1) * stride + 1` to `i * stride`, in
+ * the order the fields were given. Each field yields the same
+ * values as its single-unit counterpart and is subject to the same LOS and
+ * ally checks; values that function would not return are 0, so the array
+ * never has holes.
+ *
+ * Fields: "visibility" (1, 0 for dead or hidden units, 1 on radar only, 2 in
+ * LOS), "position" (3, base position as GetUnitPosition), "midPosition" (3),
+ * "aimPosition" (3), "velocity" (4, as GetUnitVelocity), "health" (5, as
+ * GetUnitHealth), "direction" (9, as GetUnitDirection), "heading" (1),
+ * "unitDefID" (1) and "team" (1). A unitDefID of 0 means the type is unknown,
+ * a maxHealth of 0 that the health values are hidden.
+ *
+ * Passing the array returned by a previous call as `out` avoids allocating a
+ * new one; only the first `#unitIDs * stride` entries are written. The flat
+ * layout can be uploaded as-is into a LuaVBO.
+ *
+ * @function Spring.GetUnitsStateBulk
+ * @param unitIDs integer[]
+ * @param fields string[]
+ * @param out table? array to fill instead of creating a new one
+ * @return number[] values
+ * @return integer stride number of values per unit
+ */
+int LuaSyncedRead::GetUnitsStateBulk(lua_State* L)
+{
+	luaL_checktype(L, 1, LUA_TTABLE);
+	luaL_checktype(L, 2, LUA_TTABLE);
+
+	std::array<BulkUnitField, BULK_UNIT_FIELD_COUNT * 2> fields;
+	size_t numFields = 0;
+	int stride = 0;
+
+	for (int i = 1; ; i++) {
+		lua_rawgeti(L, 2, i);
+
+		if (lua_isnil(L, -1)) {
+			lua_pop(L, 1);
+			break;
+		}
+
+		const char* fieldName = luaL_checkstring(L, -1);
+		const auto fieldIter = std::find_if(std::begin(BULK_UNIT_FIELDS), std::end(BULK_UNIT_FIELDS), [&](const auto& f) { return (strcmp(f.name, fieldName) == 0); });
+
+		if (fieldIter == std::end(BULK_UNIT_FIELDS))
+			luaL_error(L, "[%s] unknown field \"%s\"", __func__, fieldName);
+		if (numFields == fields.size())
+			luaL_error(L, "[%s] too many fields", __func__);
+
+		fields[numFields++] = static_cast<BulkUnitField>(fieldIter - std::begin(BULK_UNIT_FIELDS));
+		stride += fieldIter->numValues;
+
+		lua_pop(L, 1);
+	}
+
+	const int numUnits = lua_objlen(L, 1);
+
+	if (lua_istable(L, 3)) {
+		lua_pushvalue(L, 3);
+	} else {
+		lua_createtable(L, numUnits * stride, 0);
+	}
+
+	const int outIndex = lua_gettop(L);
+	int outKey = 1;
+
+	const auto SetNumber = [&](float value) {
+		lua_pushnumber(L, value);
+		lua_rawseti(L, outIndex, outKey++);
+	};
+	const auto SetZeros = [&](int count) {
+		for (int i = 0; i < count; i++) {
+			SetNumber(0.0f);
+		}
+	};
+	const auto SetVector = [&](const float3& v) {
+		SetNumber(v.x);
+		SetNumber(v.y);
+		SetNumber(v.z);
+	};
+
+	for (int i = 1; i <= numUnits; i++) {
+		lua_rawgeti(L, 1, i);
+		const CUnit* unit = lua_isnumber(L, -1)? unitHandler.GetUnit(lua_toint(L, -1)): nullptr;
+		lua_pop(L, 1);
+
+		const bool isVisible = (unit != nullptr) && LuaUtils::IsUnitVisible(L, unit);
+		const bool isInLos = isVisible && LuaUtils::IsUnitInLos(L, unit);
+		const bool isAlly = isVisible && LuaUtils::IsAllyUnit(L, unit);
+
+		float3 errorVec;
+
+		// same radar wobble as GetSolidObjectPosition
+		if (isVisible && !isAlly)
+			errorVec = unit->GetLuaErrorVector(CLuaHandle::GetHandleReadAllyTeam(L), CLuaHandle::GetHandleFullRead(L));
+
+		for (size_t j = 0; j < numFields; j++) {
+			const BulkUnitField field = fields[j];
+
+			switch (field) {
+				case BULK_UNIT_FIELD_VISIBILITY: {
+					SetNumber(isVisible + isInLos);
+				} break;
+
+				case BULK_UNIT_FIELD_POSITION:
+				case BULK_UNIT_FIELD_MIDPOSITION:
+				case BULK_UNIT_FIELD_AIMPOSITION: {
+					if (!isVisible) {
+						SetZeros(3);
+						break;
+					}
+
+					switch (field) {
+						case BULK_UNIT_FIELD_POSITION   : { SetVector(unit->pos    + errorVec); } break;
+						case BULK_UNIT_FIELD_MIDPOSITION: { SetVector(unit->midPos + errorVec); } break;
+						default                         : { SetVector(unit->aimPos + errorVec); } break;
+					}
+				} break;
+
+				case BULK_UNIT_FIELD_VELOCITY: {
+					if (!isInLos) {
+						SetZeros(4);
+						break;
+					}
+
+					SetVector(unit->speed);
+					SetNumber(unit->speed.w);
+				} break;
+
+				case BULK_UNIT_FIELD_HEALTH: {
+					if (!isInLos) {
+						SetZeros(5);
+						break;
+					}
+
+					const UnitDef* ud = unit->unitDef;
+
+					if (ud->hideDamage && !isAlly) {
+						SetZeros(3);
+					} else if (isAlly || (ud->decoyDef == nullptr)) {
+						SetNumber(unit->health);
+						SetNumber(unit->maxHealth);
+						SetNumber(unit->paralyzeDamage);
+					} else {
+						const float scale = (ud->decoyDef->health / ud->health);
+						SetNumber(scale * unit->health);
+						SetNumber(scale * unit->maxHealth);
+						SetNumber(scale * unit->paralyzeDamage);
+					}
+
+					SetNumber(unit->captureProgress);
+					SetNumber(unit->buildProgress);
+				} break;
+
+				case BULK_UNIT_FIELD_DIRECTION: {
+					if (!isInLos) {
+						SetZeros(9);
+						break;
+					}
+
+					SetVector(unit->frontdir);
+					SetVector(unit->rightdir);
+					SetVector(unit->updir);
+				} break;
+
+				case BULK_UNIT_FIELD_HEADING: {
+					if (!isInLos) {
+						SetZeros(1);
+						break;
+					}
+
+					SetNumber(unit->heading);
+				} break;
+
+				case BULK_UNIT_FIELD_UNITDEFID: {
+					if (!isVisible || (!isAlly && !LuaUtils::IsUnitTyped(L, unit))) {
+						SetZeros(1);
+						break;
+					}
+
+					SetNumber(isAlly? unit->unitDef->id: LuaUtils::EffectiveUnitDef(L, unit)->id);
+				} break;
+
+				case BULK_UNIT_FIELD_TEAM: {
+					if (!isVisible) {
+						SetZeros(1);
+						break;
+					}
+
+					SetNumber(unit->team);
+				} break;
+
+				default: {
+					assert(false);
+				} break;
+			}
+		}
+	}
+
+	lua_pushnumber(L, stride);
+	return 2;
+}
+
+
 /***
  *
  * @function Spring.GetUnitBuildFacing
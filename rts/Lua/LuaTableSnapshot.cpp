@@ -0,0 +1,300 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+#include "LuaTableSnapshot.h"
+#include "LuaInclude.h"
+#include "System/UnorderedMap.hpp"
+
+enum {
+	TAG_FALSE    = 0,
+	TAG_TRUE     = 1,
+	TAG_NUMBER   = 2,
+	TAG_STRING   = 3,
+	// followed by the array- and hash-part sizes, then that many key-value pairs
+	TAG_TABLE    = 4,
+	// followed by the index of an earlier TAG_TABLE
+	TAG_TABLEREF = 5,
+};
+
+static constexpr int MAX_DEPTH = 256;
+
+
+namespace {
+	struct Key {
+		// numbers first, then booleans, then strings
+		bool operator < (const Key& k) const {
+			if (type != k.type)
+				return (TypeRank() < k.TypeRank());
+			if (type != LUA_TSTRING)
+				return (number < k.number);
+
+			const int cmp = memcmp(string, k.string, std::min(length, k.length));
+			return ((cmp < 0) || (cmp == 0 && length < k.length));
+		}
+
+		int TypeRank() const { return ((type == LUA_TNUMBER)? 0: ((type == LUA_TBOOLEAN)? 1: 2)); }
+
+		int type = LUA_TNIL;
+		lua_Number number = 0;
+		const char* string = nullptr;
+		size_t length = 0;
+	};
+
+	struct Writer {
+		bool WriteValue(int index, int depth);
+		bool WriteTable(int index, int depth);
+
+		template<typename T> void Put(const T& v) {
+			const std::uint8_t* p = reinterpret_cast<const std::uint8_t*>(&v);
+			data.insert(data.end(), p, p + sizeof(T));
+		}
+
+		lua_State* L;
+		std::vector<std::uint8_t>& data;
+		spring::unordered_map<const void*, std::uint32_t> tables;
+	};
+
+	struct Reader {
+		bool ReadValue(int depth);
+		bool ReadTable(int depth);
+
+		template<typename T> bool Get(T& v) {
+			if ((end - ptr) < ptrdiff_t(sizeof(T)))
+				return false;
+
+			memcpy(&v, ptr, sizeof(T));
+			ptr += sizeof(T);
+			return true;
+		}
+
+		lua_State* L;
+		const std::uint8_t* ptr;
+		const std::uint8_t* end;
+
+		// stack index of a table mapping TAG_TABLE indices to their tables
+		int tablesIndex;
+		std::uint32_t numTables;
+	};
+}
+
+
+bool Writer::WriteValue(int index, int depth)
+{
+	switch (lua_type(L, index)) {
+		case LUA_TBOOLEAN: {
+			Put<std::uint8_t>(lua_toboolean(L, index)? TAG_TRUE: TAG_FALSE);
+		} break;
+		case LUA_TNUMBER: {
+			Put<std::uint8_t>(TAG_NUMBER);
+			Put<lua_Number>(lua_tonumber(L, index));
+		} break;
+		case LUA_TSTRING: {
+			size_t len = 0;
+			const char* str = lua_tolstring(L, index, &len);
+
+			Put<std::uint8_t>(TAG_STRING);
+			Put<std::uint32_t>(len);
+			data.insert(data.end(), str, str + len);
+		} break;
+		case LUA_TTABLE: {
+			return (WriteTable(index, depth + 1));
+		} break;
+		default: {
+			return false;
+		} break;
+	}
+
+	return true;
+}
+
+bool Writer::WriteTable(int index, int depth)
+{
+	const void* table = lua_topointer(L, index);
+	const auto it = tables.find(table);
+
+	if (it != tables.end()) {
+		Put<std::uint8_t>(TAG_TABLEREF);
+		Put<std::uint32_t>(it->second);
+		return true;
+	}
+
+	if (depth > MAX_DEPTH || !lua_checkstack(L, 6))
+		return false;
+
+	if (lua_getmetatable(L, index))
+		return false;
+
+	tables.emplace(table, tables.size());
+
+	// keys are written in a fixed order, so equal tables give equal snapshots
+	// and rebuild into tables that iterate the same way (whichever order the
+	// source table happened to hold its keys in)
+	std::vector<Key> keys;
+
+	for (lua_pushnil(L); lua_next(L, index) != 0; lua_pop(L, 1)) {
+		Key& key = keys.emplace_back();
+
+		switch ((key.type = lua_type(L, -2))) {
+			case LUA_TBOOLEAN: { key.number = lua_toboolean(L, -2); } break;
+			case LUA_TNUMBER : { key.number = lua_tonumber(L, -2); } break;
+			// the string stays referenced by the table while it is written
+			case LUA_TSTRING : { key.string = lua_tolstring(L, -2, &key.length); } break;
+			// table keys have no stable order
+			default: { return false; } break;
+		}
+	}
+
+	std::sort(keys.begin(), keys.end());
+
+	std::uint32_t numArray = 0;
+
+	while (numArray < keys.size() && keys[numArray].type == LUA_TNUMBER && keys[numArray].number == (numArray + 1))
+		numArray += 1;
+
+	Put<std::uint8_t>(TAG_TABLE);
+	Put<std::uint32_t>(numArray);
+	Put<std::uint32_t>(keys.size() - numArray);
+
+	for (const Key& key: keys) {
+		switch (key.type) {
+			case LUA_TBOOLEAN: { lua_pushboolean(L, key.number != 0); } break;
+			case LUA_TNUMBER : { lua_pushnumber(L, key.number); } break;
+			case LUA_TSTRING : { lua_pushlstring(L, key.string, key.length); } break;
+		}
+
+		lua_pushvalue(L, -1);
+		lua_rawget(L, index);
+
+		const int top = lua_gettop(L);
+
+		// on failure the caller resets the stack
+		if (!WriteValue(top - 1, depth) || !WriteValue(top, depth))
+			return false;
+
+		lua_pop(L, 2);
+	}
+
+	return true;
+}
+
+
+bool Reader::ReadValue(int depth)
+{
+	std::uint8_t tag = 0;
+
+	if (!Get(tag))
+		return false;
+
+	switch (tag) {
+		case TAG_FALSE:
+		case TAG_TRUE: {
+			lua_pushboolean(L, tag == TAG_TRUE);
+		} break;
+		case TAG_NUMBER: {
+			lua_Number n = 0;
+
+			if (!Get(n))
+				return false;
+
+			lua_pushnumber(L, n);
+		} break;
+		case TAG_STRING: {
+			std::uint32_t len = 0;
+
+			if (!Get(len) || (end - ptr) < ptrdiff_t(len))
+				return false;
+
+			lua_pushlstring(L, reinterpret_cast<const char*>(ptr), len);
+			ptr += len;
+		} break;
+		case TAG_TABLE: {
+			return (ReadTable(depth + 1));
+		} break;
+		case TAG_TABLEREF: {
+			std::uint32_t idx = 0;
+
+			if (!Get(idx) || idx >= numTables)
+				return false;
+
+			lua_rawgeti(L, tablesIndex, idx + 1);
+		} break;
+		default: {
+			return false;
+		} break;
+	}
+
+	return true;
+}
+
+bool Reader::ReadTable(int depth)
+{
+	std::uint32_t numArray = 0;
+	std::uint32_t numHash = 0;
+
+	if (depth > MAX_DEPTH || !lua_checkstack(L, 4))
+		return false;
+	if (!Get(numArray) || !Get(numHash))
+		return false;
+	// every pair takes at least four bytes, reject bogus sizes before allocating
+	if ((uint64_t(numArray) + numHash) * 4 > uint64_t(end - ptr))
+		return false;
+
+	lua_createtable(L, numArray, numHash);
+	lua_pushvalue(L, -1);
+	lua_rawseti(L, tablesIndex, ++numTables);
+
+	for (uint64_t i = 0, n = uint64_t(numArray) + numHash; i < n; i++) {
+		if (!ReadValue(depth) || !ReadValue(depth))
+			return false;
+		// lua_rawset raises an error on NaN keys
+		if (lua_isnumber(L, -2) && lua_tonumber(L, -2) != lua_tonumber(L, -2))
+			return false;
+
+		lua_rawset(L, -3);
+	}
+
+	return true;
+}
+
+
+bool LuaTableSnapshot::Write(lua_State* L, int index, std::vector<std::uint8_t>& data)
+{
+	if (!lua_istable(L, index))
+		return false;
+
+	const size_t size = data.size();
+	const int top = lua_gettop(L);
+
+	Writer writer{L, data, {}};
+
+	if (!writer.WriteTable((index > 0)? index: (top + index + 1), 0)) {
+		lua_settop(L, top);
+		data.resize(size);
+		return false;
+	}
+
+	assert(lua_gettop(L) == top);
+	return true;
+}
+
+bool LuaTableSnapshot::Read(lua_State* L, const std::uint8_t* data, size_t size)
+{
+	const int top = lua_gettop(L);
+
+	lua_newtable(L);
+
+	Reader reader{L, data, data + size, lua_gettop(L), 0};
+	std::uint8_t tag = 0;
+
+	if (!reader.Get(tag) || tag != TAG_TABLE || !reader.ReadTable(0) || reader.ptr != reader.end) {
+		lua_settop(L, top);
+		return false;
+	}
+
+	// drop the table-index table
+	lua_remove(L, -2);
+	return true;
+}
@@ -0,0 +1,26 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#ifndef LUA_TABLE_SNAPSHOT_H
+#define LUA_TABLE_SNAPSHOT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct lua_State;
+
+/**
+ * Flat binary copy of a table tree holding only booleans, numbers, strings
+ * and tables. Shared and cyclic table references are preserved; tables with
+ * metatables, table keys or values of any other type make Write fail. Keys
+ * are stored sorted, so a table read back iterates in an order that depends
+ * only on its contents.
+ */
+namespace LuaTableSnapshot {
+	/// appends the table at <index> to <data>
+	bool Write(lua_State* L, int index, std::vector<std::uint8_t>& data);
+	/// pushes the table stored in <data>, or nothing if it is malformed
+	bool Read(lua_State* L, const std::uint8_t* data, size_t size);
+};
+
+#endif /* LUA_TABLE_SNAPSHOT_H */
@@ -5,6 +5,7 @@
 #include <string_view>
 
 #include "LuaVFS.h"
+#include "LuaChunkCache.h"
 #include "LuaInclude.h"
 #include "LuaHandle.h"
 #include "LuaHashString.h"
@@ -328,7 +329,7 @@ int LuaVFS::Include(lua_State* L, bool synced)
 	}
 
 	LuaUtils::TracyRemoveAlsoExtras(fileData.data());
-	if ((luaError = luaL_loadbuffer(L, fileData.c_str(), fileData.size(), fileName.c_str())) != 0) {
+	if ((luaError = LuaChunkCache::LoadBuffer(L, fileData, fileName)) != 0) {
 		const auto buf = fmt::format("[LuaVFS::{}(synced={})][loadbuf] file={} error={} ({}) cenv={} vfsmode={}", __func__, synced, fileName, luaError, lua_tostring(L, -1), hasCustomEnv, mode);
 		lua_pushlstring(L, buf.c_str(), buf.size());
 		lua_error(L);
@@ -0,0 +1,254 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include <algorithm>
+
+#include "DerivedHeightMaps.h"
+#include "Sim/Misc/GlobalConstants.h"
+#include "System/SpringMath.h"
+
+static_assert((DerivedHeightMaps::TILE_SIZE >> (DerivedHeightMaps::NUM_MIPS - 1)) >= 1, "tiles must cover whole squares of the smallest mip");
+
+
+// inclusive bounds of the squares each stage writes; face normals need one
+// extra ring and the (half-resolution) slopemap one more beyond that
+static SRectangle GetFaceRect(const MapDimensions& dims, const SRectangle& rect)
+{
+	return {
+		std::max(          0, rect.x1 - 1),
+		std::max(          0, rect.z1 - 1),
+		std::min(dims.mapxm1, rect.x2 + 1),
+		std::min(dims.mapym1, rect.z2 + 1),
+	};
+}
+
+static SRectangle GetSlopeRect(const MapDimensions& dims, const SRectangle& rect)
+{
+	return {
+		std::max(             0, (rect.x1 / 2) - 1),
+		std::max(             0, (rect.z1 / 2) - 1),
+		std::min(dims.hmapx - 1, (rect.x2 / 2) + 1),
+		std::min(dims.hmapy - 1, (rect.z2 / 2) + 1),
+	};
+}
+
+
+static void UpdateCenterHeightmap(const DerivedHeightMaps::Maps& maps, const SRectangle& rect, const SRectangle& tile)
+{
+	const MapDimensions& dims = maps.dims;
+	const float* heightmapSynced = maps.cornerHeights;
+
+	const int x1 = std::max(rect.x1, tile.x1);
+	const int z1 = std::max(rect.z1, tile.z1);
+	const int x2 = std::min(rect.x2, tile.x2);
+	const int z2 = std::min(rect.z2, tile.z2);
+
+	for (int y = z1; y <= z2; y++) {
+		for (int x = x1; x <= x2; x++) {
+			const int idxTL = (y + 0) * dims.mapxp1 + x + 0;
+			const int idxTR = (y + 0) * dims.mapxp1 + x + 1;
+			const int idxBL = (y + 1) * dims.mapxp1 + x + 0;
+			const int idxBR = (y + 1) * dims.mapxp1 + x + 1;
+
+			const int index = y * dims.mapx + x;
+			const float height =
+				heightmapSynced[idxTL] +
+				heightmapSynced[idxTR] +
+				heightmapSynced[idxBL] +
+				heightmapSynced[idxBR];
+			maps.centerHeights[index] = height * 0.25f;
+			maps.maxHeights[index] = std::max
+					( std::max(heightmapSynced[idxTL], heightmapSynced[idxTR])
+					, std::max(heightmapSynced[idxBL], heightmapSynced[idxBR])
+					);
+		}
+	}
+}
+
+
+static void UpdateMipHeightmaps(const DerivedHeightMaps::Maps& maps, const SRectangle& rect, const SRectangle& tile)
+{
+	for (int i = 0; i < DerivedHeightMaps::NUM_MIPS - 1; i++) {
+		const int hmapx = maps.dims.mapx >> i;
+
+		// tile bounds are even at every level, so each tile reads and
+		// writes exactly the squares the full-rectangle update would
+		const int sx = std::max((rect.x1 >> i) & (~1), tile.x1 >> i);
+		const int ex = std::min((rect.x2 >> i), (tile.x2 + 1) >> i);
+		const int sy = std::max((rect.z1 >> i) & (~1), tile.z1 >> i);
+		const int ey = std::min((rect.z2 >> i), (tile.z2 + 1) >> i);
+
+		const float* topMipMap = maps.mipHeights[i    ];
+		      float* subMipMap = maps.mipHeights[i + 1];
+
+		for (int y = sy; y < ey; y += 2) {
+			for (int x = sx; x < ex; x += 2) {
+				const float height =
+					topMipMap[(x    ) + (y    ) * hmapx] +
+					topMipMap[(x    ) + (y + 1) * hmapx] +
+					topMipMap[(x + 1) + (y    ) * hmapx] +
+					topMipMap[(x + 1) + (y + 1) * hmapx];
+				subMipMap[(x / 2) + (y / 2) * hmapx / 2] = height * 0.25f;
+			}
+		}
+	}
+}
+
+
+static void UpdateFaceNormals(const DerivedHeightMaps::Maps& maps, const SRectangle& rect, const SRectangle& tile, bool initialize)
+{
+	const MapDimensions& dims = maps.dims;
+	const float* heightmapSynced = maps.cornerHeights;
+
+	const int z1 = std::max(rect.z1, tile.z1);
+	const int x1 = std::max(rect.x1, tile.x1);
+	const int z2 = std::min(rect.z2, tile.z2);
+	const int x2 = std::min(rect.x2, tile.x2);
+
+	for (int y = z1; y <= z2; y++) {
+		float3 fnTL;
+		float3 fnBR;
+
+		for (int x = x1; x <= x2; x++) {
+			const int idxTL = (y    ) * dims.mapxp1 + x; // TL
+			const int idxBL = (y + 1) * dims.mapxp1 + x; // BL
+
+			const float& hTL = heightmapSynced[idxTL    ];
+			const float& hTR = heightmapSynced[idxTL + 1];
+			const float& hBL = heightmapSynced[idxBL    ];
+			const float& hBR = heightmapSynced[idxBL + 1];
+
+			// normal of top-left triangle (face) in square
+			//
+			//  *---> e1
+			//  |
+			//  |
+			//  v
+			//  e2
+			//const float3 e1( SQUARE_SIZE, hTR - hTL,           0);
+			//const float3 e2(           0, hBL - hTL, SQUARE_SIZE);
+			//const float3 fnTL = (e2.cross(e1)).Normalize();
+			fnTL.y = SQUARE_SIZE;
+			fnTL.x = - (hTR - hTL);
+			fnTL.z = - (hBL - hTL);
+			fnTL.Normalize();
+
+			// normal of bottom-right triangle (face) in square
+			//
+			//         e3
+			//         ^
+			//         |
+			//         |
+			//  e4 <---*
+			//const float3 e3(-SQUARE_SIZE, hBL - hBR,           0);
+			//const float3 e4(           0, hTR - hBR,-SQUARE_SIZE);
+			//const float3 fnBR = (e4.cross(e3)).Normalize();
+			fnBR.y = SQUARE_SIZE;
+			fnBR.x = (hBL - hBR);
+			fnBR.z = (hTR - hBR);
+			fnBR.Normalize();
+
+			maps.faceNormalsSynced[(y * dims.mapx + x) * 2    ] = fnTL;
+			maps.faceNormalsSynced[(y * dims.mapx + x) * 2 + 1] = fnBR;
+			// square-normal
+			maps.centerNormalsSynced[y * dims.mapx + x] = (fnTL + fnBR).Normalize();
+			maps.centerNormals2D[y * dims.mapx + x] = (fnTL + fnBR).Normalize2D();
+
+			if (initialize) {
+				maps.faceNormalsUnsynced[(y * dims.mapx + x) * 2    ] = maps.faceNormalsSynced[(y * dims.mapx + x) * 2    ];
+				maps.faceNormalsUnsynced[(y * dims.mapx + x) * 2 + 1] = maps.faceNormalsSynced[(y * dims.mapx + x) * 2 + 1];
+				maps.centerNormalsUnsynced[y * dims.mapx + x] = maps.centerNormalsSynced[y * dims.mapx + x];
+			}
+		}
+	}
+}
+
+
+static void UpdateSlopemap(const DerivedHeightMaps::Maps& maps, const SRectangle& rect, const SRectangle& tile)
+{
+	const MapDimensions& dims = maps.dims;
+	const float3* faceNormalsSynced = maps.faceNormalsSynced;
+
+	// rect is in slopemap (half-resolution) squares, tiles have even bounds
+	const int sx = std::max(rect.x1, tile.x1 / 2);
+	const int ex = std::min(rect.x2, tile.x2 / 2);
+	const int sy = std::max(rect.z1, tile.z1 / 2);
+	const int ey = std::min(rect.z2, tile.z2 / 2);
+
+	for (int y = sy; y <= ey; y++) {
+		for (int x = sx; x <= ex; x++) {
+			const int idx0 = (y*2    ) * (dims.mapx) + x*2;
+			const int idx1 = (y*2 + 1) * (dims.mapx) + x*2;
+
+			float avgslope = 0.0f;
+			avgslope += faceNormalsSynced[(idx0    ) * 2    ].y;
+			avgslope += faceNormalsSynced[(idx0    ) * 2 + 1].y;
+			avgslope += faceNormalsSynced[(idx0 + 1) * 2    ].y;
+			avgslope += faceNormalsSynced[(idx0 + 1) * 2 + 1].y;
+			avgslope += faceNormalsSynced[(idx1    ) * 2    ].y;
+			avgslope += faceNormalsSynced[(idx1    ) * 2 + 1].y;
+			avgslope += faceNormalsSynced[(idx1 + 1) * 2    ].y;
+			avgslope += faceNormalsSynced[(idx1 + 1) * 2 + 1].y;
+			avgslope *= 0.125f;
+
+			float maxslope =              faceNormalsSynced[(idx0    ) * 2    ].y;
+			maxslope = std::min(maxslope, faceNormalsSynced[(idx0    ) * 2 + 1].y);
+			maxslope = std::min(maxslope, faceNormalsSynced[(idx0 + 1) * 2    ].y);
+			maxslope = std::min(maxslope, faceNormalsSynced[(idx0 + 1) * 2 + 1].y);
+			maxslope = std::min(maxslope, faceNormalsSynced[(idx1    ) * 2    ].y);
+			maxslope = std::min(maxslope, faceNormalsSynced[(idx1    ) * 2 + 1].y);
+			maxslope = std::min(maxslope, faceNormalsSynced[(idx1 + 1) * 2    ].y);
+			maxslope = std::min(maxslope, faceNormalsSynced[(idx1 + 1) * 2 + 1].y);
+
+			// smooth it a bit, so small holes don't block huge tanks
+			const float lerp = maxslope / avgslope;
+			const float slope = mix(maxslope, avgslope, lerp);
+
+			maps.slopeMap[y * dims.hmapx + x] = 1.0f - slope;
+		}
+	}
+}
+
+
+int2 DerivedHeightMaps::GetNumTiles(const MapDimensions& dims)
+{
+	return {
+		(dims.mapx + TILE_SIZE - 1) / TILE_SIZE,
+		(dims.mapy + TILE_SIZE - 1) / TILE_SIZE,
+	};
+}
+
+SRectangle DerivedHeightMaps::GetTile(const MapDimensions& dims, int tileIdx)
+{
+	const int numTilesX = GetNumTiles(dims).x;
+	const int x1 = (tileIdx % numTilesX) * TILE_SIZE;
+	const int z1 = (tileIdx / numTilesX) * TILE_SIZE;
+
+	return {x1, z1, std::min(x1 + TILE_SIZE, dims.mapx) - 1, std::min(z1 + TILE_SIZE, dims.mapy) - 1};
+}
+
+void DerivedHeightMaps::GetUpdateTiles(const MapDimensions& dims, const SRectangle& rect, std::vector<int>& tiles)
+{
+	const SRectangle faceRect = GetFaceRect(dims, rect);
+	const SRectangle slopeRect = GetSlopeRect(dims, rect);
+
+	// the slope region is the largest of the three
+	const int numTilesX = GetNumTiles(dims).x;
+	const int tx1 = std::min(faceRect.x1, slopeRect.x1 * 2) / TILE_SIZE;
+	const int tz1 = std::min(faceRect.z1, slopeRect.z1 * 2) / TILE_SIZE;
+	const int tx2 = std::max(faceRect.x2, slopeRect.x2 * 2 + 1) / TILE_SIZE;
+	const int tz2 = std::max(faceRect.z2, slopeRect.z2 * 2 + 1) / TILE_SIZE;
+
+	for (int tz = tz1; tz <= tz2; tz++) {
+		for (int tx = tx1; tx <= tx2; tx++) {
+			tiles.push_back(tz * numTilesX + tx);
+		}
+	}
+}
+
+void DerivedHeightMaps::UpdateTile(const Maps& maps, const SRectangle& rect, const SRectangle& tile, bool initialize)
+{
+	UpdateCenterHeightmap(maps, rect, tile);
+	UpdateMipHeightmaps(maps, rect, tile); // must happen after UpdateCenterHeightmap()!
+	UpdateFaceNormals(maps, GetFaceRect(maps.dims, rect), tile, initialize);
+	UpdateSlopemap(maps, GetSlopeRect(maps.dims, rect), tile); // must happen after UpdateFaceNormals()!
+}
@@ -0,0 +1,59 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#ifndef DERIVED_HEIGHT_MAPS_H
+#define DERIVED_HEIGHT_MAPS_H
+
+#include <array>
+#include <vector>
+
+#include "MapDimensions.h"
+#include "System/float3.h"
+#include "System/Rectangle.h"
+#include "System/type2.h"
+
+/**
+ * The maps CReadMap derives from the synced corner heightmap: center and
+ * max heights, MIP heights, face and center normals and the slopemap.
+ *
+ * Updates are split into TILE_SIZE x TILE_SIZE tiles that each run every
+ * stage on their own. Tile bounds are even at every MIP level and match
+ * the slopemap's 2x2 squares, so a stage only reads squares of its own
+ * tile or squares the update does not write, and tiles can be processed
+ * in any order (or in parallel) with bit-identical results.
+ */
+namespace DerivedHeightMaps {
+	/// size (in heightmap squares) of the tiles derived maps are updated in
+	static constexpr int TILE_SIZE = 64;
+	/// number of heightmap mipmaps, including full resolution
+	static constexpr int NUM_MIPS = 7;
+
+	struct Maps {
+		MapDimensions dims;
+
+		const float* cornerHeights;
+
+		float* centerHeights;
+		float* maxHeights;
+		/// [0] is centerHeights, each further level has half the resolution
+		std::array<float*, NUM_MIPS> mipHeights;
+
+		float3* faceNormalsSynced;
+		float3* faceNormalsUnsynced;
+		float3* centerNormalsSynced;
+		float3* centerNormalsUnsynced;
+		float3* centerNormals2D;
+
+		float* slopeMap;
+	};
+
+	int2 GetNumTiles(const MapDimensions& dims);
+	/// inclusive bounds of tile <tileIdx>, in center-heightmap squares
+	SRectangle GetTile(const MapDimensions& dims, int tileIdx);
+	/// appends the indices of all tiles an update of <rect> writes to
+	void GetUpdateTiles(const MapDimensions& dims, const SRectangle& rect, std::vector<int>& tiles);
+
+	/// recomputes the part of <tile> that an update of the (inclusive) <rect> covers
+	void UpdateTile(const Maps& maps, const SRectangle& rect, const SRectangle& tile, bool initialize);
+};
+
+#endif /* DERIVED_HEIGHT_MAPS_H */
@@ -6,6 +6,7 @@
 
 #include "xsimd/xsimd.hpp"
 #include "ReadMap.h"
+#include "DerivedHeightMaps.h"
 #include "MapDamage.h"
 #include "MapInfo.h"
 #include "MetalMap.h"
@@ -94,6 +95,8 @@ CR_REG_METADATA(CReadMap, (
 	CR_IGNORED(sharedSlopeMaps),
 
 	CR_IGNORED(unsyncedHeightMapUpdates),
+	CR_IGNORED(updateTiles),
+	CR_IGNORED(dirtyNormalTiles),
 
 	/*
 	CR_IGNORED(  syncedHeightMapDigests),
@@ -372,6 +375,9 @@ void CReadMap::Initialize()
 	slopeMap.clear();
 	slopeMap.resize(mapDims.hmapx * mapDims.hmapy);
 
+	dirtyNormalTiles.clear();
+	dirtyNormalTiles.resize(DerivedHeightMaps::GetNumTiles(mapDims).x * DerivedHeightMaps::GetNumTiles(mapDims).y, 0);
+
 	// by default, all squares are set to terrain-type 0
 	typeMap.clear();
 	typeMap.resize(mapDims.hmapx * mapDims.hmapy, 0);
@@ -532,10 +538,7 @@ void CReadMap::UpdateHeightMapSynced(const SRectangle& hgtMapRect)
 	const SRectangle centerRect = {std::max(mins.x, 0), std::max(mins.y, 0),  std::min(maxs.x, mapDims.mapxm1),  std::min(maxs.y, mapDims.mapym1)};
 	const SRectangle cornerRect = {std::max(mins.x, 0), std::max(mins.y, 0),  std::min(maxs.x, mapDims.mapx  ),  std::min(maxs.y, mapDims.mapy  )};
 
-	UpdateCenterHeightmap(centerRect, initialize);
-	UpdateMipHeightmaps(centerRect, initialize);
-	UpdateFaceNormals(centerRect, initialize);
-	UpdateSlopemap(centerRect, initialize); // must happen after UpdateFaceNormals()!
+	UpdateDerivedHeightMaps(centerRect, initialize);
 
 	// push the unsynced update; initial one without LOS check
 	if (initialize) {
@@ -613,171 +616,37 @@ void CReadMap::UpdateHeightBounds()
 	currHeightBounds.y = tempHeightBounds.y;
 }
 
-void CReadMap::UpdateCenterHeightmap(const SRectangle& rect, bool initialize) const
+void CReadMap::UpdateDerivedHeightMaps(const SRectangle& rect, bool initialize)
 {
 	RECOIL_DETAILED_TRACY_ZONE;
-	const float* heightmapSynced = GetCornerHeightMapSynced();
-
-	for_mt_chunk(rect.z1, rect.z2 + 1, [heightmapSynced, &rect](const int y) {
-		for (int x = rect.x1; x <= rect.x2; x++) {
-			const int idxTL = (y + 0) * mapDims.mapxp1 + x + 0;
-			const int idxTR = (y + 0) * mapDims.mapxp1 + x + 1;
-			const int idxBL = (y + 1) * mapDims.mapxp1 + x + 0;
-			const int idxBR = (y + 1) * mapDims.mapxp1 + x + 1;
-
-			const int index = y * mapDims.mapx + x;
-			const float height =
-				heightmapSynced[idxTL] +
-				heightmapSynced[idxTR] +
-				heightmapSynced[idxBL] +
-				heightmapSynced[idxBR];
-			centerHeightMap[index] = height * 0.25f;
-			maxHeightMap[index] = std::max
-					( std::max(heightmapSynced[idxTL], heightmapSynced[idxTR])
-					, std::max(heightmapSynced[idxBL], heightmapSynced[idxBR])
-					);
-		}
-	}, 256);
-}
+	static_assert(numHeightMipMaps == DerivedHeightMaps::NUM_MIPS);
+
+	const DerivedHeightMaps::Maps maps = {
+		mapDims,
+		GetCornerHeightMapSynced(),
+		centerHeightMap.data(),
+		maxHeightMap.data(),
+		mipPointerHeightMaps,
+		faceNormalsSynced.data(),
+		faceNormalsUnsynced.data(),
+		centerNormalsSynced.data(),
+		centerNormalsUnsynced.data(),
+		centerNormals2D.data(),
+		slopeMap.data(),
+	};
 
+	updateTiles.clear();
+	DerivedHeightMaps::GetUpdateTiles(mapDims, rect, updateTiles);
 
-void CReadMap::UpdateMipHeightmaps(const SRectangle& rect, bool initialize)
-{
-	RECOIL_DETAILED_TRACY_ZONE;
-	for (int i = 0; i < numHeightMipMaps - 1; i++) {
-		const int hmapx = mapDims.mapx >> i;
-
-		const int sx = (rect.x1 >> i) & (~1);
-		const int ex = (rect.x2 >> i);
-		const int sy = (rect.z1 >> i) & (~1);
-		const int ey = (rect.z2 >> i);
-
-		float* topMipMap = mipPointerHeightMaps[i    ];
-		float* subMipMap = mipPointerHeightMaps[i + 1];
-
-		for (int y = sy; y < ey; y += 2) {
-			for (int x = sx; x < ex; x += 2) {
-				const float height =
-					topMipMap[(x    ) + (y    ) * hmapx] +
-					topMipMap[(x    ) + (y + 1) * hmapx] +
-					topMipMap[(x + 1) + (y    ) * hmapx] +
-					topMipMap[(x + 1) + (y + 1) * hmapx];
-				subMipMap[(x / 2) + (y / 2) * hmapx / 2] = height * 0.25f;
-			}
-		}
+	for (const int tileIdx: updateTiles) {
+		// initialization also writes the unsynced normals
+		dirtyNormalTiles[tileIdx] = !initialize;
 	}
-}
-
-
-void CReadMap::UpdateFaceNormals(const SRectangle& rect, bool initialize)
-{
-	RECOIL_DETAILED_TRACY_ZONE;
-	const float* heightmapSynced = GetCornerHeightMapSynced();
-
-	const int z1 = std::max(             0, rect.z1 - 1);
-	const int x1 = std::max(             0, rect.x1 - 1);
-	const int z2 = std::min(mapDims.mapym1, rect.z2 + 1);
-	const int x2 = std::min(mapDims.mapxm1, rect.x2 + 1);
-
-	for_mt_chunk(z1, z2 + 1, [&](const int y) {
-		float3 fnTL;
-		float3 fnBR;
-
-		for (int x = x1; x <= x2; x++) {
-			const int idxTL = (y    ) * mapDims.mapxp1 + x; // TL
-			const int idxBL = (y + 1) * mapDims.mapxp1 + x; // BL
-
-			const float& hTL = heightmapSynced[idxTL    ];
-			const float& hTR = heightmapSynced[idxTL + 1];
-			const float& hBL = heightmapSynced[idxBL    ];
-			const float& hBR = heightmapSynced[idxBL + 1];
-
-			// normal of top-left triangle (face) in square
-			//
-			//  *---> e1
-			//  |
-			//  |
-			//  v
-			//  e2
-			//const float3 e1( SQUARE_SIZE, hTR - hTL,           0);
-			//const float3 e2(           0, hBL - hTL, SQUARE_SIZE);
-			//const float3 fnTL = (e2.cross(e1)).Normalize();
-			fnTL.y = SQUARE_SIZE;
-			fnTL.x = - (hTR - hTL);
-			fnTL.z = - (hBL - hTL);
-			fnTL.Normalize();
-
-			// normal of bottom-right triangle (face) in square
-			//
-			//         e3
-			//         ^
-			//         |
-			//         |
-			//  e4 <---*
-			//const float3 e3(-SQUARE_SIZE, hBL - hBR,           0);
-			//const float3 e4(           0, hTR - hBR,-SQUARE_SIZE);
-			//const float3 fnBR = (e4.cross(e3)).Normalize();
-			fnBR.y = SQUARE_SIZE;
-			fnBR.x = (hBL - hBR);
-			fnBR.z = (hTR - hBR);
-			fnBR.Normalize();
-
-			faceNormalsSynced[(y * mapDims.mapx + x) * 2    ] = fnTL;
-			faceNormalsSynced[(y * mapDims.mapx + x) * 2 + 1] = fnBR;
-			// square-normal
-			centerNormalsSynced[y * mapDims.mapx + x] = (fnTL + fnBR).Normalize();
-			centerNormals2D[y * mapDims.mapx + x] = (fnTL + fnBR).Normalize2D();
-
-			if (initialize) {
-				faceNormalsUnsynced[(y * mapDims.mapx + x) * 2    ] = faceNormalsSynced[(y * mapDims.mapx + x) * 2    ];
-				faceNormalsUnsynced[(y * mapDims.mapx + x) * 2 + 1] = faceNormalsSynced[(y * mapDims.mapx + x) * 2 + 1];
-				centerNormalsUnsynced[y * mapDims.mapx + x] = centerNormalsSynced[y * mapDims.mapx + x];
-			}
-		}
-	}, 64);
-}
-
 
-void CReadMap::UpdateSlopemap(const SRectangle& rect, bool initialize)
-{
-	RECOIL_DETAILED_TRACY_ZONE;
-	const int sx = std::max(0,                 (rect.x1 / 2) - 1);
-	const int ex = std::min(mapDims.hmapx - 1, (rect.x2 / 2) + 1);
-	const int sy = std::max(0,                 (rect.z1 / 2) - 1);
-	const int ey = std::min(mapDims.hmapy - 1, (rect.z2 / 2) + 1);
-
-	for_mt_chunk(sy, ey + 1, [sx, ex](const int y) {
-		for (int x = sx; x <= ex; x++) {
-			const int idx0 = (y*2    ) * (mapDims.mapx) + x*2;
-			const int idx1 = (y*2 + 1) * (mapDims.mapx) + x*2;
-
-			float avgslope = 0.0f;
-			avgslope += faceNormalsSynced[(idx0    ) * 2    ].y;
-			avgslope += faceNormalsSynced[(idx0    ) * 2 + 1].y;
-			avgslope += faceNormalsSynced[(idx0 + 1) * 2    ].y;
-			avgslope += faceNormalsSynced[(idx0 + 1) * 2 + 1].y;
-			avgslope += faceNormalsSynced[(idx1    ) * 2    ].y;
-			avgslope += faceNormalsSynced[(idx1    ) * 2 + 1].y;
-			avgslope += faceNormalsSynced[(idx1 + 1) * 2    ].y;
-			avgslope += faceNormalsSynced[(idx1 + 1) * 2 + 1].y;
-			avgslope *= 0.125f;
-
-			float maxslope =              faceNormalsSynced[(idx0    ) * 2    ].y;
-			maxslope = std::min(maxslope, faceNormalsSynced[(idx0    ) * 2 + 1].y);
-			maxslope = std::min(maxslope, faceNormalsSynced[(idx0 + 1) * 2    ].y);
-			maxslope = std::min(maxslope, faceNormalsSynced[(idx0 + 1) * 2 + 1].y);
-			maxslope = std::min(maxslope, faceNormalsSynced[(idx1    ) * 2    ].y);
-			maxslope = std::min(maxslope, faceNormalsSynced[(idx1    ) * 2 + 1].y);
-			maxslope = std::min(maxslope, faceNormalsSynced[(idx1 + 1) * 2    ].y);
-			maxslope = std::min(maxslope, faceNormalsSynced[(idx1 + 1) * 2 + 1].y);
-
-			// smooth it a bit, so small holes don't block huge tanks
-			const float lerp = maxslope / avgslope;
-			const float slope = mix(maxslope, avgslope, lerp);
-
-			slopeMap[y * mapDims.hmapx + x] = 1.0f - slope;
-		}
-	}, 128);
+	// tiles are independent, see DerivedHeightMaps.h
+	for_mt(0, static_cast<int>(updateTiles.size()), [&](const int i) {
+		DerivedHeightMaps::UpdateTile(maps, rect, DerivedHeightMaps::GetTile(mapDims, updateTiles[i]), initialize);
+	});
 }
 
 
@@ -906,14 +775,38 @@ namespace {
 	void CopySyncedToUnsyncedImpl(const std::vector<T>& src, std::vector<T>& dst) {
 		std::copy(src.begin(), src.end(), dst.begin());
 	};
+
+	template<typename T>
+	void CopySyncedToUnsyncedImpl(const std::vector<T>& src, std::vector<T>& dst, const SRectangle& tile, int elemsPerSquare) {
+		const int rowBeg = tile.x1 * elemsPerSquare;
+		const int rowEnd = (tile.x2 + 1) * elemsPerSquare;
+
+		for (int y = tile.z1; y <= tile.z2; y++) {
+			const int rowIdx = y * mapDims.mapx * elemsPerSquare;
+
+			std::copy(src.begin() + rowIdx + rowBeg, src.begin() + rowIdx + rowEnd, dst.begin() + rowIdx + rowBeg);
+		}
+	};
 }
 
 void CReadMap::CopySyncedToUnsynced()
 {
 	RECOIL_DETAILED_TRACY_ZONE;
+	// corners can also be changed without a synced update (by explosions
+	// in progress), but normals are only rewritten in dirty tiles
 	CopySyncedToUnsyncedImpl(*heightMapSyncedPtr, *heightMapUnsyncedPtr);
-	CopySyncedToUnsyncedImpl(faceNormalsSynced, faceNormalsUnsynced);
-	CopySyncedToUnsyncedImpl(centerNormalsSynced, centerNormalsUnsynced);
+
+	for_mt(0, static_cast<int>(dirtyNormalTiles.size()), [&](const int tileIdx) {
+		if (!dirtyNormalTiles[tileIdx])
+			return;
+
+		const SRectangle tile = DerivedHeightMaps::GetTile(mapDims, tileIdx);
+
+		CopySyncedToUnsyncedImpl(faceNormalsSynced, faceNormalsUnsynced, tile, 2);
+		CopySyncedToUnsyncedImpl(centerNormalsSynced, centerNormalsUnsynced, tile, 1);
+	});
+
+	std::fill(dirtyNormalTiles.begin(), dirtyNormalTiles.end(), 0);
 	eventHandler.UnsyncedHeightMapUpdate(SRectangle{ 0, 0, mapDims.mapx, mapDims.mapy });
 }
 
@@ -233,10 +233,7 @@ private:
 	void UpdateHeightBounds(int syncFrame);
 	void UpdateTempHeightBoundsSIMD(size_t begin, size_t end);
 
-	void UpdateCenterHeightmap(const SRectangle& rect, bool initialize) const;
-	void UpdateMipHeightmaps(const SRectangle& rect, bool initialize);
-	void UpdateFaceNormals(const SRectangle& rect, bool initialize);
-	void UpdateSlopemap(const SRectangle& rect, bool initialize);
+	void UpdateDerivedHeightMaps(const SRectangle& rect, bool initialize);
 
 	inline void HeightMapUpdateLOSCheck(const SRectangle& hgtMapRect);
 	inline bool HasHeightMapViewChanged(const int2 losMapPos);
@@ -299,6 +296,11 @@ private:
 	static std::vector<uint8_t>   syncedHeightMapDigests;
 	static std::vector<uint8_t> unsyncedHeightMapDigests;
 
+	/// tiles touched by the current synced update
+	std::vector<int> updateTiles;
+	/// tiles whose synced normals changed since the last CopySyncedToUnsynced
+	std::vector<uint8_t> dirtyNormalTiles;
+
 	uint32_t mapChecksum = 0;
 
 	bool processingHeightBounds = false;
@@ -47,6 +47,8 @@ public:
 	bool isLocal = false;
 	bool isReconn = false;
 	bool isMidgameJoin = false;
+	/// link is a CRelayConnection
+	bool isRelayed = false;
 
 	PlayerStatistics lastStats;
 
@@ -13,6 +13,7 @@
 
 #include "GameParticipant.h"
 #include "GameSkirmishAI.h"
+#include "SpectatorRelay.h"
 #include "AutohostInterface.h"
 
 #include "Game/ClientSetup.h"
@@ -75,6 +76,8 @@ CONFIG(bool, WhiteListAdditionalPlayers).defaultValue(true);
 CONFIG(bool, ServerRecordDemos).defaultValue(false).dedicatedValue(true);
 CONFIG(bool, ServerLogInfoMessages).defaultValue(false);
 CONFIG(bool, ServerLogDebugMessages).defaultValue(false);
+CONFIG(int, SpectatorRelayThreads).defaultValue(0).minimumValue(0).maximumValue(16).description("Number of threads that send game data to remote spectators, so that large audiences do not slow down the server thread. 0 sends to everyone from the server thread.");
+CONFIG(int, SpectatorRelayDelay).defaultValue(0).minimumValue(0).description("Number of sim-frames by which relayed spectators trail the game, 0 for none. Requires SpectatorRelayThreads.");
 CONFIG(std::string, AutohostIP).defaultValue("127.0.0.1");
 
 
@@ -170,6 +173,9 @@ void CGameServer::Initialize()
 	if (!myGameSetup->onlyLocal)
 		udpListener.reset(new netcode::UDPListener(myClientSetup->hostPort, myClientSetup->hostIP));
 
+	if (udpListener != nullptr && configHandler->GetInt("SpectatorRelayThreads") > 0)
+		spectatorRelay.reset(new CSpectatorRelay(configHandler->GetInt("SpectatorRelayThreads"), configHandler->GetInt("SpectatorRelayDelay")));
+
 	AddAutohostInterface(StringToLower(configHandler->GetString("AutohostIP")), configHandler->GetInt("AutohostPort"));
 	Message(spring::format(ServerStart, myClientSetup->hostPort), false);
 
@@ -423,12 +429,19 @@ void CGameServer::SkipTo(int targetFrameNum)
 		if (udpListener == nullptr) { continue; }
 		if ((serverFrameNum % 20) != 0) { continue; }
 
+		// relayed links also receive through the listener
+		if (spectatorRelay != nullptr)
+			spectatorRelay->Wait();
+
 		// send data every few frames, as otherwise packets would grow too big
 		udpListener->Update();
 	}
 
 	Broadcast(std::shared_ptr<const netcode::RawPacket>(endMsg.Pack()));
 
+	if (spectatorRelay != nullptr)
+		spectatorRelay->Wait();
+
 	if (udpListener != nullptr)
 		udpListener->Update();
 
@@ -890,7 +903,9 @@ void CGameServer::LagProtection()
 	for (GameParticipant& player: players) {
 		if (player.myState == GameParticipant::INGAME) {
 			// send info about the players
-			const int curPing = ((serverFrameNum - player.lastFrameResponse) * 1000) / (GAME_SPEED * internalSpeed);
+			// relayed spectators trail the game on purpose
+			const int relayDelay = player.isRelayed? spectatorRelay->GetFrameDelay(): 0;
+			const int curPing = (std::max(serverFrameNum - player.lastFrameResponse - relayDelay, 0) * 1000) / (GAME_SPEED * internalSpeed);
 			Broadcast(CBaseNetProtocol::Get().SendPlayerInfo(player.id, player.cpuUsage, curPing));
 
 			const float playerCpuUsage = player.cpuUsage;
@@ -899,7 +914,7 @@ void CGameServer::LagProtection()
 			if (player.isReconn && curPing < 2 * GAME_SPEED)
 				player.isReconn = false;
 
-			if ((player.isLocal) || (demoReader ? !player.isFromDemo : !player.spectator)) {
+			if ((player.isLocal) || (demoReader ? (!player.isFromDemo && !player.isRelayed) : !player.spectator)) {
 				if (!player.isReconn && correctedCpu > refCpuUsage)
 					refCpuUsage = correctedCpu;
 				cpu.push_back(correctedCpu);
@@ -2720,14 +2735,26 @@ void CGameServer::UpdateLoop()
 		while (!quitServer) {
 			spring_msecs(loopSleepTime).sleep(true);
 
+			// relayed links also receive through the listener
+			if (spectatorRelay != nullptr)
+				spectatorRelay->Wait();
+
 			if (udpListener != nullptr)
 				udpListener->Update();
 
+			// player links were just flushed; spectators are served
+			// in the background until the next iteration
+			if (spectatorRelay != nullptr)
+				spectatorRelay->Start();
+
 			std::lock_guard<spring::recursive_mutex> scoped_lock(gameServerMutex);
 			ServerReadNet();
 			Update();
 		}
 
+		if (spectatorRelay != nullptr)
+			spectatorRelay->Wait();
+
 		if (hostif != nullptr)
 			hostif->SendQuit();
 
@@ -3021,6 +3048,19 @@ unsigned CGameServer::BindConnection(
 		return newPlayerNumber;
 	}
 
+	newPlayer.isRelayed = false;
+
+	// remote spectators are served by the relay workers from here on
+	if (spectatorRelay != nullptr && newPlayer.spectator && !isLocal) {
+		const std::shared_ptr<netcode::UDPConnection> udpLink = std::dynamic_pointer_cast<netcode::UDPConnection>(clientLink);
+
+		if (udpLink != nullptr) {
+			udpListener->DetachConnection(udpLink);
+			clientLink = spectatorRelay->AddLink(udpLink);
+			newPlayer.isRelayed = true;
+		}
+	}
+
 	newPlayer.Connected(clientLink, isLocal);
 	newPlayer.SendData(std::shared_ptr<const RawPacket>(myGameData->Pack()));
 	newPlayer.SendData(CBaseNetProtocol::Get().SendSetPlayerNum((unsigned char)newPlayerNumber));
@@ -42,6 +42,7 @@ class CGameSetup;
 class ChatMessage;
 class GameParticipant;
 class GameSkirmishAI;
+class CSpectatorRelay;
 
 class GameTeam : public TeamBase
 {
@@ -286,6 +287,8 @@ private:
 	static std::array<std::string, 26> commandBlacklist;
 
 	std::unique_ptr<netcode::UDPListener> udpListener;
+	/// destroyed before the listener, its workers send through the listener's socket
+	std::unique_ptr<CSpectatorRelay> spectatorRelay;
 	std::unique_ptr<CDemoReader> demoReader;
 	std::unique_ptr<CDemoRecorder> demoRecorder;
 	std::unique_ptr<AutohostInterface> hostif;
@@ -7,6 +7,7 @@
 #include "System/Net/RawPacket.h"
 #include "System/Net/PackPacket.h"
 #include "System/Net/ProtocolDef.h"
+#include "System/Net/UDPConnection.h"
 #include <cinttypes>
 
 using netcode::PackPacket;
@@ -681,5 +682,9 @@ CBaseNetProtocol::CBaseNetProtocol()
 #endif // SYNCDEBUG
 
 	proto->AddType(NETMSG_GAMESTATE_DUMP, 1);
+
+	// consumed by UDPConnection itself
+	proto->AddType(netcode::UDPConnection::UDP_MSG_COMPRESSION, 1);
+	proto->AddType(netcode::UDPConnection::UDP_MSG_COMPRESSED, -2);
 }
 
@@ -0,0 +1,240 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include <algorithm>
+
+#include "SpectatorRelay.h"
+
+#include "Sim/Misc/GlobalConstants.h"
+#include "System/Net/RawPacket.h"
+#include "System/Platform/Threading.h"
+
+#include <fmt/format.h>
+
+
+void CRelayConnection::SendData(std::shared_ptr<const netcode::RawPacket> data)
+{
+	std::lock_guard<spring::mutex> lock(mutex);
+	queue.emplace_back(spring_gettime(), std::move(data));
+}
+
+bool CRelayConnection::HasIncomingData() const
+{
+	std::lock_guard<spring::mutex> lock(mutex);
+	return (link->HasIncomingData());
+}
+
+std::shared_ptr<const netcode::RawPacket> CRelayConnection::Peek(unsigned ahead) const
+{
+	std::lock_guard<spring::mutex> lock(mutex);
+	return (link->Peek(ahead));
+}
+
+std::shared_ptr<const netcode::RawPacket> CRelayConnection::GetData()
+{
+	std::lock_guard<spring::mutex> lock(mutex);
+	return (link->GetData());
+}
+
+void CRelayConnection::DeleteBufferPacketAt(unsigned index)
+{
+	std::lock_guard<spring::mutex> lock(mutex);
+	link->DeleteBufferPacketAt(index);
+}
+
+void CRelayConnection::Flush(const bool forced)
+{
+	std::lock_guard<spring::mutex> lock(mutex);
+	ReleaseQueue(spring_notime);
+	link->Flush(forced);
+}
+
+bool CRelayConnection::CheckTimeout(int seconds, bool initial) const
+{
+	std::lock_guard<spring::mutex> lock(mutex);
+	return (link->CheckTimeout(seconds, initial));
+}
+
+void CRelayConnection::ReconnectTo(netcode::CConnection& conn)
+{
+	std::lock_guard<spring::mutex> lock(mutex);
+	link->ReconnectTo(conn);
+}
+
+bool CRelayConnection::CanReconnect() const
+{
+	std::lock_guard<spring::mutex> lock(mutex);
+	return (link->CanReconnect());
+}
+
+bool CRelayConnection::NeedsReconnect()
+{
+	std::lock_guard<spring::mutex> lock(mutex);
+	return (link->NeedsReconnect());
+}
+
+unsigned int CRelayConnection::GetPacketQueueSize() const
+{
+	std::lock_guard<spring::mutex> lock(mutex);
+	return (link->GetPacketQueueSize());
+}
+
+std::string CRelayConnection::Statistics() const
+{
+	std::lock_guard<spring::mutex> lock(mutex);
+	return (fmt::format("[RelayConnection::Statistics]\n\t{} messages queued\n", queue.size()) + link->Statistics());
+}
+
+std::string CRelayConnection::GetFullAddress() const
+{
+	std::lock_guard<spring::mutex> lock(mutex);
+	return (link->GetFullAddress());
+}
+
+void CRelayConnection::Unmute()
+{
+	std::lock_guard<spring::mutex> lock(mutex);
+	link->Unmute();
+}
+
+void CRelayConnection::Close(bool flush)
+{
+	std::lock_guard<spring::mutex> lock(mutex);
+
+	if (flush)
+		ReleaseQueue(spring_notime);
+
+	link->Close(flush);
+}
+
+void CRelayConnection::SetLossFactor(int factor)
+{
+	std::lock_guard<spring::mutex> lock(mutex);
+	link->SetLossFactor(factor);
+}
+
+
+void CRelayConnection::Relay(spring_time time)
+{
+	std::lock_guard<spring::mutex> lock(mutex);
+	ReleaseQueue(time - delay);
+	link->Update();
+}
+
+void CRelayConnection::ReleaseQueue(spring_time time)
+{
+	// spring_notime releases everything
+	while (!queue.empty() && (!time.isDuration() || queue.front().first <= time)) {
+		link->SendData(std::move(queue.front().second));
+		queue.pop_front();
+	}
+}
+
+
+
+CSpectatorRelay::CSpectatorRelay(int numThreads, int frameDelay): frameDelay(frameDelay)
+{
+	workers.reserve(numThreads);
+
+	for (int i = 0; i < numThreads; i++) {
+		workers.emplace_back([this, i]() {
+			Threading::SetThreadName(fmt::format("specrelay{}", i));
+			WorkerLoop(i);
+		});
+	}
+}
+
+CSpectatorRelay::~CSpectatorRelay()
+{
+	{
+		std::unique_lock<spring::mutex> lock(roundMutex);
+
+		doneCond.wait(lock, [&]() { return (numBusyWorkers == 0); });
+		quitWorkers = true;
+	}
+
+	roundCond.notify_all();
+
+	for (spring::thread& worker: workers) {
+		worker.join();
+	}
+}
+
+
+std::shared_ptr<netcode::CConnection> CSpectatorRelay::AddLink(std::shared_ptr<netcode::CConnection> link)
+{
+	// frame delay at nominal game speed; time-based so that pauses are relayed
+	std::shared_ptr<CRelayConnection> relayLink = std::make_shared<CRelayConnection>(std::move(link), spring_msecs(frameDelay * 1000 / GAME_SPEED));
+
+	std::lock_guard<spring::mutex> lock(roundMutex);
+	newLinks.push_back(relayLink);
+	return relayLink;
+}
+
+
+void CSpectatorRelay::Start()
+{
+	{
+		std::unique_lock<spring::mutex> lock(roundMutex);
+
+		doneCond.wait(lock, [&]() { return (numBusyWorkers == 0); });
+
+		// safe to modify, no worker is looking at the list between rounds
+		links.insert(links.end(), newLinks.begin(), newLinks.end());
+		newLinks.clear();
+
+		const auto pred = [](const std::weak_ptr<CRelayConnection>& p) { return p.expired(); };
+		links.erase(std::remove_if(links.begin(), links.end(), pred), links.end());
+
+		if (links.empty() || workers.empty())
+			return;
+
+		roundTime = spring_gettime();
+		roundNum += 1;
+		numBusyWorkers = workers.size();
+	}
+
+	roundCond.notify_all();
+}
+
+void CSpectatorRelay::Wait()
+{
+	std::unique_lock<spring::mutex> lock(roundMutex);
+	doneCond.wait(lock, [&]() { return (numBusyWorkers == 0); });
+}
+
+
+void CSpectatorRelay::WorkerLoop(unsigned int threadNum)
+{
+	unsigned int lastRoundNum = 0;
+
+	while (true) {
+		{
+			std::unique_lock<spring::mutex> lock(roundMutex);
+
+			roundCond.wait(lock, [&]() { return (roundNum != lastRoundNum || quitWorkers); });
+
+			if (quitWorkers)
+				return;
+
+			lastRoundNum = roundNum;
+		}
+
+		// links are spread over the workers by index, the list is
+		// only modified by Start while no round is in progress
+		for (size_t i = threadNum, n = links.size(); i < n; i += workers.size()) {
+			const std::shared_ptr<CRelayConnection> link = links[i].lock();
+
+			if (link == nullptr)
+				continue;
+
+			link->Relay(roundTime);
+		}
+
+		{
+			std::lock_guard<spring::mutex> lock(roundMutex);
+			numBusyWorkers -= 1;
+		}
+
+		doneCond.notify_all();
+	}
+}
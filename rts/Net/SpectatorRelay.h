@@ -0,0 +1,112 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#ifndef _SPECTATOR_RELAY_H
+#define _SPECTATOR_RELAY_H
+
+#include <deque>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "System/Net/Connection.h"
+#include "System/Misc/SpringTime.h"
+#include "System/Threading/SpringThreading.h"
+
+
+/**
+ * @brief link to a spectator served by CSpectatorRelay
+ * Outgoing messages are queued and handed to the wrapped connection by one
+ * of the relay's worker threads once they are older than the relay delay;
+ * everything else is forwarded. Flush and Close pass on all queued messages.
+ */
+class CRelayConnection : public netcode::CConnection
+{
+public:
+	CRelayConnection(std::shared_ptr<netcode::CConnection> link, spring_time delay): link(link), delay(delay) {}
+
+	void SendData(std::shared_ptr<const netcode::RawPacket> data) override;
+
+	bool HasIncomingData() const override;
+	std::shared_ptr<const netcode::RawPacket> Peek(unsigned ahead) const override;
+	std::shared_ptr<const netcode::RawPacket> GetData() override;
+	void DeleteBufferPacketAt(unsigned index) override;
+
+	void Flush(const bool forced = false) override;
+	bool CheckTimeout(int seconds = 0, bool initial = false) const override;
+
+	void ReconnectTo(netcode::CConnection& conn) override;
+	bool CanReconnect() const override;
+	bool NeedsReconnect() override;
+
+	unsigned int GetPacketQueueSize() const override;
+
+	std::string Statistics() const override;
+	std::string GetFullAddress() const override;
+	void Unmute() override;
+	void Close(bool flush = false) override;
+	void SetLossFactor(int factor) override;
+
+	/// hand all messages queued before <time> to the link and update it
+	void Relay(spring_time time);
+
+private:
+	void ReleaseQueue(spring_time time);
+
+private:
+	mutable spring::mutex mutex;
+
+	std::shared_ptr<netcode::CConnection> link;
+	std::deque< std::pair<spring_time, std::shared_ptr<const netcode::RawPacket>> > queue;
+
+	spring_time delay;
+};
+
+
+/**
+ * @brief fans out server traffic to spectators on worker threads
+ * Spectator links added to the relay are only touched by its workers
+ * between Start and Wait; the server keeps sending (and reading) through
+ * the returned CRelayConnection wrappers. The links share the listener's
+ * socket with the player links the server thread flushes directly, which
+ * UDPConnection allows by serializing all sends on shared sockets.
+ */
+class CSpectatorRelay
+{
+public:
+	CSpectatorRelay(int numThreads, int frameDelay);
+	~CSpectatorRelay();
+
+	std::shared_ptr<netcode::CConnection> AddLink(std::shared_ptr<netcode::CConnection> link);
+
+	/// let the workers relay queued messages on all links
+	void Start();
+	/// block until the workers have finished the current round
+	void Wait();
+
+	int GetFrameDelay() const { return frameDelay; }
+	size_t GetNumLinks() const { return links.size(); }
+
+private:
+	void WorkerLoop(unsigned int threadNum);
+
+private:
+	std::vector< std::weak_ptr<CRelayConnection> > links;
+	std::vector< std::weak_ptr<CRelayConnection> > newLinks;
+
+	std::vector<spring::thread> workers;
+
+	spring::mutex roundMutex;
+	spring::condition_variable_any roundCond;
+	spring::condition_variable_any doneCond;
+
+	spring_time roundTime;
+
+	unsigned int roundNum = 0;
+	unsigned int numBusyWorkers = 0;
+
+	int frameDelay = 0;
+
+	bool quitWorkers = false;
+};
+
+#endif // _SPECTATOR_RELAY_H
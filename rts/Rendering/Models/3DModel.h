@@ -243,6 +243,11 @@ public:
 	const std::vector<SVertexData>& GetVerticesVec() const { return vertices; }
 	const std::vector<uint32_t>& GetIndicesVec() const { return indices; }
 	const std::vector<uint32_t>& GetShatterIndicesVec() const { return shatterIndices; }
+
+	// for ModelCache, which restores post-processed geometry in place
+	std::vector<SVertexData>& GetVerticesVec() { return vertices; }
+	std::vector<uint32_t>& GetIndicesVec() { return indices; }
+	std::vector<uint32_t>& GetShatterIndicesVec() { return shatterIndices; }
 private:
 	void CreateShatterPiecesVariation(int num);
 public:
@@ -307,6 +312,9 @@ struct S3DModel
 		, loadStatus(NOTLOADED)
 		, uploaded(false)
 
+		, invertTexYAxis(false)
+		, invertTexAlpha(false)
+
 		, matAlloc(ScopedMatricesMemAlloc())
 	{}
 
@@ -343,6 +351,9 @@ struct S3DModel
 		loadStatus = m.loadStatus;
 		uploaded = m.uploaded;
 
+		invertTexYAxis = m.invertTexYAxis;
+		invertTexAlpha = m.invertTexAlpha;
+
 		std::swap(matAlloc, m.matAlloc);
 
 		return *this;
@@ -445,6 +456,10 @@ public:
 
 	LoadStatus loadStatus;
 	bool uploaded;
+
+	// texture preload flags, set by CAssParser from the metafile
+	bool invertTexYAxis;
+	bool invertTexAlpha;
 private:
 	ScopedMatricesMemAlloc matAlloc;
 };
@@ -300,7 +300,10 @@ void CAssParser::Load(S3DModel& model, const std::string& modelFilePath)
 	FindTextures(&model, scene, modelTable, modelPath, modelName);
 	LOG_SL(LOG_SECTION_MODEL, L_INFO, "Loading textures. Tex1: '%s' Tex2: '%s'", model.texs[0].c_str(), model.texs[1].c_str());
 
-	textureHandlerS3O.PreloadTexture(&model, modelTable.GetBool("fliptextures", true), modelTable.GetBool("invertteamcolor", true));
+	model.invertTexYAxis = modelTable.GetBool("fliptextures", true);
+	model.invertTexAlpha = modelTable.GetBool("invertteamcolor", true);
+
+	textureHandlerS3O.PreloadTexture(&model, model.invertTexYAxis, model.invertTexAlpha);
 
 	// Check if bones exist
 	const auto boneNames = GetBoneNames(scene);
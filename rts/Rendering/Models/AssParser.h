@@ -60,6 +60,7 @@ public:
 	void Kill() override;
 
 	void Load(S3DModel& model, const std::string& name) override;
+	SAssPiece* AllocPiece() override;
 private:
 	static void PreProcessFileBuffer(std::vector<unsigned char>& fileBuffer);
 
@@ -122,7 +123,6 @@ private:
 		const std::vector<MeshData>& meshes
 	);
 
-	SAssPiece* AllocPiece();
 	SAssPiece* LoadPiece(
 		S3DModel* model,
 		const aiNode* pieceNode,
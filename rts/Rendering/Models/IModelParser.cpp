@@ -9,6 +9,7 @@
 #include "S3OParser.h"
 #include "AssParser.h"
 #include "3DModelVAO.h"
+#include "ModelCache.h"
 #include "ModelsLock.h"
 #include "Game/GlobalUnsynced.h"
 #include "Rendering/Textures/S3OTextureHandler.h"
@@ -145,6 +146,8 @@ void CModelLoader::Init()
 	RegisterModelFormats(parsers);
 	InitParsers();
 
+	ModelCache::Init();
+
 	models.clear();
 	models.resize(MAX_MODEL_OBJECTS);
 
@@ -352,14 +355,18 @@ void CModelLoader::FillModel(
 	const std::string& name,
 	const std::string& path
 ) {
-	ParseModel(model, name, path);
+	auto* parser = GetFormatParser(FileSystem::GetExtension(path));
+	const bool cached = ModelCache::Load(model, path, parser);
+
+	if (!cached)
+		ParseModel(model, name, path, parser);
 
 	assert(model.numPieces != 0);
 	assert(model.GetRootPiece() != nullptr);
 
 	model.SetPieceMatrices();
 
-	PostProcessGeometry(&model);
+	PostProcessGeometry(&model, path, cached);
 }
 
 void CModelLoader::DrainPreloadFutures(uint32_t numAllowed)
@@ -405,11 +412,10 @@ IModelParser* CModelLoader::GetFormatParser(const std::string& pathExt)
 	return it->second;
 }
 
-void CModelLoader::ParseModel(S3DModel& model, const std::string& name, const std::string& path)
+void CModelLoader::ParseModel(S3DModel& model, const std::string& name, const std::string& path, IModelParser* parser)
 {
 	RECOIL_DETAILED_TRACY_ZONE;
 	try {
-		auto* parser = GetFormatParser(FileSystem::GetExtension(path));
 		if (parser == nullptr) {
 			LoadDummyModel(model);
 			throw content_error(fmt::sprintf("could not find a parser for model \"%s\" (unknown format?)", name));
@@ -430,17 +436,22 @@ void CModelLoader::ParseModel(S3DModel& model, const std::string& name, const st
 
 
 
-void CModelLoader::PostProcessGeometry(S3DModel* model)
+void CModelLoader::PostProcessGeometry(S3DModel* model, const std::string& path, bool cached)
 {
 	RECOIL_DETAILED_TRACY_ZONE;
 	if (model->loadStatus == S3DModel::LoadStatus::LOADED)
 		return;
 
-	// does quads and strips conversion sometimes. Need to run first
-	for (size_t i = 0; i < model->pieceObjects.size(); ++i) {
-		auto* p = model->pieceObjects[i];
-		p->PostProcessGeometry(static_cast<uint32_t>(i));
-		p->CreateShatterPieces();
+	// cached pieces were stored after this step
+	if (!cached) {
+		// does quads and strips conversion sometimes. Need to run first
+		for (size_t i = 0; i < model->pieceObjects.size(); ++i) {
+			auto* p = model->pieceObjects[i];
+			p->PostProcessGeometry(static_cast<uint32_t>(i));
+			p->CreateShatterPieces();
+		}
+
+		ModelCache::Save(*model, path);
 	}
 	{
 		auto lock = CModelsLock::GetScopedLock(); // working with S3DModelVAO needs locking
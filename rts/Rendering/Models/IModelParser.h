@@ -19,6 +19,7 @@ public:
 	virtual void Init() {}
 	virtual void Kill() {}
 	virtual void Load(S3DModel& model, const std::string& name) = 0;
+	virtual S3DModelPiece* AllocPiece() = 0;
 };
 
 
@@ -40,7 +41,7 @@ public:
 	const std::vector<S3DModel>& GetModelsVec() const { return models; }
 	      std::vector<S3DModel>& GetModelsVec()       { return models; }
 private:
-	void ParseModel(S3DModel& model, const std::string& name, const std::string& path);
+	void ParseModel(S3DModel& model, const std::string& name, const std::string& path, IModelParser* parser);
 	void FillModel(S3DModel& model, const std::string& name, const std::string& path);
 	S3DModel* GetCachedModel(std::string name);
 
@@ -50,7 +51,7 @@ private:
 	void KillModels();
 	void KillParsers() const;
 
-	void PostProcessGeometry(S3DModel* o);
+	void PostProcessGeometry(S3DModel* o, const std::string& path, bool cached);
 	void Upload(S3DModel* o) const;
 
 private:
@@ -0,0 +1,299 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <thread>
+#include <vector>
+
+#include "ModelCache.h"
+#include "ModelCacheData.h"
+#include "3DModel.h"
+#include "IModelParser.h"
+#include "Game/GameVersion.h"
+#include "Rendering/GlobalRendering.h"
+#include "Rendering/Textures/S3OTextureHandler.h"
+#include "System/Config/ConfigHandler.h"
+#include "System/FileSystem/ArchiveScanner.h"
+#include "System/FileSystem/DataDirsAccess.h"
+#include "System/FileSystem/FileHandler.h"
+#include "System/FileSystem/FileQueryFlags.h"
+#include "System/FileSystem/FileSystem.h"
+#include "System/FileSystem/FileSystemAbstraction.h"
+#include "System/Misc/SpringTime.h"
+#include "System/StringUtil.h"
+#include "System/Threading/SpringThreading.h"
+#include "System/UnorderedMap.hpp"
+#include "lib/xxhash/xxh3.h"
+
+#include <fmt/format.h>
+
+#include "System/Misc/TracyDefs.h"
+
+CONFIG(bool, ModelCache)
+	.defaultValue(true)
+	.description("Keep post-processed S3O and Assimp models in the cache directory so unchanged models need not be parsed again on the next launch.")
+	.readOnly(true)
+;
+
+CONFIG(int, ModelCacheSize)
+	.defaultValue(1024)
+	.minimumValue(0)
+	.description("Size in MB the model cache is trimmed to on startup, dropping the least recently used models first.")
+	.readOnly(true)
+;
+
+
+static constexpr char     MODEL_MAGIC[4] = {'S', 'M', 'D', 'C'};
+static constexpr uint32_t MODEL_FORMAT = 1;
+
+// entries plus the leftovers of interrupted writes, see Save
+static constexpr char MODEL_FILE_REGEX[] = ".*\\.s3dm(\\.[0-9a-f]+\\.tmp)?";
+
+struct ModelHeader {
+	char magic[4];
+	uint32_t format;
+	// hash of the engine version, archive checksums and mesh limits
+	uint64_t keyHash;
+	// independent of the file name, guards against hash collisions
+	uint64_t pathHash;
+	uint64_t bodySize;
+	uint64_t bodyHash;
+};
+
+static std::atomic<uint32_t> numHits = {0};
+static std::atomic<uint32_t> numMisses = {0};
+static std::atomic<uint32_t> numStores = {0};
+static std::atomic<uint32_t> numRejects = {0};
+static std::atomic<uint64_t> loadMicros = {0};
+
+static spring::mutex checksumMutex;
+static spring::unordered_map<std::string, sha512::raw_digest> archiveChecksums;
+
+
+static const std::string& GetCacheDir()
+{
+	static const std::string dir = [] {
+		if (configHandler == nullptr || !configHandler->GetBool("ModelCache"))
+			return std::string();
+
+		const std::string sep(1, FileSystemAbstraction::GetNativePathSeparator());
+		const std::string cacheDir = dataDirsAccess.LocateDir(FileSystem::GetCacheDir() + sep + "models" + sep, FileQueryFlags::WRITE | FileQueryFlags::CREATE_DIRS);
+
+		// once per run, before any model of this run refreshes its timestamp
+		if (!cacheDir.empty())
+			ModelCache::Prune(cacheDir, uint64_t(configHandler->GetInt("ModelCacheSize")) << 20);
+
+		return cacheDir;
+	}();
+
+	return dir;
+}
+
+static sha512::raw_digest GetArchiveChecksum(const std::string& archiveName)
+{
+	std::lock_guard<spring::mutex> lock(checksumMutex);
+
+	const auto it = archiveChecksums.find(archiveName);
+
+	if (it != archiveChecksums.end())
+		return it->second;
+
+	// loaded archives were already checksummed by PreGame, this only hits the scanner's cache
+	const std::string archiveFile = archiveScanner->ArchiveFromName(archiveName);
+	const std::string archivePath = archiveScanner->GetArchivePath(archiveFile) + archiveFile;
+
+	return (archiveChecksums[archiveName] = archiveScanner->GetArchiveSingleChecksumBytes(archivePath));
+}
+
+static uint64_t GetKeyHash(const std::string& path)
+{
+	// loose files override archive content and carry no checksum, never cache those
+	if (CFileHandler::FileExists(path, SPRING_VFS_RAW))
+		return 0;
+
+	const std::string archiveName = CFileHandler::GetArchiveContainingFile(path, SPRING_VFS_ZIP);
+
+	if (archiveName.empty())
+		return 0;
+
+	// same lookup order as CAssParser::Load; S3O's have no metafile, which only costs a miss
+	std::string metaFileName = path + ".lua";
+
+	if (!CFileHandler::FileExists(metaFileName, SPRING_VFS_ZIP))
+		metaFileName = FileSystem::GetDirectory(path) + FileSystem::GetBasename(path) + ".lua";
+
+	const std::string metaArchiveName = CFileHandler::GetArchiveContainingFile(metaFileName, SPRING_VFS_ZIP);
+
+	const std::string ver = SpringVersion::GetSync() + "|" + std::to_string(sizeof(SVertexData));
+	const sha512::raw_digest modelChecksum = GetArchiveChecksum(archiveName);
+	const sha512::raw_digest metaChecksum = metaArchiveName.empty()? sha512::NULL_RAW_DIGEST: GetArchiveChecksum(metaArchiveName);
+
+	// CAssParser splits meshes by these
+	const int meshLimits[2] = {globalRendering->glslMaxRecommendedIndices, globalRendering->glslMaxRecommendedVertices};
+
+	uint64_t hash = XXH3_64bits(ver.data(), ver.size());
+	hash = XXH3_64bits_withSeed(modelChecksum.data(), modelChecksum.size(), hash);
+	hash = XXH3_64bits_withSeed(metaChecksum.data(), metaChecksum.size(), hash);
+	hash = XXH3_64bits_withSeed(meshLimits, sizeof(meshLimits), hash);
+
+	return (hash + (hash == 0));
+}
+
+static std::string GetModelPath(const std::string& cacheDir, const std::string& path, uint64_t keyHash)
+{
+	return (FileSystem::EnsurePathSepAtEnd(cacheDir) + fmt::format("{:016x}.s3dm", XXH3_64bits_withSeed(path.data(), path.size(), keyHash)));
+}
+
+static bool IsCacheable(const std::string& path)
+{
+	// 3DO pieces are post-processed differently and share a texture atlas
+	return (StringToLower(FileSystem::GetExtension(path)) != "3do");
+}
+
+
+void ModelCache::Init()
+{
+	std::lock_guard<spring::mutex> lock(checksumMutex);
+	archiveChecksums.clear();
+}
+
+bool ModelCache::Load(S3DModel& model, const std::string& path, IModelParser* parser)
+{
+	RECOIL_DETAILED_TRACY_ZONE;
+
+	const std::string& cacheDir = GetCacheDir();
+
+	if (cacheDir.empty() || parser == nullptr || !IsCacheable(path))
+		return false;
+
+	const spring_time t0 = spring_gettime();
+	const uint64_t keyHash = GetKeyHash(path);
+
+	if (keyHash == 0)
+		return false;
+
+	const std::string modelPath = GetModelPath(cacheDir, path, keyHash);
+
+	size_t mapSize = 0;
+	const std::uint8_t* mapData = FileSystemAbstraction::MapFile(modelPath, mapSize);
+
+	if (mapData == nullptr) {
+		numMisses += 1;
+		loadMicros += (spring_gettime() - t0).toMicroSecsi();
+		return false;
+	}
+
+	ModelHeader header;
+	bool valid = (mapSize >= sizeof(header));
+
+	if (valid)
+		std::memcpy(&header, mapData, sizeof(header));
+
+	valid = valid && (memcmp(header.magic, MODEL_MAGIC, sizeof(MODEL_MAGIC)) == 0);
+	valid = valid && (header.format == MODEL_FORMAT);
+	valid = valid && (header.keyHash == keyHash);
+	valid = valid && (header.pathHash == XXH3_64bits(path.data(), path.size()));
+	valid = valid && (header.bodySize == (mapSize - sizeof(header)));
+	valid = valid && (header.bodyHash == XXH3_64bits(mapData + sizeof(header), mapSize - sizeof(header)));
+
+	if (valid) {
+		model.name = path;
+		valid = ModelCacheData::Read(model, mapData + sizeof(header), mapSize - sizeof(header), parser);
+	}
+
+	FileSystemAbstraction::UnmapFile(mapData, mapSize);
+
+	if (!valid) {
+		numRejects += 1;
+		numMisses += 1;
+		loadMicros += (spring_gettime() - t0).toMicroSecsi();
+		return false;
+	}
+
+	// keeps the entry from being pruned as long as it is in use
+	FileSystemAbstraction::UpdateFileModificationTime(modelPath);
+
+	// what the parsers would have done after reading the texture names
+	textureHandlerS3O.PreloadTexture(&model, model.invertTexYAxis, model.invertTexAlpha);
+
+	numHits += 1;
+	loadMicros += (spring_gettime() - t0).toMicroSecsi();
+	return true;
+}
+
+void ModelCache::Save(const S3DModel& model, const std::string& path)
+{
+	RECOIL_DETAILED_TRACY_ZONE;
+
+	const std::string& cacheDir = GetCacheDir();
+
+	if (cacheDir.empty() || !IsCacheable(path))
+		return;
+	if (model.type != MODELTYPE_S3O && model.type != MODELTYPE_ASS)
+		return;
+	if (model.pieceObjects.empty() || model.numPieces != static_cast<int>(model.pieceObjects.size()))
+		return;
+
+	const uint64_t keyHash = GetKeyHash(path);
+
+	if (keyHash == 0)
+		return;
+
+	std::vector<std::uint8_t> body;
+	ModelCacheData::Write(model, body);
+
+	ModelHeader header;
+	memcpy(header.magic, MODEL_MAGIC, sizeof(MODEL_MAGIC));
+	header.format = MODEL_FORMAT;
+	header.keyHash = keyHash;
+	header.pathHash = XXH3_64bits(path.data(), path.size());
+	header.bodySize = body.size();
+	header.bodyHash = XXH3_64bits(body.data(), body.size());
+
+	// write to a private file first so concurrent loaders (or engine
+	// instances) never observe a partially written model under <path>
+	const std::string modelPath = GetModelPath(cacheDir, path, keyHash);
+	const uint64_t tmpSalt = std::hash<std::thread::id>{}(std::this_thread::get_id()) ^ spring_gettime().toNanoSecsi();
+	const std::string tmpPath = fmt::format("{}.{:x}.tmp", modelPath, tmpSalt);
+	FILE* file = fopen(tmpPath.c_str(), "wb");
+
+	if (file == nullptr)
+		return;
+
+	bool written = true;
+	written = written && (fwrite(&header, sizeof(header), 1, file) == 1);
+	written = written && (fwrite(body.data(), body.size(), 1, file) == 1);
+	written = (fclose(file) == 0) && written;
+
+	if (!written || std::rename(tmpPath.c_str(), modelPath.c_str()) != 0) {
+		std::remove(tmpPath.c_str());
+		return;
+	}
+
+	numStores += 1;
+}
+
+void ModelCache::Prune(const std::string& cacheDir, uint64_t maxSize)
+{
+	RECOIL_DETAILED_TRACY_ZONE;
+	FileSystemAbstraction::PruneFiles(cacheDir, MODEL_FILE_REGEX, maxSize);
+}
+
+
+ModelCache::Stats ModelCache::GetStats()
+{
+	return {numHits.load(), numMisses.load(), numStores.load(), numRejects.load(), loadMicros.load()};
+}
+
+void ModelCache::ResetStats()
+{
+	numHits = 0;
+	numMisses = 0;
+	numStores = 0;
+	numRejects = 0;
+	loadMicros = 0;
+}
@@ -0,0 +1,49 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#ifndef MODEL_CACHE_H
+#define MODEL_CACHE_H
+
+#include <cstdint>
+#include <string>
+
+struct S3DModel;
+class IModelParser;
+
+/**
+ * Persistent cache of post-processed S3O and Assimp models, stored under
+ * the CacheDir.
+ *
+ * An entry holds the piece hierarchy with its final vertex, index and
+ * shatter data plus the model dimensions and texture names, so a hit skips
+ * both the format parser and the per-piece post-processing. Entries are
+ * keyed by the checksums of the archives providing the model and its
+ * metafile, the engine version and the mesh-splitting limits. Anything
+ * unreadable or mismatching is ignored and the model gets parsed as usual.
+ * Loading a model refreshes its modification time, and the cache is trimmed
+ * to ModelCacheSize on first use.
+ */
+namespace ModelCache {
+	struct Stats {
+		uint32_t hits;
+		uint32_t misses;
+		uint32_t stores;
+		uint32_t rejects;
+		uint64_t loadMicros;
+	};
+
+	/// forgets the archive checksums looked up for the previous game
+	void Init();
+
+	/// fills <model> with pieces allocated from <parser>; thread-safe
+	bool Load(S3DModel& model, const std::string& path, IModelParser* parser);
+	/// stores a freshly parsed and post-processed <model>; thread-safe
+	void Save(const S3DModel& model, const std::string& path);
+
+	/// deletes the least recently used models until at most <maxSize> bytes are left
+	void Prune(const std::string& cacheDir, uint64_t maxSize);
+
+	Stats GetStats();
+	void ResetStats();
+};
+
+#endif /* MODEL_CACHE_H */
@@ -0,0 +1,237 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "ModelCacheData.h"
+#include "3DModel.h"
+#include "IModelParser.h"
+
+/*
+ * The body is a flat dump in native byte order: the model fields, then for
+ * each piece in pieceObjects order its parent index, transform, extents and
+ * count-prefixed vertex, index and shatter arrays. Strings are stored as a
+ * 32-bit length plus bytes.
+ */
+struct ModelWriter {
+	template<typename T> void Put(const T& value) {
+		static_assert(std::is_trivially_copyable_v<T>);
+		const std::uint8_t* bytes = reinterpret_cast<const std::uint8_t*>(&value);
+		data.insert(data.end(), bytes, bytes + sizeof(T));
+	}
+	template<typename T> void PutArray(const std::vector<T>& values) {
+		static_assert(std::is_trivially_copyable_v<T>);
+		const std::uint8_t* bytes = reinterpret_cast<const std::uint8_t*>(values.data());
+		Put(static_cast<uint32_t>(values.size()));
+		data.insert(data.end(), bytes, bytes + values.size() * sizeof(T));
+	}
+	void PutString(const std::string& str) {
+		Put(static_cast<uint32_t>(str.size()));
+		data.insert(data.end(), str.begin(), str.end());
+	}
+
+	std::vector<std::uint8_t> data;
+};
+
+struct ModelReader {
+	template<typename T> T Get() {
+		static_assert(std::is_trivially_copyable_v<T>);
+		T value{};
+
+		if ((valid &= (size_t(end - pos) >= sizeof(T))))
+			std::memcpy(&value, pos, sizeof(T));
+
+		pos += (sizeof(T) * valid);
+		return value;
+	}
+	template<typename T> void GetArray(std::vector<T>& values) {
+		static_assert(std::is_trivially_copyable_v<T>);
+		const uint32_t size = Get<uint32_t>();
+
+		if (!(valid &= ((size_t(end - pos) / sizeof(T)) >= size)))
+			return;
+
+		values.resize(size);
+
+		if (size > 0)
+			std::memcpy(values.data(), pos, size * sizeof(T));
+
+		pos += (size * sizeof(T));
+	}
+	std::string GetString() {
+		const uint32_t size = Get<uint32_t>();
+
+		if (!(valid &= (size_t(end - pos) >= size)))
+			return "";
+
+		pos += size;
+		return {reinterpret_cast<const char*>(pos - size), size};
+	}
+
+	const std::uint8_t* pos = nullptr;
+	const std::uint8_t* end = nullptr;
+
+	bool valid = true;
+};
+
+
+static bool ReadModel(S3DModel& model, ModelReader& mr, IModelParser* parser)
+{
+	const auto type = mr.Get<int32_t>();
+	const auto numPieces = mr.Get<int32_t>();
+
+	if (!mr.valid || (type != MODELTYPE_S3O && type != MODELTYPE_ASS) || numPieces <= 0 || numPieces > MAX_PIECES_PER_MODEL)
+		return false;
+
+	std::array<std::string, NUM_MODEL_TEXTURES> texs;
+	for (auto& tex: texs) {
+		tex = mr.GetString();
+	}
+
+	const bool invertTexYAxis = (mr.Get<uint8_t>() != 0);
+	const bool invertTexAlpha = (mr.Get<uint8_t>() != 0);
+
+	const float radius = mr.Get<float>();
+	const float height = mr.Get<float>();
+	const float3 mins = mr.Get<float3>();
+	const float3 maxs = mr.Get<float3>();
+	const float3 relMidPos = mr.Get<float3>();
+
+	std::vector<S3DModelPiece*> pieces;
+	pieces.reserve(numPieces);
+
+	for (int i = 0; i < numPieces && mr.valid; i++) {
+		S3DModelPiece* piece = pieces.emplace_back(parser->AllocPiece());
+
+		const auto parentIdx = mr.Get<int32_t>();
+
+		// pieces are stored in depth-first order, parents always come first
+		if (!(mr.valid &= ((i == 0 && parentIdx == -1) || (parentIdx >= 0 && parentIdx < i))))
+			break;
+
+		piece->name = mr.GetString();
+		piece->parent = (parentIdx >= 0)? pieces[parentIdx]: nullptr;
+		piece->offset = mr.Get<float3>();
+		piece->goffset = mr.Get<float3>();
+		piece->scales = mr.Get<float3>();
+		piece->mins = mr.Get<float3>();
+		piece->maxs = mr.Get<float3>();
+		piece->SetParentModel(&model);
+
+		if (mr.Get<uint8_t>() != 0) {
+			CMatrix44f bakedMat;
+			std::memcpy(&bakedMat.m[0], mr.Get<std::array<float, 16>>().data(), sizeof(bakedMat.m));
+
+			// a truncated body reads back as a zero matrix
+			if (mr.valid)
+				piece->SetBakedMatrix(bakedMat);
+		}
+
+		mr.GetArray(piece->GetVerticesVec());
+		mr.GetArray(piece->GetIndicesVec());
+		mr.GetArray(piece->GetShatterIndicesVec());
+
+		for (S3DModelPiecePart& part: piece->shatterParts) {
+			mr.GetArray(part.renderData);
+		}
+
+		// all parsers derive the piece volume from its extents
+		piece->SetCollisionVolume(CollisionVolume('b', 'z', piece->maxs - piece->mins, (piece->maxs + piece->mins) * 0.5f));
+
+		if (piece->parent != nullptr)
+			piece->parent->children.push_back(piece);
+	}
+
+	if (!mr.valid || mr.pos != mr.end) {
+		// pool slots are not returned, only happens for files written by a broken engine
+		for (S3DModelPiece* piece: pieces) {
+			piece->Clear();
+		}
+
+		return false;
+	}
+
+	model.type = static_cast<ModelType>(type);
+	model.numPieces = numPieces;
+	model.texs = std::move(texs);
+	model.invertTexYAxis = invertTexYAxis;
+	model.invertTexAlpha = invertTexAlpha;
+	model.radius = radius;
+	model.height = height;
+	model.mins = mins;
+	model.maxs = maxs;
+	model.relMidPos = relMidPos;
+	model.FlattenPieceTree(pieces[0]);
+
+	assert(model.pieceObjects == pieces);
+	return true;
+}
+
+static void WriteModel(const S3DModel& model, ModelWriter& mw)
+{
+	mw.Put(static_cast<int32_t>(model.type));
+	mw.Put(static_cast<int32_t>(model.numPieces));
+
+	for (const auto& tex: model.texs) {
+		mw.PutString(tex);
+	}
+
+	mw.Put(static_cast<uint8_t>(model.invertTexYAxis));
+	mw.Put(static_cast<uint8_t>(model.invertTexAlpha));
+
+	mw.Put(model.radius);
+	mw.Put(model.height);
+	mw.Put(model.mins);
+	mw.Put(model.maxs);
+	mw.Put(model.relMidPos);
+
+	const auto& pieces = model.pieceObjects;
+
+	for (const S3DModelPiece* piece: pieces) {
+		const auto parentIter = std::find(pieces.begin(), pieces.end(), piece->parent);
+		const auto parentIdx = (parentIter == pieces.end())? -1: static_cast<int32_t>(parentIter - pieces.begin());
+
+		mw.Put(static_cast<int32_t>(parentIdx));
+		mw.PutString(piece->name);
+		mw.Put(piece->offset);
+		mw.Put(piece->goffset);
+		mw.Put(piece->scales);
+		mw.Put(piece->mins);
+		mw.Put(piece->maxs);
+		mw.Put(static_cast<uint8_t>(piece->HasBackedMat()));
+
+		if (piece->HasBackedMat()) {
+			std::array<float, 16> bakedMat;
+			std::memcpy(bakedMat.data(), &piece->bakedMatrix.m[0], sizeof(bakedMat));
+			mw.Put(bakedMat);
+		}
+
+		mw.PutArray(piece->GetVerticesVec());
+		mw.PutArray(piece->GetIndicesVec());
+		mw.PutArray(piece->GetShatterIndicesVec());
+
+		for (const S3DModelPiecePart& part: piece->shatterParts) {
+			mw.PutArray(part.renderData);
+		}
+	}
+}
+
+
+void ModelCacheData::Write(const S3DModel& model, std::vector<std::uint8_t>& data)
+{
+	ModelWriter mw = {std::move(data)};
+	WriteModel(model, mw);
+	data = std::move(mw.data);
+}
+
+bool ModelCacheData::Read(S3DModel& model, const std::uint8_t* data, size_t size, IModelParser* parser)
+{
+	ModelReader mr = {data, data + size};
+	return (ReadModel(model, mr, parser));
+}
@@ -0,0 +1,24 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#ifndef MODEL_CACHE_DATA_H
+#define MODEL_CACHE_DATA_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct S3DModel;
+class IModelParser;
+
+/**
+ * Body of a ModelCache entry, kept apart from the file handling so it can
+ * be exercised without a VFS or config.
+ */
+namespace ModelCacheData {
+	/// appends the fields and piece tree of a post-processed <model> to <data>
+	void Write(const S3DModel& model, std::vector<std::uint8_t>& data);
+	/// fills <model> from a body written by Write, allocating pieces from <parser>
+	bool Read(S3DModel& model, const std::uint8_t* data, size_t size, IModelParser* parser);
+};
+
+#endif /* MODEL_CACHE_DATA_H */
@@ -60,9 +60,9 @@ public:
 	void Kill() override;
 
 	void Load(S3DModel& model, const std::string& name) override;
+	SS3OPiece* AllocPiece() override;
 
 private:
-	SS3OPiece* AllocPiece();
 	SS3OPiece* LoadPiece(S3DModel*, SS3OPiece*, std::vector<uint8_t>& buf, int offset);
 
 private:
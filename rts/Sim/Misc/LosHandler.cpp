@@ -1,6 +1,7 @@
 /* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
 
 #include "LosHandler.h"
+#include "LosRaycast.h"
 
 #include "Sim/Units/Unit.h"
 #include "Sim/Units/UnitDef.h"
@@ -12,6 +13,7 @@
 #include "System/SpringHash.h"
 #include "System/creg/STL_Deque.h"
 #include "System/EventHandler.h"
+#include "System/Config/ConfigHandler.h"
 #include "System/SafeUtil.h"
 #include "System/TimeProfiler.h"
 #include "System/Threading/ThreadPool.h"
@@ -20,6 +22,8 @@
 
 #define USE_STAGGERED_UPDATES 0
 
+CONFIG(bool, LosRaycastSIMD).defaultValue(true).description("Use the SIMD kernel for LOS and radar terrain raycasts. Results are identical to the scalar one.");
+
 
 
 CR_BIND(CLosHandler, )
@@ -64,6 +68,8 @@ inline void SLosInstance::Init(int radius, int allyteam, int2 basePos, float bas
 	this->isCached = false;
 	this->isQueuedForUpdate = false;
 	this->isQueuedForTerraform = false;
+	this->deltaSource = nullptr;
+	this->isDeltaSource = false;
 }
 
 
@@ -75,6 +81,10 @@ size_t ILosType::cacheFails = 1;
 size_t ILosType::cacheHits  = 1;
 size_t ILosType::cacheRefs  = 1;
 
+size_t ILosType::deltaUpdates        = 0;
+size_t ILosType::deltaSquaresSkipped = 0;
+size_t ILosType::deltaSquaresChanged = 0;
+
 constexpr float CLosHandler::defBaseRadarErrorSize;
 constexpr float CLosHandler::defBaseRadarErrorMult;
 constexpr SLosInstance::RLE SLosInstance::EMPTY_RLE;
@@ -126,6 +136,7 @@ void ILosType::Kill()
 	losAdd.clear();
 	losDeleted.clear();
 	losRecalc.clear();
+	losDelta.clear();
 
 	// mark as invalid
 	size = {0, 0};
@@ -258,6 +269,12 @@ inline void ILosType::UpdateUnit(CUnit* unit, bool ignore)
 	SLosInstance* li = CreateInstance();
 	li->Init(radius, allyteam, baseLos, height, hash);
 	li->refCount++;
+
+	// the unit left an instance nobody else uses, so its sight can be swapped
+	// for the new one by only touching the squares that differ between them
+	if (algoType == LOS_ALGO_RAYCAST && uli != nullptr && uli->refCount == 0 && uli->allyteam == allyteam)
+		li->deltaSource = uli;
+
 	unit->los[type] = li;
 	instanceHashes[hash].push_back(li);
 	UpdateInstanceStatus(li, SLosInstance::TLosStatus::NEW);
@@ -402,6 +419,7 @@ inline void ILosType::DeleteInstance(SLosInstance* li)
 	}
 
 	li->squares.clear();
+	li->deltaSource = nullptr;
 	freeIDs.push_back(li->id);
 }
 
@@ -530,6 +548,8 @@ void ILosType::Update()
 	if (algoType == LOS_ALGO_RAYCAST) {
 		losRecalc.clear();
 		losRecalc.reserve(losUpdate.size());
+		losDelta.clear();
+		losDelta.reserve(losUpdate.size());
 	}
 
 	// filter the updates into their subparts
@@ -540,7 +560,11 @@ void ILosType::Update()
 		switch (status) {
 			case SLosInstance::TLosStatus::NEW: {
 				if (algoType == LOS_ALGO_RAYCAST) losRecalc.push_back(li);
-				losAdd.push_back(li);
+				if (li->deltaSource != nullptr) {
+					losDelta.push_back(li);
+				} else {
+					losAdd.push_back(li);
+				}
 			} break;
 			case SLosInstance::TLosStatus::REACTIVATE: {
 				losAdd.push_back(li);
@@ -551,7 +575,8 @@ void ILosType::Update()
 				losAdd.push_back(li);
 			} break;
 			case SLosInstance::TLosStatus::REMOVE: {
-				losRemove.push_back(li);
+				// goes into losRemove below unless claimed by a delta update
+				li->isDeltaSource = true;
 				losDeleted.push_back(li);
 			} break;
 			case SLosInstance::TLosStatus::NONE: {
@@ -568,6 +593,34 @@ void ILosType::Update()
 		}
 	}
 
+	// pair moved instances with the ones they replace; the old instance must
+	// actually be removed this update (it might have been re-referenced since)
+	// and can only be claimed once
+	size_t numDeltas = 0;
+
+	for (SLosInstance* li: losDelta) {
+		SLosInstance* src = li->deltaSource;
+
+		if (src->isDeltaSource) {
+			src->isDeltaSource = false;
+			losDelta[numDeltas++] = li;
+			continue;
+		}
+
+		li->deltaSource = nullptr;
+		losAdd.push_back(li);
+	}
+
+	losDelta.resize(numDeltas);
+
+	for (SLosInstance* li: losDeleted) {
+		if (!li->isDeltaSource)
+			continue;
+
+		li->isDeltaSource = false;
+		losRemove.push_back(li);
+	}
+
 	// remove sight
 	//FIXME multithread?
 	for (SLosInstance* li: losRemove) {
@@ -584,6 +637,20 @@ void ILosType::Update()
 		});
 	}
 
+	// swap sight of moved instances
+	for (SLosInstance* li: losDelta) {
+		assert(li->refCount > 0);
+
+		size_t numChanged = 0;
+		const size_t numSkipped = losMaps[li->allyteam].AddRaycastDelta(li->deltaSource, li, numChanged);
+
+		deltaUpdates += 1;
+		deltaSquaresSkipped += numSkipped;
+		deltaSquaresChanged += numChanged;
+
+		li->deltaSource = nullptr;
+	}
+
 	// add sight
 	for (SLosInstance* li: losAdd) {
 		assert(li->refCount > 0);
@@ -686,6 +753,10 @@ void CLosHandler::InitStatic()
 	ILosType::cacheHits  = 1;
 	ILosType::cacheRefs  = 1;
 
+	ILosType::deltaUpdates        = 0;
+	ILosType::deltaSquaresSkipped = 0;
+	ILosType::deltaSquaresChanged = 0;
+
 	if (losHandler == nullptr)
 		losHandler = new (losHandlerMem) CLosHandler();
 
@@ -710,6 +781,8 @@ void CLosHandler::Init()
 	RECOIL_DETAILED_TRACY_ZONE;
 	globalLOS.fill(false);
 
+	LosRaycast::SetUseSIMD(configHandler->GetBool("LosRaycastSIMD"));
+
 	baseRadarErrorSize = defBaseRadarErrorSize;
 	baseRadarErrorMult = defBaseRadarErrorMult;
 
@@ -764,6 +837,11 @@ void CLosHandler::Kill()
 		100.0f * float(ILosType::cacheHits - ILosType::cacheRefs) / (ILosType::cacheHits + ILosType::cacheFails),
 		100.0f * float(ILosType::cacheRefs) / (ILosType::cacheHits + ILosType::cacheFails)
 	);
+	LOG("[LosHandler::%s] raycast instance delta-updates=%u; squares-{skipped,changed}={%u,%u}; skipped=%.0f%%",
+		__func__, unsigned(ILosType::deltaUpdates),
+		unsigned(ILosType::deltaSquaresSkipped), unsigned(ILosType::deltaSquaresChanged),
+		100.0f * float(ILosType::deltaSquaresSkipped) / std::max(size_t(1), ILosType::deltaSquaresSkipped + ILosType::deltaSquaresChanged)
+	);
 
 	losTypes.fill(nullptr);
 }
@@ -48,6 +48,7 @@ struct SLosInstance
 		, isCached(false)
 		, isQueuedForUpdate(false)
 		, isQueuedForTerraform(false)
+		, isDeltaSource(false)
 	{}
 	void Init(int radius, int allyteam, int2 basePos, float baseHeight, int hashNum);
 
@@ -79,6 +80,11 @@ public:
 	bool isCached;
 	bool isQueuedForUpdate;
 	bool isQueuedForTerraform;
+
+	// instance this one replaced when its unit moved (see ILosType::UpdateUnit),
+	// lets ILosType::Update swap the two by applying only their difference
+	SLosInstance* deltaSource = nullptr;
+	bool isDeltaSource;
 };
 
 
@@ -170,6 +176,12 @@ public:
 	static size_t cacheHits;
 	static size_t cacheRefs;
 
+	// number of moved instances whose sight was swapped in by a delta update,
+	// and how many los-squares those updates left untouched resp. changed
+	static size_t deltaUpdates;
+	static size_t deltaSquaresSkipped;
+	static size_t deltaSquaresChanged;
+
 	spring::unordered_map<int, std::vector<SLosInstance*> > instanceHashes;
 
 	std::vector<CLosMap> losMaps;
@@ -191,6 +203,7 @@ private:
 	std::vector<SLosInstance*> losAdd;
 	std::vector<SLosInstance*> losDeleted;
 	std::vector<SLosInstance*> losRecalc;
+	std::vector<SLosInstance*> losDelta;
 
 	static constexpr int CACHE_SIZE = 4096;
 };
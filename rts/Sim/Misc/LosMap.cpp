@@ -5,6 +5,7 @@
 
 #include "LosMap.h"
 #include "LosHandler.h"
+#include "LosRaycast.h"
 #include "Map/ReadMap.h"
 #include "System/SpringMath.h"
 #include "System/float3.h"
@@ -13,8 +14,6 @@
 #include "System/Threading/ThreadPool.h"
 #include "Game/GlobalUnsynced.h" // for myAllyTeam
 
-constexpr float LOS_BONUS_HEIGHT = 5.0f;
-
 static std::array<std::vector<float>, ThreadPool::MAX_THREADS> RADIUS_ISQRT_TABLES;
 
 static std::array<std::vector<float>, ThreadPool::MAX_THREADS> RAYCAST_ANGLE_TABLES;
@@ -114,22 +113,14 @@ void MidpointCircleAlgoPerLine(int radius, const F& func)
 class CLosTableHelper
 {
 public:
-	typedef std::vector<int2> LosLine;
-	typedef std::vector<LosLine> LosTable;
+	typedef LosRaycast::LosLine LosLine;
+	typedef LosRaycast::LosTable LosTable;
 
 	// only generates table if not in cache
 	void GenerateForLosSize(size_t losSize);
 
-	const int2 GetLosTableRaySquare(size_t losSize, size_t rayIndex, size_t squareIdx) {
-		return losTables[losSize][rayIndex][squareIdx];
-	}
-
-	size_t GetLosTableRaySize(size_t losSize, size_t rayIndex) {
-		return losTables[losSize][rayIndex].size();
-	}
-
-	size_t GetLosTableSize(size_t losSize) {
-		return losTables[losSize].size();
+	const LosTable& GetLosTable(size_t losSize) const {
+		return losTables[losSize];
 	}
 
 private:
@@ -439,31 +430,107 @@ void CLosMap::AddRaycast(SLosInstance* instance, int amount)
 	const bool visibleInstanceSquares = (instance->allyteam >= 0 && (instance->allyteam == gu->myAllyTeam || gu->spectatingFullView));
 	const bool updateUnsyncedHeightMap = sendReadmapEvents && visibleInstanceSquares;
 
-	if ((amount > 0) && updateUnsyncedHeightMap) {
-		for (const SLosInstance::RLE rle: losSquares) {
-			for (int idx = rle.start, len = rle.length; len > 0; --len, ++idx) {
-				losmap[idx] += amount;
+	for (const SLosInstance::RLE rle: losSquares) {
+		AddSquares(rle.start, rle.length, amount, updateUnsyncedHeightMap);
+	}
+}
 
-				// skip if this los-square did not *enter* LOS
-				if (losmap[idx] != amount)
-					continue;
 
-				const int2 lm = IdxToCoord(idx, size.x);
-				const int2 p1 = (lm             ) * LOS2HEIGHT;
-				const int2 p2 = (lm + int2(1, 1)) * LOS2HEIGHT;
-				const int2 p3 = {std::min(p2.x, mapDims.mapxm1), std::min(p2.y, mapDims.mapym1)};
+size_t CLosMap::AddRaycastDelta(const SLosInstance* prvInstance, const SLosInstance* curInstance, size_t& numChanged)
+{
+	RECOIL_DETAILED_TRACY_ZONE;
+	assert(prvInstance->allyteam == curInstance->allyteam);
+
+	const auto& prvSquares = prvInstance->squares;
+	const auto& curSquares = curInstance->squares;
 
-				readMap->UpdateLOS(SRectangle(p1.x, p1.y,  p3.x, p3.y));
-			}
+	const bool visibleInstanceSquares = (curInstance->allyteam >= 0 && (curInstance->allyteam == gu->myAllyTeam || gu->spectatingFullView));
+	const bool updateUnsyncedHeightMap = sendReadmapEvents && visibleInstanceSquares;
+
+	size_t numUnchanged = 0;
+
+	numChanged = 0;
+
+	// both lists are sorted by start index and their runs never overlap, so
+	// a single merge pass yields the symmetric difference (EMPTY_RLE has zero
+	// length and is consumed like any other run)
+	size_t i = 0;
+	size_t j = 0;
+
+	int prvBeg = 0, prvEnd = 0;
+	int curBeg = 0, curEnd = 0;
+
+	while (true) {
+		// skip exhausted runs
+		while (prvBeg == prvEnd && i < prvSquares.size()) {
+			prvBeg = prvSquares[i].start;
+			prvEnd = prvSquares[i].start + prvSquares[i].length;
+			++i;
+		}
+		while (curBeg == curEnd && j < curSquares.size()) {
+			curBeg = curSquares[j].start;
+			curEnd = curSquares[j].start + curSquares[j].length;
+			++j;
 		}
 
-		return;
+		const bool havePrv = (prvBeg != prvEnd);
+		const bool haveCur = (curBeg != curEnd);
+
+		if (!havePrv && !haveCur)
+			break;
+
+		// run (or its head) only covered by the old instance
+		if (!haveCur || (havePrv && prvBeg < curBeg)) {
+			const int end = haveCur? std::min(prvEnd, curBeg): prvEnd;
+			AddSquares(prvBeg, end - prvBeg, -1, false);
+			numChanged += (end - prvBeg);
+			prvBeg = end;
+			continue;
+		}
+
+		// run (or its head) only covered by the new instance
+		if (!havePrv || curBeg < prvBeg) {
+			const int end = havePrv? std::min(curEnd, prvBeg): curEnd;
+			AddSquares(curBeg, end - curBeg, 1, updateUnsyncedHeightMap);
+			numChanged += (end - curBeg);
+			curBeg = end;
+			continue;
+		}
+
+		// covered by both, refcount stays the same
+		const int end = std::min(prvEnd, curEnd);
+		numUnchanged += (end - prvBeg);
+		prvBeg = end;
+		curBeg = end;
 	}
 
-	for (const SLosInstance::RLE rle: losSquares) {
-		for (int idx = rle.start, len = rle.length; len > 0; --len, ++idx) {
+	return numUnchanged;
+}
+
+
+void CLosMap::AddSquares(int idx, int len, int amount, bool updateUnsyncedHeightMap)
+{
+	if ((amount > 0) && updateUnsyncedHeightMap) {
+		for (; len > 0; --len, ++idx) {
 			losmap[idx] += amount;
+
+			// skip if this los-square did not *enter* LOS
+			if (losmap[idx] != amount)
+				continue;
+
+			const int2 lm = IdxToCoord(idx, size.x);
+			const int2 p1 = (lm             ) * LOS2HEIGHT;
+			const int2 p2 = (lm + int2(1, 1)) * LOS2HEIGHT;
+			const int2 p3 = {std::min(p2.x, mapDims.mapxm1), std::min(p2.y, mapDims.mapym1)};
+
+			readMap->UpdateLOS(SRectangle(p1.x, p1.y,  p3.x, p3.y));
 		}
+
+		return;
+	}
+
+	for (; len > 0; --len, ++idx) {
+		losmap[idx] += amount;
 	}
 }
 
@@ -522,38 +589,6 @@ inline static constexpr size_t ToAngleMapIdx(const int2 p, const int radius)
 }
 
 
-inline void CastLos(
-	float* prvAngle,
-	float* maxAngle,
-	const int2& off,
-	std::vector<char>& losRaySquares,
-	std::vector<float>& raycastAngles,
-	int losRadius,
-	int threadNum
-) {
-	RECOIL_DETAILED_TRACY_ZONE;
-	const size_t oidx = ToAngleMapIdx(off, losRadius);
-
-	// angle to square is smaller than current max-angle, so not visible
-	if (raycastAngles[oidx] < *maxAngle) {
-		losRaySquares[oidx] = false;
-		return;
-	}
-
-	if (raycastAngles[oidx] < *prvAngle) {
-		const float invR = isqrtTableLookup(off.x * off.x + off.y * off.y, threadNum);
-		const float angle = *prvAngle - LOS_BONUS_HEIGHT * invR;
-
-		if (raycastAngles[oidx] < (*maxAngle = angle)) {
-			losRaySquares[oidx] = false;
-			return;
-		}
-	}
-
-	*prvAngle = raycastAngles[oidx];
-}
-
-
 void CLosMap::AddSquaresToInstance(SLosInstance* li, const std::vector<char>& losRaySquares) const
 {
 	RECOIL_DETAILED_TRACY_ZONE;
@@ -651,7 +686,7 @@ void CLosMap::UnsafeLosAdd(SLosInstance* li) const
 			const float invR = isqrtTableLookup(off.x*off.x + off.y*off.y, threadNum);
 			const float dh = std::max(0.0f, mipHeightMap[idx++]) - losHeight;
 
-			*(raycastAnglesPtr++) = (dh + LOS_BONUS_HEIGHT) * invR;
+			*(raycastAnglesPtr++) = (dh + LosRaycast::BONUS_HEIGHT) * invR;
 			*(losRaySquaresPtr++) = true;
 		}
 	});
@@ -659,23 +694,15 @@ void CLosMap::UnsafeLosAdd(SLosInstance* li) const
 	// cast the rays
 	losRaySquares[ToAngleMapIdx(int2(0, 0), radius)] = true;
 
-	const size_t numRays = helper.GetLosTableSize(radius);
-
-	for (size_t i = 0; i < numRays; ++i) {
-		float maxAngles[4] = {-1e7, -1e7, -1e7, -1e7};
-		float prvAngles[4] = {-1e7, -1e7, -1e7, -1e7};
+	LosRaycast::Params params;
+	params.rays = &helper.GetLosTable(radius);
+	params.isqrtTable = RADIUS_ISQRT_TABLES[threadNum].data();
+	params.angles = raycastAngles.data();
+	params.squares = losRaySquares.data();
+	params.radius = radius;
+	params.mode = LosRaycast::BOUNDS_NONE;
 
-		const size_t numSquares = helper.GetLosTableRaySize(radius, i);
-
-		for (size_t n = 0; n < numSquares; n++) {
-			const int2 square = helper.GetLosTableRaySquare(radius, i, n);
-
-			CastLos(&prvAngles[0], &maxAngles[0],       square              , losRaySquares, raycastAngles, radius, threadNum);
-			CastLos(&prvAngles[1], &maxAngles[1],      -square              , losRaySquares, raycastAngles, radius, threadNum);
-			CastLos(&prvAngles[2], &maxAngles[2], int2( square.y, -square.x), losRaySquares, raycastAngles, radius, threadNum);
-			CastLos(&prvAngles[3], &maxAngles[3], int2(-square.y,  square.x), losRaySquares, raycastAngles, radius, threadNum);
-		}
-	}
+	LosRaycast::CastRays(params);
 
 	// translate visible square indices to map square idx + RLE
 	AddSquaresToInstance(li, losRaySquares);
@@ -740,7 +767,7 @@ void CLosMap::SafeLosAdd(SLosInstance* li) const
 				const float invR = isqrtTableLookup(off.x*off.x + off.y*off.y, threadNum);
 				const float dh = std::max(0.0f, mipHeightMap[idx++]) - losHeight;
 
-				*(raycastAnglesPtr++) = (dh + LOS_BONUS_HEIGHT) * invR;
+				*(raycastAnglesPtr++) = (dh + LosRaycast::BONUS_HEIGHT) * invR;
 				*(losRaySquaresPtr++) = true;
 			}
 		}
@@ -748,76 +775,25 @@ void CLosMap::SafeLosAdd(SLosInstance* li) const
 
 
 	// Cast the Rays
-	const size_t numRays = helper.GetLosTableSize(radius);
+	LosRaycast::Params params;
+	params.rays = &helper.GetLosTable(radius);
+	params.isqrtTable = RADIUS_ISQRT_TABLES[threadNum].data();
+	params.angles = raycastAngles.data();
+	params.squares = losRaySquares.data();
+	params.radius = radius;
+	params.pos = pos;
+	params.bounds = safeRect;
 
 	if (safeRect.Inside(pos)) {
 		losRaySquares[ToAngleMapIdx(int2(0, 0), radius)] = true;
-
-		for (size_t i = 0; i < numRays; ++i) {
-			float maxAngles[4] = {-1e7, -1e7, -1e7, -1e7};
-			float prvAngles[4] = {-1e7, -1e7, -1e7, -1e7};
-
-			const size_t numSquares = helper.GetLosTableRaySize(radius, i);
-
-			for (size_t n = 0; n < numSquares; n++) {
-				const int2 square = helper.GetLosTableRaySquare(radius, i, n);
-
-				if (!safeRect.Inside(pos + square))
-					break;
-
-				CastLos(&prvAngles[0], &maxAngles[0],  square,                   losRaySquares, raycastAngles, radius, threadNum);
-			}
-			for (size_t n = 0; n < numSquares; n++) {
-				const int2 square = helper.GetLosTableRaySquare(radius, i, n);
-
-				if (!safeRect.Inside(pos - square))
-					break;
-
-				CastLos(&prvAngles[1], &maxAngles[1], -square,                   losRaySquares, raycastAngles, radius, threadNum);
-			}
-			for (size_t n = 0; n < numSquares; n++) {
-				const int2 square = helper.GetLosTableRaySquare(radius, i, n);
-
-				if (!safeRect.Inside(pos + int2(square.y, -square.x)))
-					break;
-
-				CastLos(&prvAngles[2], &maxAngles[2], int2(square.y, -square.x), losRaySquares, raycastAngles, radius, threadNum);
-			}
-			for (size_t n = 0; n < numSquares; n++) {
-				const int2 square = helper.GetLosTableRaySquare(radius, i, n);
-
-				if (!safeRect.Inside(pos + int2(-square.y, square.x)))
-					break;
-
-				CastLos(&prvAngles[3], &maxAngles[3], int2(-square.y, square.x), losRaySquares, raycastAngles, radius, threadNum);
-			}
-		}
+		params.mode = LosRaycast::BOUNDS_CLIP;
 	} else {
 		// emit position outside the map
-		for (size_t i = 0; i < numRays; ++i) {
-			float maxAngles[4] = {-1e7, -1e7, -1e7, -1e7};
-			float prvAngles[4] = {-1e7, -1e7, -1e7, -1e7};
-
-			const size_t numSquares = helper.GetLosTableRaySize(radius, i);
-
-			for (size_t n = 0; n < numSquares; n++) {
-				const int2 square = helper.GetLosTableRaySquare(radius, i, n);
-
-				if (safeRect.Inside(pos + square))
-					CastLos(&prvAngles[0], &maxAngles[0],  square,                   losRaySquares, raycastAngles, radius, threadNum);
-
-				if (safeRect.Inside(pos - square))
-					CastLos(&prvAngles[1], &maxAngles[1], -square,                   losRaySquares, raycastAngles, radius, threadNum);
-
-				if (safeRect.Inside(pos + int2(square.y, -square.x)))
-					CastLos(&prvAngles[2], &maxAngles[2], int2(square.y, -square.x), losRaySquares, raycastAngles, radius, threadNum);
-
-				if (safeRect.Inside(pos + int2(-square.y, square.x)))
-					CastLos(&prvAngles[3], &maxAngles[3], int2(-square.y, square.x), losRaySquares, raycastAngles, radius, threadNum);
-			}
-		}
+		params.mode = LosRaycast::BOUNDS_SKIP;
 	}
 
+	LosRaycast::CastRays(params);
+
 	// translate visible square indices to map square idx + RLE
 	AddSquaresToInstance(li, losRaySquares);
 }
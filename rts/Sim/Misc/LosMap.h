@@ -40,6 +40,14 @@ public:
 	/// arbitrary area, for losMap, non-circular radar maps, ...
 	void AddRaycast(SLosInstance* instance, int amount);
 
+	/**
+	 * replaces the sight of <prvInstance> by that of <curInstance>, touching
+	 * only squares that are covered by one of them but not the other; both
+	 * must already be raycast. Returns the number of squares left untouched,
+	 * <numChanged> receives the number of squares that were (un)counted.
+	 */
+	size_t AddRaycastDelta(const SLosInstance* prvInstance, const SLosInstance* curInstance, size_t& numChanged);
+
 	/// arbitrary area, for losMap, non-circular radar maps, ...
 	void PrepareRaycast(SLosInstance* instance) const;
 
@@ -60,6 +68,8 @@ private:
 
 	void AddSquaresToInstance(SLosInstance* li, const std::vector<char>& losRaySquares) const;
 
+	void AddSquares(int idx, int len, int amount, bool updateUnsyncedHeightMap);
+
 protected:
 	int2 size;
 	int2 LOS2HEIGHT;
@@ -0,0 +1,213 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include "LosRaycast.h"
+
+#include "xsimd/xsimd.hpp"
+
+#include "System/Misc/TracyDefs.h"
+
+
+static bool useSIMD = true;
+
+
+void LosRaycast::SetUseSIMD(bool b) { useSIMD = b; }
+bool LosRaycast::GetUseSIMD() { return useSIMD; }
+
+void LosRaycast::CastRays(const Params& params)
+{
+	if (useSIMD) {
+		CastRaysSIMD(params);
+	} else {
+		CastRaysScalar(params);
+	}
+}
+
+
+
+inline static constexpr size_t ToAngleMapIdx(const int2 p, const int radius)
+{
+	// [-radius, +radius]^2 -> [0, +2*radius]^2 -> idx
+	return (p.y + radius) * (2 * radius + 1) + (p.x + radius);
+}
+
+// the four quadrant mirrors of a ray square
+inline static void GetMirroredSquares(const int2 square, int2* mirrors)
+{
+	mirrors[0] = square;
+	mirrors[1] = -square;
+	mirrors[2] = int2( square.y, -square.x);
+	mirrors[3] = int2(-square.y,  square.x);
+}
+
+
+inline static void CastLos(
+	float* prvAngle,
+	float* maxAngle,
+	const int2& off,
+	const LosRaycast::Params& params
+) {
+	const size_t oidx = ToAngleMapIdx(off, params.radius);
+	const float angle = params.angles[oidx];
+
+	// angle to square is smaller than current max-angle, so not visible
+	if (angle < *maxAngle) {
+		params.squares[oidx] = false;
+		return;
+	}
+
+	if (angle < *prvAngle) {
+		const float invR = params.isqrtTable[off.x * off.x + off.y * off.y];
+		const float hillAngle = *prvAngle - LosRaycast::BONUS_HEIGHT * invR;
+
+		if (angle < (*maxAngle = hillAngle)) {
+			params.squares[oidx] = false;
+			return;
+		}
+	}
+
+	*prvAngle = angle;
+}
+
+
+void LosRaycast::CastRaysScalar(const Params& params)
+{
+	RECOIL_DETAILED_TRACY_ZONE;
+	const LosTable& rays = *params.rays;
+
+	const int2 pos = params.pos;
+	const SRectangle& bounds = params.bounds;
+
+	int2 mirrors[4];
+
+	switch (params.mode) {
+		case BOUNDS_NONE: {
+			for (const LosLine& ray: rays) {
+				float maxAngles[4] = {-1e7, -1e7, -1e7, -1e7};
+				float prvAngles[4] = {-1e7, -1e7, -1e7, -1e7};
+
+				for (const int2 square: ray) {
+					GetMirroredSquares(square, mirrors);
+
+					for (int k = 0; k < 4; k++) {
+						CastLos(&prvAngles[k], &maxAngles[k], mirrors[k], params);
+					}
+				}
+			}
+		} break;
+
+		case BOUNDS_CLIP: {
+			// each mirrored ray ends where it first leaves the map
+			for (const LosLine& ray: rays) {
+				float maxAngles[4] = {-1e7, -1e7, -1e7, -1e7};
+				float prvAngles[4] = {-1e7, -1e7, -1e7, -1e7};
+
+				for (int k = 0; k < 4; k++) {
+					for (const int2 square: ray) {
+						GetMirroredSquares(square, mirrors);
+
+						if (!bounds.Inside(pos + mirrors[k]))
+							break;
+
+						CastLos(&prvAngles[k], &maxAngles[k], mirrors[k], params);
+					}
+				}
+			}
+		} break;
+
+		case BOUNDS_SKIP: {
+			for (const LosLine& ray: rays) {
+				float maxAngles[4] = {-1e7, -1e7, -1e7, -1e7};
+				float prvAngles[4] = {-1e7, -1e7, -1e7, -1e7};
+
+				for (const int2 square: ray) {
+					GetMirroredSquares(square, mirrors);
+
+					for (int k = 0; k < 4; k++) {
+						if (bounds.Inside(pos + mirrors[k]))
+							CastLos(&prvAngles[k], &maxAngles[k], mirrors[k], params);
+					}
+				}
+			}
+		} break;
+	}
+}
+
+
+void LosRaycast::CastRaysSIMD(const Params& params)
+{
+	RECOIL_DETAILED_TRACY_ZONE;
+	// one lane per quadrant mirror; all four share the same distance to the
+	// origin (and hence invR) at every step along the ray
+	using batch_type = xsimd::batch<float, 4>;
+	using bool_type = xsimd::batch_bool<float, 4>;
+
+	const LosTable& rays = *params.rays;
+
+	const int2 pos = params.pos;
+	const SRectangle& bounds = params.bounds;
+
+	const int radius = params.radius;
+
+	int2 mirrors[4];
+	size_t oidx[4];
+
+	alignas(16) float angles[4];
+	alignas(16) bool hidden[4];
+	alignas(16) bool active[4];
+
+	for (const LosLine& ray: rays) {
+		batch_type maxAngles(-1e7f);
+		batch_type prvAngles(-1e7f);
+
+		// lanes that stopped (BOUNDS_CLIP) or skip this square (BOUNDS_SKIP)
+		// leave their state and the bitmap untouched
+		active[0] = active[1] = active[2] = active[3] = true;
+
+		for (const int2 square: ray) {
+			GetMirroredSquares(square, mirrors);
+
+			if (params.mode != BOUNDS_NONE) {
+				for (int k = 0; k < 4; k++) {
+					const bool inside = bounds.Inside(pos + mirrors[k]);
+
+					if (params.mode == BOUNDS_CLIP) {
+						active[k] = active[k] && inside;
+					} else {
+						active[k] = inside;
+					}
+				}
+
+				if (params.mode == BOUNDS_CLIP && !(active[0] || active[1] || active[2] || active[3]))
+					break;
+			}
+
+			for (int k = 0; k < 4; k++) {
+				oidx[k] = ToAngleMapIdx(mirrors[k], radius);
+				angles[k] = active[k]? params.angles[oidx[k]]: 0.0f;
+			}
+
+			const float invR = params.isqrtTable[square.x * square.x + square.y * square.y];
+
+			const batch_type curAngles = xsimd::load_aligned(&angles[0]);
+			const batch_type hillAngles = prvAngles - batch_type(BONUS_HEIGHT * invR);
+			const bool_type activeMask = bool_type().load_aligned(&active[0]);
+
+			// mirrors CastLos: below the last hilltop, or below the
+			// hilltop just passed (which then becomes the new one)
+			const bool_type belowMax = (curAngles < maxAngles);
+			const bool_type belowPrv = (~belowMax) & (curAngles < prvAngles) & activeMask;
+			const bool_type belowHill = belowPrv & (curAngles < hillAngles);
+			const bool_type isHidden = belowMax | belowHill;
+
+			maxAngles = xsimd::select(belowPrv, hillAngles, maxAngles);
+			prvAngles = xsimd::select(isHidden | (~activeMask), prvAngles, curAngles);
+
+			isHidden.store_aligned(&hidden[0]);
+
+			for (int k = 0; k < 4; k++) {
+				if (active[k] && hidden[k])
+					params.squares[oidx[k]] = false;
+			}
+		}
+	}
+}
@@ -0,0 +1,62 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#ifndef LOS_RAYCAST_H
+#define LOS_RAYCAST_H
+
+#include <vector>
+
+#include "System/type2.h"
+#include "System/Rectangle.h"
+
+
+/**
+ * Terrain raycast kernels used by CLosMap.
+ *
+ * A raycast walks every precalculated ray (see CLosTableHelper) outwards from
+ * the instance's origin, mirrored into all four quadrants, and clears each
+ * square whose elevation angle is hidden behind an earlier one on the same ray.
+ * The scalar and SIMD kernels produce identical visibility bitmaps, the SIMD one
+ * advances the four mirrored copies of a ray in lock-step.
+ */
+namespace LosRaycast {
+	typedef std::vector<int2> LosLine;
+	typedef std::vector<LosLine> LosTable;
+
+	/// extra height added to every square's elevation angle
+	constexpr float BONUS_HEIGHT = 5.0f;
+
+	enum BoundsMode {
+		BOUNDS_NONE, ///< circle lies fully inside the map
+		BOUNDS_CLIP, ///< origin inside the map, a ray stops where it leaves it
+		BOUNDS_SKIP, ///< origin outside the map, squares outside it are skipped
+	};
+
+	struct Params {
+		const LosTable* rays = nullptr;
+
+		/// 1/sqrt(r), indexed by squared distance to the origin
+		const float* isqrtTable = nullptr;
+		/// elevation angle per square, (2 * radius + 1)^2 entries
+		const float* angles = nullptr;
+		/// visibility per square, same layout as angles
+		char* squares = nullptr;
+
+		int radius = 0;
+
+		/// origin and map rectangle in los-map coordinates, not used for BOUNDS_NONE
+		int2 pos;
+		SRectangle bounds;
+		BoundsMode mode = BOUNDS_NONE;
+	};
+
+	void CastRaysScalar(const Params& params);
+	void CastRaysSIMD(const Params& params);
+
+	/// dispatches to one of the above, see SetUseSIMD
+	void CastRays(const Params& params);
+
+	void SetUseSIMD(bool b);
+	bool GetUseSIMD();
+}
+
+#endif // LOS_RAYCAST_H
@@ -217,6 +217,11 @@ public:
 	/// Enable to reduce CPU usage, but also reduce quality of resultant paths.
 	bool qtLowerQualityPaths;
 
+	/// Skip re-tesselating (and requeueing paths through) map damage blocks whose speedmods
+	/// and blocking did not actually change, e.g. when a crater or building placement leaves
+	/// the passability of a region as it was.
+	bool qtIncrementalRepair;
+
 	float pfRawDistMult;
 	float pfUpdateRateScale;
 
@@ -233,6 +238,19 @@ public:
 
 	int quadFieldQuadSizeInElmos;
 
+	/// Score weapon auto-target candidates on all cores, then run the AllowWeaponTarget
+	/// and TargetWeight call-ins on the sim thread. Results do not depend on the number
+	/// of threads. Candidates are scored before the serial unit SlowUpdate pass, so a
+	/// weapon whose script switches its AimFromWeapon or QueryWeapon piece in that pass
+	/// may pick a different target than the single-threaded path would.
+	bool parallelWeaponTargeting;
+
+	/// Run the kinematic part of synced projectile updates (plasma and EMG projectiles)
+	/// on all cores before the serial update pass. Results do not depend on the number of
+	/// threads, but a projectile observing another one in the same frame (interceptors,
+	/// Lua call-ins) may see it already moved, unlike the single-threaded path.
+	bool parallelProjectileUpdate;
+
 	bool allowTake;
 	bool allowEnginePlayerlist;
 
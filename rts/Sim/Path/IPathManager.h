@@ -152,6 +152,29 @@ public:
 		return 0;
 	}
 
+	struct PathRequest {
+		CSolidObject* caller;
+		const MoveDef* moveDef;
+		float3 startPos;
+		float3 goalPos;
+		float goalRadius;
+	};
+
+	/**
+	 * Batched form of RequestPath; pathIDs[i] receives the result of
+	 * requests[i]. Implementations may evaluate unsynced batches in
+	 * parallel, the default simply issues one request after another.
+	 * Synced batches gain nothing over separate RequestPath calls.
+	 */
+	virtual void RequestPaths(const std::vector<PathRequest>& requests, std::vector<unsigned int>& pathIDs, bool synced) {
+		pathIDs.clear();
+		pathIDs.reserve(requests.size());
+
+		for (const PathRequest& r: requests) {
+			pathIDs.push_back(RequestPath(r.caller, r.moveDef, r.startPos, r.goalPos, r.goalRadius, synced));
+		}
+	}
+
 	/**
 	 * Whenever there are any changes in the terrain
 	 * (examples: explosions, new buildings, etc.)
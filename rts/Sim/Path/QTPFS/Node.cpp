@@ -500,6 +500,8 @@ void QTPFS::QTNode::Tesselate(NodeLayer& nl, const SRectangle& r, unsigned int d
 	// technically required whenever numRefBinSquares is zero, ie.
 	// when ALL squares in <r> changed bins in unison
 	//
+	nl.IncreaseTesselatedNodeCounter();
+
 	UpdateMoveCost(threadData, nl, r, numNewBinSquares, numDifBinSquares, numClosedSquares, wantSplit, needSplit);
 	if (!needSplit && !AllSquaresImpassable()) {
 		UpdateExitOnly(nl, needSplit);
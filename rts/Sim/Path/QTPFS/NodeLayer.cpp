@@ -75,6 +75,10 @@ void QTPFS::NodeLayer::Init(unsigned int layerNum) {
 	curSpeedMods.resize(QTPFS_MAX_NODE_SIZE*QTPFS_MAX_NODE_SIZE,  0);
 	curSpeedBins.resize(QTPFS_MAX_NODE_SIZE*QTPFS_MAX_NODE_SIZE, -1);
 
+	blockHashes.clear();
+	if (modInfo.qtIncrementalRepair)
+		blockHashes.resize((xsize / QTPFS_MAP_DAMAGE_SIZE) * (zsize / QTPFS_MAP_DAMAGE_SIZE), 0);
+
 	MoveDef* md = moveDefHandler.GetMoveDefByPathType(layerNum);
 	useShortestPath = md->preferShortestPath;
 }
@@ -83,6 +87,7 @@ void QTPFS::NodeLayer::Clear() {
 	RECOIL_DETAILED_TRACY_ZONE;
 	curSpeedMods.clear();
 	curSpeedBins.clear();
+	blockHashes.clear();
 }
 
 
@@ -193,7 +198,58 @@ bool QTPFS::NodeLayer::Update(UpdateThreadData& threadData) {
 		}
 	}
 
-	return true;
+	if (blockHashes.empty())
+		return true;
+
+	return UpdateBlockHashes(r);
+}
+
+// Compares the freshly computed speedmods and bins of every damage block in <r> against
+// the ones the current tesselation was built from. Re-tesselating a node whose squares are
+// all unchanged would produce the same tree, so the caller can skip it (and leave the paths
+// running through it alone) when this returns false.
+bool QTPFS::NodeLayer::UpdateBlockHashes(const SRectangle& r) {
+	RECOIL_DETAILED_TRACY_ZONE;
+	constexpr int blockSize = QTPFS_MAP_DAMAGE_SIZE;
+
+	// node rectangles are at least one damage block in size and aligned to it
+	assert((r.x1 % blockSize) == 0 && (r.z1 % blockSize) == 0);
+	assert((r.x2 % blockSize) == 0 && (r.z2 % blockSize) == 0);
+
+	const int rw = r.GetWidth();
+	const int blocksPerRow = xsize / blockSize;
+
+	bool changed = false;
+
+	for (int bz = r.z1; bz < r.z2; bz += blockSize) {
+		for (int bx = r.x1; bx < r.x2; bx += blockSize) {
+			// FNV-1a; 0 is reserved for blocks that have never been tesselated
+			std::uint64_t hash = 14695981039346656037ull;
+
+			for (int hmz = bz; hmz < bz + blockSize; hmz++) {
+				const unsigned int recIdx = (hmz - r.z1) * rw + (bx - r.x1);
+
+				for (int i = 0; i < blockSize; i++) {
+					hash = (hash ^ curSpeedMods[recIdx + i]) * 1099511628211ull;
+					hash = (hash ^ curSpeedBins[recIdx + i]) * 1099511628211ull;
+				}
+			}
+
+			hash += (hash == 0);
+
+			std::uint64_t& blockHash = blockHashes[(bz / blockSize) * blocksPerRow + (bx / blockSize)];
+
+			if (blockHash != hash) {
+				blockHash = hash;
+				changed = true;
+			}
+		}
+	}
+
+	numRepairedBlocks += changed;
+	numSkippedBlocks += !changed;
+
+	return changed;
 }
 
 
@@ -111,6 +111,21 @@ namespace QTPFS {
 
 		void IncreaseOpenNodeCounter() { numOpenNodes++; }
 		void IncreaseClosedNodeCounter() { numClosedNodes++; }
+		void IncreaseTesselatedNodeCounter() { numTesselatedNodes++; }
+
+		// incremental repair statistics, collected (and reset) by the PathManager each frame
+		struct RepairStats {
+			unsigned int numRepairedBlocks = 0;
+			unsigned int numSkippedBlocks = 0;
+			unsigned int numTesselatedNodes = 0;
+		};
+		RepairStats PopRepairStats() {
+			RepairStats stats = {numRepairedBlocks, numSkippedBlocks, numTesselatedNodes};
+			numRepairedBlocks = 0;
+			numSkippedBlocks = 0;
+			numTesselatedNodes = 0;
+			return stats;
+		}
 
 		unsigned int GetNumOpenNodes() const { return numOpenNodes; }
 		unsigned int GetNumClosedNodes() const { return numClosedNodes; }
@@ -122,11 +137,13 @@ namespace QTPFS {
 		unsigned int GetNumLeafNodes() const { return numLeafNodes; }
 
 		SpeedBinType GetSpeedModBin(float absSpeedMod, float relSpeedMod) const;
+		bool UpdateBlockHashes(const SRectangle& r);
 
 		std::uint64_t GetMemFootPrint() const {
 			std::uint64_t memFootPrint = sizeof(NodeLayer);
 			memFootPrint += (curSpeedMods.size() * sizeof(SpeedModType));
 			memFootPrint += (curSpeedBins.size() * sizeof(SpeedBinType));
+			memFootPrint += (blockHashes.size() * sizeof(decltype(blockHashes)::value_type));
 
 			memFootPrint += (selectedNodes.size() * sizeof(decltype(selectedNodes)::value_type));
 			memFootPrint += (openNodes.size()     * sizeof(decltype(openNodes)::value_type));
@@ -175,6 +192,10 @@ namespace QTPFS {
 		std::vector<SpeedModType> curSpeedMods;
 		std::vector<SpeedBinType> curSpeedBins;
 
+		// hash of the speedmods and bins of each QTPFS_MAP_DAMAGE_SIZE block as of the
+		// last time it was tesselated; empty unless modInfo.qtIncrementalRepair is set
+		std::vector<std::uint64_t> blockHashes;
+
 public:
 		static constexpr unsigned int NUM_POOL_CHUNKS = sizeof(poolNodes) / sizeof(poolNodes[0]);
 		static constexpr unsigned int POOL_TOTAL_SIZE = (1024 * 1024) / 2;
@@ -215,6 +236,9 @@ private:
 		unsigned int updateCounter = 0;
 		unsigned int numOpenNodes = 0;
 		unsigned int numClosedNodes = 0;
+		unsigned int numRepairedBlocks = 0;
+		unsigned int numSkippedBlocks = 0;
+		unsigned int numTesselatedNodes = 0;
 
 		int32_t maxNodesAlloced = 0;
 		int32_t numRootNodes = 0;
@@ -720,6 +720,14 @@ void QTPFS::PathManager::Update() {
 			for (int i = 0; i < blocksToUpdate; ++i) { UpdateNodeLayer(layerNum, rect, curThread); }
 		});
 
+		mapDamageStats = {};
+		for (auto& nodeLayer : nodeLayers) {
+			const NodeLayer::RepairStats layerStats = nodeLayer.PopRepairStats();
+			mapDamageStats.numRepairedBlocks += layerStats.numRepairedBlocks;
+			mapDamageStats.numSkippedBlocks += layerStats.numSkippedBlocks;
+			mapDamageStats.numTesselatedNodes += layerStats.numTesselatedNodes;
+		}
+
 		// Mark all dirty paths so that they can be recalculated
 		int pathsMarkedDirty = 0;
 		for (auto& layerDirtyPaths : pathCache.dirtyPaths) {
@@ -782,6 +790,12 @@ void QTPFS::PathManager::Update() {
 		}
 		if (refreshDirtyPathRateFrame == QTPFS_LAST_FRAME && pathsMarkedDirty > 0)
 			refreshDirtyPathRateFrame = gs->frameNum + GAME_SPEED;
+
+		mapDamageStats.numRequeuedPaths = pathsMarkedDirty;
+
+		TracyPlot("QTPFS::TesselatedNodes", int64_t(mapDamageStats.numTesselatedNodes));
+		TracyPlot("QTPFS::SkippedDamageBlocks", int64_t(mapDamageStats.numSkippedBlocks));
+		TracyPlot("QTPFS::RequeuedPaths", int64_t(pathsMarkedDirty));
 	}
 }
 
@@ -882,11 +896,33 @@ void QTPFS::PathManager::ExecuteQueuedSearches() {
 
 	auto pathView = registry.group<PathSearch, ProcessPath>();
 
+	// hand out the (probably) most expensive searches first so that one long
+	// search picked up last does not keep every other worker waiting on it;
+	// the results do not depend on execution order, only on the serial loop
+	// below, so this is sync-safe
+	searchDispatchOrder.clear();
+	searchDispatchOrder.reserve(pathView.size());
+
+	for (const entt::entity pathSearchEntity: pathView) {
+		const PathSearch& search = pathView.get<PathSearch>(pathSearchEntity);
+		const IPath* path = registry.try_get<IPath>((entt::entity)search.GetID());
+
+		float cost = 0.0f;
+
+		if (path != nullptr)
+			cost = path->GetSourcePoint().SqDistance2D(path->GetGoalPosition());
+
+		searchDispatchOrder.emplace_back(cost, pathSearchEntity);
+	}
+
+	std::stable_sort(searchDispatchOrder.begin(), searchDispatchOrder.end(), [](const auto& a, const auto& b) {
+		return (a.first > b.first);
+	});
+
 	// execute pending searches collected via
 	// RequestPath and QueueDeadPathSearches
-	for_mt(0, pathView.size(), [this, &pathView](int i){
-		entt::entity pathSearchEntity = pathView.begin()[i];
-        // entt::entity pathSearchEntity = pathView.storage<PathSearch>()[i];
+	for_mt(0, searchDispatchOrder.size(), [this, &pathView](int i){
+		entt::entity pathSearchEntity = searchDispatchOrder[i].second;
 
 		assert(registry.valid(pathSearchEntity));
 		assert(registry.all_of<PathSearch>(pathSearchEntity));
@@ -1457,6 +1493,69 @@ unsigned int QTPFS::PathManager::RequestPath(
 	return returnPathId;
 }
 
+void QTPFS::PathManager::RequestPaths(
+	const std::vector<PathRequest>& requests,
+	std::vector<unsigned int>& pathIDs,
+	bool synced
+) {
+	RECOIL_DETAILED_TRACY_ZONE;
+
+	pathIDs.clear();
+	pathIDs.resize(requests.size(), 0);
+
+	if (!IsFinalized())
+		return;
+
+	for (size_t i = 0; i < requests.size(); ++i) {
+		const PathRequest& r = requests[i];
+
+		assert(r.startPos.x != 0.f || r.startPos.z != 0.f);
+
+		pathIDs[i] = QueueSearch(r.caller, r.moveDef, r.startPos, r.goalPos, r.goalRadius, synced, synced);
+	}
+
+	// Synced searches are executed with everything else in the next Update.
+	// Requests sharing a goal are not given a shared goal-side search tree:
+	// PathSearch expands from both ends and stops where the two frontiers
+	// meet, so a reverse tree grown for one unit would move the meeting point
+	// (and the resulting path) of every other unit in the batch. Paths would
+	// then depend on which units happened to be ordered together, instead of
+	// being identical to what RequestPath returns for each unit on its own.
+	if (synced)
+		return;
+
+	// Unsynced calls are expected to resolve immediately. Initialization can
+	// touch the shared path maps so it stays serial, the searches themselves
+	// only write to their own path and per-thread node data.
+	std::vector<entt::entity> searchEntities(requests.size(), entt::null);
+
+	for (size_t i = 0; i < requests.size(); ++i) {
+		if (pathIDs[i] == 0)
+			continue;
+
+		searchEntities[i] = registry.get<PathSearchRef>(entt::entity(pathIDs[i])).value;
+		assert(registry.valid(searchEntities[i]));
+
+		InitializeSearch(searchEntities[i]);
+	}
+
+	for_mt(0, searchEntities.size(), [this, &searchEntities](int i) {
+		if (searchEntities[i] == entt::null)
+			return;
+
+		PathSearch& pathSearch = registry.get<PathSearch>(searchEntities[i]);
+		int pathType = pathSearch.GetPathType();
+		ExecuteSearch(&pathSearch, nodeLayers[pathType], pathType);
+	});
+
+	for (size_t i = 0; i < requests.size(); ++i) {
+		if (pathIDs[i] == 0)
+			continue;
+
+		pathIDs[i] = CompleteUnsyncedSearch(pathIDs[i], searchEntities[i]);
+	}
+}
+
 unsigned int QTPFS::PathManager::ExecuteUnsyncedSearch(unsigned int pathId){
 	RECOIL_DETAILED_TRACY_ZONE;
 	entt::entity pathEntity = entt::entity(pathId);
@@ -1470,6 +1569,13 @@ unsigned int QTPFS::PathManager::ExecuteUnsyncedSearch(unsigned int pathId){
 	NodeLayer& nodeLayer = nodeLayers[pathType];
 	ExecuteSearch(&pathSearch, nodeLayer, pathType);
 
+	return CompleteUnsyncedSearch(pathId, pathSearchEntity);
+}
+
+unsigned int QTPFS::PathManager::CompleteUnsyncedSearch(unsigned int pathId, entt::entity pathSearchEntity) {
+	entt::entity pathEntity = entt::entity(pathId);
+	const PathSearch& pathSearch = registry.get<PathSearch>(pathSearchEntity);
+
 	if (registry.valid(pathEntity)) {
 		IPath* path = registry.try_get<IPath>(pathEntity);
 		if (path != nullptr) {
@@ -28,6 +28,12 @@ namespace QTPFS {
 			std::vector<bool> damageMap;
 			std::deque<int> damageQueue;
 		};
+		struct MapDamageStats {
+			unsigned int numRepairedBlocks = 0;  // damage blocks whose nodes were re-tesselated
+			unsigned int numSkippedBlocks = 0;   // damage blocks left alone since nothing changed
+			unsigned int numTesselatedNodes = 0; // nodes (re)built by the repairs
+			unsigned int numRequeuedPaths = 0;   // paths marked dirty by the repairs
+		};
 		struct NodeLayersChangeTrack {
 			std::vector<MapChangeTrack> mapChangeTrackers;
 			int width = 0;
@@ -65,6 +71,12 @@ namespace QTPFS {
 			bool synced
 		) override;
 
+		void RequestPaths(
+			const std::vector<PathRequest>& requests,
+			std::vector<unsigned int>& pathIDs,
+			bool synced
+		) override;
+
 		float3 NextWayPoint(
 			const CSolidObject*, // owner
 			unsigned int pathID,
@@ -88,6 +100,7 @@ namespace QTPFS {
 
 		const NodeLayer& GetNodeLayer(unsigned int pathType) const { return nodeLayers[pathType]; }
 		const NodeLayersChangeTrack& GetMapDamageTrack() const { return nodeLayersMapDamageTrack; };
+		const MapDamageStats& GetMapDamageStats() const { return mapDamageStats; }
 
 		const spring::unordered_map<unsigned int, PathSearchTrace::Execution*>& GetPathTraces() const { return pathTraces; }
 
@@ -156,6 +169,7 @@ namespace QTPFS {
 		);
 
 		unsigned int ExecuteUnsyncedSearch(unsigned int pathId);
+		unsigned int CompleteUnsyncedSearch(unsigned int pathId, entt::entity pathSearchEntity);
 
 		bool IsFinalized() const { return isFinalized; }
 
@@ -174,10 +188,14 @@ namespace QTPFS {
 		SharedPathMap sharedPaths;
 		PartialSharedPathMap partialSharedPaths;
 
+		// (estimated cost, search entity), most expensive first
+		std::vector<std::pair<float, entt::entity>> searchDispatchOrder;
+
 		// std::vector<unsigned int> numCurrExecutedSearches;
 		// std::vector<unsigned int> numPrevExecutedSearches;
 
 		NodeLayersChangeTrack nodeLayersMapDamageTrack;
+		MapDamageStats mapDamageStats;
 
 		int deadPathsToUpdatePerFrame = 1;
 		int recalcDeadPathUpdateRateOnFrame = 0;
@@ -0,0 +1,100 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include <algorithm>
+
+#include "BallisticKinematics.h"
+#include "Projectile.h"
+#include "System/Threading/ThreadPool.h"
+
+#include "xsimd/xsimd.hpp"
+
+#include "System/Misc/TracyDefs.h"
+
+
+static constexpr size_t KINEMATICS_BLOCK_SIZE = 1024;
+
+
+void CBallisticKinematics::Clear()
+{
+	projectiles.clear();
+
+	posX.clear(); posY.clear(); posZ.clear();
+	velX.clear(); velY.clear(); velZ.clear();
+	dirX.clear(); dirY.clear(); dirZ.clear();
+	gravity.clear();
+}
+
+void CBallisticKinematics::Add(CProjectile* p)
+{
+	assert(p->HasBallisticKinematics());
+	projectiles.push_back(p);
+
+	posX.push_back(p->pos.x);   posY.push_back(p->pos.y);   posZ.push_back(p->pos.z);
+	velX.push_back(p->speed.x); velY.push_back(p->speed.y); velZ.push_back(p->speed.z);
+	dirX.push_back(p->dir.x);   dirY.push_back(p->dir.y);   dirZ.push_back(p->dir.z);
+	gravity.push_back(p->mygravity);
+}
+
+
+void CBallisticKinematics::Update()
+{
+	RECOIL_DETAILED_TRACY_ZONE;
+	const size_t numBlocks = (projectiles.size() + KINEMATICS_BLOCK_SIZE - 1) / KINEMATICS_BLOCK_SIZE;
+
+	for_mt(0, numBlocks, [this](int i) {
+		UpdateBlock(i * KINEMATICS_BLOCK_SIZE, std::min((i + 1) * KINEMATICS_BLOCK_SIZE, projectiles.size()));
+	});
+}
+
+void CBallisticKinematics::UpdateBlock(size_t beg, size_t end)
+{
+	using batch_type = xsimd::simd_type<float>;
+	constexpr size_t simdSize = xsimd::simd_traits<float>::size;
+
+	const size_t simdEnd = beg + ((end - beg) / simdSize) * simdSize;
+
+	// NOTE:
+	//   every operation mirrors CProjectile::Update and SetVelocityAndSpeed
+	//   one-to-one (including the zero x- and z-components of the gravity
+	//   vector), so results are bit-identical to the per-object path
+	for (size_t i = beg; i < simdEnd; i += simdSize) {
+		const batch_type g = xsimd::load_unaligned(&gravity[i]);
+		const batch_type zg = batch_type(0.0f) * g;
+
+		const batch_type vx = xsimd::load_unaligned(&velX[i]) + zg;
+		const batch_type vy = xsimd::load_unaligned(&velY[i]) + g;
+		const batch_type vz = xsimd::load_unaligned(&velZ[i]) + zg;
+
+		const batch_type w = xsimd::sqrt(vx * vx + vy * vy + vz * vz);
+		const batch_type iw = batch_type(1.0f) / w;
+		const auto hasSpeed = (w > batch_type(0.0f));
+
+		xsimd::store_unaligned(&velX[i], vx);
+		xsimd::store_unaligned(&velY[i], vy);
+		xsimd::store_unaligned(&velZ[i], vz);
+		// reuse the gravity lane for speed.w, it is not needed after this
+		xsimd::store_unaligned(&gravity[i], w);
+
+		xsimd::store_unaligned(&dirX[i], xsimd::select(hasSpeed, vx * iw, xsimd::load_unaligned(&dirX[i])));
+		xsimd::store_unaligned(&dirY[i], xsimd::select(hasSpeed, vy * iw, xsimd::load_unaligned(&dirY[i])));
+		xsimd::store_unaligned(&dirZ[i], xsimd::select(hasSpeed, vz * iw, xsimd::load_unaligned(&dirZ[i])));
+
+		xsimd::store_unaligned(&posX[i], xsimd::load_unaligned(&posX[i]) + vx);
+		xsimd::store_unaligned(&posY[i], xsimd::load_unaligned(&posY[i]) + vy);
+		xsimd::store_unaligned(&posZ[i], xsimd::load_unaligned(&posZ[i]) + vz);
+	}
+
+	for (size_t i = beg; i < simdEnd; i++) {
+		CProjectile* p = projectiles[i];
+
+		p->speed = float4(velX[i], velY[i], velZ[i], gravity[i]);
+		p->dir = float3(dirX[i], dirY[i], dirZ[i]);
+		p->pos = float3(posX[i], posY[i], posZ[i]);
+		p->FinishKinematics();
+	}
+
+	// remainder that does not fill a whole batch
+	for (size_t i = simdEnd; i < end; i++) {
+		projectiles[i]->UpdateKinematics();
+	}
+}
@@ -0,0 +1,40 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#ifndef BALLISTIC_KINEMATICS_H
+#define BALLISTIC_KINEMATICS_H
+
+#include <cstddef>
+#include <vector>
+
+class CProjectile;
+
+/**
+ * Structure-of-arrays scratch store for projectiles whose kinematic step is
+ * plain ballistic motion (speed += gravity; pos += speed), see
+ * CProjectile::HasBallisticKinematics. The step is done in bulk with SIMD
+ * and produces bit-identical results to CProjectile::Update.
+ */
+class CBallisticKinematics
+{
+public:
+	void Clear();
+	void Add(CProjectile* p);
+
+	/// runs the kernel for every added projectile and writes the results back
+	void Update();
+
+	size_t Size() const { return projectiles.size(); }
+
+private:
+	void UpdateBlock(size_t beg, size_t end);
+
+private:
+	std::vector<CProjectile*> projectiles;
+
+	std::vector<float> posX, posY, posZ;
+	std::vector<float> velX, velY, velZ;
+	std::vector<float> dirX, dirY, dirZ;
+	std::vector<float> gravity;
+};
+
+#endif // BALLISTIC_KINEMATICS_H
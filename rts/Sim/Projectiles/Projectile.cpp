@@ -31,6 +31,7 @@ CR_REG_METADATA(CProjectile,
 
 	CR_IGNORED(createMe),
 	CR_MEMBER(deleteMe),
+	CR_IGNORED(kinematicsUpdated),
 
 	CR_MEMBER(drawSorted),
 
@@ -46,6 +46,14 @@ public:
 	//Not inheritable - used for removing a projectile from Lua.
 	void Delete();
 	virtual void Update();
+	// optional kinematic part of Update() that only touches our own state (position, speed,
+	// ttl) and may therefore run on worker threads; if a subclass implements it, it should
+	// set <kinematicsUpdated> and skip the same step in its subsequent serial Update() call
+	virtual void UpdateKinematics() {}
+	// true if UpdateKinematics() amounts to CProjectile::Update() followed by
+	// FinishKinematics(), which allows stepping it in bulk (CBallisticKinematics)
+	virtual bool HasBallisticKinematics() const { return false; }
+	virtual void FinishKinematics() { kinematicsUpdated = true; }
 	virtual void Init(const CUnit* owner, const float3& offset) override;
 
 	virtual void Draw() {}
@@ -108,6 +116,7 @@ public:
 
 	bool createMe =  true;
 	bool deleteMe = false;
+	bool kinematicsUpdated = false;
 
 	bool castShadow = false;
 	bool drawSorted = true;
@@ -15,6 +15,7 @@
 #include "Sim/Misc/CollisionHandler.h"
 #include "Sim/Misc/CollisionVolume.h"
 #include "Sim/Misc/GlobalSynced.h"
+#include "Sim/Misc/ModInfo.h"
 #include "Sim/Misc/QuadField.h"
 #include "Sim/Misc/TeamHandler.h"
 #include "Rendering/Env/Particles/Classes/NanoProjectile.h"
@@ -55,7 +56,8 @@ CR_REG_METADATA(CProjectileHandler, (
 	CR_MEMBER(maxNanoParticles),
 	CR_MEMBER(currentNanoParticles),
 	CR_MEMBER_UN(frameCurrentParticles),
-	CR_MEMBER_UN(frameProjectileCounts)
+	CR_MEMBER_UN(frameProjectileCounts),
+	CR_IGNORED(ballisticKinematics)
 ))
 
 
@@ -191,6 +193,26 @@ void CProjectileHandler::UpdateProjectilesImpl()
 
 	// WARNING: same as above but for p->Update()
 	if constexpr (synced) {
+		if (modInfo.parallelProjectileUpdate) {
+			// kinematics only touch per-projectile state; everything with
+			// side-effects (collisions, explosions, CEG spawns, quadfield
+			// moves) still happens below in container order
+			SCOPED_TIMER("Sim::Projectiles::UpdateSyncedMT");
+
+			ballisticKinematics.Clear();
+
+			for (size_t i = 0; i < pc.size(); ++i) {
+				if (pc[i]->HasBallisticKinematics())
+					ballisticKinematics.Add(pc[i]);
+			}
+
+			ballisticKinematics.Update();
+
+			for_mt_chunk(0, pc.size(), [&pc](int i) {
+				if (!pc[i]->HasBallisticKinematics())
+					pc[i]->UpdateKinematics();
+			});
+		}
 
 		SCOPED_TIMER("Sim::Projectiles::UpdateSyncedST");
 		for (size_t i = 0; i < pc.size(); ++i) {
@@ -6,6 +6,7 @@
 #include <array>
 #include <vector>
 
+#include "BallisticKinematics.h"
 #include "Rendering/Models/3DModel.h"
 #include "Rendering/Env/Particles/Classes/FlyingPiece.h"
 #include "System/float3.h"
@@ -115,6 +116,9 @@ private:
 	// [1] contains only projectiles that can     change simulation state
 	spring::FreeListMapCompact<CProjectile*, int> projectiles[2];
 
+	// per-frame scratch store for the bulk kinematics of synced projectiles
+	CBallisticKinematics ballisticKinematics;
+
 	static uint32_t UnsyncedRandInt(uint32_t N);
 	static uint32_t   SyncedRandInt(uint32_t N);
 
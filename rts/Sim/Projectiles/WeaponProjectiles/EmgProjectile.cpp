@@ -39,7 +39,7 @@ CEmgProjectile::CEmgProjectile(const ProjectileParams& params): CWeaponProjectil
 	}
 }
 
-void CEmgProjectile::Update()
+void CEmgProjectile::UpdateKinematics()
 {
 	RECOIL_DETAILED_TRACY_ZONE;
 	// disable collisions when ttl reaches 0 since the
@@ -54,10 +54,22 @@ void CEmgProjectile::Update()
 		// fade out over the next 10 frames at most
 		intensity -= 0.1f;
 		intensity = std::max(intensity, 0.0f);
-	} else {
-		explGenHandler.GenExplosion(cegID, pos, speed, ttl, intensity, 0.0f, owner(), nullptr);
 	}
 
+	kinematicsUpdated = true;
+}
+
+void CEmgProjectile::Update()
+{
+	RECOIL_DETAILED_TRACY_ZONE;
+	if (!kinematicsUpdated)
+		UpdateKinematics();
+
+	kinematicsUpdated = false;
+
+	if (ttl > 0)
+		explGenHandler.GenExplosion(cegID, pos, speed, ttl, intensity, 0.0f, owner(), nullptr);
+
 	UpdateGroundBounce();
 	UpdateInterception();
 
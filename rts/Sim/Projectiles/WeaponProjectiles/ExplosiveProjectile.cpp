@@ -45,12 +45,28 @@ CExplosiveProjectile::CExplosiveProjectile(const ProjectileParams& params): CWea
 	}
 }
 
-void CExplosiveProjectile::Update()
+void CExplosiveProjectile::UpdateKinematics()
 {
 	RECOIL_DETAILED_TRACY_ZONE;
 	CProjectile::Update();
+	FinishKinematics();
+}
+
+void CExplosiveProjectile::FinishKinematics()
+{
+	--ttl;
+	kinematicsUpdated = true;
+}
+
+void CExplosiveProjectile::Update()
+{
+	RECOIL_DETAILED_TRACY_ZONE;
+	if (!kinematicsUpdated)
+		UpdateKinematics();
+
+	kinematicsUpdated = false;
 
-	if (--ttl == 0) {
+	if (ttl == 0) {
 		Collision();
 	} else {
 		if (ttl > 0)
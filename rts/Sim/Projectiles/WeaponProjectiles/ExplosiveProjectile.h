@@ -15,6 +15,9 @@ public:
 	CExplosiveProjectile(const ProjectileParams& params);
 
 	void Update() override;
+	void UpdateKinematics() override;
+	bool HasBallisticKinematics() const override { return !luaMoveCtrl; }
+	void FinishKinematics() override;
 	void Draw() override;
 
 	int GetProjectilesCount() const override;
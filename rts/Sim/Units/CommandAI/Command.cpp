@@ -2,8 +2,10 @@
 
 #include "Command.h"
 #include "CommandParamsPool.hpp"
+#include "CommandQueueStorage.hpp"
 
 CommandParamsPool cmdParamsPool;
+CommandQueueBlockPool cmdQueueBlockPool;
 
 CR_BIND(Command, )
 CR_REG_METADATA(Command, (
@@ -26,6 +28,23 @@ Command::~Command() {
 	cmdParamsPool.ReleasePage(pageIndex);
 }
 
+Command& Command::operator = (Command&& c) {
+	if (this == &c)
+		return *this;
+
+	if (IsPooledCommand())
+		cmdParamsPool.ReleasePage(pageIndex);
+
+	memcpy(&id[0], &c.id[0], sizeof(id));
+	memcpy(&params[0], &c.params[0], sizeof(params));
+
+	SetFlags(c.timeOut, c.tag, c.options);
+
+	pageIndex = std::exchange(c.pageIndex, -1u);
+	numParams = std::exchange(c.numParams, 0);
+	return *this;
+}
+
 
 const float* Command::GetParams(unsigned int idx) const {
 	if (idx >= numParams)
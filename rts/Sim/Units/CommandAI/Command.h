@@ -6,6 +6,7 @@
 #include <string>
 #include <climits> // INT_MAX
 #include <cstring> // memset
+#include <utility>
 
 #include "System/creg/creg_cond.h"
 #include "System/float3.h"
@@ -161,6 +162,9 @@ public:
 	Command(const Command& c) {
 		*this = c;
 	}
+	Command(Command&& c) {
+		*this = std::move(c);
+	}
 
 	Command& operator = (const Command& c) {
 		memcpy(&id[0], &c.id[0], sizeof(id));
@@ -169,6 +173,8 @@ public:
 		CopyParams(c);
 		return *this;
 	}
+	/// takes over the pooled parameter page of <c>, leaving it empty
+	Command& operator = (Command&& c);
 
 	Command(const float3& pos) {
 		memset(&params[0], 0, sizeof(params));
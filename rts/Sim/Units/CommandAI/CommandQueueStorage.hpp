@@ -0,0 +1,407 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#ifndef COMMAND_QUEUE_STORAGE_H
+#define COMMAND_QUEUE_STORAGE_H
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <new>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "Command.h"
+#include "System/creg/creg_cond.h"
+
+/* Most command queues are empty or hold a single order, while factories and
+ * builders with long shift-queues can hold hundreds. CommandQueueStorage keeps
+ * up to INLINE_CAPACITY commands inside the queue object itself and takes any
+ * further ones from slots in a pool shared by all queues; the order of the
+ * queue is kept in a ring of pointers to those commands, which lives inline
+ * too until it has to grow into a power-of-two sized block from the same pool.
+ * Growing only moves the pointers, so like with std::deque references to
+ * queued commands stay valid across push_front and push_back (CommandAI code
+ * relies on this, e.g. holding front() while pushing a new order in front of
+ * it). Emptied queues hand their slots and ring back for reuse. */
+struct CommandQueueBlockPool {
+public:
+	static constexpr uint32_t NUM_SIZE_CLASSES = 24;
+	static constexpr uint32_t NUM_PAGE_SLOTS = 64;
+
+	Command** AcquireRing(uint32_t capacity) {
+		std::vector<Command**>& rings = freeRings[SizeClass(capacity)];
+
+		if (rings.empty()) {
+			numAllocatedBytes += (capacity * sizeof(Command*));
+			return (new Command*[capacity]);
+		}
+
+		Command** ring = rings.back();
+		rings.pop_back();
+		return ring;
+	}
+
+	void ReleaseRing(Command** ring, uint32_t capacity) {
+		freeRings[SizeClass(capacity)].push_back(ring);
+	}
+
+	/// uninitialized storage for one command
+	Command* AcquireSlot() {
+		if (freeSlots.empty()) {
+			Command* page = static_cast<Command*>(::operator new(NUM_PAGE_SLOTS * sizeof(Command)));
+			numAllocatedBytes += (NUM_PAGE_SLOTS * sizeof(Command));
+
+			for (uint32_t i = NUM_PAGE_SLOTS; i > 0; i--) {
+				freeSlots.push_back(&page[i - 1]);
+			}
+		}
+
+		Command* slot = freeSlots.back();
+		freeSlots.pop_back();
+		return slot;
+	}
+
+	void ReleaseSlot(Command* slot) {
+		freeSlots.push_back(slot);
+	}
+
+	/// total size of all rings and slots handed out so far, in use or not
+	size_t GetNumAllocatedBytes() const { return numAllocatedBytes; }
+
+private:
+	static uint32_t SizeClass(uint32_t capacity) {
+		assert(capacity != 0 && (capacity & (capacity - 1)) == 0);
+		uint32_t n = 0;
+
+		while ((1u << n) < capacity)
+			n++;
+
+		assert(n < NUM_SIZE_CLASSES);
+		return n;
+	}
+
+private:
+	// rings and slot pages are recycled but never returned, same as cmdParamsPool pages
+	std::array<std::vector<Command**>, NUM_SIZE_CLASSES> freeRings;
+	std::vector<Command*> freeSlots;
+
+	size_t numAllocatedBytes = 0;
+};
+
+extern CommandQueueBlockPool cmdQueueBlockPool;
+
+
+class CommandQueueStorage {
+public:
+	static constexpr uint32_t INLINE_CAPACITY = 2;
+	static constexpr uint32_t MIN_POOLED_CAPACITY = 4;
+
+	static_assert((INLINE_CAPACITY & (INLINE_CAPACITY - 1)) == 0);
+	static_assert((MIN_POOLED_CAPACITY & (MIN_POOLED_CAPACITY - 1)) == 0);
+
+	template<typename S, typename T> class TIterator {
+	public:
+		using iterator_category = std::random_access_iterator_tag;
+		using value_type = Command;
+		using difference_type = std::ptrdiff_t;
+		using pointer = T*;
+		using reference = T&;
+
+		TIterator() = default;
+		TIterator(S* s, std::ptrdiff_t i): storage(s), idx(i) {}
+
+		// iterator -> const_iterator
+		template<typename S2, typename T2> TIterator(const TIterator<S2, T2>& it): storage(it.storage), idx(it.idx) {}
+
+		reference operator * () const { return (*storage)[idx]; }
+		pointer operator -> () const { return &(*storage)[idx]; }
+		reference operator [] (difference_type n) const { return (*storage)[idx + n]; }
+
+		TIterator& operator ++ () { ++idx; return *this; }
+		TIterator& operator -- () { --idx; return *this; }
+		TIterator operator ++ (int) { TIterator it = *this; ++idx; return it; }
+		TIterator operator -- (int) { TIterator it = *this; --idx; return it; }
+
+		TIterator& operator += (difference_type n) { idx += n; return *this; }
+		TIterator& operator -= (difference_type n) { idx -= n; return *this; }
+
+		TIterator operator + (difference_type n) const { return {storage, idx + n}; }
+		TIterator operator - (difference_type n) const { return {storage, idx - n}; }
+		friend TIterator operator + (difference_type n, const TIterator& it) { return (it + n); }
+
+		template<typename S2, typename T2> difference_type operator - (const TIterator<S2, T2>& it) const { return (idx - it.idx); }
+
+		template<typename S2, typename T2> bool operator == (const TIterator<S2, T2>& it) const { return (storage == it.storage && idx == it.idx); }
+		template<typename S2, typename T2> bool operator != (const TIterator<S2, T2>& it) const { return (!(*this == it)); }
+		template<typename S2, typename T2> bool operator <  (const TIterator<S2, T2>& it) const { return (idx <  it.idx); }
+		template<typename S2, typename T2> bool operator >  (const TIterator<S2, T2>& it) const { return (idx >  it.idx); }
+		template<typename S2, typename T2> bool operator <= (const TIterator<S2, T2>& it) const { return (idx <= it.idx); }
+		template<typename S2, typename T2> bool operator >= (const TIterator<S2, T2>& it) const { return (idx >= it.idx); }
+
+	private:
+		template<typename S2, typename T2> friend class TIterator;
+		friend class CommandQueueStorage;
+
+		S* storage = nullptr;
+		// logical position, stays meaningful across insert and erase
+		std::ptrdiff_t idx = 0;
+	};
+
+	using value_type             = Command;
+	using size_type              = size_t;
+	using difference_type        = std::ptrdiff_t;
+	using iterator               = TIterator<CommandQueueStorage, Command>;
+	using const_iterator         = TIterator<const CommandQueueStorage, const Command>;
+	using reverse_iterator       = std::reverse_iterator<iterator>;
+	using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+public:
+	CommandQueueStorage() = default;
+	CommandQueueStorage(const CommandQueueStorage&) = delete;
+	CommandQueueStorage(CommandQueueStorage&&) = delete;
+	~CommandQueueStorage() { clear(); }
+
+	CommandQueueStorage& operator = (const CommandQueueStorage&) = delete;
+	CommandQueueStorage& operator = (CommandQueueStorage&&) = delete;
+
+	bool empty() const { return (count == 0); }
+	size_type size() const { return count; }
+	size_type capacity() const { return cap; }
+	bool pooled() const { return (cap > INLINE_CAPACITY); }
+
+	      Command& operator [] (size_type i)       { assert(i < count); return *RingAt(i); }
+	const Command& operator [] (size_type i) const { assert(i < count); return *RingAt(i); }
+
+	      Command& at(size_type i)       { if (i >= count) throw std::out_of_range("CommandQueueStorage::at"); return (*this)[i]; }
+	const Command& at(size_type i) const { if (i >= count) throw std::out_of_range("CommandQueueStorage::at"); return (*this)[i]; }
+
+	      Command& front()       { return (*this)[0]; }
+	const Command& front() const { return (*this)[0]; }
+	      Command& back()       { return (*this)[count - 1]; }
+	const Command& back() const { return (*this)[count - 1]; }
+
+	iterator       begin()       { return {this, 0}; }
+	const_iterator begin() const { return {this, 0}; }
+	iterator       end()       { return {this, difference_type(count)}; }
+	const_iterator end() const { return {this, difference_type(count)}; }
+
+	reverse_iterator       rbegin()       { return reverse_iterator(end()); }
+	const_reverse_iterator rbegin() const { return const_reverse_iterator(end()); }
+	reverse_iterator       rend()       { return reverse_iterator(begin()); }
+	const_reverse_iterator rend() const { return const_reverse_iterator(begin()); }
+
+
+	// queued commands never move, so <args> may refer to one of them
+	template<typename... A> Command& emplace_back(A&&... args) {
+		Command* c = new (AcquireSlot()) Command(std::forward<A>(args)...);
+
+		if (count == cap)
+			Grow();
+
+		RingAt(count++) = c;
+		return *c;
+	}
+	template<typename... A> Command& emplace_front(A&&... args) {
+		Command* c = new (AcquireSlot()) Command(std::forward<A>(args)...);
+
+		if (count == cap)
+			Grow();
+
+		head = (head - 1) & (cap - 1);
+		count += 1;
+		return *(RingAt(0) = c);
+	}
+
+	void push_back(const Command& c) { emplace_back(c); }
+	void push_back(Command&& c) { emplace_back(std::move(c)); }
+	void push_front(const Command& c) { emplace_front(c); }
+	void push_front(Command&& c) { emplace_front(std::move(c)); }
+
+	iterator insert(const_iterator pos, const Command& c) { return (insert(pos, Command(c))); }
+	iterator insert(const_iterator pos, Command&& c) {
+		const difference_type i = pos.idx;
+		assert(i >= 0 && size_type(i) <= count);
+
+		// shift whichever side of <pos> is shorter
+		if (size_type(i) < (count - i)) {
+			emplace_front(std::move(c));
+
+			Command* p = RingAt(0);
+
+			for (difference_type k = 0; k < i; k++) {
+				RingAt(k) = RingAt(k + 1);
+			}
+
+			RingAt(i) = p;
+		} else {
+			emplace_back(std::move(c));
+
+			Command* p = RingAt(count - 1);
+
+			for (difference_type k = count - 1; k > i; k--) {
+				RingAt(k) = RingAt(k - 1);
+			}
+
+			RingAt(i) = p;
+		}
+
+		return {this, i};
+	}
+
+	void pop_front() {
+		assert(count > 0);
+		ReleaseSlot(RingAt(0));
+		head = (head + 1) & (cap - 1);
+
+		if ((count -= 1) == 0)
+			Reset();
+	}
+	void pop_back() {
+		assert(count > 0);
+		ReleaseSlot(RingAt(count - 1));
+
+		if ((count -= 1) == 0)
+			Reset();
+	}
+
+	iterator erase(const_iterator pos) { return (erase(pos, pos + 1)); }
+	iterator erase(const_iterator first, const_iterator last) {
+		const difference_type i = first.idx;
+		const difference_type n = last.idx - first.idx;
+		assert(i >= 0 && n >= 0 && size_type(i + n) <= count);
+
+		if (n == 0)
+			return {this, i};
+
+		for (difference_type k = i; k < (i + n); k++) {
+			ReleaseSlot(RingAt(k));
+		}
+
+		// close the gap from whichever side has fewer pointers to move
+		if (size_type(i) < (count - (i + n))) {
+			for (difference_type k = i - 1; k >= 0; k--) {
+				RingAt(k + n) = RingAt(k);
+			}
+
+			head = (head + n) & (cap - 1);
+		} else {
+			for (difference_type k = i + n; k < difference_type(count); k++) {
+				RingAt(k - n) = RingAt(k);
+			}
+		}
+
+		if ((count -= n) == 0)
+			Reset();
+
+		return {this, i};
+	}
+
+	void clear() {
+		for (uint32_t i = 0; i < count; i++) {
+			ReleaseSlot(RingAt(i));
+		}
+
+		count = 0;
+		Reset();
+	}
+
+	void resize(size_type n) {
+		while (count > n)
+			pop_back();
+		while (count < n)
+			emplace_back();
+	}
+
+private:
+	      Command** Ring()       { return (pooled()? ring: &inlineRing[0]); }
+	const Command* const* Ring() const { return (pooled()? ring: &inlineRing[0]); }
+
+	      Command*& RingAt(size_type i)       { return Ring()[(head + i) & (cap - 1)]; }
+	const Command* RingAt(size_type i) const { return Ring()[(head + i) & (cap - 1)]; }
+
+	Command* InlineSlots() { return (reinterpret_cast<Command*>(&inlineSlots[0])); }
+
+	Command* AcquireSlot() {
+		for (uint32_t i = 0; i < INLINE_CAPACITY; i++) {
+			if ((inlineSlotMask & (1u << i)) != 0)
+				continue;
+
+			inlineSlotMask |= (1u << i);
+			return &InlineSlots()[i];
+		}
+
+		return (cmdQueueBlockPool.AcquireSlot());
+	}
+
+	void ReleaseSlot(Command* c) {
+		c->~Command();
+
+		const std::less<const Command*> less;
+
+		if (!less(c, InlineSlots()) && less(c, InlineSlots() + INLINE_CAPACITY)) {
+			inlineSlotMask &= ~(1u << (c - InlineSlots()));
+		} else {
+			cmdQueueBlockPool.ReleaseSlot(c);
+		}
+	}
+
+	void Grow() {
+		const uint32_t newCap = std::max(cap << 1, MIN_POOLED_CAPACITY);
+		Command** newRing = cmdQueueBlockPool.AcquireRing(newCap);
+
+		// unwrap into the new ring, the commands themselves stay put
+		for (uint32_t i = 0; i < count; i++) {
+			newRing[i] = RingAt(i);
+		}
+
+		if (pooled())
+			cmdQueueBlockPool.ReleaseRing(ring, cap);
+
+		ring = newRing;
+		head = 0;
+		cap = newCap;
+	}
+
+	void Reset() {
+		assert(count == 0);
+		assert(inlineSlotMask == 0);
+
+		if (pooled())
+			cmdQueueBlockPool.ReleaseRing(ring, cap);
+
+		head = 0;
+		cap = INLINE_CAPACITY;
+	}
+
+private:
+	Command** ring = nullptr;
+	Command* inlineRing[INLINE_CAPACITY];
+
+	alignas(Command) unsigned char inlineSlots[INLINE_CAPACITY * sizeof(Command)];
+
+	uint32_t head = 0;
+	uint32_t count = 0;
+	uint32_t cap = INLINE_CAPACITY;
+	uint32_t inlineSlotMask = 0;
+};
+
+
+#ifdef USING_CREG
+namespace creg
+{
+	// serialized exactly like the std::deque<Command> it replaced
+	template<>
+	struct DeduceType<CommandQueueStorage> {
+		static std::unique_ptr<IType> Get() {
+			return std::unique_ptr<IType>(new DynamicArrayType<CommandQueueStorage>());
+		}
+	};
+}
+#endif // USING_CREG
+
+#endif // COMMAND_QUEUE_STORAGE_H
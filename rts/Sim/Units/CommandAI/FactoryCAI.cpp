@@ -399,7 +399,7 @@ void CFactoryCAI::SlowUpdate()
 				case CMD_STOP: {
 					/* Targeted hack to optimize bulk STOP orders.
 					 * Build orders get replaced by STOP instead of being removed,
-					 * this is due to the buildqueue's internal implementation as `std::deque`
+					 * this is due to the buildqueue's internal implementation as a ring buffer
 					 * whose interface doesn't support removal from the middle that well.
 					 * Units often get added and removed in large quantities via CTRL/SHIFT,
 					 * such multiple STOPs commands in a row would then produce a freeze
@@ -1838,6 +1838,8 @@ void CMobileCAI::UnloadUnits_Drop(Command& c)
 	std::vector<float3> dropSpots;
 
 	const bool canUnload = FindEmptyDropSpots(startingDropPos, startingDropPos + approachVector * std::max(16.0f, c.GetParam(3)), dropSpots);
+	// <c> lives in the queue and is gone once finished
+	const unsigned char opts = c.GetOpts();
 
 	StopMoveAndFinishCommand();
 
@@ -1846,7 +1848,7 @@ void CMobileCAI::UnloadUnits_Drop(Command& c)
 		auto di = dropSpots.rbegin();
 
 		for (; ti != transportees.end() && di != dropSpots.rend(); ++ti, ++di) {
-			commandQue.push_front(Command(CMD_UNLOAD_UNIT, c.GetOpts() | INTERNAL_ORDER, *di));
+			commandQue.push_front(Command(CMD_UNLOAD_UNIT, opts | INTERNAL_ORDER, *di));
 		}
 
 		SlowUpdate();
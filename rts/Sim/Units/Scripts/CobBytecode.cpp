@@ -0,0 +1,198 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include <algorithm>
+
+#include "CobBytecode.h"
+#include "CobOpcodes.h"
+
+#include "System/Misc/TracyDefs.h"
+
+
+// maps a raw opcode to its decoded counterpart and operand count
+static int GetDecodedOp(int opcode, int* numArgs)
+{
+	*numArgs = 0;
+
+	switch (opcode) {
+		case MOVE:       { *numArgs = 2; return COBOP_MOVE;       }
+		case TURN:       { *numArgs = 2; return COBOP_TURN;       }
+		case SPIN:       { *numArgs = 2; return COBOP_SPIN;       }
+		case STOP_SPIN:  { *numArgs = 2; return COBOP_STOP_SPIN;  }
+		case SHOW:       { *numArgs = 1; return COBOP_SHOW;       }
+		case HIDE:       { *numArgs = 1; return COBOP_HIDE;       }
+		case CACHE:      { *numArgs = 1; return COBOP_NOP;        }
+		case DONT_CACHE: { *numArgs = 1; return COBOP_NOP;        }
+		case MOVE_NOW:   { *numArgs = 2; return COBOP_MOVE_NOW;   }
+		case TURN_NOW:   { *numArgs = 2; return COBOP_TURN_NOW;   }
+		case SHADE:      { *numArgs = 1; return COBOP_NOP;        }
+		case DONT_SHADE: { *numArgs = 1; return COBOP_NOP;        }
+		case EMIT_SFX:   { *numArgs = 1; return COBOP_EMIT_SFX;   }
+
+		case WAIT_TURN:  { *numArgs = 2; return COBOP_WAIT_TURN;  }
+		case WAIT_MOVE:  { *numArgs = 2; return COBOP_WAIT_MOVE;  }
+		case SLEEP:      {               return COBOP_SLEEP;      }
+
+		case PUSH_CONSTANT:    { *numArgs = 1; return COBOP_PUSH_CONSTANT;    }
+		case PUSH_LOCAL_VAR:   { *numArgs = 1; return COBOP_PUSH_LOCAL_VAR;   }
+		case PUSH_STATIC:      { *numArgs = 1; return COBOP_PUSH_STATIC;      }
+		case CREATE_LOCAL_VAR: {               return COBOP_CREATE_LOCAL_VAR; }
+		case POP_LOCAL_VAR:    { *numArgs = 1; return COBOP_POP_LOCAL_VAR;    }
+		case POP_STATIC:       { *numArgs = 1; return COBOP_POP_STATIC;       }
+		case POP_STACK:        {               return COBOP_POP_STACK;        }
+
+		case ADD:         { return COBOP_ADD;         }
+		case SUB:         { return COBOP_SUB;         }
+		case MUL:         { return COBOP_MUL;         }
+		case DIV:         { return COBOP_DIV;         }
+		case MOD:         { return COBOP_MOD;         }
+		case BITWISE_AND: { return COBOP_BITWISE_AND; }
+		case BITWISE_OR:  { return COBOP_BITWISE_OR;  }
+		case BITWISE_XOR: { return COBOP_BITWISE_XOR; }
+		case BITWISE_NOT: { return COBOP_BITWISE_NOT; }
+
+		case RAND:           { return COBOP_RAND;           }
+		case GET_UNIT_VALUE: { return COBOP_GET_UNIT_VALUE; }
+		case GET:            { return COBOP_GET;            }
+
+		case SET_LESS:             { return COBOP_SET_LESS;             }
+		case SET_LESS_OR_EQUAL:    { return COBOP_SET_LESS_OR_EQUAL;    }
+		case SET_GREATER:          { return COBOP_SET_GREATER;          }
+		case SET_GREATER_OR_EQUAL: { return COBOP_SET_GREATER_OR_EQUAL; }
+		case SET_EQUAL:            { return COBOP_SET_EQUAL;            }
+		case SET_NOT_EQUAL:        { return COBOP_SET_NOT_EQUAL;        }
+		case LOGICAL_AND:          { return COBOP_LOGICAL_AND;          }
+		case LOGICAL_OR:           { return COBOP_LOGICAL_OR;           }
+		case LOGICAL_XOR:          { return COBOP_LOGICAL_XOR;          }
+		case LOGICAL_NOT:          { return COBOP_LOGICAL_NOT;          }
+
+		// CALL is resolved into REAL_CALL or LUA_CALL by the caller
+		case START:           { *numArgs = 2; return COBOP_START;           }
+		case CALL:            { *numArgs = 2; return COBOP_REAL_CALL;       }
+		case REAL_CALL:       { *numArgs = 2; return COBOP_REAL_CALL;       }
+		case LUA_CALL:        { *numArgs = 2; return COBOP_LUA_CALL;        }
+		case JUMP:            { *numArgs = 1; return COBOP_JUMP;            }
+		case RETURN:          {               return COBOP_RETURN;          }
+		case JUMP_NOT_EQUAL:  { *numArgs = 1; return COBOP_JUMP_NOT_EQUAL;  }
+		case SIGNAL:          {               return COBOP_SIGNAL;          }
+		case SET_SIGNAL_MASK: {               return COBOP_SET_SIGNAL_MASK; }
+
+		case EXPLODE:    { *numArgs = 1; return COBOP_EXPLODE;    }
+		case PLAY_SOUND: { *numArgs = 1; return COBOP_PLAY_SOUND; }
+
+		case SET:    { return COBOP_SET;    }
+		case ATTACH: { return COBOP_ATTACH; }
+		case DROP:   { return COBOP_DROP;   }
+
+		default: {
+		} break;
+	}
+
+	return COBOP_RAW;
+}
+
+// push-constant followed by <opcode> can be fused into the returned op
+static int GetFusedPushConstantOp(int opcode)
+{
+	switch (opcode) {
+		case SET_LESS            : { return COBOP_PUSHC_SET_LESS;             }
+		case SET_LESS_OR_EQUAL   : { return COBOP_PUSHC_SET_LESS_OR_EQUAL;    }
+		case SET_GREATER         : { return COBOP_PUSHC_SET_GREATER;          }
+		case SET_GREATER_OR_EQUAL: { return COBOP_PUSHC_SET_GREATER_OR_EQUAL; }
+		case SET_EQUAL           : { return COBOP_PUSHC_SET_EQUAL;            }
+		case SET_NOT_EQUAL       : { return COBOP_PUSHC_SET_NOT_EQUAL;        }
+		case SLEEP               : { return COBOP_PUSHC_SLEEP;                }
+		default                  : {                                          } break;
+	}
+
+	return COBOP_RAW;
+}
+
+
+void CobBytecode::Decode(
+	const std::vector<int>& code,
+	const std::vector<std::string>& scriptNames,
+	const std::vector<int>& scriptLengths,
+	std::vector<SCobInstr>& instrs,
+	DecodeStats* stats
+) {
+	RECOIL_DETAILED_TRACY_ZONE;
+	const size_t numWords = code.size();
+
+	instrs.clear();
+	instrs.resize(numWords);
+
+	// NOTE:
+	//   every word is decoded as if an instruction started there, since a
+	//   (malformed) jump may land anywhere; the raw interpreter then reads
+	//   operands as opcodes and vice versa, which the decoded one must match
+	for (size_t i = 0; i < numWords; i++) {
+		SCobInstr& ins = instrs[i];
+
+		ins.op = COBOP_RAW;
+		ins.next = i;
+		ins.arg0 = 0;
+		ins.arg1 = 0;
+
+		int numArgs = 0;
+		int op = GetDecodedOp(code[i], &numArgs);
+
+		// operands running past the end make the raw interpreter throw
+		if (op == COBOP_RAW || (i + numArgs) >= numWords)
+			continue;
+
+		const int arg0 = (numArgs > 0)? code[i + 1]: 0;
+		const int arg1 = (numArgs > 1)? code[i + 2]: 0;
+
+		switch (code[i]) {
+			case CALL:
+			case REAL_CALL:
+			case START: {
+				// raw interpreter does not range-check function indices
+				if (static_cast<size_t>(arg0) >= scriptNames.size() || static_cast<size_t>(arg0) >= scriptLengths.size())
+					continue;
+
+				// CCobThread rewrites CALL on first execution, do it up-front
+				if (code[i] == CALL && scriptNames[arg0].find("lua_") == 0)
+					op = COBOP_LUA_CALL;
+			} break;
+
+			case PUSH_CONSTANT: {
+				if ((i + 2) >= numWords)
+					break;
+
+				const int fusedOp = GetFusedPushConstantOp(code[i + 2]);
+
+				if (fusedOp == COBOP_RAW)
+					break;
+
+				ins.op = fusedOp;
+				ins.next = i + 3;
+				ins.arg0 = arg0;
+				continue;
+			} break;
+
+			default: {
+			} break;
+		}
+
+		ins.op = op;
+		ins.next = i + 1 + numArgs;
+		ins.arg0 = arg0;
+		ins.arg1 = arg1;
+	}
+
+	if (stats == nullptr)
+		return;
+
+	*stats = {};
+
+	for (size_t i = 0; i < numWords; ) {
+		const SCobInstr& ins = instrs[i];
+
+		stats->numInstrs += 1;
+		stats->numRaw += (ins.op == COBOP_RAW);
+		stats->numFused += (ins.op >= COBOP_PUSHC_SET_LESS);
+
+		i = std::max(i + 1, static_cast<size_t>(ins.next));
+	}
+}
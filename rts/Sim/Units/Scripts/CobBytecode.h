@@ -0,0 +1,89 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#ifndef COB_BYTECODE_H
+#define COB_BYTECODE_H
+
+#include <string>
+#include <vector>
+
+
+/**
+ * Pre-decoded instruction set executed by CCobThread.
+ *
+ * CobBytecode::Decode turns the raw opcode stream of a CCobFile into one
+ * SCobInstr per code word (as if an instruction started there), so the
+ * interpreter can keep using raw code offsets for pc, jump targets and return
+ * addresses -- these are part of saved games. Operands and call targets are
+ * resolved ahead of time and common sequences are fused into one instruction.
+ * Anything that can not be decoded safely becomes COBOP_RAW and is handed to
+ * the raw interpreter one instruction at a time.
+ */
+#define COB_DECODED_OPS(X) \
+	X(RAW) \
+	\
+	X(MOVE) X(TURN) X(SPIN) X(STOP_SPIN) X(SHOW) X(HIDE) \
+	X(NOP) /* cache, dont-cache, shade, dont-shade */ \
+	X(MOVE_NOW) X(TURN_NOW) X(EMIT_SFX) \
+	\
+	X(WAIT_TURN) X(WAIT_MOVE) X(SLEEP) \
+	\
+	X(PUSH_CONSTANT) X(PUSH_LOCAL_VAR) X(PUSH_STATIC) X(CREATE_LOCAL_VAR) \
+	X(POP_LOCAL_VAR) X(POP_STATIC) X(POP_STACK) \
+	\
+	X(ADD) X(SUB) X(MUL) X(DIV) X(MOD) \
+	X(BITWISE_AND) X(BITWISE_OR) X(BITWISE_XOR) X(BITWISE_NOT) \
+	\
+	X(RAND) X(GET_UNIT_VALUE) X(GET) \
+	\
+	X(SET_LESS) X(SET_LESS_OR_EQUAL) X(SET_GREATER) X(SET_GREATER_OR_EQUAL) \
+	X(SET_EQUAL) X(SET_NOT_EQUAL) \
+	X(LOGICAL_AND) X(LOGICAL_OR) X(LOGICAL_XOR) X(LOGICAL_NOT) \
+	\
+	X(START) X(REAL_CALL) X(LUA_CALL) X(JUMP) X(RETURN) X(JUMP_NOT_EQUAL) \
+	X(SIGNAL) X(SET_SIGNAL_MASK) \
+	\
+	X(EXPLODE) X(PLAY_SOUND) \
+	\
+	X(SET) X(ATTACH) X(DROP) \
+	\
+	/* fused push-constant + <op>, arg0 holds the constant */ \
+	X(PUSHC_SET_LESS) X(PUSHC_SET_LESS_OR_EQUAL) X(PUSHC_SET_GREATER) X(PUSHC_SET_GREATER_OR_EQUAL) \
+	X(PUSHC_SET_EQUAL) X(PUSHC_SET_NOT_EQUAL) \
+	X(PUSHC_SLEEP)
+
+#define COB_DECODED_OP_ENUM(name) COBOP_##name,
+
+enum CobDecodedOp {
+	COB_DECODED_OPS(COB_DECODED_OP_ENUM)
+	COBOP_COUNT
+};
+
+#undef COB_DECODED_OP_ENUM
+
+
+struct SCobInstr {
+	int op;   ///< CobDecodedOp
+	int next; ///< raw code offset of the following instruction
+	int arg0;
+	int arg1;
+};
+
+
+namespace CobBytecode {
+	/// counted along a linear sweep over the code
+	struct DecodeStats {
+		size_t numInstrs = 0;
+		size_t numRaw = 0;
+		size_t numFused = 0;
+	};
+
+	void Decode(
+		const std::vector<int>& code,
+		const std::vector<std::string>& scriptNames,
+		const std::vector<int>& scriptLengths,
+		std::vector<SCobInstr>& instrs,
+		DecodeStats* stats = nullptr
+	);
+}
+
+#endif // COB_BYTECODE_H
@@ -5,6 +5,7 @@
 #include "CobThread.h"
 #include "CobFile.h"
 
+#include <algorithm>
 #include <cstdint>
 #include "System/Misc/TracyDefs.h"
 
@@ -18,6 +19,9 @@ CR_REG_METADATA(CCobEngine, (
 	CR_MEMBER(sleepingThreadIDs),
 	// always null/empty when saving
 	CR_IGNORED(waitingThreadIDs),
+	CR_IGNORED(wokenThreadIDs),
+	CR_IGNORED(wokenThreadIdx),
+	CR_IGNORED(numWokenThreads),
 
 	CR_IGNORED(curThread),
 
@@ -25,13 +29,8 @@ CR_REG_METADATA(CCobEngine, (
 	CR_MEMBER(threadCounter)
 ))
 
-CR_BIND(CCobEngine::SleepingThread, )
-CR_REG_METADATA(CCobEngine::SleepingThread, (
-	CR_MEMBER(id),
-	CR_MEMBER(wt)
-))
-
 static const char* const numCobThreadsPlot = "CobThreads";
+static const char* const numWokenCobThreadsPlot = "CobThreadsWoken";
 
 int CCobEngine::AddThread(CCobThread&& thread)
 {
@@ -93,7 +92,19 @@ void CCobEngine::ScheduleThread(const CCobThread* thread)
 			waitingThreadIDs.push_back(thread->GetID());
 		} break;
 		case CCobThread::Sleep: {
-			sleepingThreadIDs.push(SleepingThread{thread->GetID(), thread->GetWakeTime()});
+			const SleepingThread st = {thread->GetID(), thread->GetWakeTime()};
+
+			// a thread woken up this tick that goes back to sleep for a negative
+			// amount of time is due again right away, keep it in wake order
+			if (wokenThreadIdx < wokenThreadIDs.size() && st.wt < currentTime) {
+				const auto beg = wokenThreadIDs.begin() + wokenThreadIdx + 1;
+				const auto pos = std::lower_bound(beg, wokenThreadIDs.end(), st, CCobTimerWheel::WakeOrderComp());
+
+				wokenThreadIDs.insert(pos, st);
+				break;
+			}
+
+			sleepingThreadIDs.Insert(st);
 		} break;
 		default: {
 			LOG_L(L_ERROR, "[COBEngine::%s] unknown state %d for thread %d", __func__, thread->GetState(), thread->GetID());
@@ -132,21 +143,20 @@ void CCobEngine::TickThread(CCobThread* thread)
 void CCobEngine::WakeSleepingThreads()
 {
 	ZoneScoped;
-	// check on the sleeping threads, remove any whose owner died
-	while (!sleepingThreadIDs.empty()) {
-		CCobThread* zzzThread = GetThread((sleepingThreadIDs.top()).id);
+	// collect every thread whose wake-up time has passed, in wake order
+	sleepingThreadIDs.Advance(currentTime, wokenThreadIDs);
 
-		if (zzzThread == nullptr) {
-			sleepingThreadIDs.pop();
-			continue;
-		}
+	numWokenThreads = 0;
+
+	// check on the sleeping threads, skip any whose owner died
+	for (wokenThreadIdx = 0; wokenThreadIdx < wokenThreadIDs.size(); wokenThreadIdx++) {
+		CCobThread* zzzThread = GetThread(wokenThreadIDs[wokenThreadIdx].id);
 
-		// not yet time to execute this thread or any subsequent sleepers
-		if (zzzThread->GetWakeTime() >= currentTime)
-			break;
+		if (zzzThread == nullptr)
+			continue;
 
-		// remove executing thread from the queue
-		sleepingThreadIDs.pop();
+		assert(zzzThread->GetWakeTime() < currentTime);
+		numWokenThreads += 1;
 
 		// wake up the thread and tick it (if not dead)
 		// this can quite possibly re-add the thread to <sleepingThreadIDs>
@@ -164,6 +174,11 @@ void CCobEngine::WakeSleepingThreads()
 			} break;
 		}
 	}
+
+	wokenThreadIDs.clear();
+	wokenThreadIdx = 0;
+
+	TracyPlot(numWokenCobThreadsPlot, static_cast<int64_t>(numWokenThreads));
 }
 
 void CCobEngine::TickRunningThreads()
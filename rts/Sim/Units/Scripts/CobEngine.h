@@ -11,8 +11,8 @@
 #include <vector>
 
 #include "CobThread.h"
+#include "CobTimerWheel.h"
 #include "System/creg/creg_cond.h"
-#include "System/creg/STL_Queue.h"
 #include "System/creg/STL_Map.h"
 #include "System/Cpp11Compat.hpp"
 
@@ -26,19 +26,7 @@ class CCobEngine
 	CR_DECLARE_STRUCT(CCobEngine)
 
 public:
-	struct SleepingThread {
-		CR_DECLARE_STRUCT(SleepingThread)
-
-		int id;
-		int wt;
-	};
-
-	struct CCobThreadComp {
-	public:
-		bool operator() (const SleepingThread& a, const SleepingThread& b) const {
-			return a.wt > b.wt || (a.wt == b.wt && a.id > b.id);
-		}
-	};
+	typedef CCobTimerWheel::SleepingThread SleepingThread;
 
 public:
 	void Init() {
@@ -47,13 +35,17 @@ public:
 
 		runningThreadIDs.reserve(512);
 		waitingThreadIDs.reserve(512);
+		wokenThreadIDs.reserve(512);
 
-		sleepingThreadIDs = {};
+		sleepingThreadIDs.Clear();
 
 		curThread = nullptr;
 
 		currentTime = 0;
 		threadCounter = 0;
+
+		wokenThreadIdx = 0;
+		numWokenThreads = 0;
 	}
 	void Kill() {
 		// threadInstances is never explicitly iterated in the actual code,
@@ -64,9 +56,8 @@ public:
 		runningThreadIDs.clear();
 		waitingThreadIDs.clear();
 
-		while (!sleepingThreadIDs.empty()) {
-			sleepingThreadIDs.pop();
-		}
+		wokenThreadIDs.clear();
+		sleepingThreadIDs.Clear();
 	}
 
 	void Tick(int deltaTime);
@@ -99,6 +90,8 @@ public:
 //	const auto& GetRunningThreadIDs() const { return runningThreadIDs; }
 	const auto& GetWaitingThreadIDs() const { return waitingThreadIDs; }
 	const auto& GetSleepingThreadIDs() const { return sleepingThreadIDs; }
+	/// number of sleeping threads woken up during the last Tick
+	const auto  GetNumWokenThreads() const { return numWokenThreads; }
 	const auto  GetCurrTime() const { return currentTime; }
 	const auto  GetThreadCounter() const { return threadCounter; }
 	const auto  GetCurrCounter() const { return threadCounter; }
@@ -121,7 +114,13 @@ private:
 
 	// stores <id, waketime> pairs s.t. after waking up the ID can be checked
 	// for validity; thread owner might get removed while a thread is sleeping
-	std::priority_queue<SleepingThread, std::vector<SleepingThread>, CCobThreadComp> sleepingThreadIDs;
+	CCobTimerWheel sleepingThreadIDs;
+	// sleepers due in the current tick, in wake order; only non-empty
+	// during WakeSleepingThreads
+	std::vector<SleepingThread> wokenThreadIDs;
+
+	size_t wokenThreadIdx = 0;
+	int numWokenThreads = 0;
 
 	CCobThread* curThread = nullptr;
 
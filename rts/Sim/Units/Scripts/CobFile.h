@@ -9,6 +9,7 @@
 
 #include "Lua/LuaHashString.h"
 #include "CobScriptNames.h"
+#include "CobBytecode.h"
 #include "System/UnorderedMap.hpp"
 
 class CFileHandler;
@@ -16,6 +17,8 @@ class CFileHandler;
 class CCobFile
 {
 public:
+	// tests only, which fill in the code themselves
+	CCobFile() { scriptIndex.fill(-1); }
 	CCobFile(CFileHandler& in, const std::string& scriptName);
 	CCobFile(CCobFile&& f) { *this = std::move(f); }
 
@@ -23,6 +26,7 @@ public:
 		numStaticVars = f.numStaticVars;
 
 		code = std::move(f.code);
+		decodedCode = std::move(f.decodedCode);
 		scriptNames = std::move(f.scriptNames);
 		scriptOffsets = std::move(f.scriptOffsets);
 
@@ -43,6 +47,8 @@ public:
 	int numStaticVars = 0;
 
 	std::vector<int> code;
+	/// see CobBytecode::Decode, empty if pre-decoding is disabled
+	std::vector<SCobInstr> decodedCode;
 	std::vector<std::string> scriptNames;
 	std::vector<int> scriptOffsets;
 	/// Assumes that the scripts are sorted by offset in the file
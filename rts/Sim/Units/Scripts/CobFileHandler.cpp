@@ -1,8 +1,20 @@
 #include "CobFileHandler.h"
+#include "System/Config/ConfigHandler.h"
 #include "System/FileSystem/FileHandler.h"
 
 #include "System/Misc/TracyDefs.h"
 
+CONFIG(bool, CobPreDecode).defaultValue(true).description("Whether COB scripts are decoded into a threaded instruction stream when loaded, rather than interpreted from their raw opcodes.");
+
+
+static CCobFile& PreDecode(CCobFile& file)
+{
+	if (configHandler->GetBool("CobPreDecode"))
+		CobBytecode::Decode(file.code, file.scriptNames, file.scriptLengths, file.decodedCode);
+
+	return file;
+}
+
 CCobFile* CCobFileHandler::GetCobFile(const std::string& name)
 {
 	RECOIL_DETAILED_TRACY_ZONE;
@@ -19,7 +31,7 @@ CCobFile* CCobFileHandler::GetCobFile(const std::string& name)
 	cobFileHandles[name] = cobFileObjects.size();
 	cobFileObjects.emplace_back(CCobFile(f, name));
 
-	return &cobFileObjects[cobFileObjects.size() - 1];
+	return &PreDecode(cobFileObjects[cobFileObjects.size() - 1]);
 }
 
 
@@ -35,7 +47,7 @@ CCobFile* CCobFileHandler::ReloadCobFile(const std::string& name)
 	assert(f.FileExists());
 
 	cobFileObjects[it->second] = CCobFile(f, name);
-	return &cobFileObjects[it->second];
+	return &PreDecode(cobFileObjects[it->second]);
 }
 
 
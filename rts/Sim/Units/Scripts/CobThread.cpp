@@ -3,6 +3,8 @@
 
 #include "CobThread.h"
 #include "CobFile.h"
+#include "CobBytecode.h"
+#include "CobOpcodes.h"
 #include "CobInstance.h"
 #include "CobEngine.h"
 #include "Sim/Misc/GlobalConstants.h"
@@ -226,86 +228,6 @@ void CCobThread::InitStack(unsigned int n, CCobThread* t)
 
 
 
-// Command documentation from http://visualta.tauniverse.com/Downloads/cob-commands.txt
-// And some information from basm0.8 source (basm ops.txt)
-
-// Model interaction
-static constexpr int MOVE       = 0x10001000;
-static constexpr int TURN       = 0x10002000;
-static constexpr int SPIN       = 0x10003000;
-static constexpr int STOP_SPIN  = 0x10004000;
-static constexpr int SHOW       = 0x10005000;
-static constexpr int HIDE       = 0x10006000;
-static constexpr int CACHE      = 0x10007000;
-static constexpr int DONT_CACHE = 0x10008000;
-static constexpr int MOVE_NOW   = 0x1000B000;
-static constexpr int TURN_NOW   = 0x1000C000;
-static constexpr int SHADE      = 0x1000D000;
-static constexpr int DONT_SHADE = 0x1000E000;
-static constexpr int EMIT_SFX   = 0x1000F000;
-
-// Blocking operations
-static constexpr int WAIT_TURN  = 0x10011000;
-static constexpr int WAIT_MOVE  = 0x10012000;
-static constexpr int SLEEP      = 0x10013000;
-
-// Stack manipulation
-static constexpr int PUSH_CONSTANT    = 0x10021001;
-static constexpr int PUSH_LOCAL_VAR   = 0x10021002;
-static constexpr int PUSH_STATIC      = 0x10021004;
-static constexpr int CREATE_LOCAL_VAR = 0x10022000;
-static constexpr int POP_LOCAL_VAR    = 0x10023002;
-static constexpr int POP_STATIC       = 0x10023004;
-static constexpr int POP_STACK        = 0x10024000; ///< Not sure what this is supposed to do
-
-// Arithmetic operations
-static constexpr int ADD         = 0x10031000;
-static constexpr int SUB         = 0x10032000;
-static constexpr int MUL         = 0x10033000;
-static constexpr int DIV         = 0x10034000;
-static constexpr int MOD		  = 0x10034001; ///< spring specific
-static constexpr int BITWISE_AND = 0x10035000;
-static constexpr int BITWISE_OR  = 0x10036000;
-static constexpr int BITWISE_XOR = 0x10037000;
-static constexpr int BITWISE_NOT = 0x10038000;
-
-// Native function calls
-static constexpr int RAND           = 0x10041000;
-static constexpr int GET_UNIT_VALUE = 0x10042000;
-static constexpr int GET            = 0x10043000;
-
-// Comparison
-static constexpr int SET_LESS             = 0x10051000;
-static constexpr int SET_LESS_OR_EQUAL    = 0x10052000;
-static constexpr int SET_GREATER          = 0x10053000;
-static constexpr int SET_GREATER_OR_EQUAL = 0x10054000;
-static constexpr int SET_EQUAL            = 0x10055000;
-static constexpr int SET_NOT_EQUAL        = 0x10056000;
-static constexpr int LOGICAL_AND          = 0x10057000;
-static constexpr int LOGICAL_OR           = 0x10058000;
-static constexpr int LOGICAL_XOR          = 0x10059000;
-static constexpr int LOGICAL_NOT          = 0x1005A000;
-
-// Flow control
-static constexpr int START           = 0x10061000;
-static constexpr int CALL            = 0x10062000; ///< converted when executed
-static constexpr int REAL_CALL       = 0x10062001; ///< spring custom
-static constexpr int LUA_CALL        = 0x10062002; ///< spring custom
-static constexpr int JUMP            = 0x10064000;
-static constexpr int RETURN          = 0x10065000;
-static constexpr int JUMP_NOT_EQUAL  = 0x10066000;
-static constexpr int SIGNAL          = 0x10067000;
-static constexpr int SET_SIGNAL_MASK = 0x10068000;
-
-// Piece destruction
-static constexpr int EXPLODE    = 0x10071000;
-static constexpr int PLAY_SOUND = 0x10072000;
-
-// Special functions
-static constexpr int SET    = 0x10082000;
-static constexpr int ATTACH = 0x10083000;
-static constexpr int DROP   = 0x10084000;
-
 // Indices for SET, GET, and GET_UNIT_VALUE for LUA return values
 static constexpr int LUA0 = 110; // (LUA0 returns the lua call status, 0 or 1)
 static constexpr int LUA1 = 111;
@@ -416,6 +338,14 @@ bool CCobThread::Tick()
 
 	state = Run;
 
+	if (cobFile->decodedCode.empty())
+		return TickRaw(false);
+
+	return TickDecoded();
+}
+
+bool CCobThread::TickRaw(bool singleStep)
+{
 	int r1, r2, r3, r4, r5, r6;
 
 	while (state == Run) {
@@ -488,7 +418,10 @@ bool CCobThread::Tick()
 
 				if (cobFile->scriptNames[r1].find("lua_") == 0) {
 					cobFile->code[pc - 1] = LUA_CALL;
-					LuaCall();
+
+					r1 = GET_LONG_PC();
+					r2 = GET_LONG_PC();
+					LuaCall(r1, r2);
 					break;
 				}
 
@@ -515,7 +448,9 @@ bool CCobThread::Tick()
 				pc = cobFile->scriptOffsets[r1];
 			} break;
 			case LUA_CALL: {
-				LuaCall();
+				r1 = GET_LONG_PC();
+				r2 = GET_LONG_PC();
+				LuaCall(r1, r2);
 			} break;
 
 
@@ -889,12 +824,501 @@ bool CCobThread::Tick()
 				return false;
 			} break;
 		}
+
+		if (singleStep)
+			break;
 	}
 
 	// can arrive here as dead, through CCobInstance::Signal()
 	return (state != Dead);
 }
 
+// computed-goto dispatch where supported, a plain switch otherwise
+#if defined(__GNUC__) || defined(__clang__)
+	#define COB_COMPUTED_GOTO 1
+#else
+	#define COB_COMPUTED_GOTO 0
+#endif
+
+#define COB_FETCH()                                        \
+	do {                                                   \
+		if (static_cast<size_t>(pc) < numInstrs) {         \
+			ins = &instrs[pc];                             \
+		} else {                                           \
+			rawInstr.next = pc;                            \
+			ins = &rawInstr;                               \
+		}                                                  \
+		pc = ins->next;                                    \
+	} while (false)
+
+#if (COB_COMPUTED_GOTO == 1)
+	#define COB_OP(name) cobop_##name:
+	#define COB_NEXT()                                     \
+		do {                                               \
+			if (state != Run)                              \
+				goto cobop_exit;                           \
+			COB_FETCH();                                   \
+			goto *dispatchTable[ins->op];                  \
+		} while (false)
+	#define COB_DISPATCH_TABLE_ENTRY(name) &&cobop_##name,
+#else
+	#define COB_OP(name) case COBOP_##name:
+	#define COB_NEXT() break
+#endif
+
+bool CCobThread::TickDecoded()
+{
+	const SCobInstr* instrs = cobFile->decodedCode.data();
+	size_t numInstrs = cobFile->decodedCode.size();
+
+	const SCobInstr* ins = nullptr;
+	// stands in for out-of-range pc's, handled by the raw interpreter
+	SCobInstr rawInstr = {COBOP_RAW, 0, 0, 0};
+
+	int r1, r2, r3, r4, r5, r6;
+
+	// pointers can change if Lua reloads the script
+	const auto RefreshCode = [&]() {
+		if (state != Run || cobFile == nullptr)
+			return;
+
+		instrs = cobFile->decodedCode.data();
+		numInstrs = cobFile->decodedCode.size();
+	};
+
+#if (COB_COMPUTED_GOTO == 1)
+	static const void* dispatchTable[COBOP_COUNT] = {
+		COB_DECODED_OPS(COB_DISPATCH_TABLE_ENTRY)
+	};
+
+	COB_NEXT();
+#else
+	while (state == Run) {
+		COB_FETCH();
+
+		switch (ins->op) {
+#endif
+
+	// NOTE: every op mirrors its counterpart in TickRaw exactly
+	COB_OP(RAW) {
+		// pc == ins->next points at the undecodable instruction itself
+		TickRaw(true);
+		RefreshCode();
+	} COB_NEXT();
+
+	COB_OP(PUSH_CONSTANT) {
+		PushDataStack(ins->arg0);
+	} COB_NEXT();
+	COB_OP(SLEEP) {
+		r1 = PopDataStack();
+		wakeTime = cobEngine->GetCurrTime() + r1;
+		state = Sleep;
+
+		cobEngine->ScheduleThread(this);
+		return true;
+	} COB_NEXT();
+	COB_OP(PUSHC_SLEEP) {
+		wakeTime = cobEngine->GetCurrTime() + ins->arg0;
+		state = Sleep;
+
+		cobEngine->ScheduleThread(this);
+		return true;
+	} COB_NEXT();
+	COB_OP(SPIN) {
+		r3 = PopDataStack();         // speed
+		r4 = PopDataStack();         // accel
+		cobInst->Spin(ins->arg0, ins->arg1, r3, r4);
+	} COB_NEXT();
+	COB_OP(STOP_SPIN) {
+		r3 = PopDataStack();         // decel
+		cobInst->StopSpin(ins->arg0, ins->arg1, r3);
+	} COB_NEXT();
+	COB_OP(RETURN) {
+		retCode = PopDataStack();
+
+		if (LocalReturnAddr() == -1) {
+			state = Dead;
+			return false;
+		}
+
+		// return to caller
+		pc = LocalReturnAddr();
+		if (dataStack.size() > LocalStackFrame())
+			dataStack.resize(LocalStackFrame());
+
+		callStack.pop_back();
+	} COB_NEXT();
+
+	COB_OP(NOP) {
+	} COB_NEXT();
+
+	COB_OP(REAL_CALL) {
+		r1 = ins->arg0;
+		r2 = ins->arg1;
+
+		// do not call zero-length functions
+		if (cobFile->scriptLengths[r1] == 0)
+			COB_NEXT();
+
+		CallInfo& ci = PushCallStackRef();
+		ci.functionId = r1;
+		ci.returnAddr = pc;
+		ci.stackTop = dataStack.size() - r2;
+
+		paramCount = r2;
+
+		pc = cobFile->scriptOffsets[r1];
+	} COB_NEXT();
+	COB_OP(LUA_CALL) {
+		LuaCall(ins->arg0, ins->arg1);
+		RefreshCode();
+	} COB_NEXT();
+
+	COB_OP(POP_STATIC) {
+		r2 = PopDataStack();
+
+		if (static_cast<size_t>(ins->arg0) < cobInst->staticVars.size())
+			cobInst->staticVars[ins->arg0] = r2;
+	} COB_NEXT();
+	COB_OP(POP_STACK) {
+		PopDataStack();
+	} COB_NEXT();
+
+	COB_OP(START) {
+		r1 = ins->arg0;
+		r2 = ins->arg1;
+
+		if (cobFile->scriptLengths[r1] == 0)
+			COB_NEXT();
+
+		CCobThread t(cobInst);
+
+		t.SetID(cobEngine->GenThreadID());
+		t.InitStack(r2, this);
+		t.Start(r1, signalMask, {{0}}, true);
+
+		// calling AddThread directly might move <this>, defer it
+		cobEngine->QueueAddThread(std::move(t));
+	} COB_NEXT();
+
+	COB_OP(CREATE_LOCAL_VAR) {
+		if (paramCount == 0) {
+			PushDataStack(0);
+		} else {
+			paramCount--;
+		}
+	} COB_NEXT();
+	COB_OP(GET_UNIT_VALUE) {
+		r1 = PopDataStack();
+		if ((r1 >= LUA0) && (r1 <= LUA9)) {
+			PushDataStack(luaArgs[r1 - LUA0]);
+			COB_NEXT();
+		}
+		r1 = cobInst->GetUnitVal(r1, 0, 0, 0, 0);
+		PushDataStack(r1);
+	} COB_NEXT();
+
+	COB_OP(JUMP_NOT_EQUAL) {
+		r2 = PopDataStack();
+
+		if (r2 == 0)
+			pc = ins->arg0;
+	} COB_NEXT();
+	COB_OP(JUMP) {
+		pc = ins->arg0;
+	} COB_NEXT();
+
+	COB_OP(POP_LOCAL_VAR) {
+		r2 = PopDataStack();
+		dataStack[LocalStackFrame() + ins->arg0] = r2;
+	} COB_NEXT();
+	COB_OP(PUSH_LOCAL_VAR) {
+		r2 = dataStack[LocalStackFrame() + ins->arg0];
+		PushDataStack(r2);
+	} COB_NEXT();
+
+	COB_OP(BITWISE_AND) {
+		r1 = PopDataStack();
+		r2 = PopDataStack();
+		PushDataStack(r1 & r2);
+	} COB_NEXT();
+	COB_OP(BITWISE_OR) {
+		r1 = PopDataStack();
+		r2 = PopDataStack();
+		PushDataStack(r1 | r2);
+	} COB_NEXT();
+	COB_OP(BITWISE_XOR) {
+		r1 = PopDataStack();
+		r2 = PopDataStack();
+		PushDataStack(r1 ^ r2);
+	} COB_NEXT();
+	COB_OP(BITWISE_NOT) {
+		r1 = PopDataStack();
+		PushDataStack(~r1);
+	} COB_NEXT();
+
+	COB_OP(EXPLODE) {
+		r2 = PopDataStack();
+		cobInst->Explode(ins->arg0, r2);
+	} COB_NEXT();
+	COB_OP(PLAY_SOUND) {
+		r2 = PopDataStack();
+		cobInst->PlayUnitSound(ins->arg0, r2);
+	} COB_NEXT();
+
+	COB_OP(PUSH_STATIC) {
+		if (static_cast<size_t>(ins->arg0) < cobInst->staticVars.size())
+			PushDataStack(cobInst->staticVars[ins->arg0]);
+	} COB_NEXT();
+
+	COB_OP(SET_NOT_EQUAL) {
+		r1 = PopDataStack();
+		r2 = PopDataStack();
+		PushDataStack(int(r1 != r2));
+	} COB_NEXT();
+	COB_OP(SET_EQUAL) {
+		r1 = PopDataStack();
+		r2 = PopDataStack();
+		PushDataStack(int(r1 == r2));
+	} COB_NEXT();
+	COB_OP(SET_LESS) {
+		r2 = PopDataStack();
+		r1 = PopDataStack();
+		PushDataStack(int(r1 < r2));
+	} COB_NEXT();
+	COB_OP(SET_LESS_OR_EQUAL) {
+		r2 = PopDataStack();
+		r1 = PopDataStack();
+		PushDataStack(int(r1 <= r2));
+	} COB_NEXT();
+	COB_OP(SET_GREATER) {
+		r2 = PopDataStack();
+		r1 = PopDataStack();
+		PushDataStack(int(r1 > r2));
+	} COB_NEXT();
+	COB_OP(SET_GREATER_OR_EQUAL) {
+		r2 = PopDataStack();
+		r1 = PopDataStack();
+		PushDataStack(int(r1 >= r2));
+	} COB_NEXT();
+
+	// fused variants; the pushed constant is popped again right away
+	COB_OP(PUSHC_SET_NOT_EQUAL) {
+		r2 = PopDataStack();
+		PushDataStack(int(ins->arg0 != r2));
+	} COB_NEXT();
+	COB_OP(PUSHC_SET_EQUAL) {
+		r2 = PopDataStack();
+		PushDataStack(int(ins->arg0 == r2));
+	} COB_NEXT();
+	COB_OP(PUSHC_SET_LESS) {
+		r1 = PopDataStack();
+		PushDataStack(int(r1 < ins->arg0));
+	} COB_NEXT();
+	COB_OP(PUSHC_SET_LESS_OR_EQUAL) {
+		r1 = PopDataStack();
+		PushDataStack(int(r1 <= ins->arg0));
+	} COB_NEXT();
+	COB_OP(PUSHC_SET_GREATER) {
+		r1 = PopDataStack();
+		PushDataStack(int(r1 > ins->arg0));
+	} COB_NEXT();
+	COB_OP(PUSHC_SET_GREATER_OR_EQUAL) {
+		r1 = PopDataStack();
+		PushDataStack(int(r1 >= ins->arg0));
+	} COB_NEXT();
+
+	COB_OP(RAND) {
+		r2 = PopDataStack();
+		r1 = PopDataStack();
+		r3 = gsRNG.NextInt(r2 - r1 + 1) + r1;
+		PushDataStack(r3);
+	} COB_NEXT();
+	COB_OP(EMIT_SFX) {
+		r1 = PopDataStack();
+		cobInst->EmitSfx(r1, ins->arg0);
+	} COB_NEXT();
+	COB_OP(MUL) {
+		r1 = PopDataStack();
+		r2 = PopDataStack();
+		PushDataStack(r1 * r2);
+	} COB_NEXT();
+
+	COB_OP(SIGNAL) {
+		r1 = PopDataStack();
+		cobInst->Signal(r1);
+	} COB_NEXT();
+	COB_OP(SET_SIGNAL_MASK) {
+		r1 = PopDataStack();
+		signalMask = r1;
+	} COB_NEXT();
+
+	COB_OP(TURN) {
+		r2 = PopDataStack();
+		r1 = PopDataStack();
+		cobInst->Turn(ins->arg0, ins->arg1, r1, r2);
+	} COB_NEXT();
+	COB_OP(GET) {
+		r5 = PopDataStack();
+		r4 = PopDataStack();
+		r3 = PopDataStack();
+		r2 = PopDataStack();
+		r1 = PopDataStack();
+		if ((r1 >= LUA0) && (r1 <= LUA9)) {
+			PushDataStack(luaArgs[r1 - LUA0]);
+			COB_NEXT();
+		}
+		r6 = cobInst->GetUnitVal(r1, r2, r3, r4, r5);
+		PushDataStack(r6);
+	} COB_NEXT();
+	COB_OP(ADD) {
+		r2 = PopDataStack();
+		r1 = PopDataStack();
+		PushDataStack(r1 + r2);
+	} COB_NEXT();
+	COB_OP(SUB) {
+		r2 = PopDataStack();
+		r1 = PopDataStack();
+		r3 = r1 - r2;
+		PushDataStack(r3);
+	} COB_NEXT();
+	COB_OP(DIV) {
+		r2 = PopDataStack();
+		r1 = PopDataStack();
+
+		if (r2 != 0) {
+			r3 = r1 / r2;
+		} else {
+			r3 = 1000; // infinity!
+			ShowError("division by zero");
+		}
+		PushDataStack(r3);
+	} COB_NEXT();
+	COB_OP(MOD) {
+		r2 = PopDataStack();
+		r1 = PopDataStack();
+
+		if (r2 != 0) {
+			PushDataStack(r1 % r2);
+		} else {
+			PushDataStack(0);
+			ShowError("modulo division by zero");
+		}
+	} COB_NEXT();
+
+	COB_OP(MOVE) {
+		r4 = PopDataStack();
+		r3 = PopDataStack();
+		cobInst->Move(ins->arg0, ins->arg1, r3, r4);
+	} COB_NEXT();
+	COB_OP(MOVE_NOW) {
+		r3 = PopDataStack();
+		cobInst->MoveNow(ins->arg0, ins->arg1, r3);
+	} COB_NEXT();
+	COB_OP(TURN_NOW) {
+		r3 = PopDataStack();
+		cobInst->TurnNow(ins->arg0, ins->arg1, r3);
+	} COB_NEXT();
+
+	COB_OP(WAIT_TURN) {
+		if (cobInst->NeedsWait(CCobInstance::ATurn, ins->arg0, ins->arg1)) {
+			state = WaitTurn;
+			waitPiece = ins->arg0;
+			waitAxis = ins->arg1;
+			return true;
+		}
+	} COB_NEXT();
+	COB_OP(WAIT_MOVE) {
+		if (cobInst->NeedsWait(CCobInstance::AMove, ins->arg0, ins->arg1)) {
+			state = WaitMove;
+			waitPiece = ins->arg0;
+			waitAxis = ins->arg1;
+			return true;
+		}
+	} COB_NEXT();
+
+	COB_OP(SET) {
+		r2 = PopDataStack();
+		r1 = PopDataStack();
+
+		if ((r1 >= LUA0) && (r1 <= LUA9)) {
+			luaArgs[r1 - LUA0] = r2;
+			COB_NEXT();
+		}
+
+		cobInst->SetUnitVal(r1, r2);
+	} COB_NEXT();
+
+	COB_OP(ATTACH) {
+		r3 = PopDataStack();
+		r2 = PopDataStack();
+		r1 = PopDataStack();
+		cobInst->AttachUnit(r2, r1);
+	} COB_NEXT();
+	COB_OP(DROP) {
+		r1 = PopDataStack();
+		cobInst->DropUnit(r1);
+	} COB_NEXT();
+
+	// like bitwise ops, but only on values 1 and 0
+	COB_OP(LOGICAL_NOT) {
+		r1 = PopDataStack();
+		PushDataStack(int(r1 == 0));
+	} COB_NEXT();
+	COB_OP(LOGICAL_AND) {
+		r1 = PopDataStack();
+		r2 = PopDataStack();
+		PushDataStack(int(r1 && r2));
+	} COB_NEXT();
+	COB_OP(LOGICAL_OR) {
+		r1 = PopDataStack();
+		r2 = PopDataStack();
+		PushDataStack(int(r1 || r2));
+	} COB_NEXT();
+	COB_OP(LOGICAL_XOR) {
+		r1 = PopDataStack();
+		r2 = PopDataStack();
+		PushDataStack(int((!!r1) ^ (!!r2)));
+	} COB_NEXT();
+
+	COB_OP(HIDE) {
+		cobInst->SetVisibility(ins->arg0, false);
+	} COB_NEXT();
+	COB_OP(SHOW) {
+		int i;
+		for (i = 0; i < MAX_WEAPONS_PER_UNIT; ++i)
+			if (LocalFunctionID() == cobFile->scriptIndex[COBFN_FirePrimary + COBFN_Weapon_Funcs * i])
+				break;
+
+		// if true, we are in a Fire-script and should show a special flare effect
+		if (i < MAX_WEAPONS_PER_UNIT) {
+			cobInst->ShowFlare(ins->arg0);
+		} else {
+			cobInst->SetVisibility(ins->arg0, true);
+		}
+	} COB_NEXT();
+
+#if (COB_COMPUTED_GOTO == 1)
+cobop_exit:
+#else
+			default: {
+				assert(false);
+			} break;
+		}
+	}
+#endif
+
+	// can arrive here as dead, through CCobInstance::Signal()
+	return (state != Dead);
+}
+
+#undef COB_DISPATCH_TABLE_ENTRY
+#undef COB_NEXT
+#undef COB_OP
+#undef COB_FETCH
+#undef COB_COMPUTED_GOTO
+
+
 void CCobThread::ShowError(const char* msg)
 {
 	RECOIL_DETAILED_TRACY_ZONE;
@@ -913,11 +1337,10 @@ void CCobThread::ShowError(const char* msg)
 }
 
 
-void CCobThread::LuaCall()
+void CCobThread::LuaCall(int r1, int r2)
 {
 	RECOIL_DETAILED_TRACY_ZONE;
-	const int r1 = GET_LONG_PC(); // script id
-	const int r2 = GET_LONG_PC(); // arg count
+	// r1 is the script id, r2 the arg count
 
 	// setup the parameter array
 	const int size = static_cast<int>(dataStack.size());
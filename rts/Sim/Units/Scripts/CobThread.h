@@ -105,7 +105,12 @@ protected:
 		int stackTop = -1;
 	};
 
-	void LuaCall();
+	/// runs the raw opcode stream, one instruction only if singleStep
+	bool TickRaw(bool singleStep);
+	/// runs CCobFile::decodedCode, see CobBytecode::Decode
+	bool TickDecoded();
+
+	void LuaCall(int scriptId, int argCount);
 
 	void PushCallStack(CallInfo v) { callStack.push_back(v); }
 	void PushDataStack(int v) { dataStack.push_back(v); }
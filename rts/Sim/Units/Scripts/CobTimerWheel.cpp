@@ -0,0 +1,160 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include <algorithm>
+
+#include "CobTimerWheel.h"
+
+#include "System/Misc/TracyDefs.h"
+
+CR_BIND(CCobTimerWheel, )
+
+CR_REG_METADATA(CCobTimerWheel, (
+	CR_MEMBER(buckets),
+	CR_MEMBER(lateEntries),
+	CR_MEMBER(farEntries),
+	// always empty outside of Cascade
+	CR_IGNORED(cascadeEntries),
+
+	CR_MEMBER(wheelTime)
+))
+
+CR_BIND(CCobTimerWheel::SleepingThread, )
+CR_REG_METADATA(CCobTimerWheel::SleepingThread, (
+	CR_MEMBER(id),
+	CR_MEMBER(wt)
+))
+
+
+void CCobTimerWheel::Clear()
+{
+	for (auto& bucket: buckets) {
+		bucket.clear();
+	}
+
+	lateEntries.clear();
+	farEntries.clear();
+	cascadeEntries.clear();
+
+	wheelTime = 0;
+}
+
+void CCobTimerWheel::Insert(const SleepingThread& st)
+{
+	// can happen for threads sleeping a negative amount of time
+	if (st.wt < wheelTime) {
+		lateEntries.push_back(st);
+		return;
+	}
+
+	InsertBucket(st);
+}
+
+void CCobTimerWheel::InsertBucket(const SleepingThread& st)
+{
+	// store in the finest level whose range (the block of time sharing all
+	// higher bits with wheelTime) still contains the wake-up time
+	for (int level = 0; level < NUM_LEVELS; level++) {
+		if ((st.wt >> LEVEL_SHIFTS[level + 1]) != (wheelTime >> LEVEL_SHIFTS[level + 1]))
+			continue;
+
+		const int slotMask = (LEVEL_OFFSETS[level + 1] - LEVEL_OFFSETS[level]) - 1;
+		const int slot = (st.wt >> LEVEL_SHIFTS[level]) & slotMask;
+
+		buckets[LEVEL_OFFSETS[level] + slot].push_back(st);
+		return;
+	}
+
+	farEntries.push_back(st);
+}
+
+
+void CCobTimerWheel::Cascade()
+{
+	RECOIL_DETAILED_TRACY_ZONE;
+	// wheelTime just entered a new first-level block; coarser levels go first
+	// since each of them can refill the bucket of the level below it
+	if ((wheelTime & ((1 << LEVEL_SHIFTS[NUM_LEVELS]) - 1)) == 0)
+		CascadeBucket(farEntries);
+
+	for (int level = NUM_LEVELS - 1; level > 0; level--) {
+		if ((wheelTime & ((1 << LEVEL_SHIFTS[level]) - 1)) != 0)
+			continue;
+
+		const int slotMask = (LEVEL_OFFSETS[level + 1] - LEVEL_OFFSETS[level]) - 1;
+		const int slot = (wheelTime >> LEVEL_SHIFTS[level]) & slotMask;
+
+		CascadeBucket(buckets[LEVEL_OFFSETS[level] + slot]);
+	}
+}
+
+void CCobTimerWheel::CascadeBucket(std::vector<SleepingThread>& bucket)
+{
+	if (bucket.empty())
+		return;
+
+	// entries might land in the same bucket again (farEntries)
+	cascadeEntries.swap(bucket);
+
+	for (const SleepingThread& st: cascadeEntries) {
+		InsertBucket(st);
+	}
+
+	cascadeEntries.clear();
+}
+
+
+void CCobTimerWheel::Advance(int time, std::vector<SleepingThread>& due)
+{
+	RECOIL_DETAILED_TRACY_ZONE;
+	const size_t numDue = due.size();
+
+	for (; wheelTime < time; wheelTime++) {
+		const int slot = wheelTime & (LEVEL_OFFSETS[1] - 1);
+
+		if (slot == 0)
+			Cascade();
+
+		std::vector<SleepingThread>& bucket = buckets[slot];
+
+		due.insert(due.end(), bucket.begin(), bucket.end());
+		bucket.clear();
+	}
+
+	if (!lateEntries.empty()) {
+		const auto it = std::partition(lateEntries.begin(), lateEntries.end(), [&](const SleepingThread& st) { return (st.wt >= time); });
+
+		due.insert(due.end(), it, lateEntries.end());
+		lateEntries.erase(it, lateEntries.end());
+	}
+
+	// buckets are already ordered by wake-up time, but not by ID within one
+	std::sort(due.begin() + numDue, due.end(), WakeOrderComp());
+}
+
+
+std::vector<CCobTimerWheel::SleepingThread> CCobTimerWheel::GetEntries() const
+{
+	std::vector<SleepingThread> entries;
+	entries.reserve(size());
+
+	for (const auto& bucket: buckets) {
+		entries.insert(entries.end(), bucket.begin(), bucket.end());
+	}
+
+	entries.insert(entries.end(), lateEntries.begin(), lateEntries.end());
+	entries.insert(entries.end(), farEntries.begin(), farEntries.end());
+
+	std::sort(entries.begin(), entries.end(), WakeOrderComp());
+	return entries;
+}
+
+size_t CCobTimerWheel::size() const
+{
+	size_t n = lateEntries.size() + farEntries.size();
+
+	for (const auto& bucket: buckets) {
+		n += bucket.size();
+	}
+
+	return n;
+}
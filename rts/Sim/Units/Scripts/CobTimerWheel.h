@@ -0,0 +1,82 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#ifndef COB_TIMER_WHEEL_H
+#define COB_TIMER_WHEEL_H
+
+#include <array>
+#include <cstddef>
+#include <vector>
+
+#include "System/creg/creg_cond.h"
+
+
+/**
+ * Hierarchical timer wheel holding the sleeping COB threads.
+ *
+ * Wake-up times are in script milliseconds (see CCobEngine::Tick). The first
+ * level has one bucket per millisecond, the coarser levels are cascaded into
+ * it as time advances, and anything further out than the last level covers
+ * is parked in a plain list. Threads of a bucket are stored contiguously and
+ * drained in bulk; Advance hands them out in the same order the engine used
+ * to pop them from its priority-queue, by wake-up time and then by ID.
+ */
+class CCobTimerWheel
+{
+	CR_DECLARE_STRUCT(CCobTimerWheel)
+
+public:
+	struct SleepingThread {
+		CR_DECLARE_STRUCT(SleepingThread)
+
+		int id;
+		int wt;
+	};
+
+	struct WakeOrderComp {
+	public:
+		bool operator() (const SleepingThread& a, const SleepingThread& b) const {
+			return a.wt < b.wt || (a.wt == b.wt && a.id < b.id);
+		}
+	};
+
+	static constexpr int NUM_LEVELS = 4;
+	// bit offset of each level's slot index into the wake-up time
+	static constexpr std::array<int, NUM_LEVELS + 1> LEVEL_SHIFTS = {0, 8, 14, 20, 26};
+	static constexpr std::array<int, NUM_LEVELS + 1> LEVEL_OFFSETS = {0, 256, 256 + 64, 256 + 64 * 2, 256 + 64 * 3};
+	static constexpr int NUM_BUCKETS = LEVEL_OFFSETS[NUM_LEVELS];
+
+public:
+	void Clear();
+
+	void Insert(const SleepingThread& st);
+	/// appends every entry with wt < time to <due>, sorted by wake order
+	void Advance(int time, std::vector<SleepingThread>& due);
+
+	/// all entries sorted by wake order; slow, meant for sync dumps
+	std::vector<SleepingThread> GetEntries() const;
+
+	size_t size() const;
+	bool empty() const { return (size() == 0); }
+
+	int GetTime() const { return wheelTime; }
+
+private:
+	void InsertBucket(const SleepingThread& st);
+	void Cascade();
+	void CascadeBucket(std::vector<SleepingThread>& bucket);
+
+private:
+	std::array<std::vector<SleepingThread>, NUM_BUCKETS> buckets;
+
+	// wt < wheelTime, already due when inserted
+	std::vector<SleepingThread> lateEntries;
+	// wt beyond the range of the last level
+	std::vector<SleepingThread> farEntries;
+
+	std::vector<SleepingThread> cascadeEntries;
+
+	// every wake-up time before this has been drained
+	int wheelTime = 0;
+};
+
+#endif // COB_TIMER_WHEEL_H
@@ -367,6 +367,11 @@ void CUnitHandler::SlowUpdateUnits()
 
 	static std::vector<CUnit*> updateBoundingVolumeList;
 	updateBoundingVolumeList.clear();
+
+	if (modInfo.parallelWeaponTargeting) {
+		ZoneScopedN("Sim::Unit::SlowUpdateWeaponTargetsMT");
+		PreScoreUnitWeaponTargets(idxBeg, idxEnd, false);
+	}
 	{
 		ZoneScopedN("Sim::Unit::SlowUpdateST");
 		for (size_t i = idxBeg; i < idxEnd; ++i) {
@@ -410,6 +415,34 @@ void CUnitHandler::UpdateUnits()
 	}
 }
 
+void CUnitHandler::PreScoreUnitWeaponTargets(const size_t idxBeg, const size_t idxEnd, const bool fastRetargetOnly)
+{
+	// phase one of parallelWeaponTargeting: every weapon only writes its own
+	// candidate list, phase two (CWeapon::AutoTarget) then consumes the lists
+	// serially in activeUnits order so the outcome is thread-count invariant
+	for_mt_chunk(idxBeg, idxEnd, [&](const int idx) {
+		const CUnit* unit = activeUnits[idx];
+
+		if (!unit->CanUpdateWeapons())
+			return;
+
+		for (CWeapon* w: unit->weapons) {
+			if (fastRetargetOnly && !w->NeedFastAutoRetarget())
+				continue;
+			if (!w->CanPreScoreTargets())
+				continue;
+
+			// during SlowUpdate the vectors are still those of the previous
+			// frame; refresh them so movement since then is accounted for
+			// (CWeapon::SlowUpdate repeats this after querying its pieces)
+			if (!fastRetargetOnly)
+				w->UpdateWeaponVectors();
+
+			w->PreScoreTargets();
+		}
+	});
+}
+
 void CUnitHandler::UpdateUnitWeapons()
 {
 	{
@@ -420,6 +453,10 @@ void CUnitHandler::UpdateUnitWeapons()
 			unit->UpdateWeaponVectors();
 		});
 	}
+	if (modInfo.parallelWeaponTargeting) {
+		SCOPED_TIMER("Sim::Unit::WeaponTargetsMT");
+		PreScoreUnitWeaponTargets(0, activeUnits.size(), true);
+	}
 	{
 		SCOPED_TIMER("Sim::Unit::Weapon");
 		for (activeUpdateUnit = 0; activeUpdateUnit < activeUnits.size(); ++activeUpdateUnit) {
@@ -86,6 +86,7 @@ private:
 	void UpdateUnitLosStates();
 	void UpdateUnits();
 	void UpdateUnitWeapons();
+	void PreScoreUnitWeaponTargets(const size_t idxBeg, const size_t idxEnd, const bool fastRetargetOnly);
 
 	void GetUnitsWithPathRequests(std::vector<CUnit*>& unitsToMove, const size_t idxBeg, const size_t idxEnd);
 	void MultiThreadPathRequests(std::vector<CUnit*>& unitsToMove);
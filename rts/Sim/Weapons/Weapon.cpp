@@ -107,6 +107,8 @@ CR_REG_METADATA(CWeapon, (
 	CR_MEMBER(currentTargetPos),
 
 	CR_MEMBER(incomingProjectileIDs),
+	CR_IGNORED(preScoredTargets),
+	CR_IGNORED(preScoredTargetsFrame),
 
 	CR_MEMBER(weaponAimAdjustPriority),
 	CR_MEMBER(fastAutoRetargeting),
@@ -193,7 +195,9 @@ CWeapon::CWeapon(CUnit* owner, const WeaponDef* def):
 	weaponAimAdjustPriority(1.f),
 	fastAutoRetargeting(false),
 	fastQueryPointUpdate(false),
-	burstControlWhenOutOfArc(0)
+	burstControlWhenOutOfArc(0),
+
+	preScoredTargetsFrame(-1)
 {
 	assert(weaponMemPool.alloced(this));
 }
@@ -315,9 +319,7 @@ void CWeapon::Update()
 	ZoneScoped;
 
 	// Fast auto targeting needs to trigger an immediate retarget once the target is dead.
-	bool fastAutoRetargetRequired = fastAutoRetargeting && HaveTarget()
-									&& currentTarget.unit != nullptr && currentTarget.unit->isDead;
-	if (fastAutoRetargetRequired) {
+	if (NeedFastAutoRetarget()) {
 		// switch to unit's target if it has one - see next bit below
 		bool ownerTargetIsValid = (owner->curTarget.type == Target_Unit && currentTarget.unit != nullptr && !currentTarget.unit->isDead)
 								|| (owner->curTarget.type != Target_Unit && owner->curTarget.type != Target_None);
@@ -705,9 +707,49 @@ bool CWeapon::AllowWeaponAutoTarget() const
 	return (gs->frameNum > (lastTargetRetry + 65));
 }
 
+bool CWeapon::NeedFastAutoRetarget() const
+{
+	return (fastAutoRetargeting && HaveTarget() && currentTarget.unit != nullptr && currentTarget.unit->isDead);
+}
+
+bool CWeapon::CanPreScoreTargets() const
+{
+	RECOIL_DETAILED_TRACY_ZONE;
+	// Lua- and script-free subset of AllowWeaponAutoTarget; anything
+	// else is decided by the serial AutoTarget call that follows
+	if (weaponDef->noAutoTarget || noAutoTarget)
+		return false;
+	if (owner->fireState < FIRESTATE_FIREATWILL)
+		return false;
+	if (slavedTo != nullptr)
+		return false;
+	if (weaponDef->interceptor)
+		return false;
+
+	// a still-valid current target would most likely be kept
+	if (HaveTarget() && !avoidTarget && !NeedFastAutoRetarget())
+		return (currentTarget.isUserTarget)? false: (gs->frameNum > (lastTargetRetry + 65));
+
+	return true;
+}
+
+void CWeapon::PreScoreTargets()
+{
+	RECOIL_DETAILED_TRACY_ZONE;
+	// NB: called from worker threads, must not touch shared state
+	helper->ScoreWeaponTargets(this, preScoredTargets);
+	preScoredTargetsFrame = gs->frameNum;
+}
+
 bool CWeapon::AutoTarget()
 {
 	RECOIL_DETAILED_TRACY_ZONE;
+	// pre-scored candidates are only valid for the frame they were generated in
+	// and are consumed (or discarded) by the first AutoTarget call made in it
+	const bool usePreScoredTargets = (preScoredTargetsFrame == gs->frameNum);
+
+	preScoredTargetsFrame = -1;
+
 	if (!AllowWeaponAutoTarget())
 		return false;
 
@@ -725,7 +767,11 @@ bool CWeapon::AutoTarget()
 	//   GenerateWeaponTargets sorts by INCREASING order of priority, so lower equals better
 	//   <targetPairs> is normally sorted such that all bad TargetCategory units live at the
 	//   end, but Lua can mess with the ordering arbitrarily
-	for (size_t i = 0, n = CGameHelper::GenerateWeaponTargets(this, avoidUnit, targetPairs); i < n; i++, assert(n == targetPairs.size())) {
+	const size_t numTargets = usePreScoredTargets?
+		CGameHelper::CommitWeaponTargets(this, avoidUnit, preScoredTargets, targetPairs):
+		CGameHelper::GenerateWeaponTargets(this, avoidUnit, targetPairs);
+
+	for (size_t i = 0, n = numTargets; i < n; i++, assert(n == targetPairs.size())) {
 		CUnit* unit = targetPairs[i].second;
 
 		// save the "best" bad target in case we have no other
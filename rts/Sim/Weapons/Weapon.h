@@ -83,6 +83,9 @@ public:
 	virtual void UpdateRange(const float val) { range = val; }
 
 	bool AutoTarget();
+	bool NeedFastAutoRetarget() const;
+	bool CanPreScoreTargets() const;
+	void PreScoreTargets();
 	void AimReady(const int value);
 	void Fire(const bool scriptCall);
 
@@ -214,6 +217,11 @@ protected:
 	// projectiles that are on the way to our interception zone
 	// (eg. nuke toward a repulsor, or missile toward a shield)
 	std::vector<int> incomingProjectileIDs;
+
+	// candidates from the parallel scoring pass, consumed by
+	// the next AutoTarget call made during the same sim-frame
+	std::vector<SWeaponTargetScore> preScoredTargets;
+	int preScoredTargetsFrame;
 };
 
 #endif /* WEAPON_H */
@@ -48,4 +48,21 @@ public:
 	float3 groundPos;             // if targettype=ground: the ground position
 };
 
+
+// candidate produced by CGameHelper::ScoreWeaponTargets; holds the factors of its
+// priority so the avoidee, TargetWeight and AllowWeaponTarget terms can be added
+// later (see CommitWeaponTargets) in the same order the serial scorer uses
+struct SWeaponTargetScore {
+	CUnit* unit = nullptr;
+
+	// {radar, angle, range, outside unboosted range, health or radar, paralyzed}
+	float headMults[6] = {1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f};
+	// {bad category, crashing, last attacker}, applied after dividing by tailDivisor
+	float tailMults[3] = {1.0f, 1.0f, 1.0f};
+	float tailDivisor = 1.0f;
+
+	bool inLos = false;
+	bool prevLos = false;
+};
+
 #endif // WEAPONTARGET_H
@@ -0,0 +1,149 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#ifndef EVENT_BATCH_H
+#define EVENT_BATCH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+/**
+ * Per-frame accumulations of high-volume unit events, stored as parallel
+ * arrays so a client can consume a whole frame's worth with a single call.
+ * Only IDs are kept: the units involved may be gone by the time a batch is
+ * delivered (see CEventHandler::FlushEventBatches).
+ */
+struct UnitDamagedEventBatch {
+	void Add(
+		int unitID,
+		int unitDefID,
+		int unitTeam,
+		float damage,
+		bool paralyzer,
+		int weaponDefID,
+		int projectileID,
+		int attackerID,
+		int attackerDefID,
+		int attackerTeam
+	) {
+		unitIDs.push_back(unitID);
+		unitDefIDs.push_back(unitDefID);
+		unitTeams.push_back(unitTeam);
+		damages.push_back(damage);
+		paralyzers.push_back(paralyzer);
+		weaponDefIDs.push_back(weaponDefID);
+		projectileIDs.push_back(projectileID);
+		attackerIDs.push_back(attackerID);
+		attackerDefIDs.push_back(attackerDefID);
+		attackerTeams.push_back(attackerTeam);
+	}
+
+	void clear() {
+		unitIDs.clear();
+		unitDefIDs.clear();
+		unitTeams.clear();
+		damages.clear();
+		paralyzers.clear();
+		weaponDefIDs.clear();
+		projectileIDs.clear();
+		attackerIDs.clear();
+		attackerDefIDs.clear();
+		attackerTeams.clear();
+	}
+
+	size_t size() const { return unitIDs.size(); }
+	bool empty() const { return unitIDs.empty(); }
+
+	std::vector<int> unitIDs;
+	std::vector<int> unitDefIDs;
+	std::vector<int> unitTeams;
+	std::vector<float> damages;
+	std::vector<uint8_t> paralyzers;
+	std::vector<int> weaponDefIDs;
+	std::vector<int> projectileIDs;
+	// -1 if there was no attacker
+	std::vector<int> attackerIDs;
+	std::vector<int> attackerDefIDs;
+	std::vector<int> attackerTeams;
+};
+
+struct UnitLosEventBatch {
+	void Add(int unitID, int unitTeam, int allyTeam, int unitDefID) {
+		unitIDs.push_back(unitID);
+		unitTeams.push_back(unitTeam);
+		allyTeams.push_back(allyTeam);
+		unitDefIDs.push_back(unitDefID);
+	}
+
+	void clear() {
+		unitIDs.clear();
+		unitTeams.clear();
+		allyTeams.clear();
+		unitDefIDs.clear();
+	}
+
+	size_t size() const { return unitIDs.size(); }
+	bool empty() const { return unitIDs.empty(); }
+
+	std::vector<int> unitIDs;
+	std::vector<int> unitTeams;
+	std::vector<int> allyTeams;
+	std::vector<int> unitDefIDs;
+};
+
+
+/**
+ * The batches of one event kind. Synced and unsynced clients are fed from
+ * separate batches which are only filled while a client of the same kind
+ * subscribes, so what synced code receives never depends on local (e.g.
+ * widget) subscriptions. Index 0 is filled during the frame, index 1 holds
+ * the batch being delivered.
+ */
+template<typename B>
+struct EventBatchSet {
+	void SetCollecting(bool syncedClients, bool unsyncedClients) {
+		collectSynced = syncedClients;
+		collectUnsynced = unsyncedClients;
+	}
+
+	bool IsCollecting() const { return (collectSynced || collectUnsynced); }
+
+	template<typename... A>
+	void Add(const A&... args) {
+		if (collectSynced)
+			synced[0].Add(args...);
+		if (collectUnsynced)
+			unsynced[0].Add(args...);
+	}
+
+	bool empty() const { return (synced[0].empty() && unsynced[0].empty()); }
+
+	void clear() {
+		for (int i = 0; i < 2; i++) {
+			synced[i].clear();
+			unsynced[i].clear();
+		}
+	}
+
+	// events added from here on go into the next delivery
+	void BeginDelivery() {
+		std::swap(synced[0], synced[1]);
+		std::swap(unsynced[0], unsynced[1]);
+	}
+
+	void EndDelivery() {
+		synced[1].clear();
+		unsynced[1].clear();
+	}
+
+	const B& GetDelivered(bool syncedClient) const { return (syncedClient? synced[1]: unsynced[1]); }
+
+	B synced[2];
+	B unsynced[2];
+
+	bool collectSynced = false;
+	bool collectUnsynced = false;
+};
+
+#endif // EVENT_BATCH_H
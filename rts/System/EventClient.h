@@ -33,6 +33,8 @@ struct UnitDef;
 struct BuildInfo;
 struct FeatureDef;
 class LuaMaterial;
+struct UnitDamagedEventBatch;
+struct UnitLosEventBatch;
 
 #ifndef zipFile
 	// might be defined through zip.h already
@@ -143,6 +145,8 @@ class CEventClient
 			int weaponDefID,
 			int projectileID,
 			bool paralyzer) {}
+		/// all UnitDamaged events since the last call, delivered once per frame
+		virtual void UnitDamagedBatch(const UnitDamagedEventBatch& batch) {}
 		virtual void UnitStunned(const CUnit* unit, bool stunned) {}
 		virtual void UnitExperience(const CUnit* unit, float oldExperience) {}
 		virtual void UnitHarvestStorageFull(const CUnit* unit) {}
@@ -153,6 +157,8 @@ class CEventClient
 		virtual void UnitEnteredLos(const CUnit* unit, int allyTeam) {}
 		virtual void UnitLeftRadar(const CUnit* unit, int allyTeam) {}
 		virtual void UnitLeftLos(const CUnit* unit, int allyTeam) {}
+		virtual void UnitEnteredLosBatch(const UnitLosEventBatch& batch) {}
+		virtual void UnitLeftLosBatch(const UnitLosEventBatch& batch) {}
 
 		virtual void UnitEnteredUnderwater(const CUnit* unit) {}
 		virtual void UnitEnteredWater(const CUnit* unit) {}
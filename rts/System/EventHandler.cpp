@@ -4,6 +4,7 @@
 
 #include "Lua/LuaCallInCheck.h"
 #include "Lua/LuaOpenGL.h"  // FIXME -- should be moved
+#include "Sim/Units/UnitDef.h"
 
 #include "System/Config/ConfigHandler.h"
 #include "System/Platform/Threading.h"
@@ -41,6 +42,11 @@ void CEventHandler::ResetState()
 	handles.reserve(16);
 
 	SetupEvents();
+	UpdateEventBatchClients();
+
+	unitDamagedBatches.clear();
+	unitEnteredLosBatches.clear();
+	unitLeftLosBatches.clear();
 }
 
 void CEventHandler::SetupEvents()
@@ -154,6 +160,7 @@ bool CEventHandler::InsertEvent(CEventClient* ec, const std::string& ciName)
 		return false;
 
 	ListInsert(*iter->second.GetList(), ec);
+	UpdateEventBatchClients();
 	return true;
 }
 
@@ -167,6 +174,7 @@ bool CEventHandler::RemoveEvent(CEventClient* ec, const std::string& ciName)
 		return false;
 
 	ListRemove(*(iter->second.GetList()), ec);
+	UpdateEventBatchClients();
 	return true;
 }
 
@@ -558,9 +566,83 @@ void CEventHandler::GameFrame(int gameFrame)
 void CEventHandler::GameFramePost(int gameFrame)
 {
 	ZoneScoped;
+	FlushEventBatches();
 	ITERATE_EVENTCLIENTLIST(GameFramePost, gameFrame);
 }
 
+
+void CEventHandler::BatchUnitDamaged(
+	const CUnit* unit,
+	const CUnit* attacker,
+	float damage,
+	int weaponDefID,
+	int projectileID,
+	bool paralyzer
+) {
+	unitDamagedBatches.Add(
+		unit->id,
+		unit->unitDef->id,
+		unit->team,
+		damage,
+		paralyzer,
+		weaponDefID,
+		projectileID,
+		(attacker != nullptr)? attacker->id: -1,
+		(attacker != nullptr)? attacker->unitDef->id: -1,
+		(attacker != nullptr)? attacker->team: -1
+	);
+}
+
+void CEventHandler::BatchUnitLos(EventBatchSet<UnitLosEventBatch>& batches, const CUnit* unit, int allyTeam)
+{
+	batches.Add(unit->id, unit->team, allyTeam, unit->unitDef->id);
+}
+
+void CEventHandler::UpdateEventBatchClients()
+{
+	const auto hasClients = [](const EventClientList& clients, bool synced) {
+		return std::any_of(clients.begin(), clients.end(), [&](const CEventClient* ec) { return (ec->GetSynced() == synced); });
+	};
+
+	// synced batches must be gated only by synced clients, which are
+	// the same on every machine; unsynced ones may come and go locally
+	unitDamagedBatches.SetCollecting(hasClients(listUnitDamagedBatch, true), hasClients(listUnitDamagedBatch, false));
+	unitEnteredLosBatches.SetCollecting(hasClients(listUnitEnteredLosBatch, true), hasClients(listUnitEnteredLosBatch, false));
+	unitLeftLosBatches.SetCollecting(hasClients(listUnitLeftLosBatch, true), hasClients(listUnitLeftLosBatch, false));
+}
+
+template<typename B>
+void CEventHandler::FlushEventBatch(EventClientList& clients, EventBatchSet<B>& batches, void (CEventClient::*callIn)(const B&))
+{
+	if (batches.empty())
+		return;
+
+	// anything the clients cause from here on is delivered next time
+	batches.BeginDelivery();
+
+	for (size_t i = 0; i < clients.size(); ) {
+		CEventClient* ec = clients[i];
+		const B& batch = batches.GetDelivered(ec->GetSynced());
+
+		// batches span all allyteams and are not filtered per event
+		if (ec->GetFullRead() && !batch.empty())
+			(ec->*callIn)(batch);
+
+		i += (i < clients.size() && ec == clients[i]);
+	}
+
+	// also drops batches whose last interested client went away
+	batches.EndDelivery();
+}
+
+void CEventHandler::FlushEventBatches()
+{
+	ZoneScoped;
+	FlushEventBatch(listUnitDamagedBatch, unitDamagedBatches, &CEventClient::UnitDamagedBatch);
+	FlushEventBatch(listUnitEnteredLosBatch, unitEnteredLosBatches, &CEventClient::UnitEnteredLosBatch);
+	FlushEventBatch(listUnitLeftLosBatch, unitLeftLosBatches, &CEventClient::UnitLeftLosBatch);
+}
+
 void CEventHandler::GameProgress(int gameFrame)
 {
 	ZoneScoped;
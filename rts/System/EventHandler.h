@@ -6,6 +6,7 @@
 #include <string>
 #include <vector>
 
+#include "System/EventBatch.h"
 #include "System/EventClient.h"
 #include "Sim/Units/Unit.h"
 #include "Sim/Features/Feature.h"
@@ -54,6 +55,8 @@ class CEventHandler
 		void GamePaused(int playerID, bool paused);
 		void GameFrame(int gameFrame);
 		void GameFramePost(int gameFrame);
+		/// delivers the batched unit events accumulated since the last call
+		void FlushEventBatches();
 		void GameID(const unsigned char* gameID, unsigned int numBytes);
 
 		void TeamDied(int teamID);
@@ -351,6 +354,14 @@ class CEventHandler
 		void ListInsert(EventClientList& ciList, CEventClient* ec);
 		void ListRemove(EventClientList& ciList, CEventClient* ec);
 
+		void BatchUnitDamaged(const CUnit* unit, const CUnit* attacker, float damage, int weaponDefID, int projectileID, bool paralyzer);
+		void BatchUnitLos(EventBatchSet<UnitLosEventBatch>& batches, const CUnit* unit, int allyTeam);
+
+		void UpdateEventBatchClients();
+
+		template<typename B>
+		void FlushEventBatch(EventClientList& clients, EventBatchSet<B>& batches, void (CEventClient::*callIn)(const B&));
+
 	private:
 		CEventClient* mouseOwner;
 
@@ -359,6 +370,13 @@ class CEventHandler
 
 		EventClientList handles;
 
+		// filled only while some client wants the batched call-in, see
+		// UpdateEventBatchClients; events raised by the receiving clients
+		// themselves go into the next frame's batch
+		EventBatchSet<UnitDamagedEventBatch> unitDamagedBatches;
+		EventBatchSet<UnitLosEventBatch> unitEnteredLosBatches;
+		EventBatchSet<UnitLosEventBatch> unitLeftLosBatches;
+
 	#define SETUP_EVENT(name, props) EventClientList list ## name;
 	#define SETUP_UNMANAGED_EVENT(name, props)
 		#include "Events.def"
@@ -463,9 +481,23 @@ UNIT_CALLIN_INT_PARAMS(Given)
 	}
 
 UNIT_CALLIN_LOS_PARAM(EnteredRadar)
-UNIT_CALLIN_LOS_PARAM(EnteredLos)
 UNIT_CALLIN_LOS_PARAM(LeftRadar)
-UNIT_CALLIN_LOS_PARAM(LeftLos)
+
+inline void CEventHandler::UnitEnteredLos(const CUnit* unit, int allyTeam)
+{
+	ITERATE_ALLYTEAM_EVENTCLIENTLIST(UnitEnteredLos, allyTeam, unit, allyTeam)
+
+	if (unitEnteredLosBatches.IsCollecting())
+		BatchUnitLos(unitEnteredLosBatches, unit, allyTeam);
+}
+
+inline void CEventHandler::UnitLeftLos(const CUnit* unit, int allyTeam)
+{
+	ITERATE_ALLYTEAM_EVENTCLIENTLIST(UnitLeftLos, allyTeam, unit, allyTeam)
+
+	if (unitLeftLosBatches.IsCollecting())
+		BatchUnitLos(unitLeftLosBatches, unit, allyTeam);
+}
 
 
 inline void CEventHandler::UnitConstructionDecayed(const CUnit* unit,
@@ -551,6 +583,9 @@ inline void CEventHandler::UnitDamaged(
 	bool paralyzer)
 {
 	ITERATE_UNIT_ALLYTEAM_EVENTCLIENTLIST(UnitDamaged, unit, attacker, damage, weaponDefID, projectileID, paralyzer)
+
+	if (unitDamagedBatches.IsCollecting())
+		BatchUnitDamaged(unit, attacker, damage, weaponDefID, projectileID, paralyzer);
 }
 
 inline void CEventHandler::UnitStunned(
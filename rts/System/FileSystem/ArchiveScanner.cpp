@@ -3,8 +3,10 @@
 #include <algorithm>
 #include <array>
 #include <cstdio>
+#include <cstring>
 #include <memory>
 #include <random>
+#include <type_traits>
 #include <chrono>
 
 #include <sys/types.h>
@@ -58,7 +60,12 @@ LOG_REGISTER_SECTION_GLOBAL(LOG_SECTION_ARCHIVESCANNER)
  * but mapping them all, every time to make the list is)
  */
 
-constexpr static int INTERNAL_VER = 20;
+constexpr static int INTERNAL_VER = 21;
+// the last version written as ArchiveCache%i.lua, its data is still valid
+constexpr static int LAST_LUA_CACHE_VER = 20;
+
+// number of archives opened at once by ScanDirs
+constexpr static size_t ARCHIVE_SCAN_BATCH_SIZE = 64;
 
 
 /*
@@ -499,12 +506,55 @@ void CArchiveScanner::ScanDirs(const std::vector<std::string>& scanDirs)
 		}
 	}*/
 
-	// Create archiveInfos etc. if not in cache already
-	for (const std::string& archive: foundArchives) {
-		ScanArchive(archive, false);
-	#if !defined(DEDICATED) && !defined(UNITSYNC)
-		Watchdog::ClearTimer();
-	#endif
+	// Create archiveInfos etc. if not in cache already; archives are stat'ed,
+	// opened and have their info file read in parallel, but are checked
+	// against and added to the cache serially in the order they were found
+	std::vector<uint32_t> modifiedTimes(foundArchives.size(), 0);
+
+	for_mt(0, foundArchives.size(), [&](const int i) {
+		modifiedTimes[i] = GetArchiveModificationTime(foundArchives[i]);
+	});
+
+	std::vector<ArchiveScanData> scanBatch;
+	std::vector<std::string> scanLater;
+	spring::unordered_set<std::string> scanBatchNames;
+
+	for (size_t i = 0; i < foundArchives.size(); i += ARCHIVE_SCAN_BATCH_SIZE) {
+		scanBatch.clear();
+		scanLater.clear();
+		scanBatchNames.clear();
+
+		for (size_t j = i, n = std::min(i + ARCHIVE_SCAN_BATCH_SIZE, foundArchives.size()); j < n; j++) {
+			const std::string& fullName = foundArchives[j];
+
+			if (CheckCachedData(fullName, modifiedTimes[j], false))
+				continue;
+
+			// a duplicate has to see the result of the first archive by its name
+			if (!scanBatchNames.insert(StringToLower(FileSystem::GetFilename(fullName))).second) {
+				scanLater.push_back(fullName);
+				continue;
+			}
+
+			ArchiveScanData& scanData = scanBatch.emplace_back();
+			scanData.fullName = fullName;
+			scanData.modified = modifiedTimes[j];
+		}
+
+		for_mt(0, scanBatch.size(), [&scanBatch](const int j) {
+			ReadArchiveScanData(scanBatch[j]);
+		});
+
+		for (ArchiveScanData& scanData: scanBatch) {
+			AddScannedArchive(scanData, false);
+		#if !defined(DEDICATED) && !defined(UNITSYNC)
+			Watchdog::ClearTimer();
+		#endif
+		}
+
+		for (const std::string& fullName: scanLater) {
+			ScanArchive(fullName, false);
+		}
 	}
 
 	// Now we'll have to parse the replaces-stuff found in the mods
@@ -618,20 +668,27 @@ void CArchiveScanner::ReadCache()
 {
 	Clear();
 
-    cacheFile = FileSystem::EnsurePathSepAtEnd(FileSystem::GetCacheDir()) + IntToString(INTERNAL_VER, "ArchiveCache%i.lua");
+	cacheFile = FileSystem::EnsurePathSepAtEnd(FileSystem::GetCacheDir()) + IntToString(INTERNAL_VER, "ArchiveCache%i.bin");
+
+	const bool haveCacheFile = FileSystem::FileExists(cacheFile);
+	// the last Lua cache only differs in format, convert it as-is
+	const bool haveLuaCacheFile = !haveCacheFile && ReadLuaCacheData(FileSystem::EnsurePathSepAtEnd(FileSystem::GetCacheDir()) + IntToString(LAST_LUA_CACHE_VER, "ArchiveCache%i.lua"));
 
-	if (!FileSystem::FileExists(cacheFile)) {
+	if (haveLuaCacheFile)
+		isDirty = true;
+
+	if (!haveCacheFile && !haveLuaCacheFile) {
 		// Try to save initial scanning of assets, but will have to redo hashing
 		// as the previous version had bugs in that area
 		// probe two previous versions
 		std::array prevCacheFiles {
-			FileSystem::EnsurePathSepAtEnd(FileSystem::GetCacheDir()) + IntToString(INTERNAL_VER - 1, "ArchiveCache%i.lua"),
-			FileSystem::EnsurePathSepAtEnd(FileSystem::GetCacheDir()) + IntToString(INTERNAL_VER - 2, "ArchiveCache%i.lua"),
-			FileSystem::EnsurePathSepAtEnd(FileSystem::GetCacheDir()) + IntToString(INTERNAL_VER - 3, "ArchiveCache%i.lua")
+			FileSystem::EnsurePathSepAtEnd(FileSystem::GetCacheDir()) + IntToString(LAST_LUA_CACHE_VER - 1, "ArchiveCache%i.lua"),
+			FileSystem::EnsurePathSepAtEnd(FileSystem::GetCacheDir()) + IntToString(LAST_LUA_CACHE_VER - 2, "ArchiveCache%i.lua"),
+			FileSystem::EnsurePathSepAtEnd(FileSystem::GetCacheDir()) + IntToString(LAST_LUA_CACHE_VER - 3, "ArchiveCache%i.lua")
 		};
 
 		for (const auto& prevCacheFile : prevCacheFiles) {
-			if (!ReadCacheData(prevCacheFile, true))
+			if (!ReadLuaCacheData(prevCacheFile))
 				continue;
 
 			// nullify hashes, filesInfo
@@ -692,13 +749,52 @@ CArchiveScanner::BrokenArchive& CArchiveScanner::GetAddBrokenArchive(const std::
 
 void CArchiveScanner::ScanArchive(const std::string& fullName, bool doChecksum)
 {
-	uint32_t modifiedTime = 0;
+	ArchiveScanData scanData;
+	scanData.fullName = fullName;
+	scanData.modified = GetArchiveModificationTime(fullName);
 
 	assert(!isInScan);
 
-	if (CheckCachedData(fullName, modifiedTime, doChecksum))
+	if (CheckCachedData(fullName, scanData.modified, doChecksum))
 		return;
 
+	ReadArchiveScanData(scanData);
+	AddScannedArchive(scanData, doChecksum);
+}
+
+void CArchiveScanner::ReadArchiveScanData(ArchiveScanData& scanData)
+{
+	try {
+		scanData.archive.reset(archiveLoader.OpenArchive(scanData.fullName));
+
+		if (scanData.archive == nullptr || !scanData.archive->IsOpen())
+			return;
+
+		// mapinfo takes precedence, see AddScannedArchive
+		for (const char* luaInfoFile: {"mapinfo.lua", "modinfo.lua"}) {
+			if (!scanData.archive->FileExists(luaInfoFile))
+				continue;
+
+			if (!scanData.archive->GetFile(luaInfoFile, scanData.luaInfoData))
+				scanData.luaInfoData.clear();
+
+			scanData.luaInfoFile = luaInfoFile;
+			break;
+		}
+	} catch (...) {
+		// rethrown by AddScannedArchive on the scanning thread
+		scanData.exception = std::current_exception();
+	}
+}
+
+void CArchiveScanner::AddScannedArchive(ArchiveScanData& scanData, bool doChecksum)
+{
+	if (scanData.exception != nullptr)
+		std::rethrow_exception(scanData.exception);
+
+	const std::string& fullName = scanData.fullName;
+	const uint32_t modifiedTime = scanData.modified;
+
 	isDirty = true;
 	isInScan = true;
 
@@ -715,7 +811,7 @@ void CArchiveScanner::ScanArchive(const std::string& fullName, bool doChecksum)
 	const std::string& fpath = FileSystem::GetDirectory(fullName);
 	const std::string& lcfn  = StringToLower(fname);
 
-	std::unique_ptr<IArchive> ar(archiveLoader.OpenArchive(fullName));
+	std::unique_ptr<IArchive> ar(std::move(scanData.archive));
 
 	if (ar == nullptr || !ar->IsOpen()) {
 		LOG_L(L_WARNING, "[AS::%s] unable to open archive \"%s\"", __func__, fullName.c_str());
@@ -738,8 +834,8 @@ void CArchiveScanner::ScanArchive(const std::string& fullName, bool doChecksum)
 	std::string miMapFile; // value for the 'mapfile' key parsed from mapinfo
 	std::string luaInfoFile;
 
-	const bool hasModInfo = ar->FileExists("modinfo.lua");
-	const bool hasMapInfo = ar->FileExists("mapinfo.lua");
+	const bool hasMapInfo = (scanData.luaInfoFile == "mapinfo.lua");
+	const bool hasModInfo = (scanData.luaInfoFile == "modinfo.lua");
 
 
 	ArchiveInfo ai;
@@ -747,7 +843,7 @@ void CArchiveScanner::ScanArchive(const std::string& fullName, bool doChecksum)
 
 	// execute the respective .lua, otherwise assume this archive is a map
 	if (hasMapInfo) {
-		ScanArchiveLua(ar.get(), luaInfoFile = "mapinfo.lua", ai, error);
+		ScanArchiveLua(ar.get(), luaInfoFile = "mapinfo.lua", scanData.luaInfoData, ai, error);
 
 		if ((miMapFile = ad.GetMapFile()).empty()) {
 			if (ar->GetType() != ARCHIVE_TYPE_SDV)
@@ -756,7 +852,7 @@ void CArchiveScanner::ScanArchive(const std::string& fullName, bool doChecksum)
 			arMapFile = SearchMapFile(ar.get(), error);
 		}
 	} else if (hasModInfo) {
-		ScanArchiveLua(ar.get(), luaInfoFile = "modinfo.lua", ai, error);
+		ScanArchiveLua(ar.get(), luaInfoFile = "modinfo.lua", scanData.luaInfoData, ai, error);
 	} else {
 		arMapFile = SearchMapFile(ar.get(), error);
 	}
@@ -824,17 +920,22 @@ void CArchiveScanner::ScanArchive(const std::string& fullName, bool doChecksum)
 }
 
 
-bool CArchiveScanner::CheckCachedData(const std::string& fullName, uint32_t& modified, bool doChecksum)
+uint32_t CArchiveScanner::GetArchiveModificationTime(const std::string& fullName)
 {
 	// virtual archives do not exist on disk, and thus do not have a modification time
 	// they should still be scanned as normal archives so we only skip the cache-check
 	if (FileSystem::GetExtension(fullName) == "sva")
-		return false;
+		return 0;
 
-	// if stat fails, assume the archive is not broken nor cached
-	// it would also fail in the case of virtual archives and cause
+	// stat would also fail in the case of virtual archives and cause
 	// warning-spam which is suppressed by the extension-test above
-	if ((modified = FileSystemAbstraction::GetFileModificationTime(fullName)) == 0)
+	return (FileSystemAbstraction::GetFileModificationTime(fullName));
+}
+
+bool CArchiveScanner::CheckCachedData(const std::string& fullName, uint32_t modified, bool doChecksum)
+{
+	// if stat failed, assume the archive is not broken nor cached
+	if (modified == 0)
 		return false;
 
 	const std::string& fileName      = FileSystem::GetFilename(fullName);
@@ -916,11 +1017,9 @@ bool CArchiveScanner::CheckCachedData(const std::string& fullName, uint32_t& mod
 }
 
 
-bool CArchiveScanner::ScanArchiveLua(IArchive* ar, const std::string& fileName, ArchiveInfo& ai, std::string& err)
+bool CArchiveScanner::ScanArchiveLua(IArchive* ar, const std::string& fileName, const std::vector<std::uint8_t>& buf, ArchiveInfo& ai, std::string& err)
 {
-	std::vector<std::uint8_t> buf;
-
-	if (!ar->GetFile(fileName, buf) || buf.empty()) {
+	if (buf.empty()) {
 		err = "Error reading " + fileName;
 
 		if (ar->GetArchiveFile().find(".sdp") != std::string::npos)
@@ -986,14 +1085,33 @@ bool CArchiveScanner::GetArchiveChecksum(const std::string& archiveName, Archive
 	// load ignore list
 	std::unique_ptr<IFileFilter> ignore(CreateIgnoreFilter(ar.get()));
 
+	// pool files are named by the md5 of their content, so one that was hashed
+	// for any version of any pool archive needs neither a stat nor a rehash
+	const auto GetCachedPoolFileInfo = [&](uint32_t fid) -> const FileInfo* {
+		if (!sdpArchive)
+			return nullptr;
+
+		const auto it = poolFilesInfo.find(static_cast<const CPoolArchive*>(ar.get())->PoolFileName(fid));
+
+		if (it == poolFilesInfo.end() || it->second.checksum == sha512::NULL_RAW_DIGEST || it->second.size != ar->FileSize(fid))
+			return nullptr;
+
+		return &it->second;
+	};
+
 	// warm up. For some archive types ar->FileInfo(fid) is a mutable operation loading important IArchive::SFileInfo fields
 	std::atomic_uint32_t numFiles = {0};
-	for_mt(0, ar->NumFiles(), [&numFiles, &ar, &ignore](int fid) {
+	for_mt(0, ar->NumFiles(), [&numFiles, &ar, &ignore, &GetCachedPoolFileInfo](int fid) {
 		const auto fn = ar->FileName(fid);
 
 		if (ignore->Match(fn))
 			return;
 
+		if (GetCachedPoolFileInfo(fid) != nullptr) {
+			++numFiles;
+			return;
+		}
+
 		const auto volatile fi = ar->FileInfo(fid); // volatile to force execution
 		++numFiles;
 	});
@@ -1005,10 +1123,16 @@ bool CArchiveScanner::GetArchiveChecksum(const std::string& archiveName, Archive
 	archiveInfo.filesInfo.reserve(numFiles.load());
 
 	for (uint32_t fid = 0; fid < ar->NumFiles(); ++fid) {
-		auto fi = ar->FileInfo(fid);
+		if (ignore->Match(ar->FileName(fid)))
+			continue;
 
-		if (ignore->Match(fi.fileName))
+		if (const FileInfo* poolFileInfo = GetCachedPoolFileInfo(fid); poolFileInfo != nullptr) {
+			archiveInfo.filesInfo[ar->FileName(fid)] = *poolFileInfo;
+			fileNames.emplace_back(ar->FileName(fid));
 			continue;
+		}
+
+		auto fi = ar->FileInfo(fid);
 
 		// special treatment of SDP archives: insert information from poolFilesInfo
 		if (sdpArchive) {
@@ -1085,13 +1209,15 @@ bool CArchiveScanner::GetArchiveChecksum(const std::string& archiveName, Archive
 	if (sdpArchive) {
 		// makes no sense to store archiveInfo.filesInfo in the SDP entry
 		// so copy to poolFilesInfo and empty archiveInfo.filesInfo
+		const CPoolArchive* poolArchive = static_cast<const CPoolArchive*>(ar.get());
+
 		for (uint32_t fid = 0; fid < ar->NumFiles(); ++fid) {
-			const auto fi = ar->FileInfo(fid);
+			const std::string& fileName = ar->FileName(fid);
 
-			if (ignore->Match(fi.fileName))
+			if (ignore->Match(fileName))
 				continue;
 
-			poolFilesInfo[fi.specialFileName] = archiveInfo.filesInfo[fi.fileName]; // populate the updated information back to poolFilesInfo
+			poolFilesInfo[poolArchive->PoolFileName(fid)] = archiveInfo.filesInfo[fileName]; // populate the updated information back to poolFilesInfo
 		}
 		archiveInfo.filesInfo.clear();
 	}
@@ -1124,7 +1250,7 @@ bool CArchiveScanner::GetArchiveChecksum(const std::string& archiveName, Archive
 }
 
 
-bool CArchiveScanner::ReadCacheData(const std::string& filename, bool loadOldVersion)
+bool CArchiveScanner::ReadLuaCacheData(const std::string& filename)
 {
 	std::lock_guard<decltype(scannerMutex)> lck(scannerMutex);
 	if (!FileSystem::FileExists(filename)) {
@@ -1140,11 +1266,6 @@ bool CArchiveScanner::ReadCacheData(const std::string& filename, bool loadOldVer
 
 	const LuaTable archiveCacheTbl = p.GetRoot();
 
-	// Do not load old version caches
-	const int ver = archiveCacheTbl.GetInt("internalver", (INTERNAL_VER + 1));
-	if (ver != INTERNAL_VER && !loadOldVersion)
-		return false;
-
 	static const auto ReadFileInfoMap = [](const LuaTable& filesInfoTbl, spring::unordered_map<std::string, FileInfo>& filesInfoMap) {
 		for (int j = 1; filesInfoTbl.KeyExists(j); ++j) {
 			const LuaTable fileInfoTbl = filesInfoTbl.SubTable(j);
@@ -1219,16 +1340,181 @@ bool CArchiveScanner::ReadCacheData(const std::string& filename, bool loadOldVer
 	return true;
 }
 
-static inline void SafeStr(FILE* out, const char* prefix, const std::string& str)
+
+static constexpr char CACHE_MAGIC[4] = {'S', 'A', 'S', 'C'};
+
+/*
+ * ArchiveCache%i.bin is a flat dump of the scanner's tables in native byte
+ * order: magic, version, then archives, broken archives and pool files as
+ * count-prefixed lists. Strings are stored as a 32-bit length plus bytes.
+ */
+struct CacheWriter {
+	template<typename T> void Put(const T& value) {
+		static_assert(std::is_trivially_copyable_v<T>);
+		const std::uint8_t* bytes = reinterpret_cast<const std::uint8_t*>(&value);
+		data.insert(data.end(), bytes, bytes + sizeof(T));
+	}
+	void PutString(const std::string& str) {
+		Put(static_cast<uint32_t>(str.size()));
+		data.insert(data.end(), str.begin(), str.end());
+	}
+
+	std::vector<std::uint8_t> data;
+};
+
+struct CacheReader {
+	template<typename T> T Get() {
+		static_assert(std::is_trivially_copyable_v<T>);
+		T value{};
+
+		if ((valid &= (size_t(end - pos) >= sizeof(T))))
+			std::memcpy(&value, pos, sizeof(T));
+
+		pos += (sizeof(T) * valid);
+		return value;
+	}
+	std::string GetString() {
+		const uint32_t size = Get<uint32_t>();
+
+		if (!(valid &= (size_t(end - pos) >= size)))
+			return "";
+
+		pos += size;
+		return {reinterpret_cast<const char*>(pos - size), size};
+	}
+
+	const std::uint8_t* pos = nullptr;
+	const std::uint8_t* end = nullptr;
+
+	bool valid = true;
+};
+
+
+bool CArchiveScanner::ReadCacheData(const std::string& filename)
 {
-	if (str.empty())
-		return;
+	std::lock_guard<decltype(scannerMutex)> lck(scannerMutex);
+	if (!FileSystem::FileExists(filename)) {
+		LOG_L(L_INFO, "[AS::%s] ArchiveCache %s doesn't exist", __func__, filename.c_str());
+		return false;
+	}
 
-	if ((str.find_first_of("\\\"") != std::string::npos) || (str.find_first_of('\n') != std::string::npos )) {
-		fprintf(out, "%s[[%s]],\n", prefix, str.c_str());
-	} else {
-		fprintf(out, "%s\"%s\",\n", prefix, str.c_str());
+	std::vector<std::uint8_t> buffer;
+
+	if (FILE* in = fopen(filename.c_str(), "rb"); in != nullptr) {
+		fseek(in, 0, SEEK_END);
+		buffer.resize(std::max(ftell(in), 0L));
+		fseek(in, 0, SEEK_SET);
+
+		if (!buffer.empty() && fread(buffer.data(), buffer.size(), 1, in) != 1)
+			buffer.clear();
+
+		fclose(in);
+	}
+
+	CacheReader cr = {buffer.data(), buffer.data() + buffer.size()};
+
+	const auto magic = cr.Get<std::array<char, sizeof(CACHE_MAGIC)>>();
+	const auto ver = cr.Get<int32_t>();
+
+	// Do not load old version caches
+	if (!cr.valid || std::memcmp(magic.data(), CACHE_MAGIC, sizeof(CACHE_MAGIC)) != 0 || ver != INTERNAL_VER) {
+		LOG_L(L_ERROR, "[AS::%s] failed to parse ArchiveCache %s", __func__, filename.c_str());
+		return false;
 	}
+
+	const auto ReadFileInfoMap = [&cr](spring::unordered_map<std::string, FileInfo>& filesInfoMap) {
+		for (uint32_t j = cr.Get<uint32_t>(); j > 0 && cr.valid; j--) {
+			FileInfo& val = filesInfoMap[cr.GetString()];
+
+			val.size = cr.Get<decltype(val.size)>();
+			val.modTime = cr.Get<decltype(val.modTime)>();
+			val.checksum = cr.Get<sha512::raw_digest>();
+		}
+	};
+
+	// parsed completely before anything is added, a truncated cache counts as missing
+	std::vector<ArchiveInfo> cachedArchiveInfos;
+	std::vector<BrokenArchive> cachedBrokenArchives;
+	spring::unordered_map<std::string, FileInfo> cachedPoolFilesInfo;
+
+	try {
+		for (uint32_t i = cr.Get<uint32_t>(); i > 0 && cr.valid; i--) {
+			ArchiveInfo& ai = cachedArchiveInfos.emplace_back();
+
+			ai.origName = cr.GetString();
+			ai.path = cr.GetString();
+			ai.archiveDataPath = cr.GetString();
+			ai.modified = cr.Get<decltype(ai.modified)>();
+			ai.modifiedArchiveData = cr.Get<decltype(ai.modifiedArchiveData)>();
+			ai.checksum = cr.Get<sha512::raw_digest>();
+
+			ReadFileInfoMap(ai.filesInfo);
+
+			for (uint32_t j = cr.Get<uint32_t>(); j > 0 && cr.valid; j--) {
+				const std::string key = cr.GetString();
+
+				switch (cr.Get<uint8_t>()) {
+					case INFO_VALUE_TYPE_STRING : { ai.archiveData.SetInfoItemValueString (key, cr.GetString()        ); } break;
+					case INFO_VALUE_TYPE_INTEGER: { ai.archiveData.SetInfoItemValueInteger(key, cr.Get<int32_t>()    ); } break;
+					case INFO_VALUE_TYPE_FLOAT  : { ai.archiveData.SetInfoItemValueFloat  (key, cr.Get<float>()      ); } break;
+					case INFO_VALUE_TYPE_BOOL   : { ai.archiveData.SetInfoItemValueBool   (key, cr.Get<uint8_t>() != 0); } break;
+					default                     : { cr.valid = false;                                                  } break;
+				}
+			}
+
+			for (uint32_t j = cr.Get<uint32_t>(); j > 0 && cr.valid; j--) {
+				ai.archiveData.GetDependencies().push_back(cr.GetString());
+			}
+		}
+
+		for (uint32_t i = cr.Get<uint32_t>(); i > 0 && cr.valid; i--) {
+			BrokenArchive& ba = cachedBrokenArchives.emplace_back();
+
+			ba.name = cr.GetString();
+			ba.path = cr.GetString();
+			ba.problem = cr.GetString();
+			ba.modified = cr.Get<decltype(ba.modified)>();
+		}
+
+		ReadFileInfoMap(cachedPoolFilesInfo);
+	} catch (const content_error&) {
+		// reserved info-key, can only come from a damaged file
+		cr.valid = false;
+	}
+
+	if (!cr.valid || cr.pos != cr.end) {
+		LOG_L(L_ERROR, "[AS::%s] failed to parse ArchiveCache %s", __func__, filename.c_str());
+		return false;
+	}
+
+	for (ArchiveInfo& cai: cachedArchiveInfos) {
+		ArchiveInfo& ai = GetAddArchiveInfo(StringToLower(cai.origName));
+
+		ai = std::move(cai);
+		ai.updated = false;
+		ai.hashed = (ai.checksum != sha512::NULL_RAW_DIGEST);
+
+		if (ai.archiveData.IsMap()) {
+			AddDependency(ai.archiveData.GetDependencies(), GetMapHelperContentName());
+		} else if (ai.archiveData.IsGame()) {
+			AddDependency(ai.archiveData.GetDependencies(), GetSpringBaseContentName());
+		}
+	}
+
+	for (BrokenArchive& cba: cachedBrokenArchives) {
+		BrokenArchive& ba = GetAddBrokenArchive(cba.name);
+
+		ba = std::move(cba);
+		ba.updated = false;
+	}
+
+	for (auto& [poolFileName, poolFileInfo]: cachedPoolFilesInfo) {
+		poolFilesInfo[poolFileName] = poolFileInfo;
+	}
+
+	isDirty = false;
+
+	return true;
 }
 
 void FilterDep(std::vector<std::string>& deps, const std::string& exclude)
@@ -1319,109 +1605,106 @@ void CArchiveScanner::WriteCacheData(const std::string& filename)
 		}
 	}
 
-	FILE* out = fopen(filename.c_str(), "wt");
-	if (out == nullptr) {
-		LOG_L(L_ERROR, "[AS::%s] failed to write to \"%s\"!", __func__, filename.c_str());
-		return;
-	}
+	CacheWriter cw;
+
+	const auto WriteFileInfoMap = [&cw](const spring::unordered_map<std::string, FileInfo>& filesInfoMap) {
+		cw.Put(static_cast<uint32_t>(filesInfoMap.size()));
 
-	auto WriteFileInfoMapBody = [out](const spring::unordered_map<std::string, FileInfo>& filesInfoMap, size_t numTabs) {
-		const auto tabs = std::string(numTabs, '\t');
 		for (const auto& [fn, fi] : filesInfoMap) {
-			std::string tbl = fmt::format("{}{{ fileName = \"{}\", size = \"{}\", modTime = \"{}\", checksum = \"{}\" }},\n", tabs, fn, fi.size, fi.modTime, sha512::dump_digest(fi.checksum));
-			fputs(tbl.c_str(), out);
+			cw.PutString(fn);
+			cw.Put(fi.size);
+			cw.Put(fi.modTime);
+			cw.Put(fi.checksum);
 		}
 	};
 
-
-	fprintf(out, "local archiveCache = {\n\n");
-	fprintf(out, "\tinternalver = %i,\n\n", INTERNAL_VER);
-	fprintf(out, "\tarchives = {  -- count = %u\n", uint32_t(archiveInfos.size()));
+	cw.Put(CACHE_MAGIC);
+	cw.Put(static_cast<int32_t>(INTERNAL_VER));
+	cw.Put(static_cast<uint32_t>(archiveInfos.size()));
 
 	for (const ArchiveInfo& arcInfo: archiveInfos) {
-		sha512::raw_digest rawDigest;
-		sha512::hex_digest hexDigest;
-
-		rawDigest = arcInfo.checksum;
-		sha512::dump_digest(rawDigest, hexDigest);
-
-		fprintf(out, "\t\t{\n");
-		SafeStr(out, "\t\t\tname = ",              arcInfo.origName);
-		SafeStr(out, "\t\t\tpath = ",              arcInfo.path);
-		fprintf(out, "\t\t\tmodified = \"%u\",\n", arcInfo.modified);
-		fprintf(out, "\t\t\tchecksum = \"%s\",\n", hexDigest.data());
-		SafeStr(out, "\t\t\treplaced = ",          arcInfo.replaced);
-
-		if (!arcInfo.archiveDataPath.empty()) {
-			SafeStr(out, "\t\t\tarchiveDataPath = ",              arcInfo.archiveDataPath);
-			fprintf(out, "\t\t\tmodifiedArchiveData = \"%u\",\n", arcInfo.modifiedArchiveData);
-		}
+		cw.PutString(arcInfo.origName);
+		cw.PutString(arcInfo.path);
+		cw.PutString(arcInfo.archiveDataPath);
+		cw.Put(arcInfo.modified);
+		cw.Put(arcInfo.modifiedArchiveData);
+		cw.Put(arcInfo.checksum);
 
-		if (!arcInfo.filesInfo.empty()) {
-			fprintf(out, "\t\t\tfilesInfo = {\n");
-			WriteFileInfoMapBody(arcInfo.filesInfo, 4);
-			fprintf(out, "\t\t\t},\n");
-		}
+		WriteFileInfoMap(arcInfo.filesInfo);
 
 		// mod info?
 		const ArchiveData& archData = arcInfo.archiveData;
-		if (!archData.GetName().empty()) {
-			fprintf(out, "\t\t\tarchivedata = {\n");
-
-			for (const auto& ii: archData.GetInfo()) {
-				if (ii.second.valueType == INFO_VALUE_TYPE_STRING) {
-					SafeStr(out, std::string("\t\t\t\t" + ii.first + " = ").c_str(), ii.second.valueTypeString);
-				} else {
-					fprintf(out, "\t\t\t\t%s = %s,\n", ii.first.c_str(), ii.second.GetValueAsString(false).c_str());
-				}
-			}
 
-			std::vector<std::string> deps = archData.GetDependencies();
-			if (archData.IsMap()) {
-				FilterDep(deps, GetMapHelperContentName());
-			} else if (archData.IsGame()) {
-				FilterDep(deps, GetSpringBaseContentName());
-			}
+		if (archData.GetName().empty()) {
+			cw.Put(uint32_t(0));
+			cw.Put(uint32_t(0));
+			continue;
+		}
 
-			if (!deps.empty()) {
-				fprintf(out, "\t\t\t\tdepend = {\n");
-				for (const auto& dep: deps) {
-					SafeStr(out, "\t\t\t\t\t", dep);
-				}
-				fprintf(out, "\t\t\t\t},\n");
+		cw.Put(static_cast<uint32_t>(archData.GetInfo().size()));
+
+		for (const auto& ii: archData.GetInfo()) {
+			cw.PutString(ii.second.key);
+			cw.Put(static_cast<uint8_t>(ii.second.valueType));
+
+			switch (ii.second.valueType) {
+				case INFO_VALUE_TYPE_STRING : { cw.PutString(ii.second.valueTypeString);                  } break;
+				case INFO_VALUE_TYPE_INTEGER: { cw.Put(static_cast<int32_t>(ii.second.value.typeInteger)); } break;
+				case INFO_VALUE_TYPE_FLOAT  : { cw.Put(ii.second.value.typeFloat);                        } break;
+				case INFO_VALUE_TYPE_BOOL   : { cw.Put(static_cast<uint8_t>(ii.second.value.typeBool));   } break;
 			}
-			fprintf(out, "\t\t\t},\n");
 		}
 
-		fprintf(out, "\t\t},\n");
+		std::vector<std::string> deps = archData.GetDependencies();
+		if (archData.IsMap()) {
+			FilterDep(deps, GetMapHelperContentName());
+		} else if (archData.IsGame()) {
+			FilterDep(deps, GetSpringBaseContentName());
+		}
+
+		cw.Put(static_cast<uint32_t>(deps.size()));
+
+		for (const auto& dep: deps) {
+			cw.PutString(dep);
+		}
 	}
 
-	fprintf(out, "\t},\n\n"); // close 'archives'
-	fprintf(out, "\tbrokenArchives = {  -- count = %u\n", uint32_t(brokenArchives.size()));
+	cw.Put(static_cast<uint32_t>(brokenArchives.size()));
 
 	for (const BrokenArchive& ba: brokenArchives) {
-		fprintf(out, "\t\t{\n");
-		SafeStr(out, "\t\t\tname = ", ba.name);
-		SafeStr(out, "\t\t\tpath = ", ba.path);
-		fprintf(out, "\t\t\tmodified = \"%u\",\n", ba.modified);
-		SafeStr(out, "\t\t\tproblem = ", ba.problem);
-		fprintf(out, "\t\t},\n");
+		cw.PutString(ba.name);
+		cw.PutString(ba.path);
+		cw.PutString(ba.problem);
+		cw.Put(ba.modified);
 	}
 
-	fprintf(out, "\t},\n"); // close 'brokenArchives'
-
 	// Information about files in the pool
-	if (!poolFilesInfo.empty()) {
-		fprintf(out, "\tpoolFiles = {  -- count = %u\n", uint32_t(poolFilesInfo.size()));
-		WriteFileInfoMapBody(poolFilesInfo, 2);
-		fprintf(out, "\t},\n"); // close 'poolFiles'
+	WriteFileInfoMap(poolFilesInfo);
+
+	// replace the old cache only once the new one is complete, another
+	// instance (e.g. unitsync in a lobby) might be reading it right now
+	const std::string tmpFilename = filename + ".tmp";
+
+	FILE* out = fopen(tmpFilename.c_str(), "wb");
+	if (out == nullptr) {
+		LOG_L(L_ERROR, "[AS::%s] failed to write to \"%s\"!", __func__, tmpFilename.c_str());
+		return;
 	}
 
-	fprintf(out, "}\n\n"); // close 'archiveCache'
-	fprintf(out, "return archiveCache\n");
+	bool written = (fwrite(cw.data.data(), cw.data.size(), 1, out) == 1);
+	written = (fclose(out) == 0) && written;
+
+	// rename does not replace existing files on Windows
+	if (written && std::rename(tmpFilename.c_str(), filename.c_str()) != 0) {
+		std::remove(filename.c_str());
+		written = (std::rename(tmpFilename.c_str(), filename.c_str()) == 0);
+	}
 
-	if (fclose(out) == EOF)
+	if (!written) {
 		LOG_L(L_ERROR, "[AS::%s] failed to write to \"%s\"!", __func__, filename.c_str());
+		std::remove(tmpFilename.c_str());
+		return;
+	}
 
 	isDirty = false;
 }
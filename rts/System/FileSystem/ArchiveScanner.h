@@ -6,6 +6,8 @@
 #include <cstring> // memset
 #include <string>
 #include <deque>
+#include <exception>
+#include <memory>
 #include <vector>
 #include <atomic>
 
@@ -195,6 +197,17 @@ private:
 		uint32_t modified = 0;
 		bool updated = false;
 	};
+	/// what ScanDirs reads from an uncached archive before adding it
+	struct ArchiveScanData {
+		std::string fullName;
+		std::string luaInfoFile; // {map,mod}info.lua, empty if neither exists
+		std::vector<std::uint8_t> luaInfoData;
+
+		std::unique_ptr<IArchive> archive;
+		std::exception_ptr exception;
+
+		uint32_t modified = 0;
+	};
 
 private:
 	void ReadCache();
@@ -205,8 +218,15 @@ private:
 	void ScanDirs(const std::vector<std::string>& dirs);
 	void ScanDir(const std::string& curPath, std::deque<std::string>& foundArchives);
 
+	/**
+	 * open the archive and read its info file; touches no scanner
+	 * state, so ScanDirs can run it on many archives in parallel
+	 */
+	static void ReadArchiveScanData(ArchiveScanData& scanData);
+	void AddScannedArchive(ArchiveScanData& scanData, bool doChecksum);
+
 	/// scan mapinfo / modinfo lua files
-	bool ScanArchiveLua(IArchive* ar, const std::string& fileName, ArchiveInfo& ai, std::string& err);
+	bool ScanArchiveLua(IArchive* ar, const std::string& fileName, const std::vector<std::uint8_t>& buf, ArchiveInfo& ai, std::string& err);
 
 	/**
 	 * scan archive for map file
@@ -215,7 +235,9 @@ private:
 	std::string SearchMapFile(const IArchive* ar, std::string& error);
 
 
-	bool ReadCacheData(const std::string& filename, bool loadOldVersion = false);
+	bool ReadCacheData(const std::string& filename);
+	/// reads the ArchiveCache.lua written by older versions
+	bool ReadLuaCacheData(const std::string& filename);
 	void WriteCacheData(const std::string& filename);
 
 	IFileFilter* CreateIgnoreFilter(IArchive* ar);
@@ -226,7 +248,9 @@ private:
 	 */
 	bool GetArchiveChecksum(const std::string& filename, ArchiveInfo& archiveInfo);
 
-	bool CheckCachedData(const std::string& fullName, unsigned& modified, bool doChecksum);
+	/// 0 for virtual archives or if the file can not be stat'ed
+	static uint32_t GetArchiveModificationTime(const std::string& fullName);
+	bool CheckCachedData(const std::string& fullName, uint32_t modified, bool doChecksum);
 
 	/**
 	 * Returns a value > 0 if the file is rated as a meta-file.
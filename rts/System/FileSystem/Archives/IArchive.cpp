@@ -37,6 +37,11 @@ bool IArchive::GetFile(const std::string& name, std::vector<std::uint8_t>& buffe
 
 bool IArchive::CalcHash(uint32_t fid, sha512::raw_digest& hash, std::vector<std::uint8_t>& fb)
 {
+	if (const std::span<const std::uint8_t> view = GetFileView(fid); !view.empty()) {
+		sha512::calc_digest(view.data(), view.size(), hash.data());
+		return true;
+	}
+
 	// NOTE: should be possible to avoid a re-read for buffered archives
 	if (!GetFile(fid, fb))
 		return false;
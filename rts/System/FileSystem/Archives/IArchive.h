@@ -8,6 +8,7 @@
 #include <cinttypes>
 #include <memory>
 #include <semaphore>
+#include <span>
 
 #include "ArchiveTypes.h"
 #include "System/Sync/SHA512.hpp"
@@ -102,6 +103,14 @@ public:
 		return size;
 	}
 
+	/**
+	 * Returns the content of a file without copying it, if the archive
+	 * holds it uncompressed in memory (e.g. stored entries of a mapped zip).
+	 * The view stays valid for the lifetime of the archive.
+	 * @return empty span if not available, use GetFile instead
+	 */
+	virtual std::span<const std::uint8_t> GetFileView(uint32_t fid) { return {}; }
+
 	/**
 	 * Fetches the name of a file by its ID.
 	 */
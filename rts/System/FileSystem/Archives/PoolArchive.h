@@ -88,6 +88,10 @@ public:
 	int32_t FileSize(uint32_t fid) const override;
 	SFileInfo FileInfo(uint32_t fid) const override;
 	bool CalcHash(uint32_t fid, sha512::raw_digest& hash, std::vector<std::uint8_t>& fb) override;
+
+	/// name of the pool file holding the content of <fid>, without stat'ing it like FileInfo
+	std::string PoolFileName(uint32_t fid) const { assert(IsFileId(fid)); return GetPoolFileName(files[fid].md5sum); }
+
 	static std::string GetPoolRootDirectory(const std::string& sdpName);
 	static std::string GetPoolFileName(const std::array<uint8_t, 16>& md5Sum);
 	static std::string GetPoolFilePath(const std::string& poolRootDir, const std::string& poolFile);
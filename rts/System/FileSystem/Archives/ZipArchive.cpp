@@ -5,7 +5,11 @@
 #include <algorithm>
 #include <stdexcept>
 #include <cassert>
+#include <cstring>
 
+#include <zlib.h>
+
+#include "System/FileSystem/FileSystemAbstraction.h"
 #include "System/StringUtil.h"
 #include "System/Log/ILog.h"
 #include "System/Threading/ThreadPool.h"
@@ -16,6 +20,10 @@ IArchive* CZipArchiveFactory::DoCreateArchive(const std::string& filePath) const
 	return new CZipArchive(filePath);
 }
 
+
+static inline uint32_t ReadLE16(const std::uint8_t* p) { return (p[0] | (p[1] << 8)); }
+static inline uint32_t ReadLE32(const std::uint8_t* p) { return (p[0] | (p[1] << 8) | (p[2] << 16) | (uint32_t(p[3]) << 24)); }
+
 CZipArchive::CZipArchive(const std::string& archiveName)
 	: CBufferedArchive(archiveName)
 {
@@ -40,10 +48,10 @@ CZipArchive::CZipArchive(const std::string& archiveName)
 	fileEntries.reserve(globalZipInfo.number_entry);
 
 	for (int ret = unzGoToFirstFile(zip); ret == UNZ_OK; ret = unzGoToNextFile(zip)) {
-		unz_file_info info;
+		unz_file_info64 info;
 		char fName[512];
 
-		unzGetCurrentFileInfo(zip, &info, fName, sizeof(fName), nullptr, 0, nullptr, 0);
+		unzGetCurrentFileInfo64(zip, &info, fName, sizeof(fName), nullptr, 0, nullptr, 0);
 
 		if (fName[0] == 0)
 			continue;
@@ -62,13 +70,17 @@ CZipArchive::CZipArchive(const std::string& archiveName)
 			info.uncompressed_size, //size
 			fName, //origName
 			info.crc, //crc
-			static_cast<uint32_t>(CTimeUtil::DosTimeToTime64(info.dosDate)) //modTime
+			static_cast<uint32_t>(CTimeUtil::DosTimeToTime64(info.dosDate)), //modTime
+			static_cast<uint32_t>(info.compressed_size), //compressedSize
+			static_cast<uint16_t>(info.compression_method), //method
+			static_cast<uint16_t>(info.flag) //flags
 		);
 
 		lcNameIndex.emplace(StringToLower(fd.origName), fileEntries.size() - 1);
 	}
 
 	zipPerThread[0] = zip;
+	mapData = FileSystemAbstraction::MapFile(archiveName, mapSize);
 
 	parallelAccessNum = ThreadPool::GetNumThreads(); // will open NumThreads parallel archives, this way GetFile() is no longer needs to be mutex locked
 	sem = std::make_unique<decltype(sem)::element_type>(parallelAccessNum);
@@ -80,6 +92,8 @@ CZipArchive::~CZipArchive()
 {
 	std::scoped_lock lck(archiveLock); //not needed?
 
+	FileSystemAbstraction::UnmapFile(mapData, mapSize);
+
 	for (auto& zip : zipPerThread) {
 		if (zip) {
 			unzClose(zip);
@@ -113,11 +127,117 @@ IArchive::SFileInfo CZipArchive::FileInfo(uint32_t fid) const
 	};
 }
 
+std::span<const std::uint8_t> CZipArchive::GetFileView(uint32_t fid)
+{
+	assert(IsFileId(fid));
+	const FileEntry& fe = fileEntries[fid];
+
+	if (fe.method != 0)
+		return {};
+
+	const std::span<const std::uint8_t> data = GetMappedEntryData(fid);
+
+	// stored entries are their own content, but only hand out verified data
+	if (data.size() != static_cast<size_t>(fe.size) || crc32(0, data.data(), data.size()) != fe.crc)
+		return {};
+
+	return data;
+}
+
+std::span<const std::uint8_t> CZipArchive::GetMappedEntryData(uint32_t fid) const
+{
+	const FileEntry& fe = fileEntries[fid];
+
+	if (mapData == nullptr)
+		return {};
+	// encrypted, or neither stored nor deflated
+	if ((fe.flags & 1) != 0 || (fe.method != 0 && fe.method != Z_DEFLATED))
+		return {};
+
+	// minizip's offsets are relative to the start of the zip, which is not
+	// the start of the file for self-extracting archives; those fail the
+	// signature checks below and are read through minizip instead
+	const size_t cdPos = fe.fp.pos_in_zip_directory;
+
+	if (cdPos + 46 > mapSize || ReadLE32(mapData + cdPos) != 0x02014b50)
+		return {};
+
+	const uint32_t hdrPos = ReadLE32(mapData + cdPos + 42);
+
+	// zip64 entries store their offset in the extra field
+	if (hdrPos == 0xFFFFFFFF || size_t(hdrPos) + 30 > mapSize || ReadLE32(mapData + hdrPos) != 0x04034b50)
+		return {};
+
+	const size_t dataPos = size_t(hdrPos) + 30 + ReadLE16(mapData + hdrPos + 26) + ReadLE16(mapData + hdrPos + 28);
+
+	if (dataPos + fe.compressedSize > mapSize)
+		return {};
+
+	return {mapData + dataPos, fe.compressedSize};
+}
+
+int CZipArchive::ReadMappedEntry(uint32_t fid, std::span<const std::uint8_t> data, std::vector<std::uint8_t>& buffer) const
+{
+	const FileEntry& fe = fileEntries[fid];
+
+	buffer.clear();
+	buffer.resize(fe.size);
+
+	// zlib refuses a null output buffer even when there is nothing to inflate
+	if (buffer.empty())
+		return ((fe.crc == 0)? 1: 0);
+
+	if (fe.method == 0) {
+		if (data.size() != buffer.size())
+			return -1;
+
+		std::copy(data.begin(), data.end(), buffer.begin());
+	} else {
+		z_stream zs;
+		memset(&zs, 0, sizeof(zs));
+
+		// raw deflate stream, no zlib header
+		if (inflateInit2(&zs, -MAX_WBITS) != Z_OK)
+			return -1;
+
+		zs.next_in = const_cast<Bytef*>(data.data());
+		zs.avail_in = data.size();
+		zs.next_out = buffer.data();
+		zs.avail_out = buffer.size();
+
+		const int ret = inflate(&zs, Z_FINISH);
+		const uLong len = zs.total_out;
+
+		inflateEnd(&zs);
+
+		if (ret != Z_STREAM_END || len != buffer.size())
+			return -1;
+	}
+
+	if (crc32(0, buffer.data(), buffer.size()) != fe.crc)
+		return 0;
+
+	return 1;
+}
+
+
 // To simplify things, files are always read completely into memory from
 // the zip-file, since zlib does not provide any way of reading more
 // than one file at a time
 int CZipArchive::GetFileImpl(uint32_t fid, std::vector<std::uint8_t>& buffer)
 {
+	assert(IsFileId(fid));
+
+	// common case, needs no handle and can run on any number of threads
+	if (const std::span<const std::uint8_t> data = GetMappedEntryData(fid); data.data() != nullptr) {
+		const int ret = ReadMappedEntry(fid, data, buffer);
+
+		if (ret != 1)
+			buffer.clear();
+
+		return ret;
+	}
+
 	// this below will lead to expensive on-demand creation of thisThreadZip
 	// in case actual number of parallel threads entering this function is
 	// less than ThreadPool::GetThreadNum(). E.g. when counting_semaphore
@@ -136,8 +256,6 @@ int CZipArchive::GetFileImpl(uint32_t fid, std::vector<std::uint8_t>& buffer)
 	if (thisThreadZip == nullptr)
 		return -4;
 
-	assert(IsFileId(fid));
-
 	unzGoToFilePos(thisThreadZip, &fileEntries[fid].fp);
 
 	unz_file_info fi;
@@ -8,6 +8,7 @@
 #include "minizip/unzip.h"
 #include "System/Threading/AtomicFirstIndex.hpp"
 
+#include <span>
 #include <string>
 #include <vector>
 
@@ -26,6 +27,9 @@ private:
 
 /**
  * A zip compressed, single-file archive.
+ * The archive is memory-mapped; stored and deflated entries are read from
+ * the mapping without locking, anything else through per-thread minizip
+ * handles.
  */
 class CZipArchive : public CBufferedArchive
 {
@@ -42,6 +46,8 @@ public:
 	int32_t FileSize(uint32_t fid) const override;
 	SFileInfo FileInfo(uint32_t fid) const override;
 
+	std::span<const std::uint8_t> GetFileView(uint32_t fid) override;
+
 	#if 0
 	uint32_t GetCrc32(uint32_t fid) {
 		assert(IsFileId(fid));
@@ -50,6 +56,10 @@ public:
 	#endif
 protected:
 	int GetFileImpl(uint32_t fid, std::vector<std::uint8_t>& buffer) override;
+private:
+	/// the (still compressed) data of an entry inside the mapping, if it can be read from there
+	std::span<const std::uint8_t> GetMappedEntryData(uint32_t fid) const;
+	int ReadMappedEntry(uint32_t fid, std::span<const std::uint8_t> data, std::vector<std::uint8_t>& buffer) const;
 private:
 	static constexpr int MAX_THREADS = 32;
 
@@ -63,10 +73,16 @@ private:
 		std::string origName;
 		uint32_t crc;
 		uint32_t modTime;
+		uint32_t compressedSize;
+		uint16_t method;
+		uint16_t flags;
 	};
 
 	std::vector<FileEntry> fileEntries;
 
+	const std::uint8_t* mapData = nullptr;
+	size_t mapSize = 0;
+
 	static inline spring::mutex archiveLock;
 };
 
@@ -6,12 +6,14 @@
 
 #include "FileSystemAbstraction.h"
 
+#include <algorithm>
 #include <cassert>
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <cerrno>
 #include <cstring>
 #include <filesystem>
+#include <tuple>
 
 #include <fmt/printf.h>
 #include <fmt/format.h>
@@ -27,7 +29,9 @@
 
 #ifndef _WIN32
 	#include <dirent.h>
+	#include <fcntl.h>
 	#include <sstream>
+	#include <sys/mman.h>
 	#include <unistd.h>
 	#include <ctime>
 	#include <fstream>
@@ -168,6 +172,67 @@ size_t FileSystemAbstraction::GetFileSize(const std::string& file)
 	return size;
 }
 
+const std::uint8_t* FileSystemAbstraction::MapFile(const std::string& file, size_t& mapSize)
+{
+	mapSize = 0;
+
+#ifdef _WIN32
+	HANDLE handle = CreateFileA(file.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+
+	if (handle == INVALID_HANDLE_VALUE)
+		return nullptr;
+
+	LARGE_INTEGER fileSize;
+	HANDLE mapping = nullptr;
+	void* view = nullptr;
+
+	if (GetFileSizeEx(handle, &fileSize) && fileSize.QuadPart > 0)
+		mapping = CreateFileMappingA(handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+
+	if (mapping != nullptr) {
+		// the view keeps the mapping alive
+		if ((view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0)) != nullptr)
+			mapSize = static_cast<size_t>(fileSize.QuadPart);
+
+		CloseHandle(mapping);
+	}
+
+	CloseHandle(handle);
+	return (static_cast<const std::uint8_t*>(view));
+#else
+	const int fd = open(file.c_str(), O_RDONLY);
+
+	if (fd == -1)
+		return nullptr;
+
+	struct stat st;
+	void* view = MAP_FAILED;
+
+	if (fstat(fd, &st) == 0 && st.st_size > 0)
+		view = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+	close(fd);
+
+	if (view == MAP_FAILED)
+		return nullptr;
+
+	mapSize = st.st_size;
+	return (static_cast<const std::uint8_t*>(view));
+#endif
+}
+
+void FileSystemAbstraction::UnmapFile(const std::uint8_t* mapData, size_t mapSize)
+{
+	if (mapData == nullptr)
+		return;
+
+#ifdef _WIN32
+	UnmapViewOfFile(mapData);
+#else
+	munmap(const_cast<std::uint8_t*>(mapData), mapSize);
+#endif
+}
+
 bool FileSystemAbstraction::IsReadableFile(const std::string& file)
 {
 	// Exclude directories!
@@ -222,6 +287,13 @@ std::string FileSystemAbstraction::GetFileModificationDate(const std::string& fi
 	return fmt::sprintf("%d%02d%02d%02d%02d%02d", 1900 + clk->tm_year, clk->tm_mon + 1, clk->tm_mday, clk->tm_hour, clk->tm_min, clk->tm_sec);
 }
 
+bool FileSystemAbstraction::UpdateFileModificationTime(const std::string& file)
+{
+	std::error_code ec;
+	std::filesystem::last_write_time(file, std::filesystem::file_time_type::clock::now(), ec);
+	return !ec;
+}
+
 
 bool FileSystemAbstraction::IsPathOnSpinningDisk(const std::string& path)
 {
@@ -632,3 +704,51 @@ void FileSystemAbstraction::FindFiles(std::vector<std::string>& matches, const s
 	::FindFiles(matches, dataDir, dir, regexPattern, flags);
 }
 
+
+size_t FileSystemAbstraction::PruneFiles(const std::string& dir, const std::string& regex, uint64_t maxSize)
+{
+	struct FileInfo {
+		std::string path;
+		uint64_t size;
+		uint32_t time;
+	};
+
+	const std::string dirPath = EnsurePathSepAtEnd(dir);
+
+	std::vector<std::string> names;
+	std::vector<FileInfo> files;
+
+	FindFiles(names, dirPath, "", regex, 0);
+	files.reserve(names.size());
+
+	uint64_t totalSize = 0;
+
+	for (const std::string& name: names) {
+		const std::string path = dirPath + name;
+
+		files.push_back({path, GetFileSize(path), GetFileModificationTime(path)});
+		totalSize += files.back().size;
+	}
+
+	if (totalSize <= maxSize)
+		return 0;
+
+	// least recently modified first, ties in name order
+	std::sort(files.begin(), files.end(), [](const FileInfo& a, const FileInfo& b) {
+		return (std::tie(a.time, a.path) < std::tie(b.time, b.path));
+	});
+
+	size_t numDeleted = 0;
+
+	for (const FileInfo& file: files) {
+		if (totalSize <= maxSize)
+			break;
+		if (!DeleteFile(file.path))
+			continue;
+
+		totalSize -= file.size;
+		numDeleted += 1;
+	}
+
+	return numDeleted;
+}
@@ -107,6 +107,15 @@ public:
 	 */
 	static size_t GetFileSize(const std::string& file);
 
+	/**
+	 * @brief map a whole file read-only into memory
+	 *
+	 * @return start of the mapping, or nullptr if the file could not be
+	 *          opened or is empty; release with UnmapFile
+	 */
+	static const std::uint8_t* MapFile(const std::string& file, size_t& mapSize);
+	static void UnmapFile(const std::uint8_t* mapData, size_t mapSize);
+
 	// custom functions
 	static bool IsReadableFile(const std::string& file);
 
@@ -120,6 +129,8 @@ public:
 	 *          or "" on error
 	 */
 	static std::string GetFileModificationDate(const std::string& file);
+	/// sets the last modification time of <file> to now
+	static bool UpdateFileModificationTime(const std::string& file);
 
 	/**
 	 * Returns if the file or directory reside on spinning disk
@@ -131,6 +142,15 @@ public:
 	static bool IsAbsolutePath(const std::string& path);
 
 	static void FindFiles(std::vector<std::string>& matches, const std::string& dataDir, const std::string& dir, const std::string& regex, int flags);
+
+	/**
+	 * Deletes the least recently modified files in <dir> whose names match
+	 * <regex> until the remaining ones take up at most <maxSize> bytes.
+	 * Meant for caches that refresh the modification time of used entries.
+	 *
+	 * @return the number of deleted files
+	 */
+	static size_t PruneFiles(const std::string& dir, const std::string& regex, uint64_t maxSize);
 };
 
 #endif // !FILE_SYSTEM_ABSTACTION_H
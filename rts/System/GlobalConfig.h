@@ -82,6 +82,14 @@ public:
 	 */
 	int linkIncomingMaxWaitingPackets = 512;
 
+	/**
+	 * @brief networkCompression
+	 *
+	 * Whether to deflate the messages of each send window into a single
+	 * block, towards peers that announce they accept such blocks
+	 */
+	bool networkCompression = true;
+
 
 	/**
 	 * @brief useNetMessageSmoothingBuffer
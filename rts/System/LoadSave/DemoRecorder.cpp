@@ -2,7 +2,9 @@
 
 #include <cassert>
 #include <cerrno>
+#include <cstdio>
 #include <cstring>
+#include <deque>
 #include <memory>
 
 #include "DemoRecorder.h"
@@ -11,11 +13,13 @@
 #include "Sim/Misc/TeamStatistics.h"
 #include "System/TimeUtil.h"
 #include "System/StringUtil.h"
+#include "System/Config/ConfigHandler.h"
 #include "System/FileSystem/DataDirsAccess.h"
 #include "System/FileSystem/FileSystem.h"
 #include "System/FileSystem/FileQueryFlags.h"
 #include "System/FileSystem/FileHandler.h"
 #include "System/Log/ILog.h"
+#include "System/Platform/Threading.h"
 #include "System/Threading/ThreadPool.h"
 
 #ifdef CreateDirectory
@@ -27,40 +31,294 @@
 #endif
 
 
+CONFIG(int, DemoStreamChunkSize)
+	.defaultValue(0)
+	.dedicatedValue(1024)
+	.minimumValue(0)
+	.description("Size (in KB) of the chunks a demo is compressed and written to disk in while it is being recorded. 0 keeps the entire demo in memory until the game ends.");
+CONFIG(int, ServerDemoMaxBufferSize)
+	.defaultValue(32)
+	.minimumValue(1)
+	.description("Maximum amount (in MB) of not yet written server demo data kept in memory when DemoStreamChunkSize is enabled.");
+CONFIG(int, ClientDemoMaxBufferSize)
+	.defaultValue(32)
+	.minimumValue(1)
+	.description("Maximum amount (in MB) of not yet written client demo data kept in memory when DemoStreamChunkSize is enabled.");
+
+
 // server and client memory-streams
 static std::string demoStreams[2];
 static spring::mutex demoMutex;
 
 
+/**
+ * @brief Writes a demo to disk while it is being recorded
+ *
+ * Chunks are compressed on a background thread and appended as separate gzip
+ * members, which gzread (CGZFileHandler) transparently concatenates. The first
+ * member always holds the DemoFileHeader and is stored without compression so
+ * it has a constant size and can be patched in place when the demo is closed.
+ * Until then demoStreamSize is 0, which readers treat as "read until EOF".
+ */
+class CDemoStreamWriter
+{
+public:
+	CDemoStreamWriter(const std::string& fileName, size_t chunkSize, size_t maxBufferSize)
+		: file(fopen(fileName.c_str(), "wb"))
+		, maxQueuedBytes(std::max(maxBufferSize, chunkSize))
+		, streamChunkSize(chunkSize)
+	{
+		if (file == nullptr) {
+			LOG_L(L_ERROR, "[DemoStreamWriter::%s] could not open \"%s\" (%s)", __func__, fileName.c_str(), strerror(errno));
+			return;
+		}
+
+		thread = spring::thread([this]() {
+			Threading::SetThreadName("demowriter");
+			WriterLoop();
+		});
+	}
+
+	~CDemoStreamWriter() {
+		if (file == nullptr)
+			return;
+
+		{
+			std::lock_guard<spring::mutex> lock(jobMutex);
+			quitWriter = true;
+		}
+
+		jobCond.notify_one();
+		thread.join();
+
+		fclose(file);
+	}
+
+	bool IsOpen() const { return (file != nullptr); }
+
+	size_t GetChunkSize() const { return streamChunkSize; }
+
+	/// <header> must already be in little-endian order
+	void WriteHeader(const DemoFileHeader& header) {
+		QueueJob({reinterpret_cast<const char*>(&header), sizeof(header)}, true);
+	}
+
+	/// blocks while more than maxQueuedBytes are waiting to be written
+	void WriteChunk(std::string&& chunk) {
+		QueueJob(std::move(chunk), false);
+	}
+
+private:
+	struct WriteJob {
+		std::string data;
+		bool isHeader;
+	};
+
+	void QueueJob(std::string&& data, bool isHeader) {
+		{
+			std::unique_lock<spring::mutex> lock(jobMutex);
+
+			doneCond.wait(lock, [&]() { return (queuedBytes < maxQueuedBytes || writerFailed); });
+
+			queuedBytes += data.size();
+			jobs.push_back({std::move(data), isHeader});
+		}
+
+		jobCond.notify_one();
+	}
+
+	void WriterLoop() {
+		WriteJob job;
+
+		while (true) {
+			{
+				std::unique_lock<spring::mutex> lock(jobMutex);
+
+				jobCond.wait(lock, [&]() { return (!jobs.empty() || quitWriter); });
+
+				if (jobs.empty())
+					return;
+
+				job = std::move(jobs.front());
+				jobs.pop_front();
+			}
+
+			const bool written = writerFailed || WriteMember(job);
+
+			{
+				std::lock_guard<spring::mutex> lock(jobMutex);
+
+				queuedBytes -= job.data.size();
+				writerFailed |= !written;
+			}
+
+			doneCond.notify_all();
+		}
+	}
+
+	bool WriteMember(const WriteJob& job) {
+		z_stream zs;
+		memset(&zs, 0, sizeof(zs));
+
+		// +16 selects the gzip wrapper; headers are stored (level 0) to keep their size fixed
+		if (deflateInit2(&zs, job.isHeader? Z_NO_COMPRESSION: Z_BEST_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+			return false;
+
+		memberBuffer.resize(deflateBound(&zs, job.data.size()));
+
+		zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(job.data.data()));
+		zs.avail_in = job.data.size();
+		zs.next_out = memberBuffer.data();
+		zs.avail_out = memberBuffer.size();
+
+		const int ret = deflate(&zs, Z_FINISH);
+		const size_t memberSize = memberBuffer.size() - zs.avail_out;
+
+		deflateEnd(&zs);
+
+		if (ret != Z_STREAM_END)
+			return false;
+
+		if (job.isHeader) {
+			if (headerMemberSize < 0) {
+				assert(ftell(file) == 0);
+				headerMemberSize = memberSize;
+			} else {
+				if (memberSize != size_t(headerMemberSize)) {
+					LOG_L(L_ERROR, "[DemoStreamWriter::%s] header size mismatch (" _STPF_ " vs %ld bytes)", __func__, memberSize, headerMemberSize);
+					return false;
+				}
+
+				fseek(file, 0, SEEK_SET);
+			}
+		}
+
+		const bool written = (fwrite(memberBuffer.data(), memberSize, 1, file) == 1);
+
+		if (job.isHeader)
+			fseek(file, 0, SEEK_END);
+
+		// keep what has been recorded so far readable if the process dies
+		fflush(file);
+		return written;
+	}
+
+private:
+	FILE* file = nullptr;
+
+	std::deque<WriteJob> jobs;
+	std::vector<Bytef> memberBuffer;
+
+	spring::mutex jobMutex;
+	spring::condition_variable_any jobCond;
+	spring::condition_variable_any doneCond;
+
+	spring::thread thread;
+
+	size_t queuedBytes = 0;
+	size_t maxQueuedBytes = 0;
+	size_t streamChunkSize = 0;
+
+	long headerMemberSize = -1;
+
+	bool quitWriter = false;
+	bool writerFailed = false;
+};
+
+
+
+CDemoRecorder::CDemoRecorder() { memset(&fileHeader, 0, sizeof(fileHeader)); }
+CDemoRecorder::CDemoRecorder(CDemoRecorder&& r) { *this = std::move(r); }
+
 CDemoRecorder::CDemoRecorder(const std::string& mapName, const std::string& modName, bool serverDemo): isServerDemo(serverDemo)
 {
 	std::lock_guard<spring::mutex> lock(demoMutex);
 
-	SetStream();
 	SetName(mapName, modName);
 	SetFileHeader();
+
+	const size_t streamChunkSize = configHandler->GetInt("DemoStreamChunkSize") * size_t(1024);
+	const size_t maxStreamBufferSize = configHandler->GetInt(isServerDemo? "ServerDemoMaxBufferSize": "ClientDemoMaxBufferSize") * size_t(1024 * 1024);
+
+	if (streamChunkSize > 0 && !demoName.empty()) {
+		streamWriter = std::make_unique<CDemoStreamWriter>(demoName, streamChunkSize, maxStreamBufferSize);
+
+		if (!streamWriter->IsOpen())
+			streamWriter.reset();
+	}
+
+	SetStream();
 	WriteFileHeader(false);
 
+	if (streamWriter != nullptr)
+		return;
+
 	file = gzopen(demoName.c_str(), "wb9");
 }
 
 CDemoRecorder::~CDemoRecorder()
 {
-	if (file == nullptr)
+	if (!IsValid())
 		return;
 
 	WriteWinnerList();
 	WritePlayerStats();
 	WriteTeamStats();
 	WriteFileHeader(true);
-	WriteDemoFile();
+
+	if (streamWriter == nullptr) {
+		WriteDemoFile();
+		return;
+	}
+
+	// remaining data is at most one chunk, finish writing it here
+	FlushStream(true);
+
+	LOG("[DemoRecorder::%s] finishing %s-demo \"%s\" (%d bytes)", __func__, (isServerDemo? "server": "client"), demoName.c_str(), fileHeader.demoStreamSize);
+	streamWriter.reset();
+}
+
+
+CDemoRecorder& CDemoRecorder::operator = (CDemoRecorder&& r)
+{
+	memcpy(&fileHeader, &r.fileHeader, sizeof(fileHeader));
+	memset(&r.fileHeader, 0, sizeof(fileHeader));
+
+	std::swap(file, r.file);
+	std::swap(streamWriter, r.streamWriter);
+
+	std::swap(demoName, r.demoName);
+	std::swap(playerStats, r.playerStats);
+	std::swap(teamStats, r.teamStats);
+	std::swap(winningAllyTeams, r.winningAllyTeams);
+
+	std::swap(isServerDemo, r.isServerDemo);
+	return *this;
 }
 
 
 void CDemoRecorder::SetStream()
 {
 	demoStreams[isServerDemo].clear();
-	demoStreams[isServerDemo].reserve(8 * 1024 * 1024);
+	demoStreams[isServerDemo].reserve((streamWriter != nullptr)? streamWriter->GetChunkSize(): (8 * 1024 * 1024));
+}
+
+void CDemoRecorder::FlushStream(bool force)
+{
+	if (streamWriter == nullptr)
+		return;
+
+	std::string& data = demoStreams[isServerDemo];
+
+	if (data.empty())
+		return;
+	if (!force && data.size() < streamWriter->GetChunkSize())
+		return;
+
+	streamWriter->WriteChunk(std::move(data));
+
+	data.clear();
+	data.reserve(streamWriter->GetChunkSize());
 }
 
 void CDemoRecorder::SetFileHeader()
@@ -121,6 +379,12 @@ void CDemoRecorder::WriteSetupText(const std::string& text)
 
 	fileHeader.scriptSize = length;
 	demoStreams[isServerDemo].append(text.c_str(), length);
+
+	// streamed demos otherwise only get their final header from the dtor,
+	// so a demo recovered after a crash would have scriptSize 0
+	WriteFileHeader(false);
+
+	FlushStream(false);
 }
 
 void CDemoRecorder::SaveToDemo(const unsigned char* buf, const unsigned length, const float modGameTime)
@@ -133,6 +397,8 @@ void CDemoRecorder::SaveToDemo(const unsigned char* buf, const unsigned length,
 	demoStreams[isServerDemo].append(reinterpret_cast<const char*>(&chunkHeader), sizeof(chunkHeader));
 	demoStreams[isServerDemo].append(reinterpret_cast<const char*>(buf), length);
 	fileHeader.demoStreamSize += (length + sizeof(chunkHeader));
+
+	FlushStream(false);
 }
 
 void CDemoRecorder::SetName(const std::string& mapName, const std::string& modName)
@@ -242,6 +508,12 @@ unsigned int CDemoRecorder::WriteFileHeader(bool updateStreamLength)
 	// to little endian
 	tmpHeader.swab();
 
+	if (streamWriter != nullptr) {
+		// streamed demos keep their header out of the memory-stream
+		streamWriter->WriteHeader(tmpHeader);
+		return (demoStreams[isServerDemo].size());
+	}
+
 	if (demoStreams[isServerDemo].empty()) {
 		demoStreams[isServerDemo].append(reinterpret_cast<const char*>(&tmpHeader), sizeof(tmpHeader));
 	} else {
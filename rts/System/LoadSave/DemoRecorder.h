@@ -3,6 +3,7 @@
 #ifndef DEMO_RECORDER
 #define DEMO_RECORDER
 
+#include <memory>
 #include <vector>
 #include <sstream>
 #include <zlib.h>
@@ -11,6 +12,7 @@
 #include "Game/Players/PlayerStatistics.h"
 #include "Sim/Misc/TeamStatistics.h"
 
+class CDemoStreamWriter;
 
 /**
  * @brief Used to record demos
@@ -18,33 +20,21 @@
 class CDemoRecorder : public CDemo
 {
 public:
-	CDemoRecorder() { memset(&fileHeader, 0, sizeof(fileHeader)); }
+	CDemoRecorder();
 	CDemoRecorder(const std::string& mapName, const std::string& modName, bool serverDemo);
 
 	CDemoRecorder(const CDemoRecorder&) = delete;
-	CDemoRecorder(CDemoRecorder&& r) { *this = std::move(r); }
+	CDemoRecorder(CDemoRecorder&& r);
 
 	~CDemoRecorder();
 
 
 	CDemoRecorder& operator = (const CDemoRecorder&) = delete;
-	CDemoRecorder& operator = (CDemoRecorder&& r) {
-		memcpy(&fileHeader, &r.fileHeader, sizeof(fileHeader));
-		memset(&r.fileHeader, 0, sizeof(fileHeader));
+	CDemoRecorder& operator = (CDemoRecorder&& r);
 
-		std::swap(file, r.file);
 
-		std::swap(demoName, r.demoName);
-		std::swap(playerStats, r.playerStats);
-		std::swap(teamStats, r.teamStats);
-		std::swap(winningAllyTeams, r.winningAllyTeams);
-
-		std::swap(isServerDemo, r.isServerDemo);
-		return *this;
-	}
-
-
-	bool IsValid() const { return (file != nullptr); }
+	bool IsValid() const { return (file != nullptr || streamWriter != nullptr); }
+	bool IsStreaming() const { return (streamWriter != nullptr); }
 
 	void WriteSetupText(const std::string& text);
 	void SaveToDemo(const unsigned char* buf, const unsigned length, const float modGameTime);
@@ -69,10 +59,14 @@ private:
 	void WriteTeamStats();
 	void WriteWinnerList();
 	void WriteDemoFile();
+	void FlushStream(bool force);
 
 private:
 	gzFile file = nullptr;
 
+	// non-null if chunks are compressed and written while recording
+	std::unique_ptr<CDemoStreamWriter> streamWriter;
+
 	std::vector<PlayerStatistics> playerStats;
 	std::vector< std::vector<TeamStatistics> > teamStats;
 	std::vector<unsigned char> winningAllyTeams;
@@ -4,6 +4,7 @@
 
 #include <cinttypes>
 
+#include <zlib.h>
 
 #include "Socket.h"
 #include "ProtocolDef.h"
@@ -15,6 +16,7 @@
 #include "System/Log/ILog.h"
 #include "System/SpringFormat.h"
 #include "System/SafeUtil.h"
+#include "System/Threading/SpringThreading.h"
 
 #ifndef UNIT_TEST
 CONFIG(bool, UDPConnectionLogDebugMessages).defaultValue(false);
@@ -28,6 +30,53 @@ static constexpr unsigned udpMaxPacketSize = 4096;
 static constexpr int maxChunkSize = 254;
 static constexpr int chunksPerSec = 30;
 
+// blocks only pay off beyond a few messages, and must fit the uint16_t size
+static constexpr unsigned minBlockRawSize = 64;
+static constexpr unsigned maxBlockRawSize = 16384;
+static constexpr unsigned blockHeaderSize = 1 + sizeof(std::uint16_t);
+
+static_assert(int(NETMSG_LAST) <= int(UDPConnection::UDP_MSG_COMPRESSION), "transport message types overlap protocol message types");
+
+// connections accepted by a UDPListener send through its socket, and may be
+// flushed from more than one thread at a time (see CSpectatorRelay); asio
+// sockets must not be used concurrently
+static spring::mutex sharedSocketMutex;
+
+
+static const std::vector<std::uint8_t>& GetBlockDictionary()
+{
+	// every block is compressed independently (chunks may be resent and
+	// connections re-established at any point), so seed each with bytes
+	// that typically occur in a frame's worth of messages; deflate finds
+	// matches near the end of the dictionary cheapest
+	static const std::vector<std::uint8_t> dict = []() {
+		std::vector<std::uint8_t> d;
+
+		const auto Push = [&](std::initializer_list<std::uint8_t> bytes) { d.insert(d.end(), bytes.begin(), bytes.end()); };
+		const auto PushFloat = [&](float f) { std::uint8_t b[sizeof(f)]; memcpy(b, &f, sizeof(f)); d.insert(d.end(), b, b + sizeof(f)); };
+
+		for (const float f: {0.0f, 1.0f, -1.0f, 0.5f, 8.0f, 16.0f, 100.0f}) {
+			PushFloat(f);
+		}
+
+		Push({NETMSG_PLAYERINFO, 0, 0, 0, 0, 0, 0, 0, 0, 0});
+		Push({NETMSG_SYNCRESPONSE, 0, 0, 0, 0, 0, 0, 0, 0, 0});
+		Push({NETMSG_LUAMSG, 0, 0, 0, 0, 0, 0});
+		Push({NETMSG_AICOMMAND, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0});
+		Push({NETMSG_SELECT, 0, 0, 0});
+		Push({NETMSG_COMMAND, 0, 0, 0, 0, 0, 0, 0xFF, 0xFF, 0xFF, 0xFF, 0});
+		Push({NETMSG_KEYFRAME, 0, 0, 0, 0});
+
+		for (int i = 0; i < 32; i++) {
+			d.push_back(NETMSG_NEWFRAME);
+		}
+
+		return d;
+	}();
+
+	return dict;
+}
+
 
 
 #if NETWORK_TEST
@@ -256,7 +305,7 @@ UDPConnection::UDPConnection(int sourcePort, const std::string& address, const u
 UDPConnection::UDPConnection(CConnection& conn)
 	: sharedSocket(true)
 {
-	ReconnectTo(conn);
+	dynamic_cast<UDPConnection&>(conn).CopyConnection(*this);
 	Init();
 }
 
@@ -303,6 +352,13 @@ void UDPConnection::Init()
 	sentOverhead = 0;
 	recvOverhead = 0;
 
+	sentBlockRawBytes = 0;
+	sentBlockBytes = 0;
+	sentBlocks = 0;
+	recvBlockRawBytes = 0;
+	recvBlockBytes = 0;
+	recvBlocks = 0;
+
 	resentChunks = 0;
 	sentPackets = 0;
 	recvPackets = 0;
@@ -313,6 +369,9 @@ void UDPConnection::Init()
 	muted = true;
 	closed = false;
 	resend = false;
+	compression = false;
+
+	AnnounceCompression();
 
 	#ifndef UNIT_TEST
 	logMessages = configHandler->GetBool("UDPConnectionLogDebugMessages");
@@ -325,8 +384,22 @@ void UDPConnection::Init()
 #endif
 }
 
+void UDPConnection::AnnounceCompression()
+{
+	// blocks are only sent to peers that asked for them
+	if (globalConfig.networkCompression)
+		outgoingData.emplace_back(new RawPacket(1, UDP_MSG_COMPRESSION));
+}
+
 void UDPConnection::ReconnectTo(CConnection& conn) {
-	dynamic_cast<UDPConnection&>(conn).CopyConnection(*this);
+	UDPConnection& udpConn = dynamic_cast<UDPConnection&>(conn);
+	udpConn.CopyConnection(*this);
+
+	// the peer may have restarted with different settings; its announcement
+	// preceded the reconnect attempt and was seen by the temporary link, and
+	// ours has to be repeated since the old one was sent to the old address
+	compression = udpConn.compression;
+	AnnounceCompression();
 }
 
 void UDPConnection::CopyConnection(UDPConnection &conn) {
@@ -344,6 +417,14 @@ UDPConnection::~UDPConnection()
 	waitingPackets.clear();
 
 	Flush(true);
+
+	if (deflateStream != nullptr)
+		deflateEnd(deflateStream);
+	if (inflateStream != nullptr)
+		inflateEnd(inflateStream);
+
+	spring::SafeDelete(deflateStream);
+	spring::SafeDelete(inflateStream);
 }
 
 void UDPConnection::SendData(std::shared_ptr<const RawPacket> pkt)
@@ -521,6 +602,185 @@ void UDPConnection::UpdateResendRequests()
 }
 
 
+void UDPConnection::ProcessMessage(const unsigned char* data, unsigned length)
+{
+	switch (data[0]) {
+		case UDP_MSG_COMPRESSION: {
+			compression = globalConfig.networkCompression;
+		} break;
+		case UDP_MSG_COMPRESSED: {
+			InflateMessages(data, length);
+		} break;
+		default: {
+			EnqueueMessage(data, length);
+		} break;
+	}
+}
+
+void UDPConnection::EnqueueMessage(const unsigned char* data, unsigned length)
+{
+	msgQueue.emplace_back(new RawPacket(data, length));
+
+	#ifdef ENABLE_DEBUG_STATS
+	// server sends both of these, clients send only keyframe messages
+	// TODO: would be easy to feed this data into a Q3A-style lagometer
+	//
+	if (data[0] == NETMSG_NEWFRAME || data[0] == NETMSG_KEYFRAME) {
+		const spring_time dt = spring_gettime() - lastFramePacketRecvTime;
+
+		sumDeltaFramePacketRecvTime += dt.toMilliSecsf();
+		minDeltaFramePacketRecvTime = std::min(dt.toMilliSecsf(), minDeltaFramePacketRecvTime);
+		maxDeltaFramePacketRecvTime = std::max(dt.toMilliSecsf(), maxDeltaFramePacketRecvTime);
+
+		numReceivedFramePackets += 1;
+		numEnqueuedFramePackets += 1;
+		lastFramePacketRecvTime = spring_gettime();
+
+		if (logMessages) {
+			LOG_L(L_INFO,
+				"\t[%s] (received=%u enqueued=%u) packets (dt=%fms mindt=%fms maxdt=%fms sumdt=%fms)",
+				__func__, numReceivedFramePackets, numEnqueuedFramePackets, dt.toMilliSecsf(),
+				minDeltaFramePacketRecvTime, maxDeltaFramePacketRecvTime, sumDeltaFramePacketRecvTime
+			);
+		}
+	}
+	#endif
+
+	numPings += (data[0] == NETMSG_PING); // incoming
+}
+
+void UDPConnection::InflateMessages(const unsigned char* data, unsigned length)
+{
+	const std::vector<std::uint8_t>& dict = GetBlockDictionary();
+
+	if (inflateStream == nullptr) {
+		inflateStream = new z_stream{};
+
+		if (inflateInit2(inflateStream, -MAX_WBITS) != Z_OK) {
+			spring::SafeDelete(inflateStream);
+			throw network_error("[UDPConnection] failed to initialize zlib inflate stream");
+		}
+	}
+
+	blockBuffer.resize(maxBlockRawSize);
+
+	inflateReset(inflateStream);
+	inflateSetDictionary(inflateStream, dict.data(), dict.size());
+
+	inflateStream->next_in = const_cast<unsigned char*>(data + blockHeaderSize);
+	inflateStream->avail_in = length - blockHeaderSize;
+	inflateStream->next_out = blockBuffer.data();
+	inflateStream->avail_out = blockBuffer.size();
+
+	// also fails for blocks that would inflate beyond maxBlockRawSize
+	if (inflate(inflateStream, Z_FINISH) != Z_STREAM_END) {
+		LOG_L(L_ERROR, "\t[%s] discarding incoming corrupted block: LEN %u", __func__, length);
+		return;
+	}
+
+	const unsigned rawLength = inflateStream->total_out;
+
+	recvBlockRawBytes += rawLength;
+	recvBlockBytes += length;
+	recvBlocks += 1;
+
+	for (unsigned pos = 0; pos < rawLength; ) {
+		const unsigned char* bufp = &blockBuffer[pos];
+		const unsigned int msgLength = rawLength - pos;
+
+		const int pktLength = ProtocolDef::GetInstance()->PacketLength(bufp, msgLength);
+
+		// blocks hold complete protocol messages only
+		if (!ProtocolDef::GetInstance()->IsValidLength(pktLength, msgLength) || *bufp >= UDP_MSG_COMPRESSION) {
+			LOG_L(L_ERROR, "\t[%s] discarding remainder of incoming block: ID %d, LEN %d", __func__, (int)*bufp, pktLength);
+			break;
+		}
+
+		EnqueueMessage(bufp, pktLength);
+		pos += pktLength;
+	}
+}
+
+void UDPConnection::CompressOutgoingData()
+{
+	unsigned numPackets = 0;
+	unsigned rawLength = 0;
+
+	for (auto pi = outgoingData.begin(); pi != outgoingData.end(); ) {
+		const RawPacket* packet = pi->get();
+
+		// transport messages (e.g. a block held back by the bandwidth limit) are
+		// never put into a block, and a full block is not worth waiting for
+		if (packet->data[0] >= UDP_MSG_COMPRESSION || (rawLength + packet->length) > maxBlockRawSize)
+			break;
+
+		if (!ProtocolDef::GetInstance()->IsValidPacket(packet->data, packet->length)) {
+			LOG_L(L_ERROR,
+				"[UDPConnection::%s] discarding outgoing invalid packet: ID %d, LEN %d",
+				__func__, ((packet->length > 0) ? (int)packet->data[0] : -1), packet->length
+			);
+			pi = outgoingData.erase(pi);
+			continue;
+		}
+
+		rawLength += packet->length;
+		numPackets += 1;
+		++pi;
+	}
+
+	if (rawLength < minBlockRawSize)
+		return;
+
+	const std::vector<std::uint8_t>& dict = GetBlockDictionary();
+
+	if (deflateStream == nullptr) {
+		deflateStream = new z_stream{};
+
+		// raw deflate, the block header already carries the size
+		if (deflateInit2(deflateStream, Z_BEST_SPEED, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+			spring::SafeDelete(deflateStream);
+			throw network_error("[UDPConnection] failed to initialize zlib deflate stream");
+		}
+	}
+
+	blockBuffer.clear();
+
+	for (unsigned n = 0; n < numPackets; n++) {
+		blockBuffer.insert(blockBuffer.end(), outgoingData[n]->data, outgoingData[n]->data + outgoingData[n]->length);
+	}
+
+	deflateReset(deflateStream);
+	deflateSetDictionary(deflateStream, dict.data(), dict.size());
+
+	std::shared_ptr<RawPacket> block(new RawPacket(blockHeaderSize + deflateBound(deflateStream, rawLength)));
+
+	deflateStream->next_in = blockBuffer.data();
+	deflateStream->avail_in = rawLength;
+	deflateStream->next_out = block->data + blockHeaderSize;
+	deflateStream->avail_out = block->length - blockHeaderSize;
+
+	if (deflate(deflateStream, Z_FINISH) != Z_STREAM_END)
+		return;
+
+	const unsigned blockLength = blockHeaderSize + deflateStream->total_out;
+
+	// incompressible data, send as-is
+	if (blockLength >= rawLength)
+		return;
+
+	*block << std::uint8_t(UDP_MSG_COMPRESSED);
+	*block << std::uint16_t(blockLength);
+	block->length = blockLength;
+
+	sentBlockRawBytes += rawLength;
+	sentBlockBytes += blockLength;
+	sentBlocks += 1;
+
+	outgoingData.erase(outgoingData.begin(), outgoingData.begin() + numPackets);
+	outgoingData.push_front(std::move(block));
+}
+
+
 void UDPConnection::ProcessRawPacket(Packet& incoming)
 {
 	#ifdef ENABLE_DEBUG_STATS
@@ -644,36 +904,8 @@ void UDPConnection::ProcessRawPacket(Packet& incoming)
 
 			// this returns false for zero/invalid pktLength
 			if (ProtocolDef::GetInstance()->IsValidLength(pktLength, msgLength)) {
-				msgQueue.emplace_back(new RawPacket(bufp, pktLength));
-				std::shared_ptr<const RawPacket>& msgPacket = msgQueue.back();
-
-				#ifdef ENABLE_DEBUG_STATS
-				// server sends both of these, clients send only keyframe messages
-				// TODO: would be easy to feed this data into a Q3A-style lagometer
-				//
-				if (msgPacket->data[0] == NETMSG_NEWFRAME || msgPacket->data[0] == NETMSG_KEYFRAME) {
-					const spring_time dt = spring_gettime() - lastFramePacketRecvTime;
-
-					sumDeltaFramePacketRecvTime += dt.toMilliSecsf();
-					minDeltaFramePacketRecvTime = std::min(dt.toMilliSecsf(), minDeltaFramePacketRecvTime);
-					maxDeltaFramePacketRecvTime = std::max(dt.toMilliSecsf(), maxDeltaFramePacketRecvTime);
-
-					numReceivedFramePackets += 1;
-					numEnqueuedFramePackets += 1;
-					lastFramePacketRecvTime = spring_gettime();
-
-					if (logMessages) {
-						LOG_L(L_INFO,
-							"\t[%s] (received=%u enqueued=%u) packets (dt=%fms mindt=%fms maxdt=%fms sumdt=%fms)",
-							__func__, numReceivedFramePackets, numEnqueuedFramePackets, dt.toMilliSecsf(),
-							minDeltaFramePacketRecvTime, maxDeltaFramePacketRecvTime, sumDeltaFramePacketRecvTime
-						);
-					}
-				}
-				#endif
-
+				ProcessMessage(bufp, pktLength);
 				pos += pktLength;
-				numPings += (msgPacket->data[0] == NETMSG_PING); // incoming
 			} else {
 				if (pktLength >= 0) {
 					// partial packet in buffer
@@ -717,6 +949,9 @@ void UDPConnection::Flush(const bool forced)
 		std::uint8_t buffer[udpMaxPacketSize];
 		unsigned pos = 0;
 
+		if (compression)
+			CompressOutgoingData();
+
 		// Manually fragment packets to respect configured UDP_MTU.
 		// This is an attempt to fix the bug where players drop out
 		// of the game if someone in the game gives a large order.
@@ -809,6 +1044,7 @@ std::string UDPConnection::Statistics() const
 		"\t{%.3fx, %.3fx} relative protocol overhead {up, down}\n",
 		"\t%u incoming chunks dropped, %u outgoing chunks resent\n",
 		"\t%u incoming chunks processed\n",
+		"\t{%.3fx, %.3fx} compression ratio {up, down} over {%u, %u} blocks\n",
 	};
 
 	std::string msg = "[UDPConnection::Statistics]\n";
@@ -817,6 +1053,7 @@ std::string UDPConnection::Statistics() const
 	msg += spring::format(fmts[2], spring::SafeDivide(sentOverhead * 1.0f, dataSent * 1.0f), spring::SafeDivide(recvOverhead * 1.0f, dataRecv * 1.0f));
 	msg += spring::format(fmts[3], droppedChunks, resentChunks);
 	msg += spring::format(fmts[4], lastInOrder + 1);
+	msg += spring::format(fmts[5], spring::SafeDivide(sentBlockRawBytes * 1.0f, sentBlockBytes * 1.0f), spring::SafeDivide(recvBlockRawBytes * 1.0f, recvBlockBytes * 1.0f), sentBlocks, recvBlocks);
 	return msg;
 }
 
@@ -1056,8 +1293,15 @@ void UDPConnection::SendPacket(Packet& pkt)
 	ip::udp::socket::message_flags flags = 0;
 	asio::error_code err;
 
-	EMULATE_LATENCY( !EMULATE_PACKET_LOSS( LOSS_COUNTER ) ) {
-		mySocket->send_to(buffer(sendBuffer), addr, flags, err);
+	{
+		std::unique_lock<spring::mutex> lock(sharedSocketMutex, std::defer_lock);
+
+		if (sharedSocket)
+			lock.lock();
+
+		EMULATE_LATENCY( !EMULATE_PACKET_LOSS( LOSS_COUNTER ) ) {
+			mySocket->send_to(buffer(sendBuffer), addr, flags, err);
+		}
 	}
 
 	if (CheckErrorCode(err))
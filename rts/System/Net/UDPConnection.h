@@ -12,6 +12,7 @@
 #include "System/UnorderedSet.hpp"
 
 class CRC;
+struct z_stream_s;
 
 
 namespace netcode {
@@ -91,6 +92,14 @@ public:
 		MAX_LOSS_FACTOR = 2
 	};
 
+	/// transport-level message types, never passed on to the message queue
+	enum {
+		/// sender accepts compressed blocks
+		UDP_MSG_COMPRESSION = 254,
+		/// uint16_t blockSize, deflated sequence of complete messages
+		UDP_MSG_COMPRESSED  = 255,
+	};
+
 
 	// START overriding CConnection
 	void SendData(std::shared_ptr<const RawPacket> pkt) override;
@@ -143,6 +152,8 @@ private:
 	void SetMTU(unsigned mtu);
 
 	void Init();
+	/// tells the peer that we accept compressed blocks, if enabled
+	void AnnounceCompression();
 
 	/// add header to data and send it
 	void CreateChunk(const unsigned char* data, const unsigned length, const int packetNum);
@@ -155,6 +166,13 @@ private:
 	void UpdateWaitingPackets();
 	void UpdateResendRequests();
 
+	/// replace the leading run of queued messages by a compressed block
+	void CompressOutgoingData();
+	void InflateMessages(const unsigned char* data, unsigned length);
+
+	void ProcessMessage(const unsigned char* data, unsigned length);
+	void EnqueueMessage(const unsigned char* data, unsigned length);
+
 private:
 	spring_time lastChunkCreatedTime;
 	spring_time lastPacketSendTime;
@@ -179,6 +197,8 @@ private:
 	bool resend;
 	bool sharedSocket;
 	bool logMessages;
+	/// set once the other end has announced it accepts compressed blocks
+	bool compression;
 
 	int netLossFactor;
 	int reconnectTime;
@@ -205,6 +225,7 @@ private:
 	std::vector<std::uint8_t> sendBuffer;
 	std::vector<std::uint8_t> recvBuffer;
 	std::vector<std::uint8_t> waitBuffer;
+	std::vector<std::uint8_t> blockBuffer;
 
 	std::vector<int> droppedPackets;
 
@@ -224,6 +245,10 @@ private:
 
 	RawPacket fragmentBuffer;
 
+	/// created on first use; reset for every block
+	z_stream_s* deflateStream = nullptr;
+	z_stream_s* inflateStream = nullptr;
+
 	// Traffic statistics and stuff
 	#ifdef ENABLE_DEBUG_STATS
 	float sumDeltaFramePacketRecvTime;
@@ -244,6 +269,10 @@ private:
 	unsigned int sentOverhead, recvOverhead;
 	unsigned int sentPackets, recvPackets;
 
+	/// message bytes before and after compression
+	unsigned int sentBlockRawBytes, sentBlockBytes, sentBlocks;
+	unsigned int recvBlockRawBytes, recvBlockBytes, recvBlocks;
+
 	class BandwidthUsage {
 	public:
 		BandwidthUsage() = default;
@@ -175,10 +175,13 @@ void UDPListener::Update() {
 	for (auto i = connMap.cbegin(); i != connMap.cend(); ) {
 		if (i->second.expired()) {
 			LOG_L(L_DEBUG, "[UDPListener::%s] connection closed: [%s]:%i", __func__, i->first.address().to_string().c_str(), i->first.port());
+			detachedConns.erase(i->second);
 			i = connMap.erase(i);
 			continue;
 		}
-		i->second.lock()->Update();
+		if (detachedConns.find(i->second) == detachedConns.end())
+			i->second.lock()->Update();
+
 		++i;
 	}
 }
@@ -8,6 +8,7 @@
 #include <asio/ip/udp.hpp>
 #include <map>
 #include <queue>
+#include <set>
 #include <string>
 
 namespace netcode
@@ -75,6 +76,12 @@ public:
 	void RejectConnection() { waiting.pop(); }
 	void UpdateConnections(); // Updates connections when the endpoint has been reconnected
 
+	/**
+	 * @brief Stop calling Update on a connection
+	 * Incoming data is still handed to it, but sending is left to its owner.
+	 */
+	void DetachConnection(const std::shared_ptr<UDPConnection>& conn) { detachedConns.insert(conn); }
+
 private:
 	/**
 	 * @brief Do we accept packets from unknown sources?
@@ -91,6 +98,8 @@ private:
 	std::map< asio::ip::udp::endpoint, std::weak_ptr<UDPConnection> > connMap;
 	std::map< std::string, size_t> dropMap;
 
+	std::set< std::weak_ptr<UDPConnection>, std::owner_less< std::weak_ptr<UDPConnection> > > detachedConns;
+
 	std::queue< std::shared_ptr<UDPConnection> > waiting;
 };
 
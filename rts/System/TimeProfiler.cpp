@@ -2,12 +2,14 @@
 
 #include <algorithm>
 #include <climits>
+#include <cstdio>
 #include <cstring>
 
 #include "System/TimeProfiler.h"
 #include "System/GlobalRNG.h"
 #include "System/StringHash.h"
 #include "System/Log/ILog.h"
+#include "System/Platform/Threading.h"
 #include "System/Threading/SpringThreading.h"
 
 #ifdef THREADPOOL
@@ -24,6 +26,153 @@ static spring::unordered_map<unsigned, int> refCounters;
 
 static CGlobalUnsyncedRNG profileColorRNG;
 
+
+namespace {
+	struct TimerEvent {
+		unsigned nameHash;
+		int threadNum;
+
+		spring_time startTime;
+		spring_time deltaTime;
+
+		bool showGraph;
+		bool threadTimer;
+	};
+
+	// single-producer ring, filled by the thread that claimed it
+	// and drained by whoever holds profileMutex (CTimeProfiler::Merge)
+	struct TimerQueue {
+		static constexpr uint32_t NUM_EVENTS = 8192;
+
+		bool Push(const TimerEvent& e) {
+			const uint32_t h = head.load(std::memory_order_relaxed);
+
+			if ((h - tail.load(std::memory_order_acquire)) >= NUM_EVENTS)
+				return false;
+
+			events[h % NUM_EVENTS] = e;
+			head.store(h + 1, std::memory_order_release);
+			return true;
+		}
+
+		std::array<TimerEvent, NUM_EVENTS> events;
+
+		std::atomic<uint32_t> head = {0};
+		std::atomic<uint32_t> tail = {0};
+		std::atomic<bool> claimed = {false};
+
+		std::string threadName;
+		bool traceNamed = false;
+	};
+
+	struct TimerQueueHandle {
+		~TimerQueueHandle() {
+			// pending events are still merged, the queue is handed to the next new thread
+			if (queue != nullptr)
+				queue->claimed.store(false, std::memory_order_release);
+		}
+
+		TimerQueue* queue = nullptr;
+	};
+}
+
+// deque: queues must not move when another thread claims a new one
+static spring::mutex timerQueuesMutex;
+static std::deque<TimerQueue> timerQueues;
+static thread_local TimerQueueHandle timerQueueHandle;
+
+static FILE* traceFile = nullptr;
+static spring_time traceStartTime;
+static size_t traceNumEvents = 0;
+// events are formatted here and written out in large pieces, not one by one
+static std::string traceBuffer;
+static constexpr size_t TRACE_BUFFER_SIZE = 1 << 20;
+
+
+static int GetProfilerThreadNum()
+{
+	#ifdef THREADPOOL
+	return ThreadPool::GetThreadNum();
+	#else
+	return 0;
+	#endif
+}
+
+static std::string GetProfilerThreadName(size_t queueNum)
+{
+	#ifndef UNIT_TEST
+	if (Threading::IsMainThread())
+		return "main";
+	if (Threading::IsGameLoadThread())
+		return "load";
+	#endif
+
+	const int threadNum = GetProfilerThreadNum();
+
+	if (threadNum > 0)
+		return ("pool" + std::to_string(threadNum));
+
+	return ("thread" + std::to_string(queueNum));
+}
+
+// JSON string literal; timer names are free-form and may contain quotes
+static void AppendTraceString(std::string& buf, const char* str)
+{
+	buf += '"';
+
+	for (const char* c = str; *c != 0; c++) {
+		switch (*c) {
+			case '"' : { buf += "\\\""; } break;
+			case '\\': { buf += "\\\\"; } break;
+			default: {
+				if (static_cast<unsigned char>(*c) >= 0x20) {
+					buf += *c;
+					break;
+				}
+
+				char esc[8];
+				snprintf(esc, sizeof(esc), "\\u%04x", unsigned(*c));
+				buf += esc;
+			} break;
+		}
+	}
+
+	buf += '"';
+}
+
+static void FlushTraceBuffer()
+{
+	fwrite(traceBuffer.data(), 1, traceBuffer.size(), traceFile);
+	traceBuffer.clear();
+}
+
+static TimerQueue& GetTimerQueue()
+{
+	if (timerQueueHandle.queue != nullptr)
+		return *timerQueueHandle.queue;
+
+	std::lock_guard<spring::mutex> lock(timerQueuesMutex);
+
+	TimerQueue* queue = nullptr;
+
+	for (TimerQueue& q: timerQueues) {
+		if (q.claimed.exchange(true, std::memory_order_acquire))
+			continue;
+
+		queue = &q;
+		break;
+	}
+
+	if (queue == nullptr) {
+		queue = &timerQueues.emplace_back();
+		queue->claimed = true;
+	}
+
+	queue->threadName = GetProfilerThreadName(timerQueues.size() - 1);
+	queue->traceNamed = false;
+	return *(timerQueueHandle.queue = queue);
+}
+
 const std::array<CTimeProfiler::ProfileSortFunc, CTimeProfiler::SortType::ST_COUNT> CTimeProfiler::SortingFunctions = {
 	[](const TimeRecordPair& a, const TimeRecordPair& b) { return (a.first          < b.first         ); }, // ST_ALPHABETICAL = 0,
 	[](const TimeRecordPair& a, const TimeRecordPair& b) { return (a.second.total   > b.second.total  ); }, // ST_TOTALTIME    = 1,
@@ -119,7 +268,7 @@ ScopedMtTimer::~ScopedMtTimer()
 CTimeProfiler::CTimeProfiler()
 {
 	// self
-	RegisterTimer("Misc::Profiler::AddTime");
+	RegisterTimer("Misc::Profiler::Merge");
 	// specials (conditional on LuaContextData)
 	RegisterTimer("Lua::Callins::Synced");
 	RegisterTimer("Lua::Callins::Unsynced");
@@ -193,6 +342,14 @@ void CTimeProfiler::ResetState() {
 	threadProfiles.resize(ThreadPool::GetMaxThreads());
 	#endif
 
+	{
+		std::lock_guard<spring::mutex> queuesLock(timerQueuesMutex);
+
+		for (TimerQueue& q: timerQueues) {
+			q.tail.store(q.head.load(std::memory_order_acquire), std::memory_order_release);
+		}
+	}
+
 	profileColorRNG.Seed(spring_tomsecs(lastBigUpdate = spring_gettime()));
 
 	currentPosition = 0;
@@ -213,14 +370,16 @@ void CTimeProfiler::ToggleLock(bool lock)
 
 void CTimeProfiler::Update()
 {
-	if (!enabled) {
+	Merge();
+
+	if (!IsRecording()) {
 		UpdateRaw();
 		ResortProfilesRaw();
 		RefreshProfilesRaw();
 		return;
 	}
 
-	// FIXME: non-locking threadsafe
+	// ProfileDrawer and full timer queues can still touch profiles concurrently
 	std::lock_guard<ProfileMutexType> lock(profileMutex);
 
 	if (sortingType != ST_ALPHABETICAL)
@@ -352,7 +511,7 @@ const CTimeProfiler::TimeRecord& CTimeProfiler::GetTimeRecord(const char* name)
 {
 	// if disabled, only special timers can pass AddTime
 	// all of those are non-threaded, so no need to lock
-	if (!enabled)
+	if (!IsRecording())
 		return (GetTimeRecordRaw(name));
 
 	std::lock_guard<ProfileMutexType> lock(profileMutex);
@@ -361,6 +520,133 @@ const CTimeProfiler::TimeRecord& CTimeProfiler::GetTimeRecord(const char* name)
 }
 
 
+void CTimeProfiler::Merge()
+{
+	std::lock_guard<ProfileMutexType> lock(profileMutex);
+
+	MergeRaw();
+}
+
+void CTimeProfiler::MergeRaw()
+{
+	const spring_time t0 = spring_now();
+
+	std::lock_guard<spring::mutex> queuesLock(timerQueuesMutex);
+	std::unique_lock<HashNamMutexType> namesLock(hashToNameMutex, std::defer_lock);
+
+	if (traceFile != nullptr)
+		namesLock.lock();
+
+	for (size_t i = 0; i < timerQueues.size(); i++) {
+		TimerQueue& q = timerQueues[i];
+
+		const uint32_t h = q.head.load(std::memory_order_acquire);
+		const uint32_t t = q.tail.load(std::memory_order_relaxed);
+
+		for (uint32_t j = t; j != h; j++) {
+			const TimerEvent& e = q.events[j % TimerQueue::NUM_EVENTS];
+
+			AddTimeRaw(e.nameHash, e.startTime, e.deltaTime, e.showGraph, e.threadTimer, e.threadNum);
+
+			if (traceFile == nullptr || e.startTime < traceStartTime)
+				continue;
+
+			char args[128];
+
+			if (!q.traceNamed) {
+				snprintf(args, sizeof(args), "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":%u,\"args\":{\"name\":", (traceNumEvents++ > 0)? ",\n": "", unsigned(i));
+
+				traceBuffer += args;
+				AppendTraceString(traceBuffer, q.threadName.c_str());
+				traceBuffer += "}}";
+
+				q.traceNamed = true;
+			}
+
+			const auto iter = hashToName.find(e.nameHash);
+			const char* name = (iter != hashToName.end())? iter->second.c_str(): "???";
+
+			traceBuffer += (traceNumEvents++ > 0)? ",\n{\"name\":": "{\"name\":";
+			AppendTraceString(traceBuffer, name);
+
+			snprintf(args, sizeof(args), ",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":0,\"tid\":%u}",
+				(e.startTime - traceStartTime).toNanoSecsi() * 1e-3,
+				e.deltaTime.toNanoSecsi() * 1e-3,
+				unsigned(i)
+			);
+
+			traceBuffer += args;
+		}
+
+		q.tail.store(h, std::memory_order_release);
+	}
+
+	if (namesLock.owns_lock())
+		namesLock.unlock();
+
+	if (traceBuffer.size() >= TRACE_BUFFER_SIZE)
+		FlushTraceBuffer();
+
+	AddTimeRaw(hashString("Misc::Profiler::Merge"), t0, spring_now() - t0, false, false, 0);
+}
+
+
+bool CTimeProfiler::StartTrace(const std::string& fileName)
+{
+	std::lock_guard<ProfileMutexType> lock(profileMutex);
+
+	if (traceFile != nullptr)
+		return false;
+
+	if ((traceFile = fopen(fileName.c_str(), "w")) == nullptr) {
+		LOG_L(L_ERROR, "[TimeProfiler::%s] could not open \"%s\"", __func__, fileName.c_str());
+		return false;
+	}
+
+	{
+		std::lock_guard<spring::mutex> queuesLock(timerQueuesMutex);
+
+		for (TimerQueue& q: timerQueues) {
+			q.traceNamed = false;
+		}
+	}
+
+	fputs("[\n", traceFile);
+
+	traceBuffer.clear();
+	traceBuffer.reserve(TRACE_BUFFER_SIZE + 4096);
+	traceStartTime = spring_gettime();
+	traceNumEvents = 0;
+	tracing = true;
+
+	LOG("[TimeProfiler::%s] writing timer trace to \"%s\"", __func__, fileName.c_str());
+	return true;
+}
+
+void CTimeProfiler::StopTrace()
+{
+	std::lock_guard<ProfileMutexType> lock(profileMutex);
+
+	if (traceFile == nullptr)
+		return;
+
+	// flush whatever is still queued while the file is open
+	MergeRaw();
+
+	tracing = false;
+
+	FlushTraceBuffer();
+	traceBuffer.shrink_to_fit();
+
+	fputs("\n]\n", traceFile);
+	fclose(traceFile);
+
+	traceFile = nullptr;
+
+	LOG("[TimeProfiler::%s] wrote %u trace events", __func__, unsigned(traceNumEvents));
+}
+
+
 void CTimeProfiler::AddTime(
 	const unsigned nameHash,
 	const spring_time startTime,
@@ -369,24 +655,25 @@ void CTimeProfiler::AddTime(
 	const bool specialTimer,
 	const bool threadTimer
 ) {
-	const spring_time t0 = spring_now();
+	// special timers contribute even when not recording, but are never threaded
+	if (!IsRecording() && !specialTimer)
+		return;
+
+	assert(!specialTimer || !threadTimer);
 
-	if (!enabled) {
-		if (!specialTimer)
-			return;
+	const TimerEvent event = {nameHash, GetProfilerThreadNum(), startTime, deltaTime, showGraph, threadTimer};
 
-		assert(!threadTimer);
-		AddTimeRaw(nameHash, startTime, deltaTime, showGraph, threadTimer);
-		AddTimeRaw(hashString("Misc::Profiler::AddTime"), t0, spring_now() - t0, false, false);
+	TimerQueue& queue = GetTimerQueue();
+
+	if (queue.Push(event))
 		return;
-	}
 
-	// acquire lock at the start; one inserting thread could
-	// cause a profile rehash and invalidate <pi> for another
+	// queue is full because nothing merged it in a while (e.g. during
+	// loading or while catching up); drain all queues from this thread
 	std::lock_guard<ProfileMutexType> lock(profileMutex);
 
-	AddTimeRaw(nameHash, startTime, deltaTime, showGraph, threadTimer);
-	AddTimeRaw(hashString("Misc::Profiler::AddTime"), t0, spring_now() - t0, false, false);
+	MergeRaw();
+	queue.Push(event);
 }
 
 void CTimeProfiler::AddTimeRaw(
@@ -394,11 +681,12 @@ void CTimeProfiler::AddTimeRaw(
 	const spring_time startTime,
 	const spring_time deltaTime,
 	const bool showGraph,
-	const bool threadTimer
+	const bool threadTimer,
+	const int threadNum
 ) {
 #ifdef THREADPOOL
-	if (threadTimer)
-		threadProfiles[ThreadPool::GetThreadNum()].emplace_back(startTime, spring_gettime());
+	if (threadTimer && size_t(threadNum) < threadProfiles.size())
+		threadProfiles[threadNum].emplace_back(startTime, startTime + deltaTime);
 #endif
 
 	auto pi = profiles.find(nameHash);
@@ -181,6 +181,8 @@ public:
 
 	void Update();
 	void UpdateRaw();
+	/// moves the timings queued by every thread into the profiles; once per frame
+	void Merge();
 
 	void ResortProfilesRaw();
 	void RefreshProfiles();
@@ -190,6 +192,17 @@ public:
 	void SetEnabled(bool b) { enabled = b; }
 	void PrintProfilingInfo() const;
 
+	bool IsRecording() const { return (enabled || tracing); }
+	bool IsTracing() const { return tracing; }
+
+	/**
+	 * write every timing merged from now on to <fileName> as Chrome
+	 * trace events (chrome://tracing, ui.perfetto.dev), one row per
+	 * thread; does not need the ProfileDrawer nor Tracy
+	 */
+	bool StartTrace(const std::string& fileName);
+	void StopTrace();
+
 	void AddTime(
 		unsigned nameHash,
 		const spring_time startTime,
@@ -203,10 +216,13 @@ public:
 		const spring_time startTime,
 		const spring_time deltaTime,
 		const bool showGraph,
-		const bool threadTimer
+		const bool threadTimer,
+		const int threadNum
 	);
 
 private:
+	void MergeRaw();
+
 	SortType sortingType = SortType::ST_ALPHABETICAL;
 	spring::unordered_map<unsigned, TimeRecord> profiles;
 
@@ -219,8 +235,9 @@ private:
 	unsigned currentPosition;
 	unsigned resortProfiles;
 
-	// if false, AddTime is a no-op for (almost) all timers
+	// if both are false, AddTime is a no-op for (almost) all timers
 	std::atomic<bool> enabled;
+	std::atomic<bool> tracing{false};
 };
 
 
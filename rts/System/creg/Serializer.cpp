@@ -18,7 +18,6 @@
 #include <fstream>
 #include <cassert>
 #include <stdexcept>
-#include <map>
 #include <vector>
 #include <string>
 #include <cstring>
@@ -26,7 +25,6 @@
 
 using namespace creg;
 using std::string;
-using std::map;
 using std::vector;
 
 LOG_REGISTER_SECTION_GLOBAL(LOG_SECTION_CREG_SERIALIZER)
@@ -82,11 +80,19 @@ static void WriteZStr(std::ostream& file, const std::string& str)
 template<typename T>
 void ReadVarSizeUInt(std::istream* stream, T* buf)
 {
+	// go through the streambuf directly, istream::read has to construct a sentry per byte
+	std::streambuf* sbuf = stream->rdbuf();
 	std::uint64_t val = 0;
 	unsigned offset = 0;
 	while (true) {
-		unsigned char a;
-		stream->read((char*)&a, sizeof(char));
+		const int c = sbuf->sbumpc();
+
+		if (c == std::char_traits<char>::eof()) {
+			stream->setstate(std::ios::eofbit | std::ios::failbit);
+			break;
+		}
+
+		const unsigned char a = c;
 
 		val += ((std::uint64_t)(a & 0x7F)) << offset;
 		if ((a & 0x80) == 0)
@@ -101,6 +107,10 @@ void ReadVarSizeUInt(std::istream* stream, T* buf)
 template<typename T>
 void WriteVarSizeUInt(std::ostream* stream, T val)
 {
+	// 64 bits need at most 10 groups of 7
+	char bytes[10];
+	unsigned numBytes = 0;
+
 	std::uint64_t v = val;
 	do {
 		unsigned char a = v & 0x7F;
@@ -109,8 +119,10 @@ void WriteVarSizeUInt(std::ostream* stream, T val)
 		if (v > 0)
 			a |= 0x80;
 
-		stream->write((char*)&a, sizeof(char));
+		bytes[numBytes++] = a;
 	} while (v > 0);
+
+	stream->write(bytes, numBytes);
 }
 
 void creg::ReadUInt(std::istream* stream, std::uint64_t* buf)
@@ -136,26 +148,47 @@ bool COutputStreamSerializer::IsWriting()
 	return true;
 }
 
-COutputStreamSerializer::ObjectRef* COutputStreamSerializer::FindObjectRef(void* inst, creg::Class* objClass, bool isEmbedded)
+int COutputStreamSerializer::FindObjectRef(void* inst, creg::Class* objClass, bool isEmbedded) const
 {
-	std::vector<ObjectRef*>& refs = ptrToId[inst];
-	for (auto& obj: refs) {
-		if (obj->isThisObject(inst, objClass, isEmbedded))
-			return obj;
+	const auto it = ptrToId.find(inst);
+
+	if (it == ptrToId.end())
+		return 0;
+
+	for (int id = it->second; id != 0; id = objects[id].nextRefID) {
+		if (objects[id].isThisObject(inst, objClass, isEmbedded))
+			return id;
 	}
-	return nullptr;
+	return 0;
 }
 
-void COutputStreamSerializer::SerializeObject(Class* c, void* ptr, ObjectRef* objr)
+int COutputStreamSerializer::AddObjectRef(void* inst, creg::Class* objClass, bool isEmbedded)
 {
-	const unsigned objstart = stream->tellp();
+	const int newID = objects.size();
+	objects.emplace_back(inst, newID, isEmbedded, objClass);
 
-	if (c->base())
-		SerializeObject(c->base(), ptr, objr);
+	const auto it = ptrToId.find(inst);
+
+	if (it == ptrToId.end()) {
+		ptrToId[inst] = newID;
+		return newID;
+	}
 
-	ObjectMemberGroup omg;
-	omg.membersClass = c;
-	omg.size = 0;
+	// append, lookups must see refs at the same address in creation order
+	int id = it->second;
+	while (objects[id].nextRefID != 0)
+		id = objects[id].nextRefID;
+
+	objects[id].nextRefID = newID;
+	return newID;
+}
+
+void COutputStreamSerializer::SerializeObject(Class* c, void* ptr)
+{
+	const unsigned objstart = logDebug? unsigned(stream->tellp()): 0u;
+
+	if (c->base())
+		SerializeObject(c->base(), ptr);
 
 	for (uint a = 0; a < c->members.size(); a++)
 	{
@@ -163,82 +196,67 @@ void COutputStreamSerializer::SerializeObject(Class* c, void* ptr, ObjectRef* ob
 		if (m->flags & CM_NoSerialize)
 			continue;
 
-		ObjectMember om;
-		om.member = m;
-		om.memberId = a;
 		void* memberAddr = ((char*)ptr) + m->offset;
+
+		if (!logDebug) {
+			m->type->Serialize(this, memberAddr);
+			continue;
+		}
+
 		unsigned mstart = stream->tellp();
 		LOG_SL(LOG_SECTION_CREG_SERIALIZER, L_DEBUG, "Serialized %s::%s type:%s", c->name, m->name, m->type->GetName().c_str());
 		m->type->Serialize(this, memberAddr);
 		unsigned mend = stream->tellp();
-		om.size = mend - mstart;
-		omg.members.push_back(om);
-		omg.size += om.size;
-		LOG_SL(LOG_SECTION_CREG_SERIALIZER, L_DEBUG, "Serialized %s::%s type:%s size:%d", c->name, m->name, m->type->GetName().c_str(), om.size);
+		LOG_SL(LOG_SECTION_CREG_SERIALIZER, L_DEBUG, "Serialized %s::%s type:%s size:%d", c->name, m->name, m->type->GetName().c_str(), int(mend - mstart));
 	}
 
 
-	if (c->HasSerialize()) {
-		ObjectMember om;
-		om.member = nullptr;
-		om.memberId = -1;
-		unsigned mstart = stream->tellp();
+	if (c->HasSerialize())
 		c->CallSerializeProc(ptr, this);
-		unsigned mend = stream->tellp();
-		om.size = mend - mstart;
-		omg.members.push_back(om);
-		omg.size += om.size;
-	}
 
-	objr->memberGroups.push_back(omg);
+	if (!logDebug)
+		return;
 
 	const unsigned objend = stream->tellp();
-	const int sz = objend - objstart;
-	classSizes[c] += sz;
-	classCounts[c]++;
+	ClassStats& stats = classStats[c];
+	stats.size += (objend - objstart);
+	stats.count += 1;
 }
 
 void COutputStreamSerializer::SerializeObjectInstance(void* inst, creg::Class* objClass)
 {
 	// register the object, and mark it as embedded if a pointer was already referencing it
-	ObjectRef* obj = FindObjectRef(inst, objClass, true);
-	if (!obj) {
-		objects.emplace_back(inst, objects.size(), true, objClass);
-		obj = &objects.back();
-		ptrToId[inst].push_back(obj);
-	} else if (obj->isEmbedded) {
+	int id = FindObjectRef(inst, objClass, true);
+	if (id == 0) {
+		id = AddObjectRef(inst, objClass, true);
+	} else if (objects[id].isEmbedded) {
 		throw std::string("Reserialization of embedded object (") + objClass->name + ")";
-	} else {
-		std::vector<ObjectRef*>::iterator it = std::find(pendingObjects.begin(), pendingObjects.end(), obj);
-		if (it == pendingObjects.end()) {
-			throw std::string("Object pointer was serialized (") + objClass->name + ")";
-		} else {
-			pendingObjects.erase(it);
-		}
+	} else if (!objects[id].isPending) {
+		throw std::string("Object pointer was serialized (") + objClass->name + ")";
 	}
-	obj->class_ = objClass;
-	obj->isEmbedded = true;
+
+	ObjectRef& obj = objects[id];
+	obj.class_ = objClass;
+	obj.isEmbedded = true;
+	obj.isPending = false;
 
 	// write an object ID
-	WriteVarSizeUInt(stream, obj->id);
+	WriteVarSizeUInt(stream, id);
 
 	// write the object
-	SerializeObject(objClass, inst, obj);
+	SerializeObject(objClass, inst);
 }
 
 void COutputStreamSerializer::SerializeObjectPtr(void** ptr, creg::Class* objClass)
 {
 	if (*ptr) {
 		// valid pointer, write a one and the object ID
-		int id;
-		ObjectRef* obj = FindObjectRef(*ptr, objClass, false);
-		if (!obj) {
-			objects.emplace_back(*ptr, objects.size(), false, objClass);
-			obj = &objects.back();
-			ptrToId[*ptr].push_back(obj);
-			pendingObjects.push_back(obj);
+		int id = FindObjectRef(*ptr, objClass, false);
+		if (id == 0) {
+			id = AddObjectRef(*ptr, objClass, false);
+			objects[id].isPending = true;
+			pendingObjects.push_back(id);
 		}
-		id = obj->id;
 
 		WriteVarSizeUInt(stream, id);
 	} else {
@@ -271,17 +289,13 @@ void COutputStreamSerializer::SerializeInt(void* data, int byteSize)
 }
 
 
-struct COutputStreamSerializer::ClassRef
-{
-	int index;
-	creg::Class* class_;
-};
-
 void COutputStreamSerializer::SavePackage(std::ostream* s, void* rootObj, Class* rootObjClass)
 {
 	PackageHeader ph;
 
 	stream = s;
+	logDebug = LOG_IS_ENABLED_S(LOG_SECTION_CREG_SERIALIZER, L_DEBUG) || LOG_IS_ENABLED(L_DEBUG);
+
 	unsigned startOffset = stream->tellp();
 	stream->write((char*)&ph, sizeof(PackageHeader));
 	stream->seekp(startOffset + sizeof(PackageHeader));
@@ -289,59 +303,69 @@ void COutputStreamSerializer::SavePackage(std::ostream* s, void* rootObj, Class*
 
 	// Insert dummy object with id 0
 	objects.emplace_back(nullptr, 0, true, nullptr);
-	ObjectRef* obj = &objects.back();
-	obj->classIndex = 0;
 
 	// Insert the first object that will provide references to everything
-	objects.emplace_back(rootObj, objects.size(), false, rootObjClass);
-	obj = &objects.back();
-	ptrToId[rootObj].push_back(obj);
-	pendingObjects.push_back(obj);
+	const int rootID = AddObjectRef(rootObj, rootObjClass, false);
+	objects[rootID].isPending = true;
+	pendingObjects.push_back(rootID);
 
 	// Save until all the referenced objects have been stored
 	while (!pendingObjects.empty())
 	{
-		const std::vector<ObjectRef*> po = pendingObjects;
+		// objects embedded since they were queued are skipped; the
+		// remainder counts as being saved while the batch is in flight
+		pendingBatch.clear();
+
+		for (const int id: pendingObjects) {
+			if (!objects[id].isPending)
+				continue;
+
+			objects[id].isPending = false;
+			pendingBatch.push_back(id);
+		}
+
 		pendingObjects.clear();
 
-		for (ObjectRef* obj: po) {
-			SerializeObject(obj->class_, obj->ptr, obj);
-			//LOG_SL(LOG_SECTION_CREG_SERIALIZER, L_DEBUG, "Serialized %s size:%i", obj->class_->name.c_str(), sz);
+		for (const int id: pendingBatch) {
+			// not a reference, objects may be reallocated while serializing
+			const ObjectRef obj = objects[id];
+			SerializeObject(obj.class_, obj.ptr);
 		}
 	}
 
 	// Collect a set of all used classes
-	std::map<creg::Class*, ClassRef> classMap;
-	std::vector<ClassRef*> classRefs;
+	spring::unsynced_map<creg::Class*, int, PtrHash> classIndices;
+	std::vector<creg::Class*> classRefs;
 	for (ObjectRef& oRef: objects) {
 		if (oRef.ptr == nullptr)
 			continue;
 
-		creg::Class* c = oRef.class_;
-		while (c) {
-			std::map<creg::Class*, ClassRef>::iterator cr = classMap.find(c);
-			if (cr == classMap.end()) {
-				ClassRef* pRef = &classMap[c];
-				pRef->index = classRefs.size();
-				pRef->class_ = c;
-				classRefs.push_back(pRef);
-			}
-			c = c->base();
+		// a known class implies all its bases are known too
+		const auto cit = classIndices.find(oRef.class_);
+
+		if (cit != classIndices.end()) {
+			oRef.classIndex = cit->second;
+			continue;
 		}
 
-		std::map<creg::Class*, ClassRef>::iterator cr = classMap.find(oRef.class_);
-		oRef.classIndex = cr->second.index;
+		for (creg::Class* c = oRef.class_; c != nullptr; c = c->base()) {
+			if (classIndices.find(c) != classIndices.end())
+				continue;
+
+			classIndices[c] = classRefs.size();
+			classRefs.push_back(c);
+		}
+
+		oRef.classIndex = classIndices[oRef.class_];
 	}
 
 
 	if (LOG_IS_ENABLED(L_DEBUG)) {
-		for (auto &it: classSizes) {
+		for (const auto& it: classStats) {
 			LOG_L(L_DEBUG, "%30s %10u %10u",
 					it.first->name,
-					classCounts[it.first],
-					it.second);
-			it.second = 0;
-			classCounts[it.first] = 0;
+					it.second.count,
+					it.second.size);
 		}
 	}
 
@@ -349,8 +373,7 @@ void COutputStreamSerializer::SavePackage(std::ostream* s, void* rootObj, Class*
 	// Write the class references & calc their checksum
 	ph.numObjClassRefs = classRefs.size();
 	ph.objClassRefOffset = (int)stream->tellp();
-	for (auto& classRef: classRefs) {
-		Class* c = classRef->class_;
+	for (Class* c: classRefs) {
 		WriteZStr(*stream, c->name);
 	};
 
@@ -373,17 +396,15 @@ void COutputStreamSerializer::SavePackage(std::ostream* s, void* rootObj, Class*
 			const auto it = ptrToId.find(container);
 			if (container == nullptr || it == ptrToId.end())
 				throw std::string("Preallocation container of (") + oRef.class_->name + ") doesn't exist";
-			ObjectRef* objCont = it->second.front();
 			// write container ID and offset of placement-new location
-			WriteVarSizeUInt(stream, objCont->id);
+			WriteVarSizeUInt(stream, it->second);
 			WriteVarSizeUInt(stream, (char*)oRef.ptr - (char*)container);
 		}
 	}
 
 	// Calculate a checksum for metadata verification
 	ph.metadataChecksum = 0;
-	for (auto& classRef: classRefs) {
-		Class* c = classRef->class_;
+	for (Class* c: classRefs) {
 		c->CalculateChecksum(ph.metadataChecksum);
 	}
 
@@ -400,8 +421,9 @@ void COutputStreamSerializer::SavePackage(std::ostream* s, void* rootObj, Class*
 	stream->seekp(endOffset);
 	ptrToId.clear();
 	pendingObjects.clear();
+	pendingBatch.clear();
 	objects.clear();
-	classSizes.clear();
+	classStats.clear();
 }
 
 //-------------------------------------------------------------------------
@@ -569,11 +591,12 @@ void CInputStreamSerializer::LoadPackage(std::istream* s, void*& root, creg::Cla
 	objects.resize(ph.numObjects);
 
 	struct PreallocObj {
-		size_t size;
+		int objID;
 		int contID;
+		size_t size;
 		size_t offset;
 	};
-	std::map<int, PreallocObj> preallocObjs;  // objID -> PreallocObj
+	std::vector<PreallocObj> preallocObjs;  // sorted by objID
 
 	for (int a = 0; a < ph.numObjects; a++) {
 		unsigned int classRefIndex;
@@ -593,11 +616,12 @@ void CInputStreamSerializer::LoadPackage(std::istream* s, void*& root, creg::Cla
 
 			if (c->HasPrealloc()) {
 				PreallocObj po;
+				po.objID = a;
 				po.size = size;
 				ReadVarSizeUInt(stream, &po.contID);
 				ReadVarSizeUInt(stream, &po.offset);
 				// Postpone objects with placement-new
-				preallocObjs[a] = po;
+				preallocObjs.push_back(po);
 			} else {
 				// Allocate and construct
 				objects[a].obj = c->CreateInstance(size);
@@ -608,21 +632,29 @@ void CInputStreamSerializer::LoadPackage(std::istream* s, void*& root, creg::Cla
 		objects[a].classRef = classRefIndex;
 	}
 
-	size_t numPreallocs = 0;  // in case of nested preallocation containers
-	while (numPreallocs != preallocObjs.size()) {
+	// in case of nested preallocation containers, keep going while progress is made
+	for (size_t numPreallocs = 0; numPreallocs != preallocObjs.size(); ) {
 		numPreallocs = preallocObjs.size();
-		const auto pro = preallocObjs;
-		for (const auto& kv : pro) {
-			const PreallocObj& po = kv.second;
+
+		size_t numPending = 0;
+
+		for (size_t i = 0; i < numPreallocs; i++) {
+			const PreallocObj& po = preallocObjs[i];
 			void* container = objects[po.contID].obj;
-			if (container == nullptr)  // parent container wasn't created yet
+
+			if (container == nullptr) {
+				// parent container wasn't created yet
+				preallocObjs[numPending++] = po;
 				continue;
-			StoredObject& so = objects[kv.first];
+			}
+
+			StoredObject& so = objects[po.objID];
 			Class* c = classRefs[so.classRef];
 			// Allocate with placement-new and construct
 			so.obj = c->CreateInstance(po.size, (char*)container + po.offset);
-			preallocObjs.erase(kv.first);
 		}
+
+		preallocObjs.resize(numPending);
 	}
 	if (!preallocObjs.empty())
 		throw std::string("Placement-new error: Referencing non-serialized container");
@@ -8,10 +8,11 @@
 
 #ifdef USING_CREG
 
-#include <map>
-#include <vector>
-#include <deque>
+#include <cstdint>
 #include <istream>
+#include <vector>
+
+#include "System/UnorderedMap.hpp"
 
 namespace creg {
 
@@ -23,43 +24,23 @@ namespace creg {
 	class COutputStreamSerializer : public ISerializer
 	{
 	protected:
-		struct ObjectMember {
-			Class::Member* member;
-			int memberId;
-			int size;
-		};
-		struct ObjectMemberGroup {
-			Class* membersClass;
-			std::vector<COutputStreamSerializer::ObjectMember> members;
-			int size;
-		};
 		struct ObjectRef {
-			ObjectRef() {
-				ptr = 0;
-				id=0;
-				classIndex=0;
-				isEmbedded=false;
-				class_=0;
-			}
-			ObjectRef(void* ptr, int id, bool isEmbedded, Class* class_) {
-				this->ptr = ptr;
-				this->id=id;
-				classIndex=0;
-				this->isEmbedded=isEmbedded;
-				this->class_=class_;
-			}
-			ObjectRef(const ObjectRef&src) :memberGroups(src.memberGroups){
-				ptr=src.ptr;
-				id=src.id;
-				classIndex=src.classIndex;
-				isEmbedded=src.isEmbedded;
-				class_=src.class_;
-			}
-			void* ptr;
-			int id, classIndex;
-			bool isEmbedded;
-			Class* class_;
-			std::vector<COutputStreamSerializer::ObjectMemberGroup> memberGroups;
+			ObjectRef() = default;
+			ObjectRef(void* ptr, int id, bool isEmbedded, Class* class_)
+				: ptr(ptr)
+				, class_(class_)
+				, id(id)
+				, isEmbedded(isEmbedded)
+			{}
+
+			void* ptr = nullptr;
+			Class* class_ = nullptr;
+			int id = 0;
+			int classIndex = 0;
+			int nextRefID = 0; ///< next ObjectRef at the same address (e.g. a member at offset 0), 0 ends the chain
+			bool isEmbedded = false;
+			bool isPending = false; ///< referenced by pointer, not yet saved
+
 			bool isThisObject(void* objPtr, Class* objClass, bool objEmbedded) const
 			{
 				if (ptr != objPtr) return false;
@@ -77,24 +58,45 @@ namespace creg {
 			}
 		};
 
-		// Temporary class reference
-		struct ClassRef;
+		struct PtrHash {
+			size_t operator()(const void* p) const {
+				// objects are at least 8-byte aligned, mix the address before masking
+				std::uint64_t x = reinterpret_cast<std::uintptr_t>(p);
+				x ^= (x >> 33);
+				x *= 0xff51afd7ed558ccdULL;
+				x ^= (x >> 33);
+				return static_cast<size_t>(x);
+			}
+		};
+
+		struct ClassStats {
+			int size = 0;
+			int count = 0;
+		};
 
 		std::ostream* stream;
-		std::map<void*,std::vector<ObjectRef*> > ptrToId;
-		std::deque<ObjectRef> objects;
-		std::vector<ObjectRef*> pendingObjects; // these objects still have to be saved
-		std::map<Class*, int> classSizes;
-		std::map<Class*, int> classCounts;
+
+		/// address -> ID of the first ObjectRef at that address
+		spring::unsynced_map<void*, int, PtrHash> ptrToId;
+		/// indexed by object ID; ID 0 is a dummy that also means "no object"
+		std::vector<ObjectRef> objects;
+		/// IDs of objects that still have to be saved
+		std::vector<int> pendingObjects;
+		std::vector<int> pendingBatch;
+
+		spring::unsynced_map<Class*, ClassStats, PtrHash> classStats;
+
+		bool logDebug = false;
 
 		// Serialize all class names
 		void WriteObjectInfo();
 		// Helper for instance/ptr saving
 		void WriteObjectRef(void* inst, Class* cls, bool embedded);
 
-		ObjectRef* FindObjectRef(void* inst, Class* objClass, bool isEmbedded);
+		int FindObjectRef(void* inst, Class* objClass, bool isEmbedded) const;
+		int AddObjectRef(void* inst, Class* objClass, bool isEmbedded);
 
-		void SerializeObject(Class* c, void* ptr, ObjectRef* objr);
+		void SerializeObject(Class* c, void* ptr);
 
 	public:
 		COutputStreamSerializer();
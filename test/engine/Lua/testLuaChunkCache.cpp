@@ -0,0 +1,256 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include "Lua/LuaChunkCache.h"
+
+#include "lib/lua/include/lua.h"
+#include "lib/lua/include/lualib.h"
+#include "lib/lua/include/lauxlib.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <catch_amalgamated.hpp>
+
+namespace fs = std::filesystem;
+
+
+static const std::string CODE_A = "local x = ... return (x or 1) * 6 + 0.5";
+static const std::string CODE_B = "local x = ... return (x or 1) * 7 + 0.5";
+
+// a fresh empty cache directory per test case
+static std::string MakeCacheDir()
+{
+	const fs::path dir = fs::temp_directory_path() / "testLuaChunkCache";
+
+	fs::remove_all(dir);
+	fs::create_directories(dir);
+
+	return (dir.string() + "/");
+}
+
+static std::vector<fs::path> ListFiles(const std::string& dir, const std::string& ext)
+{
+	std::vector<fs::path> files;
+
+	for (const fs::directory_entry& entry: fs::directory_iterator(dir)) {
+		if (entry.path().extension() == ext)
+			files.push_back(entry.path());
+	}
+
+	return files;
+}
+
+// loads <code> through the cache and returns the value the chunk computes
+static double Run(const std::string& dir, const std::string& code, const std::string& name)
+{
+	lua_State* L = luaL_newstate();
+	luaL_openlibs(L);
+
+	REQUIRE(LuaChunkCache::LoadBuffer(L, code, name, dir) == 0);
+	REQUIRE(lua_pcall(L, 0, 1, 0) == 0);
+
+	const double result = lua_tonumber(L, -1);
+	lua_close(L);
+	return result;
+}
+
+static void WriteFile(const fs::path& path, const std::vector<char>& data)
+{
+	std::ofstream file(path, std::ios::binary | std::ios::trunc);
+	file.write(data.data(), data.size());
+}
+
+static std::vector<char> ReadFile(const fs::path& path)
+{
+	std::ifstream file(path, std::ios::binary);
+	return {std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+}
+
+
+TEST_CASE("LuaChunkCache_KeyInvalidation")
+{
+	const std::string dir = MakeCacheDir();
+
+	LuaChunkCache::ResetStats();
+
+	SECTION("unchanged source is a hit") {
+		CHECK(Run(dir, CODE_A, "a.lua") == 6.5);
+		CHECK(Run(dir, CODE_A, "a.lua") == 6.5);
+
+		const LuaChunkCache::Stats stats = LuaChunkCache::GetStats();
+		CHECK(stats.misses == 1);
+		CHECK(stats.stores == 1);
+		CHECK(stats.hits == 1);
+		CHECK(ListFiles(dir, ".luac").size() == 1);
+	}
+
+	SECTION("changed source or name is a miss") {
+		CHECK(Run(dir, CODE_A, "a.lua") == 6.5);
+		CHECK(Run(dir, CODE_B, "a.lua") == 7.5);
+		CHECK(Run(dir, CODE_A, "b.lua") == 6.5);
+
+		const LuaChunkCache::Stats stats = LuaChunkCache::GetStats();
+		CHECK(stats.misses == 3);
+		CHECK(stats.hits == 0);
+		CHECK(ListFiles(dir, ".luac").size() == 3);
+	}
+
+	SECTION("the chunk name is kept") {
+		lua_State* L = luaL_newstate();
+		luaL_openlibs(L);
+
+		for (int i = 0; i < 2; i++) {
+			REQUIRE(LuaChunkCache::LoadBuffer(L, "error('boom')", "named.lua", dir) == 0);
+			REQUIRE(lua_pcall(L, 0, 0, 0) != 0);
+			CHECK(std::string(lua_tostring(L, -1)).find("named.lua") != std::string::npos);
+			lua_pop(L, 1);
+		}
+
+		lua_close(L);
+		CHECK(LuaChunkCache::GetStats().hits == 1);
+	}
+
+	SECTION("syntax errors are not cached") {
+		lua_State* L = luaL_newstate();
+
+		CHECK(LuaChunkCache::LoadBuffer(L, "return (", "broken.lua", dir) != 0);
+		lua_close(L);
+
+		CHECK(LuaChunkCache::GetStats().stores == 0);
+		CHECK(ListFiles(dir, ".luac").empty());
+	}
+
+	SECTION("mismatching or damaged entries are rejected and replaced") {
+		CHECK(Run(dir, CODE_A, "a.lua") == 6.5);
+
+		const std::vector<fs::path> files = ListFiles(dir, ".luac");
+		REQUIRE(files.size() == 1);
+
+		const std::vector<char> valid = ReadFile(files[0]);
+		REQUIRE(valid.size() > 40);
+
+		// header fields: magic, format, compiler hash, source size, source hash
+		for (const size_t offset: {0, 4, 8, 16, 24}) {
+			std::vector<char> data = valid;
+			data[offset] ^= 0x5a;
+			WriteFile(files[0], data);
+
+			CHECK(Run(dir, CODE_A, "a.lua") == 6.5);
+			CHECK(ReadFile(files[0]) == valid);
+		}
+
+		// truncated bytecode, and no bytecode at all
+		for (const size_t size: {valid.size() - 8, size_t(32)}) {
+			WriteFile(files[0], {valid.begin(), valid.begin() + size});
+
+			CHECK(Run(dir, CODE_A, "a.lua") == 6.5);
+			CHECK(ReadFile(files[0]) == valid);
+		}
+
+		const LuaChunkCache::Stats stats = LuaChunkCache::GetStats();
+		CHECK(stats.hits == 0);
+		CHECK(stats.rejects == 7);
+		CHECK(stats.stores == 8);
+	}
+}
+
+TEST_CASE("LuaChunkCache_AtomicWrite")
+{
+	const std::string dir = MakeCacheDir();
+
+	LuaChunkCache::ResetStats();
+
+	// every loader misses and stores the same chunk at once; readers must
+	// only ever see a complete entry and no temporary file may be left
+	std::vector<std::thread> threads;
+	std::vector<double> results(8, 0.0);
+
+	for (size_t i = 0; i < results.size(); i++) {
+		threads.emplace_back([&, i]() {
+			for (int n = 0; n < 20; n++) {
+				lua_State* L = luaL_newstate();
+
+				if (LuaChunkCache::LoadBuffer(L, CODE_B, "b.lua", dir) == 0 && lua_pcall(L, 0, 1, 0) == 0)
+					results[i] += lua_tonumber(L, -1);
+
+				lua_close(L);
+			}
+		});
+	}
+
+	for (std::thread& t: threads) {
+		t.join();
+	}
+
+	for (const double result: results) {
+		CHECK(result == 20 * 7.5);
+	}
+
+	const LuaChunkCache::Stats stats = LuaChunkCache::GetStats();
+	CHECK(stats.rejects == 0);
+	CHECK(stats.hits + stats.misses == results.size() * 20);
+	CHECK(ListFiles(dir, ".luac").size() == 1);
+	CHECK(ListFiles(dir, ".tmp").empty());
+}
+
+TEST_CASE("LuaChunkCache_Prune")
+{
+	const std::string dir = MakeCacheDir();
+	const auto now = fs::file_time_type::clock::now();
+
+	std::vector<std::string> codes;
+
+	for (int i = 0; i < 6; i++) {
+		codes.push_back("return " + std::to_string(i));
+		Run(dir, codes.back(), "prune.lua");
+	}
+
+	std::vector<fs::path> files = ListFiles(dir, ".luac");
+	REQUIRE(files.size() == codes.size());
+
+	// give the entries distinct ages, in no particular order
+	for (size_t i = 0; i < files.size(); i++) {
+		fs::last_write_time(files[i], now - std::chrono::hours(1 + (i * 5) % files.size()));
+	}
+
+	// leftovers of an interrupted write count as oldest entries
+	WriteFile(fs::path(dir) / "0123456789abcdef.luac.42.tmp", std::vector<char>(16, 'x'));
+	fs::last_write_time(fs::path(dir) / "0123456789abcdef.luac.42.tmp", now - std::chrono::hours(100));
+
+	// unrelated files are never touched
+	WriteFile(fs::path(dir) / "other.txt", std::vector<char>(4096, 'x'));
+	fs::last_write_time(fs::path(dir) / "other.txt", now - std::chrono::hours(200));
+
+	// loading an entry makes it the most recently used one
+	Run(dir, codes[0], "prune.lua");
+
+	uint64_t entrySize = 0;
+
+	for (const fs::path& file: files) {
+		entrySize = std::max<uint64_t>(entrySize, fs::file_size(file));
+	}
+
+	LuaChunkCache::Prune(dir, entrySize * 2);
+
+	const std::vector<fs::path> kept = ListFiles(dir, ".luac");
+	REQUIRE(kept.size() == 2);
+	CHECK(ListFiles(dir, ".tmp").empty());
+	CHECK(fs::exists(fs::path(dir) / "other.txt"));
+
+	// the youngest untouched entry plus the one that was just used
+	LuaChunkCache::ResetStats();
+	Run(dir, codes[0], "prune.lua");
+	CHECK(LuaChunkCache::GetStats().hits == 1);
+
+	// nothing to do when below the limit
+	LuaChunkCache::Prune(dir, entrySize * 2);
+	CHECK(ListFiles(dir, ".luac").size() == 2);
+
+	fs::remove_all(dir);
+}
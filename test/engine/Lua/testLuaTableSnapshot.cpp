@@ -0,0 +1,223 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include "Lua/LuaTableSnapshot.h"
+
+#include "lib/lua/include/lua.h"
+#include "lib/lua/include/lualib.h"
+#include "lib/lua/include/lauxlib.h"
+
+#include <string>
+#include <vector>
+
+#include <catch_amalgamated.hpp>
+
+
+static lua_State* NewState()
+{
+	lua_State* L = luaL_newstate();
+	luaL_openlibs(L);
+	return L;
+}
+
+static bool RunString(lua_State* L, const char* code)
+{
+	return (luaL_dostring(L, code) == 0);
+}
+
+// lists the keys of a table (and of its subtables) in pairs() order
+static const char* ITERATION_ORDER_FUNC = R"(
+	function iterationOrder(t)
+		local keys = {}
+		for k, v in pairs(t) do
+			keys[#keys + 1] = tostring(k)
+			if type(v) == "table" then keys[#keys + 1] = "{" .. iterationOrder(v) .. "}" end
+		end
+		return table.concat(keys, ",")
+	end
+)";
+
+static std::string IterationOrder(lua_State* L, const char* name)
+{
+	lua_getglobal(L, "iterationOrder");
+	lua_getglobal(L, name);
+	REQUIRE(lua_pcall(L, 1, 1, 0) == 0);
+
+	std::string order = lua_tostring(L, -1);
+	lua_pop(L, 1);
+	return order;
+}
+
+static std::vector<std::uint8_t> SnapshotGlobal(lua_State* L, const char* name)
+{
+	std::vector<std::uint8_t> data;
+
+	lua_getglobal(L, name);
+	CHECK(LuaTableSnapshot::Write(L, -1, data));
+	lua_pop(L, 1);
+
+	return data;
+}
+
+
+TEST_CASE("LuaTableSnapshot")
+{
+	lua_State* L = NewState();
+
+	SECTION("round trip preserves values") {
+		REQUIRE(RunString(L, R"(
+			src = {
+				1, 2.5, -3, "four", true, false,
+				name = "armcom",
+				["with\0zero"] = "a\0b",
+				[0.125] = "float key",
+				[false] = 7,
+				nested = {customparams = {a = "1", b = "2"}, list = {10, 20, 30}},
+				empty = {},
+			}
+		)"));
+
+		const std::vector<std::uint8_t> data = SnapshotGlobal(L, "src");
+		const int top = lua_gettop(L);
+
+		REQUIRE(LuaTableSnapshot::Read(L, data.data(), data.size()));
+		CHECK(lua_gettop(L) == top + 1);
+		lua_setglobal(L, "dst");
+
+		REQUIRE(RunString(L, R"(
+			local function equal(a, b)
+				if type(a) ~= type(b) then return false end
+				if type(a) ~= "table" then return a == b end
+				for k, v in pairs(a) do if not equal(v, b[k]) then return false end end
+				for k, v in pairs(b) do if a[k] == nil then return false end end
+				return true
+			end
+			assert(equal(src, dst))
+			assert(#dst == 6)
+			assert(dst["with\0zero"] == "a\0b")
+		)"));
+	}
+
+	SECTION("round trip preserves shared and cyclic references") {
+		REQUIRE(RunString(L, R"(
+			local shared = {x = 1}
+			src = {a = shared, b = shared}
+			src.self = src
+		)"));
+
+		const std::vector<std::uint8_t> data = SnapshotGlobal(L, "src");
+
+		REQUIRE(LuaTableSnapshot::Read(L, data.data(), data.size()));
+		lua_setglobal(L, "dst");
+
+		REQUIRE(RunString(L, R"(
+			assert(dst.a == dst.b)
+			assert(dst.a ~= src.a)
+			assert(dst.self == dst)
+			assert(dst.a.x == 1)
+		)"));
+	}
+
+	SECTION("iteration order only depends on the contents") {
+		// the same contents, built in different orders and with different histories
+		REQUIRE(RunString(L, ITERATION_ORDER_FUNC));
+		REQUIRE(RunString(L, R"(
+			a = {}
+			for i = 1, 40 do a["key" .. i] = i end
+			for i = 1, 8 do a[i] = i * 2 end
+			a[2.5] = "x"; a[true] = "y"; a.sub = {z = 1, y = 2, x = 3}
+
+			b = {sub = {x = 3, y = 2, z = 1}, [true] = "y"}
+			for i = 8, 1, -1 do b[i] = i * 2 end
+			for i = 100, 1, -1 do b["key" .. i] = i end
+			for i = 41, 100 do b["key" .. i] = nil end
+			b[2.5] = "x"
+		)"));
+
+		REQUIRE(IterationOrder(L, "a") != IterationOrder(L, "b"));
+
+		const std::vector<std::uint8_t> dataA = SnapshotGlobal(L, "a");
+		const std::vector<std::uint8_t> dataB = SnapshotGlobal(L, "b");
+
+		CHECK(dataA == dataB);
+
+		// cache miss: the executed root is replaced by its rebuilt snapshot
+		REQUIRE(LuaTableSnapshot::Read(L, dataA.data(), dataA.size()));
+		lua_setglobal(L, "miss");
+		REQUIRE(LuaTableSnapshot::Read(L, dataB.data(), dataB.size()));
+		lua_setglobal(L, "missB");
+
+		// cache hit: the stored snapshot is read in a later game
+		lua_State* H = NewState();
+
+		REQUIRE(RunString(H, ITERATION_ORDER_FUNC));
+		REQUIRE(LuaTableSnapshot::Read(H, dataA.data(), dataA.size()));
+
+		// and a hit writes back what it read
+		std::vector<std::uint8_t> dataH;
+		REQUIRE(LuaTableSnapshot::Write(H, -1, dataH));
+		CHECK(dataH == dataA);
+
+		lua_setglobal(H, "hit");
+
+		CHECK(IterationOrder(L, "miss") == IterationOrder(L, "missB"));
+		CHECK(IterationOrder(L, "miss") == IterationOrder(H, "hit"));
+
+		lua_close(H);
+	}
+
+	SECTION("unsupported contents are rejected") {
+		const char* cases[] = {
+			"src = {f = print}",
+			"src = {[{}] = 1}",
+			"src = {nested = {co = coroutine.create(function() end)}}",
+			"src = {nested = setmetatable({}, {})}",
+		};
+
+		for (const char* code: cases) {
+			std::vector<std::uint8_t> data = {42};
+
+			REQUIRE(RunString(L, code));
+			lua_getglobal(L, "src");
+
+			const int top = lua_gettop(L);
+
+			CHECK_FALSE(LuaTableSnapshot::Write(L, -1, data));
+			// stack and output are left untouched
+			CHECK(lua_gettop(L) == top);
+			CHECK(data.size() == 1);
+
+			lua_pop(L, 1);
+		}
+
+		lua_pushnumber(L, 1.0f);
+		std::vector<std::uint8_t> data;
+		CHECK_FALSE(LuaTableSnapshot::Write(L, -1, data));
+		lua_pop(L, 1);
+	}
+
+	SECTION("malformed data is rejected") {
+		REQUIRE(RunString(L, "src = {1, 2, 3, a = {b = 'c'}, d = 'e'}"));
+
+		const std::vector<std::uint8_t> data = SnapshotGlobal(L, "src");
+		const int top = lua_gettop(L);
+
+		// every truncation must fail cleanly
+		for (size_t size = 0; size < data.size(); size++) {
+			CHECK_FALSE(LuaTableSnapshot::Read(L, data.data(), size));
+			CHECK(lua_gettop(L) == top);
+		}
+
+		// as must trailing garbage
+		std::vector<std::uint8_t> padded = data;
+		padded.push_back(0);
+		CHECK_FALSE(LuaTableSnapshot::Read(L, padded.data(), padded.size()));
+
+		// and a table count far beyond the data size
+		std::vector<std::uint8_t> huge = data;
+		huge[1] = huge[2] = huge[3] = huge[4] = 0xff;
+		CHECK_FALSE(LuaTableSnapshot::Read(L, huge.data(), huge.size()));
+		CHECK(lua_gettop(L) == top);
+	}
+
+	lua_close(L);
+}
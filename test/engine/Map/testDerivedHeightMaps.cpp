@@ -0,0 +1,325 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include "Map/DerivedHeightMaps.h"
+#include "Sim/Misc/GlobalConstants.h"
+#include "System/SpringMath.h"
+
+#include <algorithm>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include <catch_amalgamated.hpp>
+
+
+namespace {
+	struct TestMaps {
+		explicit TestMaps(const MapDimensions& dims) {
+			centerHeights.resize(dims.mapx * dims.mapy, 0.0f);
+			maxHeights.resize(dims.mapx * dims.mapy, 0.0f);
+
+			for (int i = 1; i < DerivedHeightMaps::NUM_MIPS; i++) {
+				mipHeights[i - 1].resize((dims.mapx >> i) * (dims.mapy >> i), 0.0f);
+			}
+
+			faceNormalsSynced.resize(dims.mapx * dims.mapy * 2);
+			faceNormalsUnsynced.resize(dims.mapx * dims.mapy * 2);
+			centerNormalsSynced.resize(dims.mapx * dims.mapy);
+			centerNormalsUnsynced.resize(dims.mapx * dims.mapy);
+			centerNormals2D.resize(dims.mapx * dims.mapy);
+			slopeMap.resize(dims.hmapx * dims.hmapy, 0.0f);
+		}
+
+		DerivedHeightMaps::Maps GetMaps(const MapDimensions& dims, const std::vector<float>& cornerHeights) {
+			DerivedHeightMaps::Maps maps = {
+				dims,
+				cornerHeights.data(),
+				centerHeights.data(),
+				maxHeights.data(),
+				{},
+				faceNormalsSynced.data(),
+				faceNormalsUnsynced.data(),
+				centerNormalsSynced.data(),
+				centerNormalsUnsynced.data(),
+				centerNormals2D.data(),
+				slopeMap.data(),
+			};
+
+			maps.mipHeights[0] = centerHeights.data();
+
+			for (int i = 1; i < DerivedHeightMaps::NUM_MIPS; i++) {
+				maps.mipHeights[i] = mipHeights[i - 1].data();
+			}
+
+			return maps;
+		}
+
+		std::vector<float> centerHeights;
+		std::vector<float> maxHeights;
+		std::vector<float> mipHeights[DerivedHeightMaps::NUM_MIPS - 1];
+		std::vector<float3> faceNormalsSynced;
+		std::vector<float3> faceNormalsUnsynced;
+		std::vector<float3> centerNormalsSynced;
+		std::vector<float3> centerNormalsUnsynced;
+		std::vector<float3> centerNormals2D;
+		std::vector<float> slopeMap;
+	};
+
+	template<typename T> bool BitEqual(const std::vector<T>& a, const std::vector<T>& b)
+	{
+		return (a.size() == b.size() && std::memcmp(a.data(), b.data(), a.size() * sizeof(T)) == 0);
+	}
+
+	bool BitEqual(const TestMaps& a, const TestMaps& b)
+	{
+		bool equal = true;
+
+		equal = equal && BitEqual(a.centerHeights, b.centerHeights);
+		equal = equal && BitEqual(a.maxHeights, b.maxHeights);
+		equal = equal && std::equal(std::begin(a.mipHeights), std::end(a.mipHeights), std::begin(b.mipHeights), [](const auto& x, const auto& y) { return BitEqual(x, y); });
+		equal = equal && BitEqual(a.faceNormalsSynced, b.faceNormalsSynced);
+		equal = equal && BitEqual(a.faceNormalsUnsynced, b.faceNormalsUnsynced);
+		equal = equal && BitEqual(a.centerNormalsSynced, b.centerNormalsSynced);
+		equal = equal && BitEqual(a.centerNormalsUnsynced, b.centerNormalsUnsynced);
+		equal = equal && BitEqual(a.centerNormals2D, b.centerNormals2D);
+		equal = equal && BitEqual(a.slopeMap, b.slopeMap);
+
+		return equal;
+	}
+
+
+	// the serial whole-rectangle update CReadMap ran before it was split into tiles
+	void UpdateReference(const DerivedHeightMaps::Maps& maps, const SRectangle& rect, bool initialize)
+	{
+		const MapDimensions& dims = maps.dims;
+		const float* heightmapSynced = maps.cornerHeights;
+
+		for (int y = rect.z1; y <= rect.z2; y++) {
+			for (int x = rect.x1; x <= rect.x2; x++) {
+				const int idxTL = (y + 0) * dims.mapxp1 + x + 0;
+				const int idxTR = (y + 0) * dims.mapxp1 + x + 1;
+				const int idxBL = (y + 1) * dims.mapxp1 + x + 0;
+				const int idxBR = (y + 1) * dims.mapxp1 + x + 1;
+
+				const int index = y * dims.mapx + x;
+				const float height =
+					heightmapSynced[idxTL] +
+					heightmapSynced[idxTR] +
+					heightmapSynced[idxBL] +
+					heightmapSynced[idxBR];
+				maps.centerHeights[index] = height * 0.25f;
+				maps.maxHeights[index] = std::max
+						( std::max(heightmapSynced[idxTL], heightmapSynced[idxTR])
+						, std::max(heightmapSynced[idxBL], heightmapSynced[idxBR])
+						);
+			}
+		}
+
+		for (int i = 0; i < DerivedHeightMaps::NUM_MIPS - 1; i++) {
+			const int hmapx = dims.mapx >> i;
+
+			const int sx = (rect.x1 >> i) & (~1);
+			const int ex = (rect.x2 >> i);
+			const int sy = (rect.z1 >> i) & (~1);
+			const int ey = (rect.z2 >> i);
+
+			const float* topMipMap = maps.mipHeights[i    ];
+			      float* subMipMap = maps.mipHeights[i + 1];
+
+			for (int y = sy; y < ey; y += 2) {
+				for (int x = sx; x < ex; x += 2) {
+					const float height =
+						topMipMap[(x    ) + (y    ) * hmapx] +
+						topMipMap[(x    ) + (y + 1) * hmapx] +
+						topMipMap[(x + 1) + (y    ) * hmapx] +
+						topMipMap[(x + 1) + (y + 1) * hmapx];
+					subMipMap[(x / 2) + (y / 2) * hmapx / 2] = height * 0.25f;
+				}
+			}
+		}
+
+		{
+			const int z1 = std::max(          0, rect.z1 - 1);
+			const int x1 = std::max(          0, rect.x1 - 1);
+			const int z2 = std::min(dims.mapym1, rect.z2 + 1);
+			const int x2 = std::min(dims.mapxm1, rect.x2 + 1);
+
+			for (int y = z1; y <= z2; y++) {
+				float3 fnTL;
+				float3 fnBR;
+
+				for (int x = x1; x <= x2; x++) {
+					const int idxTL = (y    ) * dims.mapxp1 + x;
+					const int idxBL = (y + 1) * dims.mapxp1 + x;
+
+					const float& hTL = heightmapSynced[idxTL    ];
+					const float& hTR = heightmapSynced[idxTL + 1];
+					const float& hBL = heightmapSynced[idxBL    ];
+					const float& hBR = heightmapSynced[idxBL + 1];
+
+					fnTL.y = SQUARE_SIZE;
+					fnTL.x = - (hTR - hTL);
+					fnTL.z = - (hBL - hTL);
+					fnTL.Normalize();
+
+					fnBR.y = SQUARE_SIZE;
+					fnBR.x = (hBL - hBR);
+					fnBR.z = (hTR - hBR);
+					fnBR.Normalize();
+
+					maps.faceNormalsSynced[(y * dims.mapx + x) * 2    ] = fnTL;
+					maps.faceNormalsSynced[(y * dims.mapx + x) * 2 + 1] = fnBR;
+					maps.centerNormalsSynced[y * dims.mapx + x] = (fnTL + fnBR).Normalize();
+					maps.centerNormals2D[y * dims.mapx + x] = (fnTL + fnBR).Normalize2D();
+
+					if (initialize) {
+						maps.faceNormalsUnsynced[(y * dims.mapx + x) * 2    ] = maps.faceNormalsSynced[(y * dims.mapx + x) * 2    ];
+						maps.faceNormalsUnsynced[(y * dims.mapx + x) * 2 + 1] = maps.faceNormalsSynced[(y * dims.mapx + x) * 2 + 1];
+						maps.centerNormalsUnsynced[y * dims.mapx + x] = maps.centerNormalsSynced[y * dims.mapx + x];
+					}
+				}
+			}
+		}
+
+		{
+			const int sx = std::max(             0, (rect.x1 / 2) - 1);
+			const int ex = std::min(dims.hmapx - 1, (rect.x2 / 2) + 1);
+			const int sy = std::max(             0, (rect.z1 / 2) - 1);
+			const int ey = std::min(dims.hmapy - 1, (rect.z2 / 2) + 1);
+
+			for (int y = sy; y <= ey; y++) {
+				for (int x = sx; x <= ex; x++) {
+					const int idx0 = (y*2    ) * (dims.mapx) + x*2;
+					const int idx1 = (y*2 + 1) * (dims.mapx) + x*2;
+					const float3* fn = maps.faceNormalsSynced;
+
+					float avgslope = 0.0f;
+					avgslope += fn[(idx0    ) * 2    ].y;
+					avgslope += fn[(idx0    ) * 2 + 1].y;
+					avgslope += fn[(idx0 + 1) * 2    ].y;
+					avgslope += fn[(idx0 + 1) * 2 + 1].y;
+					avgslope += fn[(idx1    ) * 2    ].y;
+					avgslope += fn[(idx1    ) * 2 + 1].y;
+					avgslope += fn[(idx1 + 1) * 2    ].y;
+					avgslope += fn[(idx1 + 1) * 2 + 1].y;
+					avgslope *= 0.125f;
+
+					float maxslope =              fn[(idx0    ) * 2    ].y;
+					maxslope = std::min(maxslope, fn[(idx0    ) * 2 + 1].y);
+					maxslope = std::min(maxslope, fn[(idx0 + 1) * 2    ].y);
+					maxslope = std::min(maxslope, fn[(idx0 + 1) * 2 + 1].y);
+					maxslope = std::min(maxslope, fn[(idx1    ) * 2    ].y);
+					maxslope = std::min(maxslope, fn[(idx1    ) * 2 + 1].y);
+					maxslope = std::min(maxslope, fn[(idx1 + 1) * 2    ].y);
+					maxslope = std::min(maxslope, fn[(idx1 + 1) * 2 + 1].y);
+
+					const float lerp = maxslope / avgslope;
+					const float slope = mix(maxslope, avgslope, lerp);
+
+					maps.slopeMap[y * dims.hmapx + x] = 1.0f - slope;
+				}
+			}
+		}
+	}
+
+	// runs the tiles in a random order, as for_mt may
+	void UpdateTiled(const DerivedHeightMaps::Maps& maps, const SRectangle& rect, bool initialize, std::mt19937& rng)
+	{
+		std::vector<int> tiles;
+		DerivedHeightMaps::GetUpdateTiles(maps.dims, rect, tiles);
+		std::shuffle(tiles.begin(), tiles.end(), rng);
+
+		for (const int tileIdx: tiles) {
+			DerivedHeightMaps::UpdateTile(maps, rect, DerivedHeightMaps::GetTile(maps.dims, tileIdx), initialize);
+		}
+	}
+
+	MapDimensions MakeDims(int mapx, int mapy)
+	{
+		MapDimensions dims;
+		dims.mapx = mapx;
+		dims.mapy = mapy;
+		dims.Initialize();
+		return dims;
+	}
+}
+
+
+TEST_CASE("DerivedHeightMaps_TilesMatchSerialUpdate")
+{
+	std::mt19937 rng(1234);
+
+	for (const MapDimensions& dims: {MakeDims(128, 128), MakeDims(256, 384), MakeDims(640, 256)}) {
+		CAPTURE(dims.mapx, dims.mapy);
+
+		std::uniform_real_distribution<float> heightDist(-200.0f, 800.0f);
+		std::vector<float> cornerHeights(dims.mapxp1 * dims.mapyp1);
+
+		for (float& h: cornerHeights) {
+			h = heightDist(rng);
+		}
+
+		TestMaps refMaps(dims);
+		TestMaps tiledMaps(dims);
+
+		const DerivedHeightMaps::Maps ref = refMaps.GetMaps(dims, cornerHeights);
+		const DerivedHeightMaps::Maps tiled = tiledMaps.GetMaps(dims, cornerHeights);
+
+		// what CReadMap::Initialize does
+		const SRectangle fullRect = {0, 0, dims.mapxm1, dims.mapym1};
+
+		UpdateReference(ref, fullRect, true);
+		UpdateTiled(tiled, fullRect, true, rng);
+
+		REQUIRE(BitEqual(refMaps, tiledMaps));
+
+		for (int n = 0; n < 200; n++) {
+			// mostly small craters, sometimes large and edge-touching areas
+			const int maxSize = ((n % 10) == 0)? std::max(dims.mapx, dims.mapy): 40;
+
+			const int x1 = std::uniform_int_distribution<int>(0, dims.mapxm1)(rng);
+			const int z1 = std::uniform_int_distribution<int>(0, dims.mapym1)(rng);
+			const int x2 = std::min(dims.mapxm1, x1 + std::uniform_int_distribution<int>(0, maxSize)(rng));
+			const int z2 = std::min(dims.mapym1, z1 + std::uniform_int_distribution<int>(0, maxSize)(rng));
+
+			// deform the corners the update covers
+			for (int z = z1; z <= z2 + 1; z++) {
+				for (int x = x1; x <= x2 + 1; x++) {
+					cornerHeights[z * dims.mapxp1 + x] += heightDist(rng) * 0.05f;
+				}
+			}
+
+			const SRectangle rect = {x1, z1, x2, z2};
+
+			UpdateReference(ref, rect, false);
+			UpdateTiled(tiled, rect, false, rng);
+
+			CAPTURE(n, x1, z1, x2, z2);
+			REQUIRE(BitEqual(refMaps, tiledMaps));
+		}
+	}
+}
+
+TEST_CASE("DerivedHeightMaps_UpdateTilesCoverWrites")
+{
+	const MapDimensions dims = MakeDims(256, 384);
+	const int2 numTiles = DerivedHeightMaps::GetNumTiles(dims);
+
+	CHECK(numTiles.x == 4);
+	CHECK(numTiles.y == 6);
+
+	// the last tile ends at the map border
+	const SRectangle last = DerivedHeightMaps::GetTile(dims, numTiles.x * numTiles.y - 1);
+	CHECK(last.x2 == dims.mapxm1);
+	CHECK(last.z2 == dims.mapym1);
+
+	// a single square next to a tile border also dirties the neighbours its
+	// face normals and slope squares reach into
+	std::vector<int> tiles;
+	DerivedHeightMaps::GetUpdateTiles(dims, {64, 64, 64, 64}, tiles);
+	CHECK(tiles == std::vector<int>{0, 1, 4, 5});
+
+	tiles.clear();
+	DerivedHeightMaps::GetUpdateTiles(dims, {100, 100, 100, 100}, tiles);
+	CHECK(tiles == std::vector<int>{5});
+}
@@ -0,0 +1,252 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include "Rendering/Models/ModelCacheData.h"
+#include "Rendering/Models/IModelParser.h"
+#include "Rendering/GlobalRendering.h"
+#include "Sim/Units/Unit.h"
+
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <catch_amalgamated.hpp>
+
+
+// the model and collision volume sources drag in the renderer and the
+// simulation; the (de)serializer never calls into any of these
+float3 S3DModelPiece::GetEmitPos() const { return ZeroVector; }
+float3 S3DModelPiece::GetEmitDir() const { return FwdVector; }
+void S3DModelPiece::PostProcessGeometry(uint32_t pieceIndex) {}
+void LocalModelPiece::UpdateParentMatricesRec() const {}
+CMatrix44f CUnit::GetTransformMatrix(bool synced, bool fullread) const { return CMatrix44f(); }
+CGlobalRendering* globalRendering = nullptr;
+
+namespace {
+	struct TestPiece: public S3DModelPiece {
+		void Fill(int seed) {
+			const float f = seed * 1.25f;
+
+			offset = float3(f, -f, f * 0.5f);
+			goffset = float3(f * 2.0f, f, -f);
+			scales = float3(1.0f + f, 1.0f, 0.5f);
+			mins = float3(-f, -2.0f * f, -3.0f);
+			maxs = float3(f + 1.0f, 2.0f * f + 1.0f, 3.0f);
+
+			// a baked yaw on every other piece
+			if ((seed & 1) != 0) {
+				CMatrix44f m;
+				m.RotateY(0.5f * seed);
+				SetBakedMatrix(m);
+			}
+
+			for (int i = 0; i < 3 + seed; i++) {
+				SVertexData& v = vertices.emplace_back(
+					float3(i, f, -i), float3(0.0f, 1.0f, 0.0f), float3(1.0f, 0.0f, 0.0f), float3(0.0f, 0.0f, 1.0f),
+					float2(i * 0.1f, f * 0.01f), float2(f * 0.02f, i * 0.2f)
+				);
+
+				v.boneIDsLow = {uint8_t(seed), uint8_t(i), 2, 3};
+				v.boneWeights = {200, 40, 10, 5};
+				v.boneIDsHigh = {0, 1, 0, uint8_t(i)};
+
+				indices.push_back(i);
+				indices.push_back((i + 1) % (3 + seed));
+				indices.push_back((i + 2) % (3 + seed));
+				shatterIndices.push_back(indices[indices.size() - 3]);
+			}
+
+			for (S3DModelPiecePart& part: shatterParts) {
+				for (int i = 0; i < seed % 3; i++) {
+					part.renderData.push_back({float3(f, i, -f).ANormalize(), uint32_t(i * 3), uint32_t(3)});
+				}
+			}
+		}
+
+		bool IsSameAs(const TestPiece& p) const {
+			return (
+				vertices.size() == p.vertices.size() &&
+				std::memcmp(vertices.data(), p.vertices.data(), vertices.size() * sizeof(SVertexData)) == 0 &&
+				indices == p.indices &&
+				shatterIndices == p.shatterIndices &&
+				hasBakedMat == p.hasBakedMat
+			);
+		}
+	};
+
+	class TestParser: public IModelParser {
+	public:
+		void Load(S3DModel& model, const std::string& name) override {}
+		S3DModelPiece* AllocPiece() override { return pieces.emplace_back(std::make_unique<TestPiece>()).get(); }
+
+		std::vector<std::unique_ptr<TestPiece>> pieces;
+	};
+
+	bool SamePos(const float3& a, const float3& b)
+	{
+		return (a.x == b.x && a.y == b.y && a.z == b.z);
+	}
+
+	// root -> {a -> {c, d}, b -> {e}}
+	void MakeModel(S3DModel& model, TestParser& parser)
+	{
+		static const int parentIndices[] = {-1, 0, 0, 1, 1, 2};
+
+		std::vector<TestPiece*> pieces;
+
+		for (size_t i = 0; i < std::size(parentIndices); i++) {
+			TestPiece* piece = static_cast<TestPiece*>(parser.AllocPiece());
+
+			piece->name = "piece" + std::to_string(i);
+			piece->parent = (parentIndices[i] >= 0)? pieces[parentIndices[i]]: nullptr;
+			piece->SetParentModel(&model);
+			piece->Fill(i);
+
+			if (piece->parent != nullptr)
+				piece->parent->children.push_back(piece);
+
+			pieces.push_back(piece);
+		}
+
+		model.name = "objects3d/test.s3o";
+		model.type = MODELTYPE_S3O;
+		model.numPieces = pieces.size();
+		model.texs = {"tex1.dds", "tex2.dds"};
+		model.invertTexYAxis = true;
+		model.invertTexAlpha = false;
+		model.radius = 42.5f;
+		model.height = 17.25f;
+		model.mins = float3(-10.0f, -1.0f, -12.0f);
+		model.maxs = float3(10.0f, 20.0f, 12.5f);
+		model.relMidPos = float3(0.0f, 9.5f, 0.25f);
+		model.FlattenPieceTree(pieces[0]);
+	}
+}
+
+
+TEST_CASE("ModelCache_RoundTrip")
+{
+	TestParser writeParser;
+	TestParser readParser;
+
+	S3DModel written;
+	S3DModel read;
+
+	MakeModel(written, writeParser);
+
+	std::vector<std::uint8_t> data;
+	ModelCacheData::Write(written, data);
+
+	REQUIRE(ModelCacheData::Read(read, data.data(), data.size(), &readParser));
+
+	CHECK(read.type == written.type);
+	CHECK(read.numPieces == written.numPieces);
+	CHECK(read.texs == written.texs);
+	CHECK(read.invertTexYAxis == written.invertTexYAxis);
+	CHECK(read.invertTexAlpha == written.invertTexAlpha);
+	CHECK(read.radius == written.radius);
+	CHECK(read.height == written.height);
+	CHECK(SamePos(read.mins, written.mins));
+	CHECK(SamePos(read.maxs, written.maxs));
+	CHECK(SamePos(read.relMidPos, written.relMidPos));
+
+	REQUIRE(read.pieceObjects.size() == written.pieceObjects.size());
+
+	for (size_t i = 0; i < written.pieceObjects.size(); i++) {
+		const TestPiece* wp = static_cast<const TestPiece*>(written.pieceObjects[i]);
+		const TestPiece* rp = static_cast<const TestPiece*>(read.pieceObjects[i]);
+
+		CAPTURE(i);
+		CHECK(rp == readParser.pieces[i].get());
+		CHECK(rp->name == wp->name);
+		CHECK(rp->GetParentModel() == &read);
+
+		// same shape of the tree, by index
+		if (wp->parent == nullptr) {
+			CHECK(rp->parent == nullptr);
+		} else {
+			REQUIRE(rp->parent != nullptr);
+			CHECK(rp->parent->name == wp->parent->name);
+		}
+
+		REQUIRE(rp->children.size() == wp->children.size());
+
+		for (size_t j = 0; j < wp->children.size(); j++) {
+			CHECK(rp->children[j]->name == wp->children[j]->name);
+		}
+
+		CHECK(SamePos(rp->offset, wp->offset));
+		CHECK(SamePos(rp->goffset, wp->goffset));
+		CHECK(SamePos(rp->scales, wp->scales));
+		CHECK(SamePos(rp->mins, wp->mins));
+		CHECK(SamePos(rp->maxs, wp->maxs));
+
+		CHECK(rp->HasBackedMat() == wp->HasBackedMat());
+		CHECK(std::memcmp(&rp->bakedMatrix.m[0], &wp->bakedMatrix.m[0], sizeof(rp->bakedMatrix.m)) == 0);
+
+		CHECK(rp->IsSameAs(*wp));
+
+		for (size_t j = 0; j < wp->shatterParts.size(); j++) {
+			const auto& wrd = wp->shatterParts[j].renderData;
+			const auto& rrd = rp->shatterParts[j].renderData;
+
+			REQUIRE(rrd.size() == wrd.size());
+
+			for (size_t k = 0; k < wrd.size(); k++) {
+				CHECK(SamePos(rrd[k].dir, wrd[k].dir));
+				CHECK(rrd[k].indexStart == wrd[k].indexStart);
+				CHECK(rrd[k].indexCount == wrd[k].indexCount);
+			}
+		}
+
+		// the volume is rebuilt from the extents
+		CHECK(SamePos(rp->GetCollisionVolume()->GetScales(), wp->maxs - wp->mins));
+	}
+
+	// and writing the copy gives the same bytes again
+	std::vector<std::uint8_t> rewritten;
+	ModelCacheData::Write(read, rewritten);
+	CHECK(rewritten == data);
+}
+
+TEST_CASE("ModelCache_RejectsDamagedData")
+{
+	TestParser writeParser;
+	S3DModel written;
+
+	MakeModel(written, writeParser);
+
+	std::vector<std::uint8_t> data;
+	ModelCacheData::Write(written, data);
+
+	// every truncation has to be detected rather than read past the end
+	for (size_t size = 0; size < data.size(); size += 1 + size / 16) {
+		TestParser readParser;
+		S3DModel read;
+
+		CAPTURE(size);
+		CHECK(!ModelCacheData::Read(read, data.data(), size, &readParser));
+		CHECK(read.pieceObjects.empty());
+	}
+
+	// trailing garbage
+	{
+		std::vector<std::uint8_t> padded = data;
+		padded.push_back(0);
+
+		TestParser readParser;
+		S3DModel read;
+		CHECK(!ModelCacheData::Read(read, padded.data(), padded.size(), &readParser));
+	}
+
+	// out-of-range model type and piece count
+	for (const size_t offset: {0, 4}) {
+		std::vector<std::uint8_t> broken = data;
+		std::memset(broken.data() + offset, 0xff, sizeof(int32_t));
+
+		TestParser readParser;
+		S3DModel read;
+		CHECK(!ModelCacheData::Read(read, broken.data(), broken.size(), &readParser));
+		CHECK(readParser.pieces.empty());
+	}
+}
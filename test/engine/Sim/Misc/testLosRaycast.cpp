@@ -0,0 +1,121 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include "Sim/Misc/LosRaycast.h"
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include <catch_amalgamated.hpp>
+
+
+// rays to every square on the quadrant's rim, like CLosTableHelper::GetRay
+static LosRaycast::LosTable GenerateRays(int radius)
+{
+	LosRaycast::LosTable rays;
+
+	for (int yf = 0; yf <= radius; yf++) {
+		const int xf = int(std::sqrt(float(radius * radius - yf * yf)));
+
+		if (xf == 0 && yf == radius)
+			continue;
+
+		LosRaycast::LosLine ray;
+
+		if (xf > yf) {
+			const float m = float(yf) / float(xf);
+			for (int x = 1; x <= xf; x++) {
+				ray.emplace_back(x, int(std::round(m * x)));
+			}
+		} else {
+			const float m = float(xf) / float(yf);
+			for (int y = 1; y <= yf; y++) {
+				ray.emplace_back(int(std::round(m * y)), y);
+			}
+		}
+
+		rays.push_back(std::move(ray));
+	}
+
+	return rays;
+}
+
+
+static std::vector<char> CastRays(LosRaycast::Params params, const std::vector<char>& initial, bool useSIMD)
+{
+	std::vector<char> squares = initial;
+	params.squares = squares.data();
+
+	if (useSIMD) {
+		LosRaycast::CastRaysSIMD(params);
+	} else {
+		LosRaycast::CastRaysScalar(params);
+	}
+
+	return squares;
+}
+
+
+TEST_CASE("LosRaycast")
+{
+	std::mt19937 rng(1234);
+
+	constexpr int NUM_RUNS = 500;
+	constexpr int MAX_RADIUS = 64;
+
+	std::vector<float> isqrtTable;
+	for (int i = 0; i <= 2 * (MAX_RADIUS + 1) * (MAX_RADIUS + 1); i++) {
+		isqrtTable.push_back(1.0f / std::sqrt(float(std::max(i, 1))));
+	}
+
+	for (int run = 0; run < NUM_RUNS; run++) {
+		const int radius = 1 + rng() % MAX_RADIUS;
+		const int size = 2 * radius + 1;
+
+		const LosRaycast::LosTable rays = GenerateRays(radius);
+
+		// random terrain, mixing smooth slopes with spikes and flat areas
+		std::uniform_real_distribution<float> heightDist(-200.0f, 400.0f);
+		std::vector<float> angles(size * size);
+		std::vector<char> initial(size * size, true);
+
+		const float baseHeight = heightDist(rng);
+		const float slope = heightDist(rng) * 0.01f;
+
+		for (int y = -radius; y <= radius; y++) {
+			for (int x = -radius; x <= radius; x++) {
+				const int idx = (y + radius) * size + (x + radius);
+				const float h = ((rng() % 4) == 0)? heightDist(rng): ((rng() % 3) == 0)? 0.0f: slope * (x + y);
+				const float invR = isqrtTable[x * x + y * y];
+
+				angles[idx] = (std::max(0.0f, h) - baseHeight + LosRaycast::BONUS_HEIGHT) * invR;
+			}
+		}
+
+		LosRaycast::Params params;
+		params.rays = &rays;
+		params.isqrtTable = isqrtTable.data();
+		params.angles = angles.data();
+		params.radius = radius;
+
+		// map rectangle that may cut off parts of the circle, with the
+		// origin either inside (clipped rays) or outside (skipped squares)
+		const int mapSize = radius + 1 + rng() % (3 * radius);
+		params.bounds = SRectangle(0, 0, mapSize, mapSize);
+		params.pos = int2(int(rng() % (mapSize + 2 * radius)) - radius, int(rng() % (mapSize + 2 * radius)) - radius);
+
+		for (const LosRaycast::BoundsMode mode: {LosRaycast::BOUNDS_NONE, LosRaycast::BOUNDS_CLIP, LosRaycast::BOUNDS_SKIP}) {
+			if (mode == LosRaycast::BOUNDS_CLIP && !params.bounds.Inside(params.pos))
+				continue;
+			if (mode == LosRaycast::BOUNDS_SKIP && params.bounds.Inside(params.pos))
+				continue;
+
+			params.mode = mode;
+
+			const std::vector<char> scalar = CastRays(params, initial, false);
+			const std::vector<char> simd = CastRays(params, initial, true);
+
+			CHECK(scalar == simd);
+		}
+	}
+}
@@ -0,0 +1,124 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include "Sim/Units/Scripts/CobBytecode.h"
+#include "Sim/Units/Scripts/CobOpcodes.h"
+
+#include <string>
+#include <vector>
+
+#include <catch_amalgamated.hpp>
+
+
+TEST_CASE("CobBytecode")
+{
+	const std::vector<std::string> scriptNames = {"Create", "lua_Foo", "Empty"};
+	const std::vector<int> scriptLengths = {16, 0, 0};
+
+	std::vector<SCobInstr> instrs;
+	CobBytecode::DecodeStats stats;
+
+	SECTION("operands and jump targets") {
+		const std::vector<int> code = {
+			PUSH_CONSTANT, 42,   // 0
+			MOVE, 3, 1,          // 2
+			JUMP, 0,             // 5
+			RETURN,              // 7
+		};
+
+		CobBytecode::Decode(code, scriptNames, scriptLengths, instrs, &stats);
+
+		REQUIRE(instrs.size() == code.size());
+
+		CHECK(instrs[0].op == COBOP_PUSH_CONSTANT);
+		CHECK(instrs[0].next == 2);
+		CHECK(instrs[0].arg0 == 42);
+
+		CHECK(instrs[2].op == COBOP_MOVE);
+		CHECK(instrs[2].next == 5);
+		CHECK(instrs[2].arg0 == 3);
+		CHECK(instrs[2].arg1 == 1);
+
+		CHECK(instrs[5].op == COBOP_JUMP);
+		CHECK(instrs[5].arg0 == 0);
+
+		CHECK(instrs[7].op == COBOP_RETURN);
+		CHECK(instrs[7].next == 8);
+
+		CHECK(stats.numInstrs == 4);
+		CHECK(stats.numRaw == 0);
+		CHECK(stats.numFused == 0);
+	}
+
+	SECTION("push-constant fusion") {
+		const std::vector<int> code = {
+			PUSH_LOCAL_VAR, 0,   // 0
+			PUSH_CONSTANT, 7,    // 2
+			SET_LESS,            // 4
+			PUSH_CONSTANT, 100,  // 5
+			SLEEP,               // 7
+			PUSH_CONSTANT, 1,    // 8
+			ADD,                 // 10
+		};
+
+		CobBytecode::Decode(code, scriptNames, scriptLengths, instrs, &stats);
+
+		CHECK(instrs[2].op == COBOP_PUSHC_SET_LESS);
+		CHECK(instrs[2].next == 5);
+		CHECK(instrs[2].arg0 == 7);
+
+		CHECK(instrs[5].op == COBOP_PUSHC_SLEEP);
+		CHECK(instrs[5].next == 8);
+		CHECK(instrs[5].arg0 == 100);
+
+		// ADD is not fused
+		CHECK(instrs[8].op == COBOP_PUSH_CONSTANT);
+		CHECK(instrs[8].next == 10);
+
+		CHECK(stats.numInstrs == 5);
+		CHECK(stats.numFused == 2);
+	}
+
+	SECTION("calls") {
+		const std::vector<int> code = {
+			CALL, 0, 0,          // 0
+			CALL, 1, 2,          // 3
+			START, 2, 0,         // 6
+			CALL, 5, 0,          // 9
+		};
+
+		CobBytecode::Decode(code, scriptNames, scriptLengths, instrs, &stats);
+
+		CHECK(instrs[0].op == COBOP_REAL_CALL);
+		CHECK(instrs[3].op == COBOP_LUA_CALL);
+		CHECK(instrs[3].arg0 == 1);
+		CHECK(instrs[3].arg1 == 2);
+		CHECK(instrs[6].op == COBOP_START);
+
+		// out-of-range function index is left to the raw interpreter
+		CHECK(instrs[9].op == COBOP_RAW);
+		CHECK(instrs[9].next == 9);
+	}
+
+	SECTION("raw fallback") {
+		const std::vector<int> code = {
+			0x12345678,          // 0, unknown opcode
+			SHADE, 1,            // 1
+			TURN, 2,             // 3, truncated operands
+		};
+
+		CobBytecode::Decode(code, scriptNames, scriptLengths, instrs, &stats);
+
+		CHECK(instrs[0].op == COBOP_RAW);
+		CHECK(instrs[0].next == 0);
+
+		CHECK(instrs[1].op == COBOP_NOP);
+		CHECK(instrs[1].next == 3);
+
+		CHECK(instrs[3].op == COBOP_RAW);
+		CHECK(instrs[3].next == 3);
+
+		// RAW entries advance the sweep by one word
+		CHECK(stats.numInstrs == 4);
+		CHECK(stats.numRaw == 3);
+	}
+}
@@ -0,0 +1,374 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include "Sim/Units/Scripts/CobThread.h"
+#include "Sim/Units/Scripts/CobEngine.h"
+#include "Sim/Units/Scripts/CobFile.h"
+#include "Sim/Units/Scripts/CobInstance.h"
+#include "Sim/Units/Scripts/CobOpcodes.h"
+#include "Sim/Misc/GlobalSynced.h"
+#include "Lua/LuaRules.h"
+
+#include <algorithm>
+#include <array>
+#include <string>
+#include <vector>
+
+#include <catch_amalgamated.hpp>
+
+
+// every call a thread makes out of the interpreter, in order
+static std::vector<std::string> callLog;
+
+template<typename... Args>
+static void Record(const char* name, Args... args)
+{
+	std::string s = name;
+	((s += ' ', s += std::to_string(args)), ...);
+	callLog.push_back(std::move(s));
+}
+
+
+// CobThread.cpp calls into the unit script, the engine and Lua; only
+// recording stand-ins are linked so both interpreters can be compared
+CCobEngine* cobEngine = nullptr;
+CGlobalSyncedRNG gsRNG;
+CLuaRules* luaRules = nullptr;
+
+void CCobEngine::ScheduleThread(const CCobThread* thread)
+{
+	CCobThread* t = const_cast<CCobThread*>(thread);
+	Record("schedule", t->GetID(), int(t->GetState()), t->GetWakeTime(), t->GetSignalMask(), t->CheckStack(~0u, false));
+}
+
+void CLuaRules::Cob2Lua(const LuaHashString& name, const CUnit* unit, int& argsCount, int* args) { FAIL(); }
+
+CUnitScript::CUnitScript(CUnit* unit): unit(unit), busy(false), hasSetSFXOccupy(false), hasRockUnit(false), hasStartBuilding(false) {}
+CUnitScript::~CUnitScript() {}
+
+void CUnitScript::Spin(int piece, int axis, float speed, float accel) { Record("spin", piece, axis, speed, accel); }
+void CUnitScript::StopSpin(int piece, int axis, float decel) { Record("stop-spin", piece, axis, decel); }
+void CUnitScript::Turn(int piece, int axis, float speed, float destination) { Record("turn", piece, axis, speed, destination); }
+void CUnitScript::Move(int piece, int axis, float speed, float destination) { Record("move", piece, axis, speed, destination); }
+void CUnitScript::MoveNow(int piece, int axis, float destination) { Record("move-now", piece, axis, destination); }
+void CUnitScript::TurnNow(int piece, int axis, float destination) { Record("turn-now", piece, axis, destination); }
+void CUnitScript::SetVisibility(int piece, bool visible) { Record("visibility", piece, visible); }
+void CUnitScript::AttachUnit(int piece, int unit) { Record("attach", piece, unit); }
+void CUnitScript::DropUnit(int unit) { Record("drop", unit); }
+void CUnitScript::Explode(int piece, int flags) { Record("explode", piece, flags); }
+void CUnitScript::ShowFlare(int piece) { Record("flare", piece); }
+void CUnitScript::SetUnitVal(int val, int param) { Record("set", val, param); }
+
+bool CUnitScript::EmitSfx(int sfxType, int sfxPiece) { Record("sfx", sfxType, sfxPiece); return true; }
+// odd pieces are still animating
+bool CUnitScript::NeedsWait(AnimType type, int piece, int axis) { Record("needs-wait", int(type), piece, axis); return ((piece & 1) != 0); }
+
+int CUnitScript::GetUnitVal(int val, int p1, int p2, int p3, int p4)
+{
+	Record("get", val, p1, p2, p3, p4);
+	return (val * 1000 + p1 - p2 + p3 - p4);
+}
+
+CCobInstance::~CCobInstance() {}
+void CCobInstance::ShowScriptError(const std::string& msg) { FAIL(msg); }
+void CCobInstance::Signal(int signal) { Record("signal", signal); }
+void CCobInstance::PlayUnitSound(int snr, int attr) { Record("sound", snr, attr); }
+void CCobInstance::ThreadCallback(ThreadCallbackType type, int retCode, int cbParam) { Record("callback", int(type), retCode, cbParam); }
+
+// never called by a thread
+bool CCobInstance::HasBlockShot(int weaponNum) const { return false; }
+bool CCobInstance::HasTargetWeight(int weaponNum) const { return false; }
+void CCobInstance::RawCall(int functionId) {}
+void CCobInstance::Create() {}
+void CCobInstance::Killed() {}
+void CCobInstance::WindChanged(float heading, float speed) {}
+void CCobInstance::ExtractionRateChanged(float speed) {}
+void CCobInstance::WorldRockUnit(const float3& rockDir) {}
+void CCobInstance::RockUnit(const float3& rockDir) {}
+void CCobInstance::WorldHitByWeapon(const float3& hitDir, int weaponDefId, float& inoutDamage) {}
+void CCobInstance::HitByWeapon(const float3& hitDir, int weaponDefId, float& inoutDamage) {}
+void CCobInstance::SetSFXOccupy(int curTerrainType) {}
+void CCobInstance::QueryLandingPads(std::vector<int>& out_pieces) {}
+void CCobInstance::BeginTransport(const CUnit* unit) {}
+int  CCobInstance::QueryTransport(const CUnit* unit) { return -1; }
+void CCobInstance::TransportPickup(const CUnit* unit) {}
+void CCobInstance::TransportDrop(const CUnit* unit, const float3& pos) {}
+void CCobInstance::StartBuilding(float heading, float pitch) {}
+int  CCobInstance::QueryNanoPiece() { return -1; }
+int  CCobInstance::QueryBuildInfo() { return -1; }
+void CCobInstance::Destroy() {}
+void CCobInstance::StartMoving(bool reversing) {}
+void CCobInstance::StopMoving() {}
+void CCobInstance::StartUnload() {}
+void CCobInstance::EndTransport() {}
+void CCobInstance::StartBuilding() {}
+void CCobInstance::StopBuilding() {}
+void CCobInstance::Falling() {}
+void CCobInstance::Landed() {}
+void CCobInstance::Activate() {}
+void CCobInstance::Deactivate() {}
+void CCobInstance::MoveRate(int curRate) {}
+void CCobInstance::FireWeapon(int weaponNum) {}
+void CCobInstance::EndBurst(int weaponNum) {}
+int   CCobInstance::QueryWeapon(int weaponNum) { return -1; }
+void  CCobInstance::AimWeapon(int weaponNum, float heading, float pitch) {}
+void  CCobInstance::AimShieldWeapon(CPlasmaRepulser* weapon) {}
+int   CCobInstance::AimFromWeapon(int weaponNum) { return -1; }
+void  CCobInstance::Shot(int weaponNum) {}
+bool  CCobInstance::BlockShot(int weaponNum, const CUnit* targetUnit, bool userTarget) { return false; }
+float CCobInstance::TargetWeight(int weaponNum, const CUnit* targetUnit) { return 1.0f; }
+void CCobInstance::AnimFinished(AnimType type, int piece, int axis) {}
+
+
+namespace {
+	enum {
+		FN_MAIN,
+		FN_HELPER,
+		FN_LUA,
+		FN_EMPTY,
+		FN_CHILD,
+		FN_FIRE,
+		FN_OVERLAP,
+		FN_BROKEN,
+	};
+
+	struct Program {
+		std::vector<int> code;
+		std::vector<int> offsets;
+		std::vector<int> lengths;
+
+		int Here() const { return code.size(); }
+		void Emit(std::initializer_list<int> words) { code.insert(code.end(), words); }
+		void Begin() { offsets.push_back(Here()); }
+		void End() { lengths.push_back(Here() - offsets.back()); }
+	};
+
+	// a bit of every opcode, including calls, threads, sleeps and waits
+	Program MakeProgram()
+	{
+		Program p;
+
+		p.Begin(); // Main(a, b)
+		p.Emit({CREATE_LOCAL_VAR, CREATE_LOCAL_VAR, CREATE_LOCAL_VAR});
+
+		// for (i = 0; i < 5; i++)
+		const int loop = p.Here();
+		p.Emit({PUSH_LOCAL_VAR, 2, PUSH_CONSTANT, 5, SET_LESS, JUMP_NOT_EQUAL, 0});
+		const int exit = p.Here() - 1;
+
+		// static[0] += a * i; static[1] ^= b
+		p.Emit({PUSH_STATIC, 0, PUSH_LOCAL_VAR, 0, PUSH_LOCAL_VAR, 2, MUL, ADD, POP_STATIC, 0});
+		p.Emit({PUSH_STATIC, 1, PUSH_LOCAL_VAR, 1, BITWISE_XOR, POP_STATIC, 1});
+		// sleep(i * 10); Helper(i)
+		p.Emit({PUSH_LOCAL_VAR, 2, PUSH_CONSTANT, 10, MUL, SLEEP});
+		p.Emit({PUSH_LOCAL_VAR, 2, CALL, FN_HELPER, 1});
+		p.Emit({PUSH_LOCAL_VAR, 2, PUSH_CONSTANT, 1, ADD, POP_LOCAL_VAR, 2, JUMP, loop});
+		p.code[exit] = p.Here();
+
+		p.Emit({PUSH_CONSTANT, 100, SLEEP});
+		p.Emit({CALL, FN_EMPTY, 0});
+		p.Emit({PUSH_CONSTANT, 11, PUSH_CONSTANT, 22, CALL, FN_LUA, 2});
+		p.Emit({PUSH_CONSTANT, 110, GET_UNIT_VALUE});
+		p.Emit({PUSH_CONSTANT, 42, PUSH_CONSTANT, 43, START, FN_CHILD, 2});
+		p.Emit({PUSH_CONSTANT, 4, SET_SIGNAL_MASK, PUSH_CONSTANT, 44, START, FN_CHILD, 1});
+		p.Emit({START, FN_EMPTY, 0});
+		p.Emit({CALL, FN_FIRE, 0});
+
+		// animations; piece 1 is still turning, piece 2 done moving
+		p.Emit({PUSH_CONSTANT, 30, PUSH_CONSTANT, 5, TURN, 1, 2, WAIT_TURN, 1, 2});
+		p.Emit({PUSH_CONSTANT, 8, PUSH_CONSTANT, 9, MOVE, 2, 0, WAIT_MOVE, 2, 0});
+		p.Emit({PUSH_CONSTANT, 3, PUSH_CONSTANT, 4, SPIN, 0, 2, PUSH_CONSTANT, 2, STOP_SPIN, 0, 1});
+		p.Emit({PUSH_CONSTANT, 5, TURN_NOW, 3, 2, PUSH_CONSTANT, 6, MOVE_NOW, 3, 0});
+		p.Emit({HIDE, 1, SHOW, 2, SHADE, 1, DONT_SHADE, 1, CACHE, 1, DONT_CACHE, 1});
+		p.Emit({PUSH_CONSTANT, 7, PUSH_CONSTANT, 0, WAIT_MOVE, 1, 0});
+
+		// unit values and effects
+		p.Emit({PUSH_CONSTANT, 4, GET_UNIT_VALUE});
+		p.Emit({PUSH_CONSTANT, 20, PUSH_CONSTANT, 1, PUSH_CONSTANT, 2, PUSH_CONSTANT, 3, PUSH_CONSTANT, 4, GET});
+		p.Emit({PUSH_CONSTANT, 5, PUSH_CONSTANT, 1, SET});
+		p.Emit({PUSH_CONSTANT, 1, PUSH_CONSTANT, 2, ATTACH, PUSH_CONSTANT, 5, DROP});
+		p.Emit({PUSH_CONSTANT, 4, EXPLODE, 2, PUSH_CONSTANT, 1, PLAY_SOUND, 0, PUSH_CONSTANT, 3, EMIT_SFX, 1});
+		p.Emit({PUSH_CONSTANT, 2, SIGNAL});
+		p.Emit({PUSH_CONSTANT, 1, PUSH_CONSTANT, 100, RAND, PUSH_CONSTANT, -50, PUSH_CONSTANT, 50, RAND});
+
+		// arithmetic, including division by zero
+		p.Emit({PUSH_CONSTANT, 7, PUSH_CONSTANT, 3, DIV, PUSH_CONSTANT, -7, PUSH_CONSTANT, 3, MOD});
+		p.Emit({PUSH_CONSTANT, 7, PUSH_CONSTANT, 0, DIV, PUSH_CONSTANT, 7, PUSH_CONSTANT, 0, MOD});
+		p.Emit({PUSH_CONSTANT, 9, PUSH_CONSTANT, 12, SUB, BITWISE_NOT, PUSH_CONSTANT, 0xff, BITWISE_AND, PUSH_CONSTANT, 0x100, BITWISE_OR});
+		p.Emit({PUSH_CONSTANT, 0, PUSH_CONSTANT, 5, LOGICAL_OR, PUSH_CONSTANT, 3, LOGICAL_NOT, LOGICAL_AND, PUSH_CONSTANT, 1, LOGICAL_XOR});
+
+		// comparisons, plain and fused
+		for (const int op: {SET_LESS, SET_LESS_OR_EQUAL, SET_GREATER, SET_GREATER_OR_EQUAL, SET_EQUAL, SET_NOT_EQUAL}) {
+			p.Emit({PUSH_LOCAL_VAR, 0, PUSH_CONSTANT, 7, op});
+			p.Emit({PUSH_CONSTANT, 7, PUSH_LOCAL_VAR, 1, op});
+		}
+
+		// out-of-range statics are ignored, leftovers stay on the stack
+		p.Emit({PUSH_CONSTANT, 9, POP_STACK, PUSH_STATIC, 7, PUSH_CONSTANT, 1, POP_STATIC, 9});
+		p.Emit({PUSH_CONSTANT, 13, PUSH_CONSTANT, 25, SLEEP, PUSH_LOCAL_VAR, 2, RETURN});
+		p.End();
+
+		p.Begin(); // Helper(x): static[2] += x * 2, sleeps when x == 2
+		p.Emit({CREATE_LOCAL_VAR, PUSH_LOCAL_VAR, 0, PUSH_CONSTANT, 2, MUL, PUSH_STATIC, 2, ADD, POP_STATIC, 2});
+		p.Emit({PUSH_LOCAL_VAR, 0, PUSH_CONSTANT, 2, SET_EQUAL, JUMP_NOT_EQUAL, 0});
+		const int skip = p.Here() - 1;
+		p.Emit({PUSH_CONSTANT, 1, SLEEP});
+		p.code[skip] = p.Here();
+		p.Emit({PUSH_LOCAL_VAR, 0, RETURN});
+		p.End();
+
+		p.Begin(); // lua_Foo
+		p.Emit({PUSH_CONSTANT, 0, RETURN});
+		p.End();
+
+		p.Begin(); // Empty
+		p.End();
+
+		p.Begin(); // Child(x, y)
+		p.Emit({CREATE_LOCAL_VAR, CREATE_LOCAL_VAR, PUSH_LOCAL_VAR, 0, RETURN});
+		p.End();
+
+		p.Begin(); // FirePrimary
+		p.Emit({SHOW, 4, PUSH_CONSTANT, 0, RETURN});
+		p.End();
+
+		p.Begin(); // Overlap: jumps into the operand of a push
+		const int operand = p.Here() + 5;
+		p.Emit({PUSH_CONSTANT, 6, JUMP, operand, PUSH_CONSTANT, RETURN});
+		p.End();
+
+		p.Begin(); // Broken
+		p.Emit({PUSH_CONSTANT, 1, 0x12345678, PUSH_CONSTANT, 2, RETURN});
+		p.End();
+
+		return p;
+	}
+
+	CCobFile MakeFile(const Program& p, bool decode)
+	{
+		CCobFile file;
+
+		file.name = "test.cob";
+		file.code = p.code;
+		file.scriptNames = {"Main", "Helper", "lua_Foo", "Empty", "Child", "FirePrimary", "Overlap", "Broken"};
+		file.scriptOffsets = p.offsets;
+		file.scriptLengths = p.lengths;
+		file.scriptIndex[COBFN_FirePrimary] = FN_FIRE;
+		file.numStaticVars = 4;
+
+		if (decode)
+			CobBytecode::Decode(file.code, file.scriptNames, file.scriptLengths, file.decodedCode);
+
+		return file;
+	}
+
+	// runs <function> to completion, waking the thread whenever it yields,
+	// and returns everything it did in order
+	std::vector<std::string> Run(const Program& p, bool decode, int function, const std::array<int, 1 + MAX_COB_ARGS>& args)
+	{
+		callLog.clear();
+		gsRNG.SetSeed(1234, true);
+
+		CCobFile file = MakeFile(p, decode);
+		CCobInstance inst;
+
+		inst.cobFile = &file;
+		inst.staticVars = {0, 0x55, 100, -1};
+
+		{
+			// threads STARTed by <function> die with the engine
+			CCobEngine engine;
+
+			engine.Init();
+			cobEngine = &engine;
+
+			CCobThread thread(&inst);
+			thread.SetID(engine.GenThreadID());
+			thread.Start(function, 0, args, false);
+
+			for (int n = 0; n < 100; n++) {
+				const bool alive = thread.Tick();
+
+				Record("tick", alive, int(thread.GetState()), thread.GetWakeTime(), thread.GetRetCode(), thread.GetSignalMask());
+
+				for (int i = 0, size = thread.CheckStack(~0u, false); i < size; i++) {
+					Record("stack", i, thread.GetStackVal(i));
+				}
+
+				if (!alive)
+					break;
+
+				// woken up, or its animation finished
+				thread.SetState(CCobThread::Run);
+			}
+
+			Record("threads", engine.GetThreadCounter());
+
+			for (size_t i = 0; i < inst.staticVars.size(); i++) {
+				Record("static", i, inst.staticVars[i]);
+			}
+
+			cobEngine = nullptr;
+		}
+
+		return callLog;
+	}
+}
+
+
+TEST_CASE("CobThread_DecodedMatchesRaw")
+{
+	const Program p = MakeProgram();
+
+	REQUIRE(p.offsets.size() == FN_BROKEN + 1);
+	REQUIRE(p.lengths[FN_EMPTY] == 0);
+
+	const auto Compare = [&](int function, const std::array<int, 1 + MAX_COB_ARGS>& args) {
+		const std::vector<std::string> raw = Run(p, false, function, args);
+		const std::vector<std::string> decoded = Run(p, true, function, args);
+
+		REQUIRE(raw.size() == decoded.size());
+
+		for (size_t i = 0; i < raw.size(); i++) {
+			CHECK(decoded[i] == raw[i]);
+		}
+
+		return raw;
+	};
+
+	SECTION("main") {
+		const std::vector<std::string> log = Compare(FN_MAIN, {{2, 7, -3}});
+
+		// sanity-check that the program went where it was meant to go
+		const auto Count = [&](const std::string& prefix) {
+			return std::count_if(log.begin(), log.end(), [&](const std::string& s) { return (s.rfind(prefix, 0) == 0); });
+		};
+
+		CHECK(Count("schedule 0 1") == 5 + 1 + 1 + 1);
+		CHECK(Count("tick 1 4") == 1);
+		CHECK(Count("needs-wait") == 3);
+		CHECK(Count("flare 4") == 1);
+		CHECK(Count("visibility 2 1") == 1);
+		CHECK(Count("schedule 1 ") == 1);
+		CHECK(Count("schedule 2 ") == 1);
+		CHECK(Count("threads 3") == 1);
+		CHECK(Count("static 0 70") == 1);
+		CHECK(Count("static 2 120") == 1);
+		CHECK(log.back() == "static 3 -1");
+	}
+
+	SECTION("no arguments") {
+		Compare(FN_MAIN, {{0}});
+	}
+
+	SECTION("overlapping instructions") {
+		const std::vector<std::string> log = Compare(FN_OVERLAP, {{0}});
+
+		CHECK(log[0] == "tick 0 3 0 6 0");
+	}
+
+	SECTION("unknown opcode") {
+		const std::vector<std::string> log = Compare(FN_BROKEN, {{0}});
+
+		CHECK(log[0] == "tick 0 3 0 -1 0");
+	}
+}
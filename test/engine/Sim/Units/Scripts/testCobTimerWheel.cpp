@@ -0,0 +1,115 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include "Sim/Units/Scripts/CobTimerWheel.h"
+
+#include <queue>
+#include <random>
+#include <vector>
+
+#include <catch_amalgamated.hpp>
+
+
+typedef CCobTimerWheel::SleepingThread SleepingThread;
+
+// the ordering CCobEngine used before the timer wheel
+struct ReferenceComp {
+	bool operator() (const SleepingThread& a, const SleepingThread& b) const {
+		return a.wt > b.wt || (a.wt == b.wt && a.id > b.id);
+	}
+};
+
+typedef std::priority_queue<SleepingThread, std::vector<SleepingThread>, ReferenceComp> ReferenceQueue;
+
+
+static bool operator == (const SleepingThread& a, const SleepingThread& b) { return (a.id == b.id && a.wt == b.wt); }
+
+
+TEST_CASE("CobTimerWheel")
+{
+	std::mt19937 rng(1234);
+
+	CCobTimerWheel wheel;
+	ReferenceQueue queue;
+
+	std::vector<SleepingThread> woken;
+	std::vector<SleepingThread> expected;
+
+	int time = 0;
+	int numThreads = 0;
+
+	// mostly short sleeps, some long ones crossing every level of the
+	// wheel, and a few negative ones that are due right away
+	const auto RandomSleep = [&]() {
+		switch (rng() % 16) {
+			case 0: return -int(rng() % 100);
+			case 1: return int(rng() % (1 << 16));
+			case 2: return int(rng() % (1 << 22));
+			case 3: return int(rng() % (1 << 28));
+			default: break;
+		}
+
+		return int(rng() % 1000);
+	};
+
+	for (int i = 0; i < 2000; i++) {
+		const SleepingThread st = {numThreads++, time + RandomSleep()};
+
+		wheel.Insert(st);
+		queue.push(st);
+	}
+
+	SECTION("wake order") {
+		// fixed script ticks plus the occasional large jump
+		for (int tick = 0; tick < 20000; tick++) {
+			time += ((tick % 1000) == 999)? int(rng() % (1 << 22)): (1000 / 30);
+
+			woken.clear();
+			expected.clear();
+
+			wheel.Advance(time, woken);
+
+			while (!queue.empty() && queue.top().wt < time) {
+				expected.push_back(queue.top());
+				queue.pop();
+			}
+
+			REQUIRE(woken == expected);
+
+			// woken threads go back to sleep, some spawn another one
+			for (const SleepingThread& w: woken) {
+				const SleepingThread st = {w.id, time + RandomSleep()};
+
+				wheel.Insert(st);
+				queue.push(st);
+
+				if ((rng() % 8) != 0 || queue.size() >= 4000)
+					continue;
+
+				const SleepingThread nt = {numThreads++, time + RandomSleep()};
+
+				wheel.Insert(nt);
+				queue.push(nt);
+			}
+
+			CHECK(wheel.size() == queue.size());
+		}
+	}
+
+	SECTION("entries") {
+		std::vector<SleepingThread> entries = wheel.GetEntries();
+
+		REQUIRE(entries.size() == queue.size());
+
+		for (const SleepingThread& st: entries) {
+			CHECK(st == queue.top());
+			queue.pop();
+		}
+	}
+
+	SECTION("clear") {
+		wheel.Clear();
+
+		CHECK(wheel.empty());
+		CHECK(wheel.GetTime() == 0);
+	}
+}
@@ -0,0 +1,249 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include "Sim/Units/CommandAI/CommandQueueStorage.hpp"
+
+#include <algorithm>
+#include <deque>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+#include <catch_amalgamated.hpp>
+
+
+// commands with more than MAX_COMMAND_PARAMS params live in cmdParamsPool
+static Command MakeCommand(int id, unsigned int numParams)
+{
+	Command c(id);
+
+	for (unsigned int i = 0; i < numParams; i++) {
+		c.PushParam(id * 100.0f + i);
+	}
+
+	return c;
+}
+
+static bool SameCommand(const Command& a, const Command& b)
+{
+	if (a.GetID() != b.GetID() || a.GetNumParams() != b.GetNumParams())
+		return false;
+
+	for (unsigned int i = 0; i < a.GetNumParams(); i++) {
+		if (a.GetParam(i) != b.GetParam(i))
+			return false;
+	}
+
+	return true;
+}
+
+static void CheckEqual(const CommandQueueStorage& q, const std::deque<Command>& ref)
+{
+	REQUIRE(q.size() == ref.size());
+	REQUIRE(q.empty() == ref.empty());
+
+	for (size_t i = 0; i < ref.size(); i++) {
+		REQUIRE(SameCommand(q[i], ref[i]));
+	}
+
+	REQUIRE(std::equal(q.begin(), q.end(), ref.begin(), ref.end(), SameCommand));
+	REQUIRE(std::equal(q.rbegin(), q.rend(), ref.rbegin(), ref.rend(), SameCommand));
+}
+
+
+TEST_CASE("CommandQueueStorage_InlineAndPooled")
+{
+	CommandQueueStorage q;
+
+	CHECK(q.empty());
+	CHECK(!q.pooled());
+	CHECK(q.capacity() == CommandQueueStorage::INLINE_CAPACITY);
+
+	for (unsigned int i = 0; i < CommandQueueStorage::INLINE_CAPACITY; i++) {
+		q.push_back(MakeCommand(i, 1));
+	}
+
+	CHECK(!q.pooled());
+
+	q.push_front(MakeCommand(-1, 1));
+
+	CHECK(q.pooled());
+	CHECK(q.capacity() == CommandQueueStorage::MIN_POOLED_CAPACITY);
+	CHECK(q.front().GetID() == -1);
+	CHECK(q.back().GetID() == int(CommandQueueStorage::INLINE_CAPACITY) - 1);
+
+	// draining a pooled queue returns its block and goes back inline
+	while (!q.empty())
+		q.pop_back();
+
+	CHECK(!q.pooled());
+	CHECK_THROWS_AS(q.at(0), std::out_of_range);
+}
+
+TEST_CASE("CommandQueueStorage_SelfReference")
+{
+	CommandQueueStorage q;
+
+	q.push_back(MakeCommand(1, 12));
+	q.push_back(MakeCommand(2, 3));
+
+	// full, so these grow the queue while copying one of its commands
+	q.push_back(q.front());
+	q.push_front(q.back());
+
+	REQUIRE(q.size() == 4);
+	CHECK(SameCommand(q[0], MakeCommand(1, 12)));
+	CHECK(SameCommand(q[1], MakeCommand(1, 12)));
+	CHECK(SameCommand(q[2], MakeCommand(2, 3)));
+	CHECK(SameCommand(q[3], MakeCommand(1, 12)));
+}
+
+TEST_CASE("CommandQueueStorage_StableReferences")
+{
+	CommandQueueStorage q;
+
+	// CommandAI code holds front() while pushing orders around it, which
+	// std::deque allows; growing from inline to pooled and beyond must not
+	// move the held command
+	q.push_back(MakeCommand(1, 3));
+	q.front().SetOpts(SHIFT_KEY);
+
+	Command& c = q.front();
+	const Command* addr = &c;
+
+	for (int i = 0; i < 100; i++) {
+		q.push_front(MakeCommand(-i, MAX_COMMAND_PARAMS + 1));
+		q.push_back(MakeCommand(i + 100, 2));
+
+		REQUIRE(&q[i + 1] == addr);
+	}
+
+	CHECK(c.GetOpts() == SHIFT_KEY);
+	CHECK(SameCommand(c, MakeCommand(1, 3)));
+
+	std::vector<const Command*> addrs;
+
+	for (const Command& qc: q) {
+		addrs.push_back(&qc);
+	}
+
+	q.push_front(q[50]);
+	q.push_back(q[50]);
+
+	for (size_t i = 0; i < addrs.size(); i++) {
+		REQUIRE(&q[i + 1] == addrs[i]);
+	}
+}
+
+TEST_CASE("CommandQueueStorage_BlockReuse")
+{
+	{
+		CommandQueueStorage q;
+
+		for (int i = 0; i < 100; i++) {
+			q.push_back(MakeCommand(i, 0));
+		}
+	}
+
+	const size_t numBytes = cmdQueueBlockPool.GetNumAllocatedBytes();
+
+	for (int n = 0; n < 10; n++) {
+		CommandQueueStorage q;
+
+		for (int i = 0; i < 100; i++) {
+			q.push_back(MakeCommand(i, 0));
+		}
+	}
+
+	CHECK(cmdQueueBlockPool.GetNumAllocatedBytes() == numBytes);
+}
+
+TEST_CASE("CommandQueueStorage_ManyPooledParams")
+{
+	// more live pooled commands than cmdParamsPool allocates pages for at once
+	CommandQueueStorage q;
+
+	for (int i = 0; i < 2000; i++) {
+		q.push_back(MakeCommand(i, MAX_COMMAND_PARAMS + 1 + (i % 5)));
+	}
+
+	for (int i = 0; i < 2000; i++) {
+		REQUIRE(SameCommand(q[i], MakeCommand(i, MAX_COMMAND_PARAMS + 1 + (i % 5))));
+	}
+}
+
+TEST_CASE("CommandQueueStorage_MatchesDeque")
+{
+	std::mt19937 rng(1234);
+	std::uniform_int_distribution<int> op(0, 9);
+	std::uniform_int_distribution<int> numParams(0, 12);
+
+	CommandQueueStorage q;
+	std::deque<Command> ref;
+
+	for (int n = 0; n < 20000; n++) {
+		const int id = n;
+
+		switch (op(rng)) {
+			case 0:
+			case 1: {
+				q.push_back(MakeCommand(id, numParams(rng)));
+				ref.push_back(q.back());
+			} break;
+			case 2:
+			case 3: {
+				q.push_front(MakeCommand(id, numParams(rng)));
+				ref.push_front(q.front());
+			} break;
+			case 4: {
+				if (ref.empty())
+					break;
+
+				q.pop_front();
+				ref.pop_front();
+			} break;
+			case 5: {
+				if (ref.empty())
+					break;
+
+				q.pop_back();
+				ref.pop_back();
+			} break;
+			case 6: {
+				const size_t pos = rng() % (ref.size() + 1);
+				const Command c = MakeCommand(id, numParams(rng));
+
+				const auto qi = q.insert(q.begin() + pos, c);
+				const auto ri = ref.insert(ref.begin() + pos, c);
+
+				CHECK((qi - q.begin()) == (ri - ref.begin()));
+			} break;
+			case 7: {
+				if (ref.empty())
+					break;
+
+				const size_t first = rng() % ref.size();
+				const size_t last = first + rng() % std::min<size_t>(ref.size() - first + 1, 4);
+
+				const auto qi = q.erase(q.begin() + first, q.begin() + last);
+				const auto ri = ref.erase(ref.begin() + first, ref.begin() + last);
+
+				CHECK((qi - q.begin()) == (ri - ref.begin()));
+			} break;
+			case 8: {
+				const auto pred = [&](const Command& c) { return ((c.GetID() % 7) == (id % 7)); };
+
+				q.erase(std::remove_if(q.begin(), q.end(), pred), q.end());
+				ref.erase(std::remove_if(ref.begin(), ref.end(), pred), ref.end());
+			} break;
+			case 9: {
+				if ((n % 97) != 0)
+					break;
+
+				q.clear();
+				ref.clear();
+			} break;
+		}
+
+		CheckEqual(q, ref);
+	}
+}
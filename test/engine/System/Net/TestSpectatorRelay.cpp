@@ -0,0 +1,130 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include "Net/SpectatorRelay.h"
+#include "Net/Protocol/BaseNetProtocol.h"
+#include "System/Net/UDPListener.h"
+#include "System/Net/UDPConnection.h"
+#include "System/Net/RawPacket.h"
+#include "System/Misc/SpringTime.h"
+
+#include <cstring>
+#include <thread>
+
+#include <catch_amalgamated.hpp>
+
+namespace streflop {
+	template<typename T> inline void streflop_init() {
+		// Do nothing by default, or for unknown types
+	}
+}
+
+using PacketType = std::shared_ptr<const netcode::RawPacket>;
+
+static constexpr int NUM_SPECTATORS = 200;
+static constexpr int NUM_FRAMES = 100;
+
+
+// one server listener fanning out frame messages to many spectators over loopback
+TEST_CASE("SpectatorRelay")
+{
+	spring_clock::PushTickRate();
+	spring_time::setstarttime(spring_time::gettime(true));
+
+	netcode::UDPListener listener(27203, "127.0.0.1");
+	CSpectatorRelay relay(4, 0);
+
+	std::vector< std::unique_ptr<netcode::UDPConnection> > clients;
+	std::vector< std::shared_ptr<netcode::CConnection> > links;
+	std::vector< std::vector<PacketType> > received(NUM_SPECTATORS);
+	std::vector<PacketType> sent;
+
+	const auto Pump = [&]() {
+		relay.Wait();
+		listener.Update();
+		relay.Start();
+
+		for (int i = 0; i < NUM_SPECTATORS; i++) {
+			clients[i]->Update();
+			clients[i]->Flush(true);
+
+			while (clients[i]->HasIncomingData()) {
+				received[i].push_back(clients[i]->GetData());
+			}
+		}
+
+		std::this_thread::sleep_for(std::chrono::milliseconds(2));
+	};
+
+	for (int i = 0; i < NUM_SPECTATORS; i++) {
+		clients.emplace_back(new netcode::UDPConnection(0, "127.0.0.1", 27203));
+		clients.back()->Unmute();
+		// announce ourselves, see UDPConnection::ProcessRawPacket
+		clients.back()->SendData(CBaseNetProtocol::Get().SendPing(0, 0, 0.0f));
+		clients.back()->Flush(true);
+	}
+
+	for (int n = 0; n < 100 && links.size() < NUM_SPECTATORS; n++) {
+		Pump();
+
+		while (listener.HasIncomingConnections()) {
+			std::shared_ptr<netcode::UDPConnection> conn = listener.AcceptConnection();
+
+			conn->Unmute();
+			listener.DetachConnection(conn);
+			links.push_back(relay.AddLink(conn));
+		}
+	}
+
+	REQUIRE(links.size() == NUM_SPECTATORS);
+
+	// let both ends of every link see each other's first chunks
+	for (int n = 0; n < 10; n++) {
+		Pump();
+	}
+
+	for (int frameNum = 0; frameNum < NUM_FRAMES; frameNum++) {
+		const float params[] = {1024.0f, 0.0f, frameNum * 8.0f};
+
+		sent.push_back(CBaseNetProtocol::Get().SendNewFrame());
+		sent.push_back(CBaseNetProtocol::Get().SendKeyFrame(frameNum));
+		sent.push_back(CBaseNetProtocol::Get().SendCommand(frameNum % 4, 10, 0, 0, 3, params));
+
+		// the server thread only ever queues messages on relayed links
+		for (const std::shared_ptr<netcode::CConnection>& link: links) {
+			for (size_t i = sent.size() - 3; i < sent.size(); i++) {
+				link->SendData(sent[i]);
+			}
+		}
+
+		Pump();
+
+		// the server thread also flushes and closes links directly while
+		// the workers are sending through the same socket
+		links[frameNum % NUM_SPECTATORS]->Flush(true);
+	}
+
+	const auto AllReceived = [&]() {
+		for (const std::vector<PacketType>& msgs: received) {
+			if (msgs.size() < sent.size())
+				return false;
+		}
+
+		return true;
+	};
+
+	for (int n = 0; n < 500 && !AllReceived(); n++) {
+		Pump();
+	}
+
+	relay.Wait();
+
+	for (int i = 0; i < NUM_SPECTATORS; i++) {
+		INFO("spectator " << i);
+		REQUIRE(received[i].size() == sent.size());
+
+		for (size_t j = 0; j < sent.size(); j++) {
+			REQUIRE(received[i][j]->length == sent[j]->length);
+			REQUIRE(memcmp(received[i][j]->data, sent[j]->data, sent[j]->length) == 0);
+		}
+	}
+}
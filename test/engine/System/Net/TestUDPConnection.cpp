@@ -0,0 +1,225 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include "System/Net/UDPConnection.h"
+#include "System/Net/RawPacket.h"
+#include "System/GlobalConfig.h"
+#include "System/Misc/SpringTime.h"
+#include "Net/Protocol/BaseNetProtocol.h"
+
+#include <cstring>
+#include <thread>
+
+#include <catch_amalgamated.hpp>
+
+namespace streflop {
+	template<typename T> inline void streflop_init() {
+		// Do nothing by default, or for unknown types
+	}
+}
+
+using PacketType = std::shared_ptr<const netcode::RawPacket>;
+
+
+static std::vector<PacketType> GetFrameMessages(int frameNum)
+{
+	CBaseNetProtocol& proto = CBaseNetProtocol::Get();
+	std::vector<PacketType> msgs;
+
+	const float params[] = {1024.0f, 0.0f, frameNum * 8.0f};
+
+	msgs.push_back(proto.SendNewFrame());
+	msgs.push_back(proto.SendKeyFrame(frameNum));
+	msgs.push_back(proto.SendPlayerInfo(frameNum % 4, 0.5f, 100));
+	msgs.push_back(proto.SendCommand(frameNum % 4, 10, 0, 0, 3, params));
+	msgs.push_back(proto.SendSyncResponse(frameNum % 4, frameNum, 0x1234));
+	msgs.push_back(proto.SendCommand((frameNum + 1) % 4, 20, 0, 0, 3, params));
+	msgs.push_back(proto.SendNewFrame());
+	return msgs;
+}
+
+static void InitClock()
+{
+	[[maybe_unused]] static const bool init = [] {
+		spring_clock::PushTickRate();
+		spring_time::setstarttime(spring_time::gettime(true));
+		return true;
+	}();
+}
+
+// sends a number of frame windows from one connection to another over loopback
+static void Exchange(bool compressA, bool compressB, unsigned* bytesReceived, std::string* stats)
+{
+	globalConfig.networkCompression = compressA;
+	netcode::UDPConnection a(27201, "127.0.0.1", 27202);
+	globalConfig.networkCompression = compressB;
+	netcode::UDPConnection b(27202, "127.0.0.1", 27201);
+
+	a.Unmute();
+	b.Unmute();
+
+	std::vector<PacketType> sent;
+	std::vector<PacketType> recv;
+
+	const auto Pump = [&]() {
+		a.Update();
+		b.Update();
+		a.Flush(true);
+		b.Flush(true);
+
+		while (b.HasIncomingData()) {
+			recv.push_back(b.GetData());
+		}
+
+		std::this_thread::sleep_for(std::chrono::milliseconds(5));
+	};
+
+	// a connection whose peer has not yet received anything from it treats
+	// all incoming chunks after the first one as reconnection attempts
+	b.SendData(CBaseNetProtocol::Get().SendPing(0, 0, 0.0f));
+
+	// let both ends announce themselves
+	for (int i = 0; i < 10; i++) {
+		Pump();
+	}
+
+	for (int frameNum = 0; frameNum < 50; frameNum++) {
+		for (const PacketType& msg: GetFrameMessages(frameNum)) {
+			a.SendData(msg);
+			sent.push_back(msg);
+		}
+
+		Pump();
+	}
+
+	for (int i = 0; i < 200 && recv.size() < sent.size(); i++) {
+		Pump();
+	}
+
+	REQUIRE(recv.size() == sent.size());
+
+	for (size_t i = 0; i < sent.size(); i++) {
+		CHECK(recv[i]->length == sent[i]->length);
+		CHECK(memcmp(recv[i]->data, sent[i]->data, sent[i]->length) == 0);
+	}
+
+	*bytesReceived = b.GetDataReceived();
+	*stats = a.Statistics();
+
+	globalConfig.networkCompression = true;
+}
+
+
+TEST_CASE("UDPConnectionCompression")
+{
+	InitClock();
+
+	unsigned plainBytes = 0;
+	unsigned blockBytes = 0;
+	unsigned halfBytes = 0;
+
+	std::string plainStats;
+	std::string blockStats;
+	std::string halfStats;
+
+	Exchange(false, false, &plainBytes, &plainStats);
+	Exchange( true,  true, &blockBytes, &blockStats);
+	// only the sender asking for compression must not enable it
+	Exchange( true, false, &halfBytes, &halfStats);
+
+	INFO(plainStats);
+	INFO(blockStats);
+	INFO(halfStats);
+
+	CHECK(blockBytes < plainBytes);
+
+	CHECK(plainStats.find("{0.000x, 0.000x} compression ratio") != std::string::npos);
+	CHECK( halfStats.find("{0.000x, 0.000x} compression ratio") != std::string::npos);
+	CHECK(blockStats.find("{0.000x, 0.000x} compression ratio") == std::string::npos);
+}
+
+TEST_CASE("UDPConnectionReconnect")
+{
+	InitClock();
+
+	// the client starts out without compression support
+	globalConfig.networkCompression = true;
+	netcode::UDPConnection a(27211, "127.0.0.1", 27212);
+	globalConfig.networkCompression = false;
+	netcode::UDPConnection b(27212, "127.0.0.1", 27211);
+
+	a.Unmute();
+	b.Unmute();
+
+	std::vector<PacketType> sent;
+	std::vector<PacketType> recv;
+
+	const auto Pump = [&]() {
+		a.Update();
+		b.Update();
+		a.Flush(true);
+		b.Flush(true);
+
+		while (b.HasIncomingData()) {
+			recv.push_back(b.GetData());
+		}
+
+		std::this_thread::sleep_for(std::chrono::milliseconds(5));
+	};
+
+	const auto SendFrames = [&](int firstFrame, int lastFrame) {
+		for (int frameNum = firstFrame; frameNum < lastFrame; frameNum++) {
+			for (const PacketType& msg: GetFrameMessages(frameNum)) {
+				a.SendData(msg);
+				sent.push_back(msg);
+			}
+
+			Pump();
+		}
+
+		for (int i = 0; i < 200 && recv.size() < sent.size(); i++) {
+			Pump();
+		}
+	};
+
+	b.SendData(CBaseNetProtocol::Get().SendPing(0, 0, 0.0f));
+
+	for (int i = 0; i < 10; i++) {
+		Pump();
+	}
+
+	SendFrames(0, 20);
+	REQUIRE(recv.size() == sent.size());
+	CHECK(a.Statistics().find("{0.000x, 0.000x} compression ratio") != std::string::npos);
+
+	// the client moves to another address, now announcing itself before its
+	// reconnect attempt, which the server receives on a temporary link
+	globalConfig.networkCompression = true;
+	netcode::UDPConnection clientTemp(27213, "127.0.0.1", 27214);
+	netcode::UDPConnection serverTemp(27214, "127.0.0.1", 27213);
+
+	clientTemp.Unmute();
+	clientTemp.SendData(CBaseNetProtocol::Get().SendPing(1, 0, 0.0f));
+	clientTemp.Flush(true);
+
+	for (int i = 0; i < 100 && !serverTemp.HasIncomingData(); i++) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(5));
+		serverTemp.Update();
+	}
+
+	REQUIRE(serverTemp.HasIncomingData());
+
+	b.ReconnectTo(clientTemp);
+	a.ReconnectTo(serverTemp);
+
+	// both ends have to learn about each other again before blocks are sent
+	SendFrames(20, 60);
+	REQUIRE(recv.size() == sent.size());
+
+	for (size_t i = 0; i < sent.size(); i++) {
+		CHECK(recv[i]->length == sent[i]->length);
+		CHECK(memcmp(recv[i]->data, sent[i]->data, sent[i]->length) == 0);
+	}
+
+	INFO(a.Statistics());
+	CHECK(a.Statistics().find("{0.000x, 0.000x} compression ratio") == std::string::npos);
+}
@@ -0,0 +1,208 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include "System/TimeProfiler.h"
+#include "System/Misc/SpringTime.h"
+
+#include <atomic>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <catch_amalgamated.hpp>
+
+InitSpringTime ist;
+
+// a few more than fit into one thread's queue (TimerQueue::NUM_EVENTS)
+static constexpr int NUM_QUEUE_EVENTS = 8192 * 3 + 17;
+static constexpr int NUM_THREADS = 4;
+static constexpr int NUM_THREAD_EVENTS = 20000;
+
+static const char* TRACE_TIMER_NAME = "Test::\"quoted\" \\path\\\t";
+static const char* TRACE_TIMER_JSON = "\"name\":\"Test::\\\"quoted\\\" \\\\path\\\\\\u0009\"";
+
+
+static void AddTimes(const char* name, int count, bool specialTimer = false)
+{
+	CTimeProfiler& profiler = CTimeProfiler::GetInstance();
+
+	for (int i = 0; i < count; i++) {
+		profiler.AddTime(hashString(name), spring_gettime(), spring_msecs(1), false, specialTimer);
+	}
+}
+
+static int GetTotalMillis(const char* name)
+{
+	return CTimeProfiler::GetInstance().GetTimeRecord(name).total.toMilliSecsi();
+}
+
+static size_t CountOf(const std::string& str, const std::string& sub)
+{
+	size_t count = 0;
+
+	for (size_t pos = str.find(sub); pos != std::string::npos; pos = str.find(sub, pos + sub.size())) {
+		count++;
+	}
+
+	return count;
+}
+
+// one trace event per line; braces must balance outside of strings, and
+// strings may not hold anything JSON requires to be escaped
+static bool IsWellFormedEvent(const std::string& line)
+{
+	int depth = 0;
+	bool inString = false;
+
+	for (size_t i = 0; i < line.size(); i++) {
+		const char c = line[i];
+
+		if (inString) {
+			if (static_cast<unsigned char>(c) < 0x20)
+				return false;
+
+			if (c == '\\') {
+				if (++i >= line.size() || std::string("\"\\/bfnrtu").find(line[i]) == std::string::npos)
+					return false;
+			} else if (c == '"') {
+				inString = false;
+			}
+
+			continue;
+		}
+
+		switch (c) {
+			case '"': { inString = true; } break;
+			case '{': { depth++; } break;
+			case '}': { depth--; } break;
+			default: {} break;
+		}
+
+		if (depth < 0)
+			return false;
+	}
+
+	return (!inString && depth == 0 && line.front() == '{' && line.back() == '}');
+}
+
+
+TEST_CASE("TimeProfiler_Queue")
+{
+	CTimeProfiler& profiler = CTimeProfiler::GetInstance();
+
+	profiler.ResetState();
+	profiler.SetEnabled(true);
+
+	SECTION("a full queue is drained, not dropped") {
+		AddTimes("Test::Queue", NUM_QUEUE_EVENTS);
+
+		// nothing merged yet except what the full queue forced out
+		CHECK(GetTotalMillis("Test::Queue") < NUM_QUEUE_EVENTS);
+
+		profiler.Merge();
+		CHECK(GetTotalMillis("Test::Queue") == NUM_QUEUE_EVENTS);
+	}
+
+	SECTION("timings of concurrent threads are all merged") {
+		std::vector<std::thread> threads;
+		std::atomic<int> numDone = {0};
+
+		for (int i = 0; i < NUM_THREADS; i++) {
+			threads.emplace_back([&]() {
+				AddTimes("Test::Threads", NUM_THREAD_EVENTS);
+				numDone += 1;
+			});
+		}
+
+		while (numDone < NUM_THREADS) {
+			profiler.Merge();
+		}
+
+		for (std::thread& t: threads) {
+			t.join();
+		}
+
+		// the queues of exited threads are merged and handed on
+		std::thread([&]() { AddTimes("Test::Threads", NUM_THREAD_EVENTS); }).join();
+
+		profiler.Merge();
+		CHECK(GetTotalMillis("Test::Threads") == (NUM_THREADS + 1) * NUM_THREAD_EVENTS);
+	}
+
+	SECTION("only special timers are queued while not recording") {
+		profiler.SetEnabled(false);
+
+		AddTimes("Test::Normal", 10);
+		AddTimes("Test::Special", 10, true);
+
+		profiler.Merge();
+		CHECK(GetTotalMillis("Test::Normal") == 0);
+		CHECK(GetTotalMillis("Test::Special") == 10);
+	}
+
+	profiler.ResetState();
+}
+
+TEST_CASE("TimeProfiler_Trace")
+{
+	CTimeProfiler& profiler = CTimeProfiler::GetInstance();
+	CTimeProfiler::RegisterTimer(TRACE_TIMER_NAME);
+
+	const std::string fileName = (std::filesystem::temp_directory_path() / "testTimeProfiler.json").string();
+
+	profiler.ResetState();
+	profiler.SetEnabled(true);
+
+	// timings started before the trace are not part of it
+	AddTimes(TRACE_TIMER_NAME, 5);
+	spring_sleep(spring_msecs(2));
+
+	REQUIRE(profiler.StartTrace(fileName));
+	CHECK(!profiler.StartTrace(fileName));
+
+	// enough to be written out in more than one piece
+	for (int i = 0; i < NUM_QUEUE_EVENTS; i += 1000) {
+		AddTimes(TRACE_TIMER_NAME, std::min(1000, NUM_QUEUE_EVENTS - i));
+		profiler.Merge();
+	}
+
+	AddTimes("Test::Unregistered", 1);
+	profiler.StopTrace();
+
+	CHECK(GetTotalMillis(TRACE_TIMER_NAME) == NUM_QUEUE_EVENTS + 5);
+
+	std::ifstream file(fileName, std::ios::binary);
+	const std::string trace = {std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+
+	REQUIRE(trace.size() > 4);
+	CHECK(trace.substr(0, 2) == "[\n");
+	CHECK(trace.substr(trace.size() - 3) == "\n]\n");
+
+	CHECK(CountOf(trace, "\"ph\":\"X\"") == NUM_QUEUE_EVENTS + 1);
+	CHECK(CountOf(trace, TRACE_TIMER_JSON) == NUM_QUEUE_EVENTS);
+	CHECK(CountOf(trace, "\"name\":\"???\"") == 1);
+	// only this thread contributed
+	CHECK(CountOf(trace, "\"ph\":\"M\"") == 1);
+
+	std::istringstream lines(trace.substr(2, trace.size() - 5));
+	size_t numLines = 0;
+
+	for (std::string line; std::getline(lines, line); numLines++) {
+		if (!line.empty() && line.back() == ',')
+			line.pop_back();
+
+		INFO(line);
+		REQUIRE(IsWellFormedEvent(line));
+	}
+
+	CHECK(numLines == NUM_QUEUE_EVENTS + 2);
+
+	file.close();
+	std::remove(fileName.c_str());
+
+	CTimeProfiler::UnRegisterTimer(TRACE_TIMER_NAME);
+	profiler.ResetState();
+}
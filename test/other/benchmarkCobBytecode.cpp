@@ -0,0 +1,234 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include "Sim/Units/Scripts/CobBytecode.h"
+#include "Sim/Units/Scripts/CobOpcodes.h"
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+// Runs over a corpus of real .cob files, taken from the directory named by
+// the COB_CORPUS_DIR environment variable (e.g. a game's scripts/ folder).
+//
+// BenchDecode measures the load-time cost added to CCobFileHandler, the two
+// sweeps compare raw and pre-decoded instruction fetch along every script's
+// code without executing it; end-to-end numbers come from toggling the
+// CobPreDecode config in-game and comparing CCobEngine::Tick profiles.
+
+namespace {
+	struct CobCorpusFile {
+		std::vector<int> code;
+		std::vector<std::string> scriptNames;
+		std::vector<int> scriptLengths;
+		std::vector<int> scriptOffsets;
+
+		std::vector<SCobInstr> instrs;
+	};
+
+	// same layout as read by CCobFile, little-endian hosts only
+	bool ParseCobFile(const std::vector<uint8_t>& data, CobCorpusFile& file)
+	{
+		const auto ReadInt = [&](size_t ofs) {
+			int v = 0;
+			if ((ofs + sizeof(v)) <= data.size())
+				memcpy(&v, &data[ofs], sizeof(v));
+			return v;
+		};
+		const auto ReadString = [&](size_t ofs) {
+			std::string s;
+			while (ofs < data.size() && data[ofs] != 0)
+				s += char(data[ofs++]);
+			return s;
+		};
+
+		if (data.size() < 11 * sizeof(int))
+			return false;
+
+		const int numScripts = ReadInt(1 * 4);
+		const int totalScriptLen = ReadInt(3 * 4);
+		const int codeIndexOfs = ReadInt(6 * 4);
+		const int nameIndexOfs = ReadInt(7 * 4);
+		const int codeOfs = ReadInt(9 * 4);
+
+		if (numScripts <= 0 || codeOfs <= 0 || size_t(codeOfs) > data.size())
+			return false;
+
+		for (int i = 0; i < numScripts; ++i) {
+			file.scriptNames.push_back(ReadString(ReadInt(nameIndexOfs + i * 4)));
+			file.scriptOffsets.push_back(ReadInt(codeIndexOfs + i * 4));
+		}
+		for (int i = 0; i < numScripts - 1; ++i) {
+			file.scriptLengths.push_back(file.scriptOffsets[i + 1] - file.scriptOffsets[i]);
+		}
+
+		file.scriptLengths.push_back(totalScriptLen - file.scriptOffsets[numScripts - 1]);
+
+		const size_t codeBytes = data.size() - codeOfs;
+		file.code.resize(codeBytes / 4 + 4);
+		memcpy(file.code.data(), &data[codeOfs], codeBytes);
+		return true;
+	}
+
+	const std::vector<CobCorpusFile>& GetCorpus()
+	{
+		static std::vector<CobCorpusFile> corpus;
+
+		if (!corpus.empty())
+			return corpus;
+
+		const char* dir = std::getenv("COB_CORPUS_DIR");
+
+		if (dir == nullptr)
+			return corpus;
+
+		for (const auto& entry: std::filesystem::recursive_directory_iterator(dir)) {
+			if (!entry.is_regular_file())
+				continue;
+
+			std::string ext = entry.path().extension().string();
+			for (char& c: ext) {
+				c = std::tolower(c);
+			}
+
+			if (ext != ".cob")
+				continue;
+
+			std::ifstream ifs(entry.path(), std::ios::binary);
+			const std::vector<uint8_t> data((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
+
+			CobCorpusFile file;
+
+			if (!ParseCobFile(data, file))
+				continue;
+
+			CobBytecode::Decode(file.code, file.scriptNames, file.scriptLengths, file.instrs);
+			corpus.push_back(std::move(file));
+		}
+
+		return corpus;
+	}
+
+	// operand count per raw opcode, as consumed by CCobThread::TickRaw
+	inline int GetNumRawOperands(int opcode)
+	{
+		switch (opcode) {
+			case MOVE: case TURN: case SPIN: case STOP_SPIN: case MOVE_NOW: case TURN_NOW:
+			case WAIT_TURN: case WAIT_MOVE: case START: case CALL: case REAL_CALL: case LUA_CALL:
+				return 2;
+			case SHOW: case HIDE: case CACHE: case DONT_CACHE: case SHADE: case DONT_SHADE: case EMIT_SFX:
+			case PUSH_CONSTANT: case PUSH_LOCAL_VAR: case PUSH_STATIC: case POP_LOCAL_VAR: case POP_STATIC:
+			case JUMP: case JUMP_NOT_EQUAL: case EXPLODE: case PLAY_SOUND:
+				return 1;
+			default:
+				break;
+		}
+
+		return 0;
+	}
+}
+
+
+static void BenchDecode(benchmark::State& state) {
+	const std::vector<CobCorpusFile>& corpus = GetCorpus();
+
+	if (corpus.empty()) {
+		state.SkipWithError("COB_CORPUS_DIR is not set or contains no .cob files");
+		return;
+	}
+
+	std::vector<SCobInstr> instrs;
+	CobBytecode::DecodeStats stats;
+	CobBytecode::DecodeStats totals;
+
+	for (const CobCorpusFile& file: corpus) {
+		CobBytecode::Decode(file.code, file.scriptNames, file.scriptLengths, instrs, &stats);
+
+		totals.numInstrs += stats.numInstrs;
+		totals.numRaw += stats.numRaw;
+		totals.numFused += stats.numFused;
+	}
+
+	for (auto _ : state) {
+		for (const CobCorpusFile& file: corpus) {
+			CobBytecode::Decode(file.code, file.scriptNames, file.scriptLengths, instrs);
+			benchmark::DoNotOptimize(instrs.data());
+		}
+	}
+
+	state.counters["files"] = corpus.size();
+	state.counters["instrs"] = totals.numInstrs;
+	state.counters["raw"] = totals.numRaw;
+	state.counters["fused"] = totals.numFused;
+}
+
+static void BenchSweepRaw(benchmark::State& state) {
+	const std::vector<CobCorpusFile>& corpus = GetCorpus();
+
+	if (corpus.empty()) {
+		state.SkipWithError("COB_CORPUS_DIR is not set or contains no .cob files");
+		return;
+	}
+
+	for (auto _ : state) {
+		int sum = 0;
+
+		for (const CobCorpusFile& file: corpus) {
+			for (size_t s = 0; s < file.scriptOffsets.size(); s++) {
+				const int end = file.scriptOffsets[s] + file.scriptLengths[s];
+
+				for (int pc = file.scriptOffsets[s]; pc >= 0 && pc < end && size_t(pc) < file.code.size(); ) {
+					const int numArgs = GetNumRawOperands(file.code[pc++]);
+
+					for (int i = 0; i < numArgs && size_t(pc) < file.code.size(); i++) {
+						sum += file.code[pc++];
+					}
+				}
+			}
+		}
+
+		benchmark::DoNotOptimize(sum);
+	}
+}
+
+static void BenchSweepDecoded(benchmark::State& state) {
+	const std::vector<CobCorpusFile>& corpus = GetCorpus();
+
+	if (corpus.empty()) {
+		state.SkipWithError("COB_CORPUS_DIR is not set or contains no .cob files");
+		return;
+	}
+
+	for (auto _ : state) {
+		int sum = 0;
+
+		for (const CobCorpusFile& file: corpus) {
+			for (size_t s = 0; s < file.scriptOffsets.size(); s++) {
+				const int end = file.scriptOffsets[s] + file.scriptLengths[s];
+
+				for (int pc = file.scriptOffsets[s]; pc >= 0 && pc < end && size_t(pc) < file.instrs.size(); ) {
+					const SCobInstr& ins = file.instrs[pc];
+
+					sum += ins.arg0 + ins.arg1;
+					pc = std::max(pc + 1, ins.next);
+				}
+			}
+		}
+
+		benchmark::DoNotOptimize(sum);
+	}
+}
+
+BENCHMARK(BenchDecode);
+BENCHMARK(BenchSweepRaw);
+BENCHMARK(BenchSweepDecoded);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,166 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include "Sim/Units/CommandAI/CommandQueueStorage.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <vector>
+
+// 5000 command queues of a given length, the way CCommandAI used to hold them
+// (std::deque<Command>) against CommandQueueStorage. The memory counters are
+// the bytes per queue including the queue object itself; the iteration runs
+// walk every queue front to back like SlowUpdate and the command drawers do,
+// and the churn runs model units finishing and receiving orders each frame.
+
+namespace {
+	constexpr int NUM_QUEUES = 5000;
+
+	size_t dequeHeapBytes = 0;
+
+	template<typename T> struct CountingAllocator {
+		using value_type = T;
+
+		CountingAllocator() = default;
+		template<typename U> CountingAllocator(const CountingAllocator<U>&) {}
+
+		T* allocate(size_t n) {
+			dequeHeapBytes += (n * sizeof(T));
+			return (std::allocator<T>().allocate(n));
+		}
+		void deallocate(T* p, size_t n) {
+			dequeHeapBytes -= (n * sizeof(T));
+			std::allocator<T>().deallocate(p, n);
+		}
+
+		template<typename U> bool operator == (const CountingAllocator<U>&) const { return true; }
+		template<typename U> bool operator != (const CountingAllocator<U>&) const { return false; }
+	};
+
+	using CommandDeque = std::deque<Command, CountingAllocator<Command>>;
+
+
+	Command MakeCommand(int i)
+	{
+		Command c(i % 20, 0, float3(i * 1.0f, 0.0f, i * 2.0f));
+
+		// every 16th command carries enough params to spill into cmdParamsPool
+		if ((i & 15) == 0) {
+			for (int p = 0; p < 6; p++) {
+				c.PushParam(p * 1.0f);
+			}
+		}
+
+		return c;
+	}
+
+	template<typename Q> void Fill(std::vector<std::unique_ptr<Q>>& queues, int numCommands)
+	{
+		queues.clear();
+
+		for (int q = 0; q < NUM_QUEUES; q++) {
+			Q& queue = *queues.emplace_back(std::make_unique<Q>());
+
+			for (int i = 0; i < numCommands; i++) {
+				queue.push_back(MakeCommand(q + i));
+			}
+		}
+	}
+
+	size_t StorageBytes(const std::vector<std::unique_ptr<CommandQueueStorage>>& queues)
+	{
+		size_t numBytes = 0;
+
+		for (const auto& q: queues) {
+			numBytes += sizeof(CommandQueueStorage);
+			numBytes += (q->pooled() * q->capacity() * sizeof(Command));
+		}
+
+		return numBytes;
+	}
+}
+
+
+static void BenchDequeMemory(benchmark::State& state)
+{
+	std::vector<std::unique_ptr<CommandDeque>> queues;
+
+	for (auto _: state) {
+		Fill(queues, state.range(0));
+		benchmark::DoNotOptimize(queues.data());
+	}
+
+	state.counters["bytesPerQueue"] = double(sizeof(CommandDeque) * NUM_QUEUES + dequeHeapBytes) / NUM_QUEUES;
+}
+
+static void BenchStorageMemory(benchmark::State& state)
+{
+	std::vector<std::unique_ptr<CommandQueueStorage>> queues;
+
+	for (auto _: state) {
+		Fill(queues, state.range(0));
+		benchmark::DoNotOptimize(queues.data());
+	}
+
+	state.counters["bytesPerQueue"] = double(StorageBytes(queues)) / NUM_QUEUES;
+	state.counters["poolBytes"] = cmdQueueBlockPool.GetNumAllocatedBytes();
+}
+
+
+template<typename Q> static void BenchIterate(benchmark::State& state)
+{
+	std::vector<std::unique_ptr<Q>> queues;
+	Fill(queues, state.range(0));
+
+	for (auto _: state) {
+		float sum = 0.0f;
+
+		for (const auto& q: queues) {
+			for (const Command& c: *q) {
+				sum += (c.GetID() + c.GetParam(0));
+			}
+		}
+
+		benchmark::DoNotOptimize(sum);
+	}
+
+	state.SetItemsProcessed(state.iterations() * NUM_QUEUES * state.range(0));
+}
+
+template<typename Q> static void BenchChurn(benchmark::State& state)
+{
+	std::vector<std::unique_ptr<Q>> queues;
+	Fill(queues, state.range(0));
+
+	int n = 0;
+
+	for (auto _: state) {
+		for (const auto& q: queues) {
+			// finish the current order, get a new one shift-queued and
+			// occasionally an internal order pushed in front
+			q->pop_front();
+			q->push_back(MakeCommand(n++));
+
+			if ((n & 7) == 0) {
+				q->push_front(MakeCommand(n));
+				q->pop_front();
+			}
+		}
+	}
+
+	state.SetItemsProcessed(state.iterations() * NUM_QUEUES);
+}
+
+
+BENCHMARK(BenchDequeMemory)->Arg(1)->Arg(4)->Arg(32)->Arg(256);
+BENCHMARK(BenchStorageMemory)->Arg(1)->Arg(4)->Arg(32)->Arg(256);
+
+BENCHMARK_TEMPLATE(BenchIterate, CommandDeque)->Arg(1)->Arg(4)->Arg(32)->Arg(256);
+BENCHMARK_TEMPLATE(BenchIterate, CommandQueueStorage)->Arg(1)->Arg(4)->Arg(32)->Arg(256);
+
+BENCHMARK_TEMPLATE(BenchChurn, CommandDeque)->Arg(1)->Arg(4)->Arg(32);
+BENCHMARK_TEMPLATE(BenchChurn, CommandQueueStorage)->Arg(1)->Arg(4)->Arg(32);
+
+BENCHMARK_MAIN();
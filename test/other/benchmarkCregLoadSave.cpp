@@ -0,0 +1,200 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include "System/creg/creg_cond.h"
+#include "System/creg/Serializer.h"
+#include <algorithm>
+#include <cstdlib>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <catch_amalgamated.hpp>
+
+// number of graph nodes, override with CREG_BENCH_NUM_OBJECTS=<n>
+static constexpr int DEFAULT_NUM_OBJECTS = 10000;
+
+
+struct BenchPayload {
+	CR_DECLARE_STRUCT(BenchPayload)
+
+	int id = 0;
+	float weight = 0.0f;
+};
+
+CR_BIND(BenchPayload, )
+CR_REG_METADATA(BenchPayload, (
+	CR_MEMBER(id),
+	CR_MEMBER(weight)
+))
+
+
+struct BenchNode {
+	CR_DECLARE_STRUCT(BenchNode)
+
+	int id = 0;
+	std::vector<int> values;
+
+	// random edges, plus a pointer into an embedded member of another node
+	BenchNode* edges[3] = {nullptr, nullptr, nullptr};
+	BenchPayload* foreignPayload = nullptr;
+
+	BenchPayload payload;
+};
+
+CR_BIND(BenchNode, )
+CR_REG_METADATA(BenchNode, (
+	CR_MEMBER(id),
+	CR_MEMBER(values),
+	CR_MEMBER(edges),
+	CR_MEMBER(foreignPayload),
+	CR_MEMBER(payload)
+))
+
+
+struct BenchGraph {
+	CR_DECLARE_STRUCT(BenchGraph)
+
+	~BenchGraph() {
+		for (BenchNode* n: nodes) {
+			delete n;
+		}
+	}
+
+	std::vector<BenchNode*> nodes;
+};
+
+CR_BIND(BenchGraph, )
+CR_REG_METADATA(BenchGraph, (
+	CR_MEMBER(nodes)
+))
+
+
+static int GetNumObjects()
+{
+	const char* env = std::getenv("CREG_BENCH_NUM_OBJECTS");
+
+	if (env == nullptr)
+		return DEFAULT_NUM_OBJECTS;
+
+	return std::max(1, std::atoi(env));
+}
+
+static BenchGraph* CreateGraph(int numNodes)
+{
+	BenchGraph* graph = new BenchGraph();
+	graph->nodes.reserve(numNodes);
+
+	for (int i = 0; i < numNodes; i++) {
+		BenchNode* n = new BenchNode();
+		n->id = i;
+		n->payload.id = i;
+		n->payload.weight = i * 0.5f;
+		n->values.assign(i % 7, i);
+
+		graph->nodes.push_back(n);
+	}
+
+	// deterministic LCG so every run saves the same graph
+	unsigned int seed = 1234567;
+	const auto next = [&]() { return ((seed = seed * 1103515245u + 12345u) >> 8) % numNodes; };
+
+	for (BenchNode* n: graph->nodes) {
+		for (BenchNode*& e: n->edges) {
+			e = graph->nodes[next()];
+		}
+
+		n->foreignPayload = &graph->nodes[next()]->payload;
+	}
+
+	return graph;
+}
+
+static bool CompareGraphs(const BenchGraph* a, const BenchGraph* b)
+{
+	if (a->nodes.size() != b->nodes.size())
+		return false;
+
+	for (size_t i = 0; i < a->nodes.size(); i++) {
+		const BenchNode* na = a->nodes[i];
+		const BenchNode* nb = b->nodes[i];
+
+		if (na->id != nb->id || na->values != nb->values)
+			return false;
+		if (na->payload.id != nb->payload.id || na->payload.weight != nb->payload.weight)
+			return false;
+
+		for (int j = 0; j < 3; j++) {
+			if (na->edges[j]->id != nb->edges[j]->id)
+				return false;
+		}
+
+		// must point at the embedded payload of the loaded node, not a copy
+		if (na->foreignPayload->id != nb->foreignPayload->id)
+			return false;
+		if (nb->foreignPayload != &b->nodes[nb->foreignPayload->id]->payload)
+			return false;
+	}
+
+	return true;
+}
+
+static void SaveGraph(BenchGraph* graph, std::stringstream& ss)
+{
+	creg::COutputStreamSerializer os;
+	os.SavePackage(&ss, graph, graph->GetClass());
+}
+
+static BenchGraph* LoadGraph(std::stringstream& ss)
+{
+	void* root = nullptr;
+	creg::Class* rootCls = nullptr;
+
+	creg::CInputStreamSerializer is;
+	is.LoadPackage(&ss, root, rootCls);
+
+	return static_cast<BenchGraph*>(root);
+}
+
+
+
+TEST_CASE("CregLoadSaveBenchmark")
+{
+	const int numObjects = GetNumObjects();
+	BenchGraph* graph = CreateGraph(numObjects);
+
+	std::stringstream package(std::ios::in | std::ios::out | std::ios::binary);
+	SaveGraph(graph, package);
+
+	{
+		package.seekg(0);
+		BenchGraph* loaded = LoadGraph(package);
+
+		INFO("graph with " << numObjects << " nodes survives a save/load roundtrip");
+		CHECK(CompareGraphs(graph, loaded));
+
+		delete loaded;
+	}
+
+	BENCHMARK("Save") {
+		std::stringstream ss(std::ios::in | std::ios::out | std::ios::binary);
+		SaveGraph(graph, ss);
+		return ss.tellp();
+	};
+
+	BENCHMARK_ADVANCED("Load")(Catch::Benchmark::Chronometer meter) {
+		std::vector<BenchGraph*> loaded(meter.runs(), nullptr);
+		std::vector<std::stringstream> packages(meter.runs());
+
+		for (std::stringstream& ss: packages) {
+			ss.str(package.str());
+		}
+
+		meter.measure([&](int i) { loaded[i] = LoadGraph(packages[i]); });
+
+		for (BenchGraph* g: loaded) {
+			delete g;
+		}
+	};
+
+	delete graph;
+}
@@ -0,0 +1,164 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include "System/EventBatch.h"
+
+#include "lib/lua/include/lua.h"
+#include "lib/lua/include/lualib.h"
+#include "lib/lua/include/lauxlib.h"
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <iterator>
+#include <type_traits>
+#include <vector>
+
+// Lua call overhead of delivering a frame's worth of UnitDamaged events one
+// call-in per event (as CLuaHandle::UnitDamaged does: traceback handler,
+// global lookup, ten arguments, pcall) against a single UnitDamagedBatch
+// call-in with packed arrays, whose tables are kept in the registry and
+// refilled each frame like CLuaHandle::PushBatchArray does. Both Lua handlers
+// do the same trivial work.
+
+namespace {
+	constexpr const char* HANDLERS = R"(
+		damageSum = 0
+
+		function UnitDamaged(unitID, unitDefID, unitTeam, damage, paralyzer, weaponDefID, projectileID, attackerID, attackerDefID, attackerTeam)
+			damageSum = damageSum + damage
+		end
+
+		function UnitDamagedBatch(unitIDs, unitDefIDs, unitTeams, damages, paralyzers, weaponDefIDs, projectileIDs, attackerIDs, attackerDefIDs, attackerTeams, count)
+			local sum = damageSum
+			for i = 1, count do
+				sum = sum + damages[i]
+			end
+			damageSum = sum
+		end
+	)";
+
+	lua_State* CreateState()
+	{
+		lua_State* L = luaL_newstate();
+
+		luaL_openlibs(L);
+		luaL_dostring(L, HANDLERS);
+		return L;
+	}
+
+	UnitDamagedEventBatch CreateBatch(int numEvents)
+	{
+		UnitDamagedEventBatch batch;
+
+		for (int i = 0; i < numEvents; i++) {
+			batch.Add(i, i % 200, i % 8, 10.0f + i % 50, (i % 16) == 0, i % 40, 100000 + i, ((i % 5) == 0)? -1: (i * 7) % 5000, i % 200, (i + 1) % 8);
+		}
+
+		return batch;
+	}
+
+	void PushTraceback(lua_State* L)
+	{
+		lua_getglobal(L, "debug");
+		lua_getfield(L, -1, "traceback");
+		lua_remove(L, -2);
+	}
+
+	template<typename T>
+	void PushArray(lua_State* L, int& ref, const std::vector<T>& values)
+	{
+		if (ref == LUA_NOREF) {
+			lua_createtable(L, values.size(), 0);
+			lua_pushvalue(L, -1);
+			ref = luaL_ref(L, LUA_REGISTRYINDEX);
+		} else {
+			lua_rawgeti(L, LUA_REGISTRYINDEX, ref);
+		}
+
+		for (size_t i = 0; i < values.size(); i++) {
+			if constexpr (std::is_same_v<T, uint8_t>) {
+				lua_pushboolean(L, values[i]);
+			} else {
+				lua_pushnumber(L, values[i]);
+			}
+
+			lua_rawseti(L, -2, i + 1);
+		}
+	}
+}
+
+static void BenchPerEventCallIns(benchmark::State& state)
+{
+	lua_State* L = CreateState();
+	const UnitDamagedEventBatch batch = CreateBatch(state.range(0));
+
+	for (auto _ : state) {
+		for (size_t i = 0; i < batch.size(); i++) {
+			PushTraceback(L);
+			const int errFuncIdx = lua_gettop(L);
+
+			lua_getglobal(L, "UnitDamaged");
+			lua_pushnumber(L, batch.unitIDs[i]);
+			lua_pushnumber(L, batch.unitDefIDs[i]);
+			lua_pushnumber(L, batch.unitTeams[i]);
+			lua_pushnumber(L, batch.damages[i]);
+			lua_pushboolean(L, batch.paralyzers[i]);
+			lua_pushnumber(L, batch.weaponDefIDs[i]);
+			lua_pushnumber(L, batch.projectileIDs[i]);
+
+			if (batch.attackerIDs[i] >= 0) {
+				lua_pushnumber(L, batch.attackerIDs[i]);
+				lua_pushnumber(L, batch.attackerDefIDs[i]);
+				lua_pushnumber(L, batch.attackerTeams[i]);
+			} else {
+				lua_pushnil(L);
+				lua_pushnil(L);
+				lua_pushnil(L);
+			}
+
+			lua_pcall(L, 10, 0, errFuncIdx);
+			lua_pop(L, 1);
+		}
+	}
+
+	state.SetItemsProcessed(state.iterations() * batch.size());
+	lua_close(L);
+}
+
+static void BenchBatchedCallIn(benchmark::State& state)
+{
+	lua_State* L = CreateState();
+	const UnitDamagedEventBatch batch = CreateBatch(state.range(0));
+
+	int refs[10];
+	std::fill(std::begin(refs), std::end(refs), LUA_NOREF);
+
+	for (auto _ : state) {
+		PushTraceback(L);
+		const int errFuncIdx = lua_gettop(L);
+
+		lua_getglobal(L, "UnitDamagedBatch");
+		PushArray(L, refs[0], batch.unitIDs);
+		PushArray(L, refs[1], batch.unitDefIDs);
+		PushArray(L, refs[2], batch.unitTeams);
+		PushArray(L, refs[3], batch.damages);
+		PushArray(L, refs[4], batch.paralyzers);
+		PushArray(L, refs[5], batch.weaponDefIDs);
+		PushArray(L, refs[6], batch.projectileIDs);
+		PushArray(L, refs[7], batch.attackerIDs);
+		PushArray(L, refs[8], batch.attackerDefIDs);
+		PushArray(L, refs[9], batch.attackerTeams);
+		lua_pushnumber(L, batch.size());
+
+		lua_pcall(L, 11, 0, errFuncIdx);
+		lua_pop(L, 1);
+	}
+
+	state.SetItemsProcessed(state.iterations() * batch.size());
+	lua_close(L);
+}
+
+BENCHMARK(BenchPerEventCallIns)->Arg(100)->Arg(1000)->Arg(10000);
+BENCHMARK(BenchBatchedCallIn)->Arg(100)->Arg(1000)->Arg(10000);
+
+BENCHMARK_MAIN();
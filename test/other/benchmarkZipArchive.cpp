@@ -0,0 +1,132 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include "System/FileSystem/Archives/ZipArchive.h"
+#include "System/GlobalConfig.h"
+#include "System/Misc/SpringTime.h"
+#include "System/Platform/Threading.h"
+#include "System/Sync/SHA512.hpp"
+#include "System/Threading/ThreadPool.h"
+
+#include "minizip/zip.h"
+
+#include <benchmark/benchmark.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+// Wall time of hashing every file of an archive (what CArchiveScanner does
+// per archive) and of reading every file (what a game preload does) with
+// 1..N pool threads. Set ZIP_ARCHIVE_PATH to an .sdz to measure real content,
+// otherwise a synthetic archive of mixed stored and deflated entries is used.
+
+namespace {
+	constexpr int NUM_FILES = 512;
+
+	std::string CreateSyntheticArchive()
+	{
+		const std::string path = "benchmarkZipArchive.sdz";
+
+		zipFile zf = zipOpen(path.c_str(), APPEND_STATUS_CREATE);
+
+		if (zf == nullptr)
+			return "";
+
+		std::vector<std::uint8_t> data;
+
+		for (int i = 0; i < NUM_FILES; i++) {
+			// 4..260 KB of moderately compressible data, like textures and models
+			data.resize(4096 + (i % 64) * 4096);
+
+			for (size_t j = 0; j < data.size(); j++) {
+				data[j] = static_cast<std::uint8_t>((j * 31 + i) ^ (j >> 7));
+			}
+
+			const std::string name = "files/" + std::to_string(i) + ".bin";
+			const int method = ((i % 2) == 0)? 0: Z_DEFLATED;
+
+			zip_fileinfo zi = {};
+			zipOpenNewFileInZip(zf, name.c_str(), &zi, nullptr, 0, nullptr, 0, nullptr, method, Z_DEFAULT_COMPRESSION);
+			zipWriteInFileInZip(zf, data.data(), data.size());
+			zipCloseFileInZip(zf);
+		}
+
+		zipClose(zf, nullptr);
+		return path;
+	}
+
+	const std::string& GetArchivePath()
+	{
+		static const std::string path = [] {
+			const char* env = std::getenv("ZIP_ARCHIVE_PATH");
+			return ((env != nullptr)? std::string(env): CreateSyntheticArchive());
+		}();
+
+		return path;
+	}
+
+	void SetupThreads(int numThreads)
+	{
+		static const bool init = [] {
+			spring_clock::PushTickRate();
+			spring_time::setstarttime(spring_time::gettime(true));
+			Threading::DetectCores();
+			// measure the archive, not the buffer cache of CBufferedArchive
+			globalConfig.vfsCacheArchiveFiles = false;
+			return true;
+		}();
+
+		(void) init;
+		ThreadPool::SetThreadCount(numThreads);
+	}
+}
+
+
+static void BM_Scan(benchmark::State& state)
+{
+	SetupThreads(state.range(0));
+
+	for (auto _: state) {
+		CZipArchive archive(GetArchivePath());
+		std::vector<sha512::raw_digest> hashes(archive.NumFiles());
+		std::vector<std::vector<std::uint8_t>> buffers(ThreadPool::GetMaxThreads());
+
+		for_mt(0, archive.NumFiles(), [&](const int i) {
+			archive.CalcHash(i, hashes[i], buffers[ThreadPool::GetThreadNum()]);
+		});
+
+		benchmark::DoNotOptimize(hashes.data());
+	}
+}
+
+static void BM_Preload(benchmark::State& state)
+{
+	SetupThreads(state.range(0));
+
+	size_t numBytes = 0;
+
+	for (auto _: state) {
+		CZipArchive archive(GetArchivePath());
+		std::vector<std::vector<std::uint8_t>> buffers(ThreadPool::GetMaxThreads());
+		std::vector<size_t> sizes(archive.NumFiles());
+
+		for_mt(0, archive.NumFiles(), [&](const int i) {
+			std::vector<std::uint8_t>& buffer = buffers[ThreadPool::GetThreadNum()];
+
+			archive.GetFile(i, buffer);
+			sizes[i] = buffer.size();
+		});
+
+		for (size_t size: sizes) {
+			numBytes += size;
+		}
+	}
+
+	state.SetBytesProcessed(numBytes);
+}
+
+BENCHMARK(BM_Scan)->DenseRange(1, 8)->UseRealTime()->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_Preload)->DenseRange(1, 8)->UseRealTime()->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
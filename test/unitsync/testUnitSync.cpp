@@ -10,6 +10,9 @@
 #include <stdio.h>
 #include <stdlib.h>
 
+#include <chrono>
+#include <filesystem>
+#include <fstream>
 #include <string>
 #include <vector>
 //#include <future>
@@ -351,3 +354,183 @@ TEST_CASE("UnitSync")
 		FAIL_CHECK("No error on GetWritableDataDirectory before init"); // there's an error cause we called GetWritableDataDirectory() after UnInit()!
 	}
 }
+
+
+/******************************************************************************/
+/******************************************************************************/
+
+namespace fs = std::filesystem;
+
+// fixed modification time of the test game, so rewriting its modinfo.lua
+// does not invalidate the cached entry
+static constexpr uint32_t CACHE_TEST_MODTIME = 1600000000;
+
+static void SetEnv(const char* name, const char* value)
+{
+#ifdef _WIN32
+	_putenv_s(name, value);
+#else
+	setenv(name, value, 1);
+#endif
+}
+
+static void SetModTime(const fs::path& path)
+{
+	const std::chrono::sys_seconds t{std::chrono::seconds(CACHE_TEST_MODTIME)};
+	fs::last_write_time(path, std::chrono::file_clock::from_sys(t));
+}
+
+static void WriteFile(const fs::path& path, const std::string& data)
+{
+	std::ofstream file(path, std::ios::binary | std::ios::trunc);
+	file.write(data.data(), data.size());
+}
+
+static std::string ReadFile(const fs::path& path)
+{
+	std::ifstream file(path, std::ios::binary);
+	return {std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+}
+
+static void WriteModInfo(const fs::path& gameDir, const std::string& name)
+{
+	WriteFile(gameDir / "modinfo.lua", "return {name = \"" + name + "\", shortname = \"CT\", modtype = 1}\n");
+
+	SetModTime(gameDir / "modinfo.lua");
+	SetModTime(gameDir);
+}
+
+struct CacheTestGame {
+	std::string name;
+	std::string path;
+	unsigned int checksum = 0;
+};
+
+// runs a full Init and reports what the scanner knows about cachetest.sdd
+static CacheTestGame ScanCacheTestGame()
+{
+	CacheTestGame game;
+
+	REQUIRE(us::Init(false, 0) != 0);
+
+	for (int i = 0, n = us::GetPrimaryModCount(); i < n; i++) {
+		const char* archive = us::GetPrimaryModArchive(i);
+
+		if (archive == nullptr || std::string(archive) != "cachetest.sdd")
+			continue;
+
+		const char* path = us::GetArchivePath("cachetest.sdd");
+
+		game.name = GetGameName(i);
+		game.path = (path != nullptr)? path: "";
+		game.checksum = us::GetArchiveChecksum((game.path + "cachetest.sdd").c_str());
+	}
+
+	// the scanner writes the cache (including new checksums) on shutdown
+	us::UnInit();
+	return game;
+}
+
+TEST_CASE("UnitSync_ArchiveCache")
+{
+	const fs::path writeDir = fs::temp_directory_path() / "testUnitSyncArchiveCache";
+	const fs::path gameDir = writeDir / "games" / "cachetest.sdd";
+	const fs::path binCache = writeDir / "cache" / "ArchiveCache21.bin";
+	const fs::path luaCache = writeDir / "cache" / "ArchiveCache20.lua";
+
+	fs::remove_all(writeDir);
+	fs::create_directories(gameDir);
+
+	SetEnv("SPRING_WRITEDIR", writeDir.string().c_str());
+	us::SetSpringConfigFile((writeDir / "springsettings.cfg").string().c_str());
+
+	WriteModInfo(gameDir, "CacheTest");
+
+	const CacheTestGame scanned = ScanCacheTestGame();
+
+	REQUIRE(scanned.name == "CacheTest");
+	REQUIRE(!scanned.path.empty());
+	REQUIRE(fs::exists(binCache));
+
+	const std::string valid = ReadFile(binCache);
+
+	// from here on only a rescan can see the new name
+	WriteModInfo(gameDir, "CacheTest Changed");
+
+	SECTION("round trip") {
+		const CacheTestGame cached = ScanCacheTestGame();
+
+		CHECK(cached.name == scanned.name);
+		CHECK(cached.path == scanned.path);
+		CHECK(cached.checksum == scanned.checksum);
+	}
+
+	SECTION("damaged caches are rescanned") {
+		std::vector<std::string> damaged;
+
+		for (const size_t size: {size_t(0), size_t(3), size_t(8), valid.size() / 3, valid.size() / 2, valid.size() - 1}) {
+			damaged.push_back(valid.substr(0, size));
+		}
+
+		// trailing garbage, wrong magic, wrong version
+		damaged.push_back(valid + "x");
+		damaged.push_back("X" + valid.substr(1));
+		damaged.push_back(valid.substr(0, 4) + std::string(1, char(valid[4] ^ 1)) + valid.substr(5));
+
+		for (const std::string& data: damaged) {
+			WriteFile(binCache, data);
+
+			const CacheTestGame rescanned = ScanCacheTestGame();
+
+			INFO("cache size " << data.size());
+			CHECK(rescanned.name == "CacheTest Changed");
+			CHECK(rescanned.checksum != scanned.checksum);
+
+			// and replaced by a valid one
+			CHECK(ReadFile(binCache).size() > 8);
+		}
+	}
+
+	SECTION("the last Lua cache is converted") {
+		// hex of a 64-byte digest
+		const std::string digest(128, '5');
+		const std::string modTime = std::to_string(CACHE_TEST_MODTIME);
+
+		fs::remove(binCache);
+		WriteFile(luaCache,
+			"return {\n"
+			"  internalver = 20,\n"
+			"  archives = {\n"
+			"    {\n"
+			"      name = \"cachetest.sdd\",\n"
+			"      path = [[" + scanned.path + "]],\n"
+			"      modified = \"" + modTime + "\",\n"
+			"      checksum = \"" + digest + "\",\n"
+			"      archiveDataPath = [[" + scanned.path + "cachetest.sdd/modinfo.lua]],\n"
+			"      modifiedArchiveData = \"" + modTime + "\",\n"
+			"      archivedata = {name = \"CacheTest Lua\", shortname = \"CT\", modtype = 1},\n"
+			"    },\n"
+			"  },\n"
+			"  brokenArchives = {},\n"
+			"}\n"
+		);
+
+		const CacheTestGame converted = ScanCacheTestGame();
+
+		CHECK(converted.name == "CacheTest Lua");
+		CHECK(converted.checksum == 0x55555555);
+		CHECK(fs::exists(binCache));
+
+		// the binary cache keeps the converted entry, hash included
+		fs::remove(luaCache);
+
+		const CacheTestGame cached = ScanCacheTestGame();
+
+		CHECK(cached.name == "CacheTest Lua");
+		CHECK(cached.checksum == 0x55555555);
+	}
+
+	SetEnv("SPRING_WRITEDIR", "");
+	us::SetSpringConfigFile("");
+	fs::remove_all(writeDir);
+}
@@ -0,0 +1,156 @@
+function widget:GetInfo()
+return {
+	name    = "Test-UnitsStateBulk",
+	desc    = "Compares Spring.GetUnitsStateBulk against the single-unit getters",
+	date    = "Oct. 2026",
+	license = "GNU GPL, v2 or later",
+	layer   = 0,
+	enabled = true,
+}
+end
+
+local checkinterval = 15 -- frames between checks
+local minhidden = 10 -- if fewer known units than this were hidden in a check print a warning
+
+local FIELDS = {"visibility", "position", "midPosition", "aimPosition", "velocity", "health", "direction", "heading", "unitDefID", "team"}
+local STRIDE = 1 + 3 + 3 + 3 + 4 + 5 + 9 + 1 + 1 + 1
+
+-- what each field is supposed to hold, taken from its single-unit getter;
+-- values that getter does not return are 0
+local function GetExpected(unitID)
+	local expected = {}
+	local n = 0
+
+	local function Append(count, ...)
+		for i = 1, count do
+			expected[n + i] = (select(i, ...)) or 0
+		end
+		n = n + count
+	end
+
+	local px, py, pz, mx, my, mz, ax, ay, az = Spring.GetUnitPosition(unitID, true, true)
+	local inLos = (Spring.GetUnitHeading(unitID) ~= nil)
+
+	Append(1, (px == nil and 0) or (inLos and 2) or 1)
+	Append(3, px, py, pz)
+	Append(3, mx, my, mz)
+	Append(3, ax, ay, az)
+	Append(4, Spring.GetUnitVelocity(unitID))
+	Append(5, Spring.GetUnitHealth(unitID))
+	Append(9, Spring.GetUnitDirection(unitID))
+	Append(1, Spring.GetUnitHeading(unitID))
+	Append(1, Spring.GetUnitDefID(unitID))
+	Append(1, Spring.GetUnitTeam(unitID))
+
+	return expected
+end
+
+-- every unit seen so far; dead or hidden ones must come back as 0
+local knownUnits = {}
+local numKnownUnits = 0
+local out
+
+local numChecked = 0
+local numHidden = 0
+local numErrors = 0
+local viewMode = 0
+
+local function LogError(msg)
+	numErrors = numErrors + 1
+
+	if numErrors <= 20 then
+		Spring.Log("test_units_state_bulk.lua", LOG.ERROR, msg)
+	end
+end
+
+local function CheckUnits()
+	for _, unitID in ipairs(Spring.GetAllUnits()) do
+		if not knownUnits[unitID] then
+			knownUnits[unitID] = true
+			numKnownUnits = numKnownUnits + 1
+		end
+	end
+
+	-- never valid ids are 0 as well
+	local unitIDs = {-1, 1e6}
+
+	for unitID in pairs(knownUnits) do
+		unitIDs[#unitIDs + 1] = unitID
+	end
+
+	local values, stride = Spring.GetUnitsStateBulk(unitIDs, FIELDS, out)
+
+	if stride ~= STRIDE then
+		LogError(string.format("stride %s, expected %i", tostring(stride), STRIDE))
+		return
+	end
+
+	-- refilling the previous result must hand back the same table
+	if out ~= nil and values ~= out then
+		LogError("out table was not reused")
+	end
+
+	out = values
+
+	if #values < #unitIDs * stride then
+		LogError(string.format("%i values, expected at least %i", #values, #unitIDs * stride))
+	end
+
+	local _, fullView = Spring.GetSpectatingState()
+
+	for i, unitID in ipairs(unitIDs) do
+		local expected = GetExpected(unitID)
+		local base = (i - 1) * stride
+
+		for k = 1, stride do
+			if values[base + k] ~= expected[k] then
+				LogError(string.format("unit %i value %i: %s, expected %s (fullview %s, allyteam %i)",
+					unitID, k, tostring(values[base + k]), tostring(expected[k]), tostring(fullView), Spring.GetMyAllyTeamID()))
+			end
+		end
+
+		if expected[1] == 0 and knownUnits[unitID] then
+			numHidden = numHidden + 1
+		end
+	end
+
+	numChecked = numChecked + #unitIDs
+end
+
+-- alternates between full view and the limited view of each ally team,
+-- so the LOS, radar and ally branches are all compared
+local function NextViewMode()
+	viewMode = (viewMode + 1) % 3
+
+	if viewMode == 0 then
+		Spring.SendCommands("specfullview 1")
+	else
+		Spring.SendCommands("specfullview 0", "specteam " .. (viewMode - 1))
+	end
+end
+
+local function ShowStats()
+	Spring.Echo("UnitsStateBulk test done:")
+	Spring.Echo(string.format("Units known: %i checked: %i hidden: %i errors: %i", numKnownUnits, numChecked, numHidden, numErrors))
+
+	if numHidden < minhidden then
+		Spring.Log("test_units_state_bulk.lua", LOG.WARNING, string.format("Fewer than %i hidden units were checked!", minhidden))
+	end
+
+	Spring.SendCommands("specfullview 1")
+end
+
+function widget:GameFrame(n)
+	if n % checkinterval ~= 0 then
+		return
+	end
+
+	CheckUnits()
+	NextViewMode()
+end
+
+function widget:Shutdown()
+	if numChecked > 0 then
+		ShowStats()
+	end
+end
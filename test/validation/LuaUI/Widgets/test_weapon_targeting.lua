@@ -0,0 +1,76 @@
+function widget:GetInfo()
+return {
+	name    = "Test-WeaponTargeting",
+	desc    = "Reports the per-frame cost of unit and weapon updates, run with parallelWeaponTargeting on and off to compare",
+	date    = "Oct. 2026",
+	license = "GNU GPL, v2 or later",
+	layer   = 0,
+	enabled = true,
+}
+end
+
+local warmupframes = 900 -- skip the start of the game where few units are armed
+local minunits = 100 -- if fewer units than this were alive on average print a warning
+
+-- the timers CUnitHandler wraps around the real CGameHelper targeting paths
+local TIMERS = {
+	"Sim::Unit::SlowUpdate",
+	"Sim::Unit::WeaponTargetsMT",
+	"Sim::Unit::Weapon",
+}
+
+local startTotals = {}
+local startFrame
+local lastFrame
+
+local unitSamples = 0
+local numSamples = 0
+
+local function GetTotal(name)
+	local total = Spring.GetProfilerTimeRecord(name)
+	return total or 0
+end
+
+local function ShowStats()
+	local numFrames = lastFrame - startFrame
+	local avgUnits = unitSamples / math.max(numSamples, 1)
+
+	Spring.Echo("WeaponTargeting test done:")
+	Spring.Echo(string.format("Frames: %i units (avg): %.1f threads: %i", numFrames, avgUnits, Spring.GetConfigInt("WorkerThreadCount", -1)))
+
+	for _, name in ipairs(TIMERS) do
+		local ms = GetTotal(name) - startTotals[name]
+		Spring.Echo(string.format("%-28s %8.3f ms/frame", name, ms / math.max(numFrames, 1)))
+	end
+
+	if avgUnits < minunits then
+		Spring.Log("test_weapon_targeting.lua", LOG.WARNING, string.format("Fewer than %i units were alive on average!", minunits))
+	end
+end
+
+function widget:GameFrame(n)
+	if n == warmupframes then
+		startFrame = n
+
+		for _, name in ipairs(TIMERS) do
+			startTotals[name] = GetTotal(name)
+		end
+	end
+
+	if startFrame == nil then
+		return
+	end
+
+	lastFrame = n
+
+	if n % 30 == 0 then
+		unitSamples = unitSamples + #Spring.GetAllUnits()
+		numSamples = numSamples + 1
+	end
+end
+
+function widget:Shutdown()
+	if startFrame ~= nil and lastFrame > startFrame then
+		ShowStats()
+	end
+end